@@ -0,0 +1,178 @@
+#include "BenchSignals.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace bench {
+
+namespace {
+constexpr double kTwoPi = 6.283185307179586;
+
+// xorshift32: tiny, and identical everywhere (unlike std:: distributions)
+struct Rng {
+  uint32_t s;
+  explicit Rng(uint32_t seed) : s(seed ? seed : 0x9e3779b9u) {}
+  uint32_t next() { s ^= s << 13; s ^= s >> 17; s ^= s << 5; return s; }
+  float uniform() { return float(next() >> 8) * (2.0f / 16777216.0f) - 1.0f; }   // [-1, 1)
+};
+
+StereoSignal blank(const char* name, int sr, double seconds) {
+  StereoSignal s;
+  s.name = name;
+  s.sampleRate = sr;
+  const size_t n = size_t(std::max(0.0, seconds) * sr);
+  s.l.assign(n, 0.0f);
+  s.r.assign(n, 0.0f);
+  return s;
+}
+
+uint32_t le32(const unsigned char* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24); }
+uint16_t le16(const unsigned char* p) { return uint16_t(p[0] | (p[1] << 8)); }
+}
+
+StereoSignal makeSweep(int sr, double seconds, double f0, double f1) {
+  StereoSignal s = blank("sweep", sr, seconds);
+  const double T = std::max(1e-3, seconds);
+  const double k = std::log(f1 / f0);
+  for (int i = 0; i < s.frames(); ++i) {
+    const double t = double(i) / sr;
+    const double phase = kTwoPi * f0 * T / k * (std::exp(t / T * k) - 1.0);
+    s.l[i] = float(0.5 * std::sin(phase));
+    s.r[i] = float(0.5 * std::cos(phase));
+  }
+  return s;
+}
+
+StereoSignal makeImpulses(int sr, double seconds, double interval) {
+  StereoSignal s = blank("impulse", sr, seconds);
+  const int step = std::max(1, int(std::lround(interval * sr)));
+  const int delay = sr / 1000;
+  for (int i = 0; i < s.frames(); i += step) {
+    s.l[i] = 1.0f;
+    if (i + delay < s.frames()) s.r[i + delay] = 1.0f;
+  }
+  return s;
+}
+
+StereoSignal makePinkNoise(int sr, double seconds, uint32_t seed) {
+  StereoSignal s = blank("pink", sr, seconds);
+  for (int ch = 0; ch < 2; ++ch) {
+    Rng rng(seed + uint32_t(ch) * 7919u);
+    std::vector<float>& out = ch ? s.r : s.l;
+    float b0 = 0, b1 = 0, b2 = 0, b3 = 0, b4 = 0, b5 = 0, b6 = 0;
+    for (float& y : out) {
+      const float w = rng.uniform();
+      b0 = 0.99886f * b0 + w * 0.0555179f;
+      b1 = 0.99332f * b1 + w * 0.0750759f;
+      b2 = 0.96900f * b2 + w * 0.1538520f;
+      b3 = 0.86650f * b3 + w * 0.3104856f;
+      b4 = 0.55000f * b4 + w * 0.5329522f;
+      b5 = -0.7616f * b5 - w * 0.0168980f;
+      y = (b0 + b1 + b2 + b3 + b4 + b5 + b6 + w * 0.5362f) * 0.11f;
+      b6 = w * 0.115926f;
+    }
+  }
+  return s;
+}
+
+StereoSignal makeDrumLoop(int sr, double seconds, double bpm) {
+  StereoSignal s = blank("drums", sr, seconds);
+  Rng rng(42);
+  const double beat = 60.0 / std::max(1.0, bpm);
+  const int sixteenth = std::max(1, int(std::lround(beat / 4.0 * sr)));
+  const double bassNotes[4] = {55.0, 55.0, 65.41, 49.0};   // A1 A1 C2 G1, one per bar
+
+  for (int step = 0; size_t(step) * sixteenth < size_t(s.frames()); ++step) {
+    const int start = step * sixteenth;
+    const int inBar = step % 16;
+    const int len = std::min(s.frames() - start, 2 * sixteenth);
+    for (int i = 0; i < len; ++i) {
+      const double t = double(i) / sr;
+      float kick = 0, snare = 0, hat = 0;
+      if (inBar % 4 == 0)                                   // four on the floor
+        kick = float(0.9 * std::exp(-t * 18.0) * std::sin(kTwoPi * (50.0 * t + 60.0 * (1 - std::exp(-t * 30.0)) / 30.0)));
+      if (inBar == 4 || inBar == 12)                        // backbeat
+        snare = float(std::exp(-t * 25.0) * (0.35 * rng.uniform() + 0.25 * std::sin(kTwoPi * 190.0 * t)));
+      if (inBar % 2 == 0)                                   // eighth hats
+        hat = float(0.12 * std::exp(-t * 120.0) * rng.uniform());
+      s.l[start + i] += kick + snare + hat * 0.7f;
+      s.r[start + i] += kick + snare * 0.8f + hat;
+    }
+  }
+  // Sustained bass under it
+  const int bar = 16 * sixteenth;
+  for (int i = 0; i < s.frames(); ++i) {
+    const double f = bassNotes[(i / bar) % 4];
+    const float b = float(0.2 * std::sin(kTwoPi * f * double(i) / sr));
+    s.l[i] = std::clamp(s.l[i] + b, -1.0f, 1.0f);
+    s.r[i] = std::clamp(s.r[i] + b, -1.0f, 1.0f);
+  }
+  return s;
+}
+
+bool loadWav(const std::string& path, StereoSignal& out, std::string* error) {
+  auto fail = [&](const char* msg) { if (error) *error = path + ": " + msg; return false; };
+
+  std::ifstream f(path, std::ios::binary);
+  if (!f) return fail("cannot open");
+  std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+  if (bytes.size() < 12 || std::memcmp(bytes.data(), "RIFF", 4) || std::memcmp(bytes.data() + 8, "WAVE", 4))
+    return fail("not a RIFF/WAVE file");
+
+  int format = 0, channels = 0, rate = 0, bits = 0;
+  const unsigned char* data = nullptr;
+  size_t dataBytes = 0;
+  for (size_t pos = 12; pos + 8 <= bytes.size();) {
+    const unsigned char* chunk = bytes.data() + pos;
+    const size_t size = le32(chunk + 4);
+    const size_t body = std::min(size, bytes.size() - pos - 8);
+    if (!std::memcmp(chunk, "fmt ", 4) && body >= 16) {
+      format = le16(chunk + 8);
+      channels = le16(chunk + 10);
+      rate = int(le32(chunk + 12));
+      bits = le16(chunk + 22);
+      if (format == 0xFFFE && body >= 40) format = le16(chunk + 8 + 24);   // extensible: subformat GUID
+    } else if (!std::memcmp(chunk, "data", 4)) {
+      data = chunk + 8;
+      dataBytes = body;
+    }
+    pos += 8 + size + (size & 1);
+  }
+  if (!data || channels <= 0 || rate <= 0) return fail("missing fmt or data chunk");
+  if (!((format == 1 && (bits == 16 || bits == 24 || bits == 32)) || (format == 3 && bits == 32)))
+    return fail("unsupported sample format (PCM 16/24/32 or float32 only)");
+
+  const int bytesPerSample = bits / 8;
+  const size_t frames = dataBytes / size_t(bytesPerSample * channels);
+  out = StereoSignal{};
+  out.name = path;
+  out.sampleRate = rate;
+  out.l.resize(frames);
+  out.r.resize(frames);
+
+  auto sample = [&](const unsigned char* p) -> float {
+    if (format == 3) { float v; std::memcpy(&v, p, 4); return v; }
+    switch (bits) {
+      case 16: return float(int16_t(le16(p))) / 32768.0f;
+      case 24: return float(int32_t((uint32_t(p[0]) << 8) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 24)) >> 8) / 8388608.0f;
+      default: return float(double(int32_t(le32(p))) / 2147483648.0);
+    }
+  };
+  for (size_t i = 0; i < frames; ++i) {
+    const unsigned char* p = data + i * size_t(bytesPerSample * channels);
+    out.l[i] = sample(p);
+    out.r[i] = channels > 1 ? sample(p + bytesPerSample) : out.l[i];
+  }
+  return true;
+}
+
+bool makeSignal(const std::string& spec, int sr, double seconds, StereoSignal& out, std::string* error) {
+  if (spec == "sweep")   { out = makeSweep(sr, seconds); return true; }
+  if (spec == "impulse") { out = makeImpulses(sr, seconds); return true; }
+  if (spec == "pink")    { out = makePinkNoise(sr, seconds); return true; }
+  if (spec == "drums")   { out = makeDrumLoop(sr, seconds); return true; }
+  return loadWav(spec, out, error);
+}
+
+} // namespace bench
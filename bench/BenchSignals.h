@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Test material for wledqt_bench: synthetic signals and a small WAV reader.
+// Generators use their own PRNG so the samples (and any golden output made
+// from them) are the same on every platform and compiler.
+namespace bench {
+
+struct StereoSignal {
+  std::string name;
+  int sampleRate = 48000;
+  std::vector<float> l, r;
+  int frames() const { return int(l.size()); }
+};
+
+// Log sweep f0 -> f1 over the whole length, R a quarter-cycle behind L.
+StereoSignal makeSweep(int sr, double seconds, double f0 = 20.0, double f1 = 20000.0);
+// Unit clicks every `interval` seconds (R delayed by 1 ms).
+StereoSignal makeImpulses(int sr, double seconds, double interval = 0.5);
+// Pink noise (Kellet filter on white), independent L/R.
+StereoSignal makePinkNoise(int sr, double seconds, uint32_t seed = 1);
+// Kick / snare / hi-hat pattern over a bass line at `bpm`.
+StereoSignal makeDrumLoop(int sr, double seconds, double bpm = 120.0);
+
+// 16/24/32-bit PCM or 32-bit float, any channel count (>2 keeps the first two).
+bool loadWav(const std::string& path, StereoSignal& out, std::string* error = nullptr);
+
+// "sweep", "impulse", "pink", "drums" or a path to a .wav file.
+bool makeSignal(const std::string& spec, int sr, double seconds, StereoSignal& out,
+                std::string* error = nullptr);
+
+} // namespace bench
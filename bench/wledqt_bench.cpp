@@ -0,0 +1,513 @@
+// wledqt_bench: headless, faster-than-real-time runs of the DSP processors.
+//
+// Feeds a synthetic signal or a WAV file through AudioProcessor and/or
+// AdvancedAudioProcessor straight through their input rings (no device, no
+// event loop) and reports hops/s, time per stage, heap allocations per hop and
+// peak RSS for every point of the N x hop x bands (x threads) matrix.
+//
+// --golden-out writes every hop's outputs; --golden-in compares a run against
+// such a file (bit-exact by default), so a SIMD table or thread-count change
+// can be checked numerically:
+//
+//   wledqt_bench --signal drums --golden-out base.wqg
+//   WLEDQT_SIMD=scalar wledqt_bench --signal drums --golden-in base.wqg
+//   wledqt_bench --processor advanced --threads 0,1,3 --golden-in base.wqg
+//
+// --fft-compare times a bare forward FFT per size with every FFT backend in
+// the build and prints the speedup over kissfft:
+//
+//   wledqt_bench --fft-compare 256,1024,4096,16384
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QLoggingCategory>
+#include <QStringList>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "AudioProcessor.h"
+#include "AdvancedAudioProcessor.h"
+#include "DspKernels.h"
+#include "FftBackend.h"
+#include "LatencyTracer.h"
+#include "BenchSignals.h"
+
+#if defined(_WIN32)
+  #include <windows.h>
+  #include <psapi.h>
+#else
+  #include <sys/resource.h>
+#endif
+
+// --- heap allocation counter (every thread, Qt included) ---
+static std::atomic<uint64_t> g_allocs{0};
+
+void* operator new(std::size_t n) {
+  g_allocs.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) { return operator new(n); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+static long peakRssKb() {
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS pmc{};
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return long(pmc.PeakWorkingSetSize / 1024);
+  return 0;
+#else
+  rusage ru{};
+  getrusage(RUSAGE_SELF, &ru);
+#if defined(__APPLE__)
+  return long(ru.ru_maxrss / 1024);     // bytes on macOS
+#else
+  return long(ru.ru_maxrss);            // KiB on Linux
+#endif
+#endif
+}
+
+namespace {
+
+using bench::StereoSignal;
+
+struct StageNs {
+  std::string name;
+  double nsPerRun = 0;
+  uint64_t runs = 0;
+};
+
+struct RunResult {
+  std::string key;          // golden key: processor/signal/rate/layout (no thread count)
+  std::string label;        // key + anything that must not change the output
+  uint64_t hops = 0;        // measured hops (after warm-up)
+  double seconds = 0;
+  double audioSeconds = 0;
+  uint64_t allocs = 0;
+  long peakRssKb = 0;
+  std::vector<StageNs> stages;
+  int valuesPerHop = 0;
+  std::vector<float> values;  // every hop, warm-up included
+};
+
+// Interleave one block and push it through the processor's ring + drain.
+template <typename Proc>
+void feedBlock(Proc& proc, const StereoSignal& s, int pos, int count, std::vector<float>& tmp) {
+  for (int i = 0; i < count; ++i) {
+    tmp[2 * i]     = s.l[pos + i];
+    tmp[2 * i + 1] = s.r[pos + i];
+  }
+  proc.inputRing()->writeInterleaved(tmp.data(), std::size_t(count), 2);
+  proc.drainInput();
+}
+
+// Warm-up (first `warmup` frames) is fed but not measured: plan allocation,
+// first-touch of buffers and the like are not per-hop costs.
+template <typename Proc, typename ResetCounters>
+void drive(Proc& proc, const StereoSignal& s, int block, int warmup, uint64_t& hops,
+           RunResult& r, ResetCounters&& resetCounters) {
+  std::vector<float> tmp(size_t(2 * block));
+  int pos = 0;
+  for (; pos < std::min(warmup, s.frames()); pos += block)
+    feedBlock(proc, s, pos, std::min(block, s.frames() - pos), tmp);
+
+  resetCounters();
+  const uint64_t hops0 = hops;
+  const uint64_t allocs0 = g_allocs.load();
+  const int64_t t0 = monotonicNs();
+  for (; pos < s.frames(); pos += block)
+    feedBlock(proc, s, pos, std::min(block, s.frames() - pos), tmp);
+  r.seconds = double(monotonicNs() - t0) * 1e-9;
+  r.allocs = g_allocs.load() - allocs0;
+  r.hops = hops - hops0;
+  r.audioSeconds = double(s.frames() - std::min(warmup, s.frames())) / s.sampleRate;
+  r.peakRssKb = peakRssKb();
+}
+
+RunResult runBasic(const StereoSignal& s, int N, int hop, int bands, int block, int warmup) {
+  RunResult r;
+  r.key = "basic/" + s.name + "/sr" + std::to_string(s.sampleRate) + "/N" + std::to_string(N) +
+          "/hop" + std::to_string(hop) + "/bands" + std::to_string(bands);
+  r.label = r.key;
+  r.valuesPerHop = 2 * bands + SpectrumFrame::kSrBins;
+
+  LatencyTracer tracer;
+  AudioProcessor proc;
+  proc.setSampleRate(s.sampleRate);
+  proc.setFftSize(N, hop);
+  proc.setNumBands(bands);
+  proc.setLatencyTracer(&tracer);
+
+  // Reserve outputs up front so collecting them doesn't show up as allocations
+  r.values.reserve(size_t(s.frames() / std::max(1, hop) + 2) * size_t(r.valuesPerHop));
+  uint64_t hops = 0;
+  QObject::connect(&proc, &AudioProcessor::frameReady, [&](const SpectrumFramePtr& f) {
+    ++hops;
+    r.values.insert(r.values.end(), f->bandsL, f->bandsL + f->numBands);
+    r.values.insert(r.values.end(), f->bandsR, f->bandsR + f->numBands);
+    r.values.insert(r.values.end(), f->bins16, f->bins16 + SpectrumFrame::kSrBins);
+  });
+
+  proc.start();
+  drive(proc, s, block, warmup, hops, r, [&] { tracer.reset(); });
+  proc.requestStop();
+
+  for (LatencyTracer::Stage st : {LatencyTracer::Fft, LatencyTracer::Bands}) {
+    const LatencyHistogram& h = tracer.histogram(st);
+    r.stages.push_back({LatencyTracer::stageName(st), h.meanNs(), h.count()});
+  }
+  return r;
+}
+
+RunResult runAdvanced(const StereoSignal& s, int threads, int block, int warmup) {
+  RunResult r;
+  r.key = "advanced/" + s.name + "/sr" + std::to_string(s.sampleRate);
+  r.label = r.key + "/threads" + std::to_string(threads);
+
+  AdvancedAudioProcessor proc;
+  proc.setSampleRate(s.sampleRate);
+  proc.setWorkerThreads(threads);
+  proc.setStageTiming(true);
+
+  uint64_t hops = 0;
+  bool reserved = false;
+  QObject::connect(&proc, &AdvancedAudioProcessor::multiResolutionAnalysisReady,
+                   [&](const MultiResolutionData& d) {
+    ++hops;
+    const float scalars[] = { d.spectralCentroid, d.spectralRolloff, d.zeroCrossingRate,
+                              d.harmonicPercussiveRatio, d.beatBpm, d.beatPhase, d.beatConfidence,
+                              d.isOnset ? 1.0f : 0.0f };
+    const int per = int(d.bass.size() + d.harmonic.size() + d.percussive.size() + d.macro.size() +
+                        d.chromagram.size() + d.onsetStrength.size()) + int(std::size(scalars));
+    if (!reserved) {
+      r.valuesPerHop = per;
+      r.values.reserve(size_t(s.frames() / 256 + 2) * size_t(per));
+      reserved = true;
+    }
+    for (const QVector<float>* v : {&d.bass, &d.harmonic, &d.percussive, &d.macro, &d.chromagram, &d.onsetStrength})
+      r.values.insert(r.values.end(), v->begin(), v->end());
+    r.values.insert(r.values.end(), std::begin(scalars), std::end(scalars));
+  });
+
+  proc.start();
+  drive(proc, s, block, warmup, hops, r, [&] { proc.resetStageTimings(); });
+  for (const AdvancedAudioProcessor::StageTiming& t : proc.stageTimings())
+    r.stages.push_back({t.name, t.runs ? double(t.totalNs) / double(t.runs) : 0.0, t.runs});
+  proc.requestStop();
+  return r;
+}
+
+// --- FFT backends: ns per forward transform (real, and packed complex) ---
+struct FftTiming {
+  double realNs = 0;
+  double complexNs = 0;
+  float maxRelDiff = 0;     // real spectrum vs kissfft, relative to its peak
+};
+
+template <typename Fn>
+double nsPerCall(Fn&& fn) {
+  for (int i = 0; i < 8; ++i) fn();                 // warm caches / first-touch
+  uint64_t calls = 0;
+  const int64_t t0 = monotonicNs();
+  int64_t t = t0;
+  while (t - t0 < 200000000) {                     // ~200 ms per measurement
+    for (int i = 0; i < 16; ++i) fn();
+    calls += 16;
+    t = monotonicNs();
+  }
+  return double(t - t0) / double(calls);
+}
+
+bool timeFft(int N, fft::Backend b, const std::vector<fft::Complex>* reference,
+             std::vector<fft::Complex>& spec, FftTiming& out) {
+  auto real = fft::makeReal(N, false, b);
+  auto cplx = fft::makeComplex(N, b);
+  if (!real || !cplx) return false;
+
+  std::vector<float> in(static_cast<size_t>(N));
+  std::vector<fft::Complex> zin(static_cast<size_t>(N)), zout(static_cast<size_t>(N));
+  uint32_t seed = 12345;
+  for (int n = 0; n < N; ++n) {
+    seed = seed * 1664525u + 1013904223u;
+    in[size_t(n)] = float(int32_t(seed)) * (1.0f / 2147483648.0f);
+    zin[size_t(n)] = {in[size_t(n)], -in[size_t(n)]};
+  }
+  spec.assign(size_t(N / 2 + 1), fft::Complex{0, 0});
+  out.realNs = nsPerCall([&] { real->forward(in.data(), spec.data()); });
+  out.complexNs = nsPerCall([&] { cplx->forward(zin.data(), zout.data()); });
+
+  if (reference) {
+    float peak = 0, diff = 0;
+    for (size_t k = 0; k < spec.size(); ++k) {
+      const fft::Complex& a = (*reference)[k];
+      peak = std::max(peak, std::hypot(a.r, a.i));
+      diff = std::max(diff, std::hypot(spec[k].r - a.r, spec[k].i - a.i));
+    }
+    out.maxRelDiff = peak > 0 ? diff / peak : 0;
+  }
+  return true;
+}
+
+void compareFftBackends(const std::vector<int>& sizes) {
+  const bool haveFftw = fft::backendAvailable(fft::Backend::Fftw);
+  std::printf("%8s %14s %14s", "N", "kissfft r2c", "kissfft c2c");
+  if (haveFftw) std::printf(" %14s %14s %9s %9s %10s", "fftw3f r2c", "fftw3f c2c", "r2c x", "c2c x", "max rel d");
+  std::printf("\n");
+  for (int N : sizes) {
+    std::vector<fft::Complex> ref, spec;
+    FftTiming kiss, fftw;
+    if (!timeFft(N, fft::Backend::Kiss, nullptr, ref, kiss)) {
+      std::printf("%8d  (no plan)\n", N);
+      continue;
+    }
+    std::printf("%8d %11.0f ns %11.0f ns", N, kiss.realNs, kiss.complexNs);
+    if (haveFftw && timeFft(N, fft::Backend::Fftw, &ref, spec, fftw)) {
+      std::printf(" %11.0f ns %11.0f ns %8.2fx %8.2fx %10.2g", fftw.realNs, fftw.complexNs,
+                  kiss.realNs / fftw.realNs, kiss.complexNs / fftw.complexNs, double(fftw.maxRelDiff));
+    }
+    std::printf("\n");
+  }
+  if (!haveFftw) std::printf("(built without FFTW: configure with -DWLEDQT_WITH_FFTW=ON to compare)\n");
+}
+
+// --- golden files: "WQGB" v1, then per run: key, hops, values per hop, floats ---
+struct Golden {
+  int valuesPerHop = 0;
+  std::vector<float> values;
+};
+
+bool writeGolden(const std::string& path, const std::vector<RunResult>& runs) {
+  std::ofstream f(path, std::ios::binary);
+  if (!f) return false;
+  auto u32 = [&](uint32_t v) { f.write(reinterpret_cast<const char*>(&v), 4); };
+  f.write("WQGB", 4);
+  u32(1);
+  std::map<std::string, bool> written;
+  for (const RunResult& r : runs) {
+    if (written[r.key]) continue;          // same key twice (e.g. thread counts): keep the first
+    written[r.key] = true;
+    u32(uint32_t(r.key.size()));
+    f.write(r.key.data(), std::streamsize(r.key.size()));
+    u32(uint32_t(r.valuesPerHop ? r.values.size() / size_t(r.valuesPerHop) : 0));
+    u32(uint32_t(r.valuesPerHop));
+    f.write(reinterpret_cast<const char*>(r.values.data()), std::streamsize(r.values.size() * sizeof(float)));
+  }
+  return bool(f);
+}
+
+bool readGolden(const std::string& path, std::map<std::string, Golden>& out, std::string& err) {
+  std::ifstream f(path, std::ios::binary);
+  if (!f) { err = "cannot open " + path; return false; }
+  auto u32 = [&](uint32_t& v) { return bool(f.read(reinterpret_cast<char*>(&v), 4)); };
+  char magic[4];
+  uint32_t version = 0;
+  if (!f.read(magic, 4) || std::memcmp(magic, "WQGB", 4) || !u32(version) || version != 1) {
+    err = path + ": not a golden file";
+    return false;
+  }
+  uint32_t keyLen;
+  while (u32(keyLen)) {
+    std::string key(keyLen, '\0');
+    uint32_t hops = 0, per = 0;
+    if (!f.read(key.data(), keyLen) || !u32(hops) || !u32(per)) { err = path + ": truncated"; return false; }
+    Golden& g = out[key];
+    g.valuesPerHop = int(per);
+    g.values.resize(size_t(hops) * per);
+    if (!f.read(reinterpret_cast<char*>(g.values.data()), std::streamsize(g.values.size() * sizeof(float)))) {
+      err = path + ": truncated";
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns true if within tolerance; prints a one-line verdict.
+bool compare(const RunResult& r, const Golden& g, double tolerance) {
+  if (g.valuesPerHop != r.valuesPerHop || g.values.size() != r.values.size()) {
+    std::printf("  MISMATCH %s: layout differs (%zu x %d vs golden %zu x %d)\n", r.label.c_str(),
+                r.values.size() / size_t(std::max(1, r.valuesPerHop)), r.valuesPerHop,
+                g.values.size() / size_t(std::max(1, g.valuesPerHop)), g.valuesPerHop);
+    return false;
+  }
+  double maxAbs = 0;
+  size_t firstBad = size_t(-1), diffs = 0;
+  for (size_t i = 0; i < r.values.size(); ++i) {
+    const float a = r.values[i], b = g.values[i];
+    if (std::memcmp(&a, &b, sizeof(float)) == 0) continue;   // bit-identical (NaNs included)
+    const double d = std::isnan(a) || std::isnan(b) ? INFINITY : std::fabs(double(a) - double(b));
+    maxAbs = std::max(maxAbs, d);
+    ++diffs;
+    if (d > tolerance && firstBad == size_t(-1)) firstBad = i;
+  }
+  if (firstBad != size_t(-1)) {
+    std::printf("  MISMATCH %s: %zu values differ, max |d| %.3g, first at hop %zu value %zu\n", r.label.c_str(),
+                diffs, maxAbs, firstBad / size_t(r.valuesPerHop), firstBad % size_t(r.valuesPerHop));
+    return false;
+  }
+  if (diffs) std::printf("  match    %s: %zu values within %.3g (max |d| %.3g)\n", r.label.c_str(), diffs, tolerance, maxAbs);
+  else       std::printf("  match    %s: bit-exact\n", r.label.c_str());
+  return true;
+}
+
+std::vector<int> intList(const QString& s) {
+  std::vector<int> out;
+  for (const QString& part : s.split(',', Qt::SkipEmptyParts)) {
+    bool ok = false;
+    const int v = part.trimmed().toInt(&ok);
+    if (ok) out.push_back(v);
+  }
+  return out;
+}
+
+void printResult(const RunResult& r, FILE* csv) {
+  const double hps = r.seconds > 0 ? double(r.hops) / r.seconds : 0.0;
+  const double rt = r.seconds > 0 ? r.audioSeconds / r.seconds : 0.0;
+  const double aph = r.hops ? double(r.allocs) / double(r.hops) : 0.0;
+  std::printf("%-58s %9.0f hops/s %7.1fx rt %6.2f allocs/hop %7ld KiB\n", r.label.c_str(), hps, rt, aph, r.peakRssKb);
+  std::string stages;
+  for (const StageNs& st : r.stages) {
+    std::printf("    %-16s %10.0f ns  (%llu runs)\n", st.name.c_str(), st.nsPerRun, (unsigned long long)st.runs);
+    stages += (stages.empty() ? "" : ";") + st.name + "=" + std::to_string(int64_t(st.nsPerRun));
+  }
+  if (csv) {
+    std::fprintf(csv, "%s,%llu,%.3f,%.1f,%.2f,%.3f,%ld,%s\n", r.label.c_str(), (unsigned long long)r.hops,
+                 r.seconds, hps, rt, aph, r.peakRssKb, stages.c_str());
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("wledqt_bench");
+  QLoggingCategory::setFilterRules("*.debug=false");   // the processors log periodically
+
+  QCommandLineParser p;
+  p.setApplicationDescription("Offline throughput / regression runs of the wledqt DSP pipeline");
+  p.addHelpOption();
+  p.addOptions({
+    {"signal",    "sweep, impulse, pink, drums or a .wav path (comma-separated for several)", "list", "sweep,pink,drums"},
+    {"seconds",   "Length of synthetic signals", "s", "30"},
+    {"sr",        "Sample rate of synthetic signals", "hz", "48000"},
+    {"processor", "basic, advanced or both", "which", "both"},
+    {"fft",       "AudioProcessor FFT sizes", "list", "1024"},
+    {"hop",       "AudioProcessor hops (0 = N/2)", "list", "0"},
+    {"bands",     "AudioProcessor band counts", "list", "16,32,64"},
+    {"threads",   "AdvancedAudioProcessor helper threads (-1 = default)", "list", "0"},
+    {"block",     "Frames per ring write (like a capture period)", "frames", "480"},
+    {"simd",      "Force a kernel table (scalar, sse2, avx2); same as WLEDQT_SIMD", "isa"},
+    {"fft-backend","Force an FFT backend (kiss, fftw); same as WLEDQT_FFT", "name"},
+    {"fft-compare","Time a forward FFT at these sizes with every backend, print the speedup, exit", "list"},
+    {"fft-wisdom","Load (and save) FFTW wisdom from/to this file", "file"},
+    {"csv",       "Append results as CSV", "file"},
+    {"golden-out","Write every hop's outputs here", "file"},
+    {"golden-in", "Compare every hop's outputs against this file", "file"},
+    {"tolerance", "Max |difference| accepted by --golden-in (0 = bit-exact)", "x", "0"},
+  });
+  p.process(app);
+
+  // Must happen before the first dsp::kernels() call (processor construction)
+  if (p.isSet("simd")) qputenv("WLEDQT_SIMD", p.value("simd").toLocal8Bit());
+  // Likewise before the first FFT plan
+  if (p.isSet("fft-backend")) qputenv("WLEDQT_FFT", p.value("fft-backend").toLocal8Bit());
+  const std::string wisdom = p.value("fft-wisdom").toStdString();
+  if (!wisdom.empty()) fft::loadWisdom(wisdom);
+
+  if (p.isSet("fft-compare")) {
+    compareFftBackends(intList(p.value("fft-compare")));
+    if (!wisdom.empty()) fft::saveWisdom(wisdom);
+    return 0;
+  }
+
+  const double seconds = p.value("seconds").toDouble();
+  const int sr = p.value("sr").toInt();
+  const int block = std::max(1, p.value("block").toInt());
+  const QString which = p.value("processor");
+  const bool doBasic = which == "basic" || which == "both";
+  const bool doAdvanced = which == "advanced" || which == "both";
+
+  std::vector<StereoSignal> inputs;
+  for (const QString& spec : p.value("signal").split(',', Qt::SkipEmptyParts)) {
+    StereoSignal s;
+    std::string err;
+    if (!bench::makeSignal(spec.trimmed().toStdString(), sr, seconds, s, &err)) {
+      std::fprintf(stderr, "%s\n", err.c_str());
+      return 2;
+    }
+    inputs.push_back(std::move(s));
+  }
+
+  std::map<std::string, Golden> golden;
+  if (p.isSet("golden-in")) {
+    std::string err;
+    if (!readGolden(p.value("golden-in").toStdString(), golden, err)) {
+      std::fprintf(stderr, "%s\n", err.c_str());
+      return 2;
+    }
+  }
+
+  FILE* csv = nullptr;
+  if (p.isSet("csv")) {
+    const std::string path = p.value("csv").toStdString();
+    const bool fresh = !std::ifstream(path).good();
+    csv = std::fopen(path.c_str(), "a");
+    if (csv && fresh) std::fprintf(csv, "run,hops,seconds,hops_per_s,realtime_x,allocs_per_hop,peak_rss_kib,stage_ns\n");
+  }
+
+  std::printf("kernels: %s, fft: %s\n", dsp::kernels().name, fft::backendName(fft::defaultBackend()));
+  std::vector<RunResult> runs;
+  for (const StereoSignal& s : inputs) {
+    const int warmup = std::min(s.frames(), s.sampleRate / 2);
+    if (doBasic) {
+      for (int N : intList(p.value("fft")))
+        for (int hop : intList(p.value("hop")))
+          for (int bands : intList(p.value("bands"))) {
+            const int h = hop > 0 ? hop : N / 2;
+            if (h > N || !AudioProcessor::isSupportedBandCount(bands)) continue;
+            runs.push_back(runBasic(s, N, h, bands, block, warmup));
+            printResult(runs.back(), csv);
+          }
+    }
+    if (doAdvanced) {
+      for (int threads : intList(p.value("threads"))) {
+        runs.push_back(runAdvanced(s, threads, block, warmup));
+        printResult(runs.back(), csv);
+      }
+    }
+  }
+  if (csv) std::fclose(csv);
+
+  // Runs sharing a key (different thread counts) must agree with each other
+  // as well as with the golden file.
+  bool ok = true;
+  const double tolerance = p.value("tolerance").toDouble();
+  std::map<std::string, const RunResult*> first;
+  std::printf("\n");
+  for (const RunResult& r : runs) {
+    if (auto it = golden.find(r.key); it != golden.end()) ok = compare(r, it->second, tolerance) && ok;
+    else if (p.isSet("golden-in")) { std::printf("  missing  %s (not in golden file)\n", r.label.c_str()); ok = false; }
+
+    if (auto it = first.find(r.key); it != first.end()) {
+      ok = compare(r, Golden{it->second->valuesPerHop, it->second->values}, tolerance) && ok;
+    } else {
+      first[r.key] = &r;
+    }
+  }
+
+  if (!wisdom.empty()) fft::saveWisdom(wisdom);
+  if (p.isSet("golden-out") && !writeGolden(p.value("golden-out").toStdString(), runs)) {
+    std::fprintf(stderr, "cannot write %s\n", qPrintable(p.value("golden-out")));
+    return 2;
+  }
+  return ok ? 0 : 1;
+}
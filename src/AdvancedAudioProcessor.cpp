@@ -1,75 +1,119 @@
 #include "AdvancedAudioProcessor.h"
+#include "LatencyTracer.h"
 #include <cmath>
 #include <cstring>
 #include <algorithm>
 #include <numeric>
+#include <QTimer>
+#include <cstdlib>
+
+AdvancedAudioProcessor::AdvancedAudioProcessor(QObject* parent) : QObject(parent) {
+  _pool.setName("advanced-worker");
+  _hops.bind("wledqt_advanced_hops_total", {}, "Multi-resolution base hops processed");
+  _hopSeconds.bind("wledqt_advanced_hop_seconds", {}, "Wall time of the last base hop");
+  _cpu.bind("advanced");
+  const std::string advanced = metrics::labels({{"ring", "advanced"}});
+  const StereoRingBuffer* ring = &_input;
+  metrics::addProbe(this, "wledqt_ring_overruns_total", advanced, "Capture writes that did not fit the ring",
+                    metrics::Kind::Counter, [ring] { return double(ring->overruns()); });
+  metrics::addProbe(this, "wledqt_ring_dropped_frames_total", advanced, "Frames lost to ring overruns",
+                    metrics::Kind::Counter, [ring] { return double(ring->droppedFrames()); });
+  metrics::addProbe(this, "wledqt_ring_fill_frames", advanced, "Frames waiting in the ring",
+                    metrics::Kind::Gauge, [ring] { return double(ring->framesWritten() - ring->framesRead()); });
+}
 
-AdvancedAudioProcessor::AdvancedAudioProcessor(QObject* parent) : QObject(parent) {}
+void AdvancedAudioProcessor::applyWorkerThreads() {
+  int threads = _requestedThreads.load();
+  if (threads == _appliedRequest) return;
+  _appliedRequest = threads;
+  if (threads < 0) {
+    threads = DspWorkerPool::defaultThreadCount();
+    if (const char* env = std::getenv("WLEDQT_DSP_THREADS")) threads = std::atoi(env);
+  }
+  _pool.setThreadCount(threads);
+}
 
 AdvancedAudioProcessor::~AdvancedAudioProcessor() {
+  metrics::removeProbes(this);
   cleanup();
 }
 
 void AdvancedAudioProcessor::cleanup() {
-  if (_harmonicCfg) { kiss_fftr_free(_harmonicCfg); _harmonicCfg = nullptr; }
-  if (_bassCfg) { kiss_fftr_free(_bassCfg); _bassCfg = nullptr; }
-  if (_percCfg) { kiss_fftr_free(_percCfg); _percCfg = nullptr; }
-  if (_macroCfg) { kiss_fftr_free(_macroCfg); _macroCfg = nullptr; }
+  _engine.clear();
+  _bassRes = _harmonicRes = _percRes = _macroRes = -1;
 }
 
 void AdvancedAudioProcessor::start() {
   _stop.store(false);
   _initialized = false;
   cleanup();
-  _fifoL.clear();
-  _fifoR.clear();
+  _winL.clear();
+  _winR.clear();
   _frameCount = 0;
+  _position = 0;
+  _history = 0;
+  _cpu.mark();
+
+  _input.discard();
+  if (!_pollTimer) {
+    _pollTimer = new QTimer(this);
+    _pollTimer->setTimerType(Qt::PreciseTimer);
+    connect(_pollTimer, &QTimer::timeout, this, &AdvancedAudioProcessor::drainInput);
+  }
+  _pollTimer->start(kPollIntervalMs);
 }
 
 void AdvancedAudioProcessor::requestStop() {
-  _stop.store(true);
-  cleanup();
-  _fifoL.clear();
-  _fifoR.clear();
+  if (_stop.exchange(true)) return;
+  QMetaObject::invokeMethod(this, [this] { finishStop(); }, Qt::QueuedConnection);
 }
 
-void AdvancedAudioProcessor::onFrames(const QVector<float>& left, const QVector<float>& right) {
-  if (_stop.load() || left.isEmpty() || right.isEmpty()) return;
-
-  int n = std::min(left.size(), right.size());
-  if (n <= 0) return;
-
-  // Append to FIFOs
-  const int prevL = _fifoL.size();
-  _fifoL.reserve(prevL + n);
-  _fifoL.resize(prevL + n);
-  std::memcpy(_fifoL.data() + prevL, left.constData(), n * sizeof(float));
+void AdvancedAudioProcessor::finishStop() {
+  if (!_stop.load()) return;     // restarted before this got to run
+  if (_pollTimer) _pollTimer->stop();
+  cleanup();
+  _winL.clear();
+  _winR.clear();
+  _history = 0;
+  _cpu.clear();
+  emit stopped();
+}
 
-  const int prevR = _fifoR.size();
-  _fifoR.reserve(prevR + n);
-  _fifoR.resize(prevR + n);
-  std::memcpy(_fifoR.data() + prevR, right.constData(), n * sizeof(float));
+void AdvancedAudioProcessor::drainInput() {
+  if (_stop.load()) {
+    if (_pollTimer) _pollTimer->stop();
+    return;
+  }
 
-  processMultiResolution();
+  initialize();
+  if (!_initialized) return;
+  applyWorkerThreads();
+
+  // Top the windows up, process every complete hop, repeat until the ring is empty.
+  while (!_stop.load()) {
+    const std::size_t got = _input.consume(std::size_t(_winL.space()),
+      [this](const float* l, const float* r, std::size_t count) {
+        _winL.push(l, int(count));
+        _winR.push(r, int(count));
+      });
+    if (got == 0) break;
+    processMultiResolution();
+  }
 }
 
 void AdvancedAudioProcessor::initialize() {
   if (_initialized) return;
 
-  // Initialize all FFT configurations
-  _harmonicCfg = kiss_fftr_alloc(_harmonicN, 0, nullptr, nullptr);
-  _bassCfg = kiss_fftr_alloc(_bassN, 0, nullptr, nullptr);
-  _percCfg = kiss_fftr_alloc(_percN, 0, nullptr, nullptr);
-  _macroCfg = kiss_fftr_alloc(_macroN, 0, nullptr, nullptr);
-
-  if (!_harmonicCfg || !_bassCfg || !_percCfg || !_macroCfg) {
+  // One engine, four resolutions (re-adding an existing size is a no-op)
+  setupBuffers();
+  if (_bassRes < 0 || _harmonicRes < 0 || _percRes < 0 || _macroRes < 0) {
     qWarning("FFT allocation failed");
     return;
   }
 
-  // Initialize all buffers
-  setupBuffers();
-  setupWindows();
+  setupStages();
+
+  // Mappings depend on the sample rate, so they are rebuilt on every init
   setupFrequencyBands();
   setupOnsetDetection();
   setupRhythmTracking();
@@ -78,47 +122,18 @@ void AdvancedAudioProcessor::initialize() {
 }
 
 void AdvancedAudioProcessor::setupBuffers() {
-  // Harmonic analysis (current system)
-  _harmonicFrameL.assign(_harmonicN, 0.0f);
-  _harmonicFrameR.assign(_harmonicN, 0.0f);
-  _harmonicSpecL.assign(_harmonicN/2 + 1, kiss_fft_cpx{0,0});
-  _harmonicSpecR.assign(_harmonicN/2 + 1, kiss_fft_cpx{0,0});
-  _harmonicWindow.assign(_harmonicN, 0.0f);
-
-  // Bass analysis (high frequency resolution)
-  _bassFrameL.assign(_bassN, 0.0f);
-  _bassFrameR.assign(_bassN, 0.0f);
-  _bassSpecL.assign(_bassN/2 + 1, kiss_fft_cpx{0,0});
-  _bassSpecR.assign(_bassN/2 + 1, kiss_fft_cpx{0,0});
-  _bassWindow.assign(_bassN, 0.0f);
-
-  // Percussive analysis (high time resolution)
-  _percFrameL.assign(_percN, 0.0f);
-  _percFrameR.assign(_percN, 0.0f);
-  _percSpecL.assign(_percN/2 + 1, kiss_fft_cpx{0,0});
-  _percSpecR.assign(_percN/2 + 1, kiss_fft_cpx{0,0});
-  _percWindow.assign(_percN, 0.0f);
-
-  // Macro analysis (long-term features)
-  _macroFrameL.assign(_macroN, 0.0f);
-  _macroFrameR.assign(_macroN, 0.0f);
-  _macroSpecL.assign(_macroN/2 + 1, kiss_fft_cpx{0,0});
-  _macroSpecR.assign(_macroN/2 + 1, kiss_fft_cpx{0,0});
-  _macroWindow.assign(_macroN, 0.0f);
-}
-
-void AdvancedAudioProcessor::setupWindows() {
-  // Hann windows for all analysis types
-  auto createHannWindow = [](std::vector<float>& window, int N) {
-    for (int n = 0; n < N; ++n) {
-      window[n] = 0.5f * (1.0f - std::cos(2.0f * float(M_PI) * n / (N - 1)));
-    }
-  };
+  // Shared input windows: largest analysis plus the same again of fresh audio
+  if (_winL.capacity() != 2 * _macroN) {
+    _winL.reset(2 * _macroN);
+    _winR.reset(2 * _macroN);
+  }
 
-  createHannWindow(_harmonicWindow, _harmonicN);
-  createHannWindow(_bassWindow, _bassN);
-  createHannWindow(_percWindow, _percN);
-  createHannWindow(_macroWindow, _macroN);
+  _engine.setSampleRate(_sr);
+  _bassRes     = _engine.addResolution(_bassN);
+  _harmonicRes = _engine.addResolution(_harmonicN);
+  _percRes     = _engine.addResolution(_percN);
+  _macroRes    = _engine.addResolution(_macroN);
+  _engine.invalidate();
 }
 
 void AdvancedAudioProcessor::setupFrequencyBands() {
@@ -129,6 +144,10 @@ void AdvancedAudioProcessor::setupFrequencyBands() {
   // Harmonic bands: Musical resolution 80Hz-18kHz (32 bands)
   _harmonicBands.resize(32);
   setupHarmonicFrequencyMapping();
+  _hpssHarm.assign(_harmonicN/2 + 1, 0.0f);
+  _hpssPerc.assign(_harmonicN/2 + 1, 0.0f);
+  _hpss.configure(_harmonicN/2 + 1, float(_sr) / _harmonicN, 2.0 * kBaseHop / _sr);   // harmonic stage hop
+  _hpss.reset();
 
   // Percussive bands: Transient detection (8 broad bands)
   _percBands.resize(8);
@@ -214,31 +233,8 @@ void AdvancedAudioProcessor::setupMacroFrequencyMapping() {
 }
 
 void AdvancedAudioProcessor::setupChromagramMapping() {
-  // Map harmonic spectrum to 12 pitch classes
-  _chromaKLo.resize(12);
-  _chromaKHi.resize(12);
-  
-  // A4 = 440Hz, 12-tone equal temperament
-  const float A4 = 440.0f;
-  
-  for (int i = 0; i < 12; ++i) {
-    // Collect all octaves of this pitch class
-    _chromaKLo[i] = _harmonicN/2; // Will find minimum
-    _chromaKHi[i] = 1;            // Will find maximum
-    
-    // Check multiple octaves
-    for (int octave = 1; octave <= 7; ++octave) {
-      float semitone = i - 9; // A=0, so C=-9, C#=-8, etc.
-      float freq = A4 * std::pow(2.0f, octave + semitone/12.0f);
-      if (freq > _sr/2) break;
-      
-      int k = int(freq * _harmonicN / _sr);
-      if (k >= 1 && k < _harmonicN/2) {
-        _chromaKLo[i] = std::min(_chromaKLo[i], k);
-        _chromaKHi[i] = std::max(_chromaKHi[i], k + 2); // Include nearby bins
-      }
-    }
-  }
+  // Map harmonic spectrum to 12 pitch classes: one small bin range per octave
+  _chromaMap.build(_sr, _harmonicN);
 }
 
 void AdvancedAudioProcessor::setupOnsetDetection() {
@@ -246,7 +242,6 @@ void AdvancedAudioProcessor::setupOnsetDetection() {
   _prevSpecFlux.assign(4, 0.0f); // Track flux for different frequency bands
   _onsetStrength.assign(4, 0.0f);
   _prevPercMagnitudes.assign(_percN/2 + 1, 0.0f);
-  _prevHarmonicMagnitudes.assign(_harmonicN/2 + 1, 0.0f);
   
   // Onset detection parameters
   _fluxThreshold = 0.1f;
@@ -255,184 +250,169 @@ void AdvancedAudioProcessor::setupOnsetDetection() {
 }
 
 void AdvancedAudioProcessor::setupRhythmTracking() {
-  // Simple beat tracking setup
-  _beatHistory.assign(64, 0.0f); // 64 frames of beat strength
+  // trackRhythm runs once per base hop
+  _tempo.configure(double(_sr) / double(kBaseHop), 60.0, 200.0);
   _beatPhase = 0.0f;
-  _beatPeriod = 120.0f; // BPM estimate
+  _beatPeriod = float(_tempo.periodHops());
+  _beatBpm = float(_tempo.bpm());
   _beatConfidence = 0.0f;
+  _isBeat = false;
 }
 
-void AdvancedAudioProcessor::processMultiResolution() {
-  initialize();
-  if (!_initialized) return;
+void AdvancedAudioProcessor::setupStages() {
+  // Same cadence as before (percussive every hop ... macro every 8th), but
+  // declared per stage so the schedule below can spread them out
+  _stages = {
+    { "percussive", _percN,     kBaseHop,     &AdvancedAudioProcessor::analyzePercussive },
+    { "harmonic",   _harmonicN, 2 * kBaseHop, &AdvancedAudioProcessor::analyzeHarmonic },
+    { "bass",       _bassN,     4 * kBaseHop, &AdvancedAudioProcessor::analyzeBass },
+    { "macro",      _macroN,    8 * kBaseHop, &AdvancedAudioProcessor::analyzeMacro },
+  };
 
-  // Only process when we have enough samples for the largest analysis
-  while (!_stop.load() && _fifoL.size() >= _macroN && _fifoR.size() >= _macroN) {
-    
-    // 1. PERCUSSIVE ANALYSIS (highest time resolution)
-    if (_frameCount % 1 == 0) { // Every frame
-      analyzePercussive();
-    }
-    
-    // 2. HARMONIC ANALYSIS (medium resolution)
-    if (_frameCount % 2 == 0) { // Every 2nd frame
-      analyzeHarmonic();
-    }
-    
-    // 3. BASS ANALYSIS (high frequency resolution)
-    if (_frameCount % 4 == 0) { // Every 4th frame
-      analyzeBass();
+  int period = 1;
+  for (Stage& st : _stages) {
+    st.every = std::max(1, st.hop / kBaseHop);
+    st.cost = double(st.n) * std::log2(double(st.n));
+    period = std::lcm(period, st.every);
+  }
+  _due.reserve(_stages.size());
+
+  // Greedy, most expensive first: pick the offset whose slots end up with the
+  // lowest peak load over one period (ties: the lighter slot).
+  std::vector<Stage*> order;
+  for (Stage& st : _stages) order.push_back(&st);
+  std::stable_sort(order.begin(), order.end(),
+                   [](const Stage* a, const Stage* b) { return a->cost > b->cost; });
+
+  std::vector<double> load(size_t(period), 0.0);
+  for (Stage* st : order) {
+    int bestOffset = 0;
+    double bestPeak = 0.0, bestBase = 0.0;
+    for (int o = 0; o < st->every; ++o) {
+      double peak = 0.0, base = 0.0;
+      for (int slot = o; slot < period; slot += st->every) {
+        peak = std::max(peak, load[slot] + st->cost);
+        base += load[slot];
+      }
+      if (o == 0 || peak < bestPeak || (peak == bestPeak && base < bestBase)) {
+        bestOffset = o; bestPeak = peak; bestBase = base;
+      }
     }
-    
-    // 4. MACRO ANALYSIS (long-term features)
-    if (_frameCount % 8 == 0) { // Every 8th frame
-      analyzeMacro();
+    st->offset = bestOffset;
+    for (int slot = bestOffset; slot < period; slot += st->every) load[slot] += st->cost;
+  }
+}
+
+template <typename Fn>
+void AdvancedAudioProcessor::timed(StageTiming& t, Fn&& fn) {
+  if (!_timeStages) { fn(); return; }
+  const int64_t t0 = monotonicNs();
+  fn();
+  t.totalNs += monotonicNs() - t0;
+  ++t.runs;
+}
+
+std::vector<AdvancedAudioProcessor::StageTiming> AdvancedAudioProcessor::stageTimings() const {
+  std::vector<StageTiming> out;
+  for (const Stage& st : _stages) out.push_back(st.timing);
+  for (const StageTiming& t : _hopTiming) out.push_back(t);
+  return out;
+}
+
+void AdvancedAudioProcessor::resetStageTimings() {
+  for (Stage& st : _stages) st.timing = StageTiming{st.name};
+  for (StageTiming& t : _hopTiming) t = StageTiming{t.name};
+}
+
+void AdvancedAudioProcessor::runStages() {
+  _due.clear();
+  for (Stage& st : _stages) {
+    if (_history < st.n) continue;                    // window still filling
+    if (_frameCount % st.every != st.offset) continue; // not this stage's slot
+    _due.push_back(&st);
+  }
+  // Each task only touches its own Stage (timing included)
+  _pool.run(int(_due.size()), [this](int i) {
+    Stage& st = *_due[i];
+    timed(st.timing, [&] { (this->*st.run)(); });
+  });
+}
+
+void AdvancedAudioProcessor::processMultiResolution() {
+  // One pass per base hop of fresh audio. The window keeps at most _macroN
+  // samples of history, so stages run as soon as their own N is available.
+  while (!_stop.load() && _winL.size() - _history >= kBaseHop && _winR.size() - _history >= kBaseHop) {
+    const int64_t t0 = monotonicNs();
+    _history += kBaseHop;
+    _position += kBaseHop;
+    if (_history > _macroN) {
+      // Slide windows (index move, no memmove)
+      _winL.advance(_history - _macroN);
+      _winR.advance(_history - _macroN);
+      _history = _macroN;
     }
-    
-    // 5. MUSICAL FEATURE EXTRACTION
-    extractMusicalFeatures();
-    
-    // 6. ONSET AND RHYTHM DETECTION
-    detectOnsets();
-    trackRhythm();
-    
+
+    // 1-4. TRANSFORM STAGES (percussive / harmonic / bass / macro, staggered)
+    runStages();
+
+    // 5. MUSICAL FEATURES (harmonic spectrum) || 6. ONSETS + RHYTHM (percussive spectrum)
+    _pool.run(2, [this](int task) {
+      if (task == 0) {
+        timed(_hopTiming[kFeaturesTiming], [this] { extractMusicalFeatures(); });
+      } else {
+        timed(_hopTiming[kOnsetTiming], [this] { detectOnsets(); trackRhythm(); });
+      }
+    });
+
     // 7. EMIT ALL RESULTS
-    emitAdvancedResults();
-    
-    // Advance FIFOs
-    int hop = _harmonicN / 4; // 256 samples hop
-    _fifoL.erase(_fifoL.begin(), _fifoL.begin() + hop);
-    _fifoR.erase(_fifoR.begin(), _fifoR.begin() + hop);
-    
+    timed(_hopTiming[kEmitTiming], [this] { emitAdvancedResults(); });
+
     _frameCount++;
+    _hops.add();
+    _hopSeconds.set(double(monotonicNs() - t0) * 1e-9);
   }
 }
 
+const SpectrumEngine::Spectrum& AdvancedAudioProcessor::spectrumFor(int res, int N) {
+  // The window holds _history samples ending with this hop; take the last N of
+  // them so short and long transforms are time-aligned.
+  const int offset = _history - N;
+  return _engine.compute(res, _winL.peek(_history) + offset, _winR.peek(_history) + offset, _position);
+}
+
+void AdvancedAudioProcessor::sumBands(const SpectrumEngine::Spectrum& s, const std::vector<int>& kLo,
+                                      const std::vector<int>& kHi, std::vector<float>& bands) {
+  for (size_t b = 0; b < bands.size(); ++b)
+    bands[b] = kHi[b] > kLo[b] ? float(s.mags.magSum(kLo[b], kHi[b])) : 0.0f;
+}
+
 void AdvancedAudioProcessor::analyzePercussive() {
-  // Copy and window percussive frame
-  std::memcpy(_percFrameL.data(), _fifoL.data(), _percN * sizeof(float));
-  std::memcpy(_percFrameR.data(), _fifoR.data(), _percN * sizeof(float));
-  
-  applyDCRemoval(_percFrameL);
-  applyDCRemoval(_percFrameR);
-  
-  for (int i = 0; i < _percN; ++i) {
-    _percFrameL[i] *= _percWindow[i];
-    _percFrameR[i] *= _percWindow[i];
-  }
-  
-  // FFT
-  kiss_fftr(_percCfg, _percFrameL.data(), _percSpecL.data());
-  kiss_fftr(_percCfg, _percFrameR.data(), _percSpecR.data());
-  
   // Compute percussive bands (sum both channels)
-  for (int b = 0; b < 8; ++b) {
-    float sum = 0.0f;
-    for (int k = _percKLo[b]; k < _percKHi[b]; ++k) {
-      sum += std::hypot(_percSpecL[k].r, _percSpecL[k].i);
-      sum += std::hypot(_percSpecR[k].r, _percSpecR[k].i);
-    }
-    _percBands[b] = sum * 0.5f; // Average L/R
-  }
+  sumBands(spectrumFor(_percRes, _percN), _percKLo, _percKHi, _percBands);
 }
 
 void AdvancedAudioProcessor::analyzeHarmonic() {
-  // Copy and window harmonic frame  
-  std::memcpy(_harmonicFrameL.data(), _fifoL.data(), _harmonicN * sizeof(float));
-  std::memcpy(_harmonicFrameR.data(), _fifoR.data(), _harmonicN * sizeof(float));
-  
-  applyDCRemoval(_harmonicFrameL);
-  applyDCRemoval(_harmonicFrameR);
-  
-  for (int i = 0; i < _harmonicN; ++i) {
-    _harmonicFrameL[i] *= _harmonicWindow[i];
-    _harmonicFrameR[i] *= _harmonicWindow[i];
-  }
-  
-  // FFT
-  kiss_fftr(_harmonicCfg, _harmonicFrameL.data(), _harmonicSpecL.data());
-  kiss_fftr(_harmonicCfg, _harmonicFrameR.data(), _harmonicSpecR.data());
-  
   // Compute harmonic bands
-  for (int b = 0; b < 32; ++b) {
-    float sum = 0.0f;
-    for (int k = _harmonicKLo[b]; k < _harmonicKHi[b]; ++k) {
-      sum += std::hypot(_harmonicSpecL[k].r, _harmonicSpecL[k].i);
-      sum += std::hypot(_harmonicSpecR[k].r, _harmonicSpecR[k].i);
-    }
-    _harmonicBands[b] = sum * 0.5f;
-  }
+  const SpectrumEngine::Spectrum& s = spectrumFor(_harmonicRes, _harmonicN);
+  sumBands(s, _harmonicKLo, _harmonicKHi, _harmonicBands);
+  // HPSS once per harmonic hop (its time medians count these hops)
+  _hpss.process(s.mags.mag(), _hpssHarm.data(), _hpssPerc.data());
 }
 
 void AdvancedAudioProcessor::analyzeBass() {
-  // Copy and window bass frame
-  std::memcpy(_bassFrameL.data(), _fifoL.data(), _bassN * sizeof(float));
-  std::memcpy(_bassFrameR.data(), _fifoR.data(), _bassN * sizeof(float));
-  
-  applyDCRemoval(_bassFrameL);
-  applyDCRemoval(_bassFrameR);
-  
-  for (int i = 0; i < _bassN; ++i) {
-    _bassFrameL[i] *= _bassWindow[i];
-    _bassFrameR[i] *= _bassWindow[i];
-  }
-  
-  // FFT
-  kiss_fftr(_bassCfg, _bassFrameL.data(), _bassSpecL.data());
-  kiss_fftr(_bassCfg, _bassFrameR.data(), _bassSpecR.data());
-  
   // Compute ultra-high resolution bass bands
-  for (int b = 0; b < 16; ++b) {
-    float sum = 0.0f;
-    for (int k = _bassKLo[b]; k < _bassKHi[b]; ++k) {
-      sum += std::hypot(_bassSpecL[k].r, _bassSpecL[k].i);
-      sum += std::hypot(_bassSpecR[k].r, _bassSpecR[k].i);
-    }
-    _bassBands[b] = sum * 0.5f;
-  }
+  sumBands(spectrumFor(_bassRes, _bassN), _bassKLo, _bassKHi, _bassBands);
 }
 
 void AdvancedAudioProcessor::analyzeMacro() {
-  // Copy and window macro frame
-  std::memcpy(_macroFrameL.data(), _fifoL.data(), _macroN * sizeof(float));
-  std::memcpy(_macroFrameR.data(), _fifoR.data(), _macroN * sizeof(float));
-  
-  applyDCRemoval(_macroFrameL);
-  applyDCRemoval(_macroFrameR);
-  
-  for (int i = 0; i < _macroN; ++i) {
-    _macroFrameL[i] *= _macroWindow[i];
-    _macroFrameR[i] *= _macroWindow[i];
-  }
-  
-  // FFT
-  kiss_fftr(_macroCfg, _macroFrameL.data(), _macroSpecL.data());
-  kiss_fftr(_macroCfg, _macroFrameR.data(), _macroSpecR.data());
-  
   // Compute macro bands for long-term evolution
-  for (int b = 0; b < 12; ++b) {
-    float sum = 0.0f;
-    for (int k = _macroKLo[b]; k < _macroKHi[b]; ++k) {
-      sum += std::hypot(_macroSpecL[k].r, _macroSpecL[k].i);
-      sum += std::hypot(_macroSpecR[k].r, _macroSpecR[k].i);
-    }
-    _macroBands[b] = sum * 0.5f;
-  }
+  sumBands(spectrumFor(_macroRes, _macroN), _macroKLo, _macroKHi, _macroBands);
 }
 
 void AdvancedAudioProcessor::extractMusicalFeatures() {
   // 1. CHROMAGRAM - Map harmonic content to 12 pitch classes
-  std::fill(_chromagram.begin(), _chromagram.end(), 0.0f);
-  
-  for (int c = 0; c < 12; ++c) {
-    for (int k = _chromaKLo[c]; k < _chromaKHi[c]; ++k) {
-      if (k < _harmonicSpecL.size()) {
-        _chromagram[c] += std::hypot(_harmonicSpecL[k].r, _harmonicSpecL[k].i);
-        _chromagram[c] += std::hypot(_harmonicSpecR[k].r, _harmonicSpecR[k].i);
-      }
-    }
-    _chromagram[c] *= 0.5f; // Average L/R
-  }
+  // (range sums on the last harmonic spectrum's cache; no pass over the bins)
+  _chromaMap.fold(_engine.spectrum(_harmonicRes).mags, _chromagram.data());
   
   // 2. SPECTRAL FEATURES
   computeSpectralFeatures();
@@ -442,50 +422,20 @@ void AdvancedAudioProcessor::extractMusicalFeatures() {
 }
 
 void AdvancedAudioProcessor::computeSpectralFeatures() {
-  // Spectral Centroid (brightness)
-  float weightedSum = 0.0f;
-  float magnitudeSum = 0.0f;
-  
-  for (int k = 1; k < _harmonicN/2; ++k) {
-    float freq = float(k) * _sr / _harmonicN;
-    float magL = std::hypot(_harmonicSpecL[k].r, _harmonicSpecL[k].i);
-    float magR = std::hypot(_harmonicSpecR[k].r, _harmonicSpecR[k].i);
-    float mag = (magL + magR) * 0.5f;
-    
-    weightedSum += freq * mag;
-    magnitudeSum += mag;
-  }
-  
-  _spectralCentroid = (magnitudeSum > 0) ? weightedSum / magnitudeSum : 0.0f;
-  
-  // Spectral Rolloff (90% of energy cutoff)
-  float energySum = 0.0f;
-  for (int k = 1; k < _harmonicN/2; ++k) {
-    float magL = std::hypot(_harmonicSpecL[k].r, _harmonicSpecL[k].i);
-    float magR = std::hypot(_harmonicSpecR[k].r, _harmonicSpecR[k].i);
-    energySum += (magL + magR) * 0.5f;
-  }
-  
-  float targetEnergy = energySum * 0.9f;
-  float runningEnergy = 0.0f;
-  _spectralRolloff = 0.0f;
-  
-  for (int k = 1; k < _harmonicN/2; ++k) {
-    float magL = std::hypot(_harmonicSpecL[k].r, _harmonicSpecL[k].i);
-    float magR = std::hypot(_harmonicSpecR[k].r, _harmonicSpecR[k].i);
-    runningEnergy += (magL + magR) * 0.5f;
-    
-    if (runningEnergy >= targetEnergy) {
-      _spectralRolloff = float(k) * _sr / _harmonicN;
-      break;
-    }
-  }
+  const SpectrumEngine::Spectrum& h = _engine.spectrum(_harmonicRes);
+
+  // Centroid (brightness), rolloff (90% of the magnitude, binary search) and
+  // flatness: reads from the prefix sums, bins 1 .. N/2-1
+  const MagnitudeCache& m = h.mags;
+  _spectralCentroid = m.centroidHz(1, _harmonicN/2);
+  _spectralRolloff = m.rolloffHz(0.9f, 1, _harmonicN/2);
+  _spectralFlatness = m.flatness(1, _harmonicN/2);
   
   // Zero Crossing Rate (on time domain)
   int crossings = 0;
   for (int n = 1; n < _harmonicN; ++n) {
-    if ((_harmonicFrameL[n-1] >= 0) != (_harmonicFrameL[n] >= 0) ||
-        (_harmonicFrameR[n-1] >= 0) != (_harmonicFrameR[n] >= 0)) {
+    if ((h.frameL[n-1] >= 0) != (h.frameL[n] >= 0) ||
+        (h.frameR[n-1] >= 0) != (h.frameR[n] >= 0)) {
       crossings++;
     }
   }
@@ -493,25 +443,24 @@ void AdvancedAudioProcessor::computeSpectralFeatures() {
 }
 
 void AdvancedAudioProcessor::computeHarmonicPercussiveRatio() {
-  // Simple ratio of harmonic vs percussive energy
-  float harmonicEnergy = std::accumulate(_harmonicBands.begin(), _harmonicBands.end(), 0.0f);
-  float percussiveEnergy = std::accumulate(_percBands.begin(), _percBands.end(), 0.0f);
-  
+  // Energy of the median-filtered harmonic vs percussive parts (last harmonic hop)
+  const float harmonicEnergy = _hpss.harmonicEnergy();
+  const float percussiveEnergy = _hpss.percussiveEnergy();
   _harmonicPercussiveRatio = (percussiveEnergy > 0) ? harmonicEnergy / percussiveEnergy : 1.0f;
 }
 
 void AdvancedAudioProcessor::detectOnsets() {
   if (_onsetTimer > 0) _onsetTimer--;
   
-  // Spectral Flux calculation for onset detection
+  // Spectral Flux calculation for onset detection (percussive spectrum, cached magnitudes)
+  const float* mag = _engine.spectrum(_percRes).mags.mag();   // (|L|+|R|)/2
   float totalFlux = 0.0f;
   
   // High-frequency flux (good for detecting hi-hats, cymbals)
   float hfFlux = 0.0f;
   for (int k = _percN/4; k < _percN/2; ++k) { // Upper half of spectrum
-    float currentMag = std::hypot(_percSpecL[k].r, _percSpecL[k].i) + 
-                       std::hypot(_percSpecR[k].r, _percSpecR[k].i);
-    float prevMag = (k < _prevPercMagnitudes.size()) ? _prevPercMagnitudes[k] : 0.0f;
+    float currentMag = 2.0f * mag[k];
+    float prevMag = _prevPercMagnitudes[k];
     float diff = currentMag - prevMag;
     if (diff > 0) hfFlux += diff; // Only positive differences
   }
@@ -519,9 +468,8 @@ void AdvancedAudioProcessor::detectOnsets() {
   // Low-frequency flux (good for kicks, bass)
   float lfFlux = 0.0f;
   for (int k = 1; k < _percN/8; ++k) { // Lower portion of spectrum
-    float currentMag = std::hypot(_percSpecL[k].r, _percSpecL[k].i) + 
-                       std::hypot(_percSpecR[k].r, _percSpecR[k].i);
-    float prevMag = (k < _prevPercMagnitudes.size()) ? _prevPercMagnitudes[k] : 0.0f;
+    float currentMag = 2.0f * mag[k];
+    float prevMag = _prevPercMagnitudes[k];
     float diff = currentMag - prevMag;
     if (diff > 0) lfFlux += diff;
   }
@@ -529,10 +477,8 @@ void AdvancedAudioProcessor::detectOnsets() {
   totalFlux = hfFlux + lfFlux;
   
   // Update previous magnitudes
-  _prevPercMagnitudes.resize(_percN/2 + 1);
   for (int k = 0; k < _percN/2 + 1; ++k) {
-    _prevPercMagnitudes[k] = std::hypot(_percSpecL[k].r, _percSpecL[k].i) + 
-                             std::hypot(_percSpecR[k].r, _percSpecR[k].i);
+    _prevPercMagnitudes[k] = 2.0f * mag[k];
   }
   
   // Store flux values
@@ -550,43 +496,13 @@ void AdvancedAudioProcessor::detectOnsets() {
 }
 
 void AdvancedAudioProcessor::trackRhythm() {
-  // Simple beat tracking using onset strength
-  float currentBeat = _onsetStrength[0] + _onsetStrength[2]; // Total + bass emphasis
-  
-  // Update beat history (circular buffer)
-  static int beatIndex = 0;
-  _beatHistory[beatIndex] = currentBeat;
-  beatIndex = (beatIndex + 1) % _beatHistory.size();
-  
-  // Simple tempo estimation (very basic)
-  // Look for peaks in autocorrelation of beat history
-  float maxCorr = 0.0f;
-  int bestPeriod = 30; // Default ~120 BPM at current frame rate
-  
-  for (int period = 20; period < 60; ++period) { // 60-200 BPM range
-    float corr = 0.0f;
-    for (int i = 0; i < _beatHistory.size() - period; ++i) {
-      corr += _beatHistory[i] * _beatHistory[i + period];
-    }
-    if (corr > maxCorr) {
-      maxCorr = corr;
-      bestPeriod = period;
-    }
-  }
-  
-  // Update beat tracking
-  _beatPeriod = bestPeriod;
-  _beatPhase = fmod(_beatPhase + 1.0f, _beatPeriod);
-  _beatConfidence = maxCorr / (_beatHistory.size() * 0.1f); // Normalize roughly
-  _beatConfidence = std::clamp(_beatConfidence, 0.0f, 1.0f);
-}
-
-void AdvancedAudioProcessor::applyDCRemoval(std::vector<float>& frame) {
-  // Simple DC removal: subtract the mean
-  float mean = std::accumulate(frame.begin(), frame.end(), 0.0f) / frame.size();
-  for (float &sample : frame) {
-    sample -= mean;
-  }
+  // Total + bass-emphasis flux drives the tempo tracker; it keeps its own
+  // history and only redoes the autocorrelation every few hops
+  _isBeat = _tempo.process(_onsetStrength[0] + _onsetStrength[2]);
+  _beatPeriod = float(_tempo.periodHops());
+  _beatPhase = float(_tempo.phase() * _tempo.periodHops());
+  _beatBpm = float(_tempo.bpm());
+  _beatConfidence = float(_tempo.confidence());
 }
 
 void AdvancedAudioProcessor::emitAdvancedResults() {
@@ -627,10 +543,13 @@ void AdvancedAudioProcessor::emitAdvancedResults() {
   data.spectralCentroid = _spectralCentroid;
   data.spectralRolloff = _spectralRolloff;
   data.zeroCrossingRate = _zeroCrossingRate;
+  data.spectralFlatness = _spectralFlatness;
   data.harmonicPercussiveRatio = _harmonicPercussiveRatio;
   data.beatPhase = _beatPhase;
   data.beatPeriod = _beatPeriod;
   data.beatConfidence = _beatConfidence;
+  data.beatBpm = _beatBpm;
+  data.isBeat = _isBeat;
   data.frameCount = _frameCount;
   
   emit multiResolutionAnalysisReady(data);
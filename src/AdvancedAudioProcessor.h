@@ -3,10 +3,15 @@
 #include <QVector>
 #include <atomic>
 #include <vector>
+#include "StereoRingBuffer.h"
+#include "CircularBuffer.h"
+#include "SpectrumEngine.h"
+#include "TempoTracker.h"
+#include "HpssProcessor.h"
+#include "DspWorkerPool.h"
+#include "Metrics.h"
 
-extern "C" {
-  #include "kiss_fftr.h"
-}
+class QTimer;
 
 // Comprehensive data structure for multi-resolution analysis
 struct MultiResolutionData {
@@ -20,12 +25,16 @@ struct MultiResolutionData {
   float spectralCentroid;                 // Brightness (Hz)
   float spectralRolloff;                  // 90% energy cutoff (Hz)
   float zeroCrossingRate;                 // Noisiness measure
-  float harmonicPercussiveRatio;          // Tonal vs rhythmic content
-  float beatPhase;                        // Current beat phase (0-1)
-  float beatPeriod;                       // Beat period (frames)
+  float spectralFlatness;                 // 0 tonal .. 1 noise-like
+  float harmonicPercussiveRatio;          // Tonal vs rhythmic energy (HPSS of the harmonic spectrum)
+  float beatPhase;                        // Hops since the last beat (0..beatPeriod)
+  float beatPeriod;                       // Beat period (hops)
   float beatConfidence;                   // Beat tracking confidence (0-1)
+  float beatBpm;                          // Tempo estimate (beats per minute)
+  bool isBeat;                            // A beat falls in this hop
   int frameCount;                         // Frame number
 };
+Q_DECLARE_METATYPE(MultiResolutionData)
 
 class AdvancedAudioProcessor : public QObject {
   Q_OBJECT
@@ -33,6 +42,9 @@ public:
   explicit AdvancedAudioProcessor(QObject* parent = nullptr);
   ~AdvancedAudioProcessor();
 
+  // Ring the capture callback writes into (attach with AudioCapture::attachRing).
+  StereoRingBuffer* inputRing() { return &_input; }
+
   // Configuration
   void setSampleRate(int sr) { 
     if (sr != _sr) {
@@ -41,10 +53,31 @@ public:
     }
   }
 
+  // Helper threads for the per-hop stages (0 = all on this thread, -1 = default:
+  // WLEDQT_DSP_THREADS or cores - 1, capped). Any thread; applied on the next drain.
+  // Results are identical for every setting.
+  void setWorkerThreads(int threads) { _requestedThreads.store(threads); }
+  int workerThreads() const { return _pool.threadCount(); }
+
+  // Optional per-stage wall time (off by default; read on the processing thread
+  // or after it stopped). Entries: the transform stages, then "features",
+  // "onsets+rhythm" and "emit".
+  struct StageTiming {
+    const char* name;
+    uint64_t runs = 0;
+    int64_t totalNs = 0;
+  };
+  void setStageTiming(bool on) { _timeStages = on; }
+  std::vector<StageTiming> stageTimings() const;
+  void resetStageTimings();
+
 public slots:
   void start();
+  // Any thread: only raises the flag. The teardown (engine plans, windows)
+  // runs on the analysis thread after the current drainInput, i.e. after
+  // _pool.run has returned; then stopped().
   void requestStop();
-  void onFrames(const QVector<float>& left, const QVector<float>& right);
+  void drainInput();                      // pull queued frames from the input ring
 
 signals:
   // Individual analysis outputs
@@ -82,82 +115,116 @@ private:
   static constexpr int _percN = 256;      // High time resolution (~5ms)
   static constexpr int _macroN = 8192;    // Long-term analysis (~170ms)
 
-  // Audio input buffers
-  std::vector<float> _fifoL;              // Left channel FIFO
-  std::vector<float> _fifoR;              // Right channel FIFO
+  // Audio input: SPSC ring from the capture callback, polled on this thread
+  StereoRingBuffer _input{1u << 15};
+  QTimer* _pollTimer = nullptr;
+  static constexpr int kPollIntervalMs = 2;
+
+  // Metrics (Metrics.h), written on this thread; the ring is probed
+  metrics::Counter _hops;
+  metrics::Gauge _hopSeconds;
+  metrics::ThreadCpu _cpu;
+
+  // Sliding analysis windows (mirrored: any N-frame is contiguous, slide = index move)
+  CircularBuffer _winL;                   // Left channel window (capacity 2 * _macroN)
+  CircularBuffer _winR;                   // Right channel window (capacity 2 * _macroN)
+
+  // === SHARED FFT ENGINE ===
+  // One plan/window/buffer set per size; every stage reads its spectra from here.
+  SpectrumEngine _engine;
+  int _bassRes = -1, _harmonicRes = -1, _percRes = -1, _macroRes = -1;
+  int64_t _position = 0;                  // absolute sample index the current hop ends at
+  int _history = 0;                       // window samples up to and including this hop (<= _macroN)
+
+  // Newest N samples of the window (right-aligned so all resolutions share "now")
+  const SpectrumEngine::Spectrum& spectrumFor(int res, int N);
+
+  // === STAGE SCHEDULE ===
+  // Each transform stage declares its window and hop; the hop is a multiple
+  // of the base hop (_percN). setupStages gives every stage a slot offset so the
+  // big transforms land on different base hops, and a stage only runs once the
+  // window holds N samples, so the short ones produce output from the start.
+  static constexpr int kBaseHop = _percN;
+  struct Stage {
+    const char* name;
+    int n;                                // window (samples)
+    int hop;                              // samples between runs (multiple of kBaseHop)
+    void (AdvancedAudioProcessor::*run)();
+    int every = 1;                        // hop / kBaseHop
+    int offset = 0;                       // base hop within `every` it runs on
+    double cost = 0.0;                    // relative, ~ N log2 N
+    StageTiming timing{name};             // filled when _timeStages is on
+  };
+  std::vector<Stage> _stages;
+  std::vector<Stage*> _due;               // stages due this hop (reserved, no per-hop allocation)
+  enum { kFeaturesTiming, kOnsetTiming, kEmitTiming, kHopTimings };
+  StageTiming _hopTiming[kHopTimings] = { {"features"}, {"onsets+rhythm"}, {"emit"} };
+  bool _timeStages = false;
+  template <typename Fn> void timed(StageTiming& t, Fn&& fn);
+  void setupStages();                     // declare stages + stagger their offsets
+  void runStages();                       // run the stages due on this base hop
+
+  // === PARALLEL EXECUTION ===
+  // Due stages run side by side (each has its own engine resolution and band
+  // vector), then features and onset/rhythm run as a second pair; both joins
+  // happen before emitAdvancedResults sees the hop.
+  DspWorkerPool _pool;
+  std::atomic<int> _requestedThreads{-1};
+  int _appliedRequest = -2;               // last value applyWorkerThreads acted on
+  void applyWorkerThreads();
 
   // === BASS ANALYSIS (Ultra-high frequency resolution) ===
-  kiss_fftr_cfg _bassCfg = nullptr;
-  std::vector<float> _bassFrameL;         // Bass analysis frame L
-  std::vector<float> _bassFrameR;         // Bass analysis frame R
-  std::vector<kiss_fft_cpx> _bassSpecL;   // Bass spectrum L
-  std::vector<kiss_fft_cpx> _bassSpecR;   // Bass spectrum R
-  std::vector<float> _bassWindow;         // Bass window function
   std::vector<int> _bassKLo, _bassKHi;    // Bass frequency bin ranges
   std::vector<float> _bassBands;          // 16 bass bands (20-400Hz)
 
   // === HARMONIC ANALYSIS (Musical resolution) ===
-  kiss_fftr_cfg _harmonicCfg = nullptr;
-  std::vector<float> _harmonicFrameL;     // Harmonic analysis frame L
-  std::vector<float> _harmonicFrameR;     // Harmonic analysis frame R  
-  std::vector<kiss_fft_cpx> _harmonicSpecL; // Harmonic spectrum L
-  std::vector<kiss_fft_cpx> _harmonicSpecR; // Harmonic spectrum R
-  std::vector<float> _harmonicWindow;     // Harmonic window function
   std::vector<int> _harmonicKLo, _harmonicKHi; // Harmonic frequency bin ranges
   std::vector<float> _harmonicBands;      // 32 harmonic bands (80Hz-18kHz)
+  HpssProcessor _hpss;                    // median-filter split of the harmonic spectrum
+  std::vector<float> _hpssHarm, _hpssPerc; // its two parts (_harmonicN/2+1)
 
   // === PERCUSSIVE ANALYSIS (High time resolution) ===
-  kiss_fftr_cfg _percCfg = nullptr;
-  std::vector<float> _percFrameL;         // Percussive analysis frame L
-  std::vector<float> _percFrameR;         // Percussive analysis frame R
-  std::vector<kiss_fft_cpx> _percSpecL;   // Percussive spectrum L
-  std::vector<kiss_fft_cpx> _percSpecR;   // Percussive spectrum R
-  std::vector<float> _percWindow;         // Percussive window function
   std::vector<int> _percKLo, _percKHi;    // Percussive frequency bin ranges
   std::vector<float> _percBands;          // 8 percussive bands
 
   // === MACRO ANALYSIS (Long-term features) ===
-  kiss_fftr_cfg _macroCfg = nullptr;
-  std::vector<float> _macroFrameL;        // Macro analysis frame L
-  std::vector<float> _macroFrameR;        // Macro analysis frame R
-  std::vector<kiss_fft_cpx> _macroSpecL;  // Macro spectrum L
-  std::vector<kiss_fft_cpx> _macroSpecR;  // Macro spectrum R
-  std::vector<float> _macroWindow;        // Macro window function
   std::vector<int> _macroKLo, _macroKHi;  // Macro frequency bin ranges
   std::vector<float> _macroBands;         // 12 macro bands
 
   // === MUSICAL FEATURE EXTRACTION ===
   std::vector<float> _chromagram;         // 12 pitch classes (C, C#, D, ...)
-  std::vector<int> _chromaKLo, _chromaKHi; // Chromagram frequency mappings
+  ChromaMap _chromaMap;                   // harmonic bins -> pitch classes, per octave
   float _spectralCentroid = 0.0f;         // Brightness measure
   float _spectralRolloff = 0.0f;          // 90% energy cutoff frequency  
+  float _spectralFlatness = 0.0f;         // Geometric / arithmetic mean of the magnitudes
   float _zeroCrossingRate = 0.0f;         // Zero crossing rate
-  float _harmonicPercussiveRatio = 0.0f;  // Harmonic vs percussive content
+  float _harmonicPercussiveRatio = 0.0f;  // Harmonic vs percussive energy (HPSS)
 
   // === ONSET DETECTION ===
   std::vector<float> _onsetStrength;      // Onset strength per band
   std::vector<float> _prevSpecFlux;       // Previous spectral flux
   std::vector<float> _prevPercMagnitudes; // Previous percussive magnitudes
-  std::vector<float> _prevHarmonicMagnitudes; // Previous harmonic magnitudes
   bool _isOnset = false;                  // Onset detected this frame
   float _fluxThreshold = 0.1f;            // Onset detection threshold
   int _onsetCooldown = 10;                // Frames between onsets
   int _onsetTimer = 0;                    // Cooldown timer
 
   // === RHYTHM TRACKING ===
-  std::vector<float> _beatHistory;        // Beat strength history
-  float _beatPhase = 0.0f;                // Current beat phase
-  float _beatPeriod = 120.0f;             // Estimated beat period (frames)
+  TempoTracker _tempo;                    // Novelty ring + FFT autocorrelation + beat PLL
+  float _beatPhase = 0.0f;                // Hops since the last beat
+  float _beatPeriod = 93.75f;             // Estimated beat period (hops)
+  float _beatBpm = 120.0f;                // Estimated tempo
+  bool _isBeat = false;                   // Beat in this hop
   float _beatConfidence = 0.0f;           // Beat tracking confidence
 
   // === CORE PROCESSING METHODS ===
   void initialize();                      // Main initialization
   void cleanup();                         // Resource cleanup
+  void finishStop();                      // analysis thread, queued by requestStop
   void processMultiResolution();          // Main processing loop
 
   // === SETUP METHODS ===
-  void setupBuffers();                    // Allocate all buffers
-  void setupWindows();                    // Create window functions
+  void setupBuffers();                    // Allocate all buffers and FFT resolutions
   void setupFrequencyBands();             // Setup all frequency mappings
   void setupBassFrequencyMapping();       // Bass band mapping (20-400Hz)
   void setupHarmonicFrequencyMapping();   // Harmonic band mapping (80Hz-18kHz)
@@ -181,6 +248,8 @@ private:
   void trackRhythm();                     // Beat tracking algorithm
 
   // === UTILITY METHODS ===
-  void applyDCRemoval(std::vector<float>& frame); // DC removal filter
+  // Sum of (|L|+|R|)/2 over [kLo, kHi) for each band (prefix sums of the spectrum's cache)
+  static void sumBands(const SpectrumEngine::Spectrum& s, const std::vector<int>& kLo,
+                       const std::vector<int>& kHi, std::vector<float>& bands);
   void emitAdvancedResults();             // Emit all analysis results
 };
\ No newline at end of file
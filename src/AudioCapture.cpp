@@ -1,28 +1,56 @@
 #include "AudioCapture.h"
+#include "StereoRingBuffer.h"
 #include <QString>
-#include <cstring>
-#include <algorithm>     // std::max
-#include "miniaudio.h"
+#include <algorithm>
+#include <cstdlib>
 
-AudioCapture::AudioCapture(QObject* parent) : QObject(parent) {}
+AudioCapture::AudioCapture(QObject* parent) : QObject(parent) {
+  if (const char* env = std::getenv("WLEDQT_CAPTURE")) _spec = QString::fromLocal8Bit(env);
+  bindMetrics();
+}
 
 AudioCapture::~AudioCapture() {
   cleanup();
 }
 
-void AudioCapture::cleanup() {
-  // It's safe to call ma_device_stop() even if not started, but guard anyway.
-  if (_dev) {
-    ma_device_stop(_dev);               // ok to call even if already stopped
-    ma_device_uninit(_dev);
-    delete _dev; _dev = nullptr;
+void AudioCapture::bindMetrics() {
+  const std::string l = _name.empty() ? std::string() : metrics::labels({{"capture", _name}});
+  _callbacks.bind("wledqt_capture_callbacks_total", l, "Blocks delivered by the capture source");
+  _frames.bind("wledqt_capture_frames_total", l, "Audio frames delivered by the capture source");
+  _driftGauge.bind("wledqt_capture_drift_ppm", l, "Capture clock against the steady clock, ppm (+ = device fast)");
+  _cpu.bind(_name.empty() ? "capture" : ("capture-" + _name).c_str());
+}
+
+void AudioCapture::setName(const std::string& name) {
+  if (_running.load() || name == _name) return;
+  _name = name;
+  bindMetrics();
+}
+
+bool AudioCapture::attachRing(StereoRingBuffer* ring, int left, int right) {
+  if (!ring || _numRings >= kMaxRings || _running.load()) return false;
+  if (left < 0 || right < 0 || left >= CaptureSpec::kMaxChannels || right >= CaptureSpec::kMaxChannels) return false;
+  _rings[_numRings++] = Route{ring, unsigned(left), unsigned(right)};
+  return true;
+}
+
+bool AudioCapture::detachRing(StereoRingBuffer* ring) {
+  if (_running.load()) return false;
+  for (int i = 0; i < _numRings; ++i) {
+    if (_rings[i].ring != ring) continue;
+    for (int j = i + 1; j < _numRings; ++j) _rings[j - 1] = _rings[j];
+    _rings[--_numRings] = Route{};
+    return true;
   }
-  if (_ctx) {
-    ma_context_uninit(_ctx);
-    delete _ctx; _ctx = nullptr;
+  return false;
+}
+
+void AudioCapture::cleanup() {
+  if (_source) {
+    _source->stop();
+    _source.reset();
   }
-  _scratchL.clear();
-  _scratchR.clear();
+  _cpu.clear();             // the callback thread is gone with the source
 }
 
 void AudioCapture::requestStop() {
@@ -37,143 +65,80 @@ void AudioCapture::start() {
   // Prevent double-start.
   if (_running.exchange(true)) { emit status("Audio already running"); return; }
 
-  // 1) Context
-  _ctx = new ma_context{};
-  if (ma_context_init(nullptr, 0, nullptr, _ctx) != MA_SUCCESS) {
-    emit status("miniaudio: context init failed");
+  auto fail = [this](const QString& msg) {
+    emit status(msg);
     _running.store(false);
     cleanup();
     emit stopped();
-    return;
+  };
+
+  CaptureSpec spec;
+  QString error;
+  if (!CaptureSpec::parse(_spec, spec, &error)) return fail(error);
+
+  _source = CaptureSource::create(spec);
+  if (!_source) return fail("capture: no source");
+
+  _frameCount = 0;
+  _driftGauge.set(0.0);
+  _drift.reset();
+  int sampleRate = 0, channels = 0;
+  QString info;
+  if (!_source->start(this, sampleRate, channels, info)) return fail(info);
+  _drift.setNominalRate(sampleRate);   // the callback may already be running
+
+  // A ring asking for a channel the source doesn't have would silently get the last one
+  for (int i = 0; i < _numRings; ++i) {
+    const unsigned need = std::max(_rings[i].left, _rings[i].right) + 1;
+    if (channels > 0 && need > unsigned(channels))
+      return fail(QString("capture: channel %1 requested, %2 has %3 (add ?ch=0 to open every input)")
+                    .arg(need).arg(_spec.isEmpty() ? "loopback" : _spec).arg(channels));
   }
 
-  // 2) Loopback device config
-  ma_device_config cfg = ma_device_config_init(ma_device_type_loopback);
-
-  // Inherit rate/channels, but force f32 so callback casting is safe.
-  cfg.sampleRate         = 0;                   // inherit device rate 48000, 44100 common
-  cfg.capture.channels   = 2;                   // inherit channel count or force to 2
-  cfg.capture.format     = ma_format_f32;       // force float32 to avoid ambiguity
-  cfg.capture.shareMode  = ma_share_mode_shared;
-
-  // WASAPI specifics: predictable behavior, avoid redundant SRC.
-  cfg.wasapi.noAutoConvertSRC      = MA_TRUE;
-  cfg.wasapi.noHardwareOffloading  = MA_TRUE;
-
-  // Performance / callback sizing (request, not guaranteed).
-  cfg.performanceProfile     = ma_performance_profile_low_latency;
-  cfg.periodSizeInFrames     = 480;     // ~10 ms @ 48 kHz (tune to taste)
-  cfg.periods                = 3;       // triple buffering
-  cfg.noFixedSizedCallback   = MA_FALSE; // prefer fixed-size callbacks
-
-  // Callbacks
-  // give miniaudio a pointer to this object and a function to call when a period is ready
-  cfg.dataCallback = &AudioCapture::dataCallback;
-  cfg.pUserData    = this;
-
-  // 3) Create and bind device to context and config, catch failures.
-  _dev = new ma_device{};
-  ma_result res = ma_device_init(_ctx, &cfg, _dev);
-  if (res != MA_SUCCESS) {
-    emit status("miniaudio: loopback device init failed");
-    _running.store(false);
-    cleanup();
-    emit stopped();
-    return;
-  }
-
-
-  // After ma_device_init(_ctx, &cfg, _dev) == MA_SUCCESS
-  const ma_uint32 sr       = _dev->sampleRate;             // actual sample rate
-  const ma_uint32 ch       = _dev->capture.channels;       // actual channels
-  const ma_format fmt      = _dev->capture.format;         // actual format
-  const ma_uint32 periodF  = cfg.periodSizeInFrames;     // actual period (frames)
-  const ma_uint32 periods  = cfg.periods;                  // actual periods (buffers)
-
-  QString info = QStringLiteral(
-    "Loopback actual: %1 Hz, %2 ch, fmt=%3 (period = %4 frames x %5)")
-    .arg(sr)
-    .arg(ch)
-    .arg(int(fmt))       // cast enum to int for printing
-    .arg(periodF)
-    .arg(periods);
-
   emit status(info);
-  emit deviceSampleRateChanged(static_cast<int>(sr));
-
-  // Preallocate scratch buffer for max expected frames per callback
-  // this gets written with each callbacks section of audio
-  ma_uint32 reserveFrames = cfg.periodSizeInFrames;
-  if (reserveFrames == 0) {
-    // Fallback: a safe upper bound for common WASAPI/ASIO/ALSA periods
-    // 2048 is plenty for 48 kHz with ~40 ms periods.
-    reserveFrames = 2048;
-  }
-  _scratchL.reserve(static_cast<int>(reserveFrames));
-  _scratchR.reserve(static_cast<int>(reserveFrames));
-
-  // 4) Start device catch failures to clear and return cleanly.
-  if (ma_device_start(_dev) != MA_SUCCESS) {
-    emit status("miniaudio: device start failed");
-    _running.store(false);
-    cleanup();
-    emit stopped();
-    return;
-  }
+  emit deviceSampleRateChanged(sampleRate);
 }
 
-static inline void zeroStereo(QVector<float>& L, QVector<float>& R, int frames) {
-  L.resize(frames); R.resize(frames);
-  std::fill(L.begin(), L.end(), 0.0f);
-  std::fill(R.begin(), R.end(), 0.0f);
+void AudioCapture::sourceFinished() {
+  // Called from inside the source's own timer; tear down after it returns
+  QMetaObject::invokeMethod(this, [this] {
+    if (_running.load()) emit status("Capture source finished");
+    requestStop();
+  }, Qt::QueuedConnection);
 }
 
-void AudioCapture::emitStereo(const float* interleaved, unsigned frames, unsigned channels)
+void AudioCapture::pushFrames(const float* interleaved, unsigned frames, unsigned channels, int64_t stampNs)
 {
   if (!_running.load()) return;
-
-  _scratchL.resize(int(frames));
-  _scratchR.resize(int(frames));
-
-  if (channels == 1) {
-    // Duplicate mono → L and R (fast path).
-    std::memcpy(_scratchL.data(), interleaved, sizeof(float)*frames);
-    std::memcpy(_scratchR.data(), interleaved, sizeof(float)*frames);
-  } else {
-    // Take first two channels as L/R. (For >2ch you can change policy later.)
-    const unsigned stride = channels;
-    const float* src = interleaved;
-    float* dstL = _scratchL.data();
-    float* dstR = _scratchR.data();
-
-    for (unsigned i = 0; i < frames; ++i, src += stride) {
-      dstL[i] = src[0];
-      dstR[i] = (channels >= 2) ? src[1] : src[0]; // safety net
-    }
+  _cpu.mark();
+  _callbacks.add();
+  _frames.add(frames);
+  stampNs = dejitter(frames, stampNs);
+  // Each consumer has its own SPSC ring; a full ring drops (and counts) on its own.
+  for (int i = 0; i < _numRings; ++i) {
+    const Route& r = _rings[i];
+    r.ring->writeInterleaved(interleaved, frames, channels, r.left, r.right);
+    r.ring->stamp(stampNs);
   }
-
-  emit framesReady(_scratchL, _scratchR); // queued to processing thread
 }
 
-
-// static audio thread callback
-// args(device that triggers callback, unused output buffer, input frames, number of frames)
-void AudioCapture::dataCallback(ma_device* dev, void* pOutput, const void* pInput, ma_uint32 frameCount) {
-  (void)pOutput; // capture-only
-  // retrieve "this" pointer from device user data
-  auto* self = static_cast<AudioCapture*>(dev ? dev->pUserData : nullptr);
-  if (!self || !self->_running.load() || frameCount == 0) return;
-
-  // We forced f32 above, so this cast is safe.
-  const ma_uint32 ch = (dev->capture.channels > 0) ? dev->capture.channels : 2;
-
-  if (pInput == nullptr) {
-    // Keep cadence stable on silence/glitch.
-    zeroStereo(self->_scratchL, self->_scratchR, int(frameCount));
-    emit self->framesReady(self->_scratchL, self->_scratchR);
-    return;
+void AudioCapture::pushSilence(unsigned frames, int64_t stampNs)
+{
+  if (!_running.load()) return;
+  _cpu.mark();
+  _callbacks.add();
+  _frames.add(frames);
+  stampNs = dejitter(frames, stampNs);
+  for (int i = 0; i < _numRings; ++i) {
+    _rings[i].ring->writeSilence(frames);
+    _rings[i].ring->stamp(stampNs);
   }
+}
 
-  const float* in = static_cast<const float*>(pInput);
-  self->emitStereo(in, frameCount, ch);
-}
\ No newline at end of file
+int64_t AudioCapture::dejitter(unsigned frames, int64_t stampNs)
+{
+  _frameCount += frames;
+  stampNs = _drift.update(_frameCount, stampNs);
+  if (_drift.settled()) _driftGauge.set(_drift.ppm());
+  return stampNs;
+}
@@ -2,54 +2,88 @@
 #include <QObject>
 #include <QVector>
 #include <QString>
+#include <array>
 #include <atomic>
-#include "miniaudio.h"
+#include <cstdint>
+#include <memory>
+#include "CaptureSource.h"
+#include "ClockDrift.h"
+#include "Metrics.h"
 
-// Forward-declare to avoid pulling in the full miniaudio header.
-struct ma_context;
-struct ma_device;
-//class QString;
+class StereoRingBuffer;
 
-class AudioCapture : public QObject {
+// Owns the active CaptureSource and fans its audio out to the processors'
+// rings. The source is chosen by a spec string (see CaptureSource.h): WASAPI
+// loopback by default, or WLEDQT_CAPTURE / setSourceSpec for a capture device,
+// a file or a network stream.
+//
+// Each ring takes its own channel pair, so one multichannel interface can
+// feed several processors (CaptureZone). The callback stamps are de-jittered
+// through a ClockDrift fit, which also reports the device's drift against the
+// steady clock (wledqt_capture_drift_ppm): stamps of different devices are
+// then comparable, which is what lines their zones up downstream.
+class AudioCapture : public QObject, public CaptureSink {
     Q_OBJECT
 public:
     explicit AudioCapture(QObject* parent = nullptr);
     ~AudioCapture();
 
+    // Register a consumer ring the callback writes into (up to kMaxRings),
+    // fed from source channels `left` / `right` (0-based; equal = mono).
+    // Call before start(); the list is read lock-free from the audio callback.
+    // start() fails if the source has fewer channels than a ring asks for.
+    bool attachRing(StereoRingBuffer* ring, int left = 0, int right = 1);
+    bool detachRing(StereoRingBuffer* ring);    // before start() too
+    static constexpr int kMaxRings = 4 + CaptureZone::kMaxZones;
+
+    // Metrics label for a capture besides the main one ("" = unlabelled, thread "capture")
+    void setName(const std::string& name);
+
+    QString sourceSpec() const { return _spec; }
+    double driftPpm() const { return _drift.ppm(); }     // any thread
+
 public slots:
     // state management
-    void start();        // create context, open WASAPI loopback, start stream
+    void start();        // open the configured source and start streaming
     void requestStop();  // stop & free everything
+    // Takes effect on the next start(); "" = loopback
+    void setSourceSpec(const QString& spec) { _spec = spec; }
 
 signals:
     // state management
     void status(const QString& msg);
     void stopped();
-    // ---- Active path: emit R and L frames to processor ----
-    void framesReady(const QVector<float>& left, const QVector<float>& right);
     void deviceSampleRateChanged(int sampleRate);
 
 private:
     // state management
     std::atomic<bool> _running{false};
     void cleanup();
-    // Audio callback (static because C API)
-    static void dataCallback(ma_device* dev, void* pOutput, const void* pInput, ma_uint32 frameCount);
-
-    void emitStereo(const float* interleaved, unsigned frames, unsigned channels);
-    // Mono downmix and emit
-    // void emitMono(const float* in, unsigned int frames, unsigned int channels);
-
-    ma_context* _ctx{nullptr};
-    ma_device*  _dev{nullptr};
-
-    // Reuse this buffer to avoid allocating every callback
-    // Preallocated memory to use each callback
-    QVector<float> _scratchL;
-    QVector<float> _scratchR;
-    //QVector<float> _scratchMono; // if you want mono output
 
+    // CaptureSink: de-interleave straight into every attached ring (no allocation, no signals).
+    void pushFrames(const float* interleaved, unsigned frames, unsigned channels, int64_t stampNs) override;
+    void pushSilence(unsigned frames, int64_t stampNs) override;
+    void sourceFinished() override;
+    // Frame count + ClockDrift: the stamp the rings get
+    int64_t dejitter(unsigned frames, int64_t stampNs);
 
+    QString _spec;
+    std::unique_ptr<CaptureSource> _source;
 
+    // Consumer rings (owned by the processors) and their channels, fixed before start().
+    struct Route {
+        StereoRingBuffer* ring = nullptr;
+        unsigned left = 0, right = 1;
+    };
+    std::array<Route, kMaxRings> _rings{};
+    int _numRings = 0;
 
+    // Written from the audio callback (one source at a time)
+    uint64_t _frameCount = 0;
+    ClockDrift _drift;
+    std::string _name;
+    metrics::Counter _callbacks, _frames;
+    metrics::Gauge _driftGauge;
+    metrics::ThreadCpu _cpu;
+    void bindMetrics();
 };
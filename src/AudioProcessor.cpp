@@ -3,60 +3,197 @@
 #include <cstring>
 #include <algorithm>
 #include <QDebug>
-
-AudioProcessor::AudioProcessor(QObject* parent) : QObject(parent) {}
+#include <QTimer>
+#include <QMetaMethod>
+
+AudioProcessor::AudioProcessor(QObject* parent)
+  : QObject(parent), _framePool(SpectrumFramePool::create(kFramePoolSize)) {
+  // Scratch for the largest N up front: config swaps only resize within capacity
+  _frameL.reserve(kMaxFft);  _frameR.reserve(kMaxFft);
+  _specL.reserve(kMaxFft / 2 + 1);  _specR.reserve(kMaxFft / 2 + 1);
+  _magL.reserve(kMaxFft / 2 + 1);   _magR.reserve(kMaxFft / 2 + 1);
+  _bandsL.reserve(SpectrumFrame::kMaxBands);  _bandsR.reserve(SpectrumFrame::kMaxBands);
+  _levelL.reserve(SpectrumFrame::kMaxBands);  _levelR.reserve(SpectrumFrame::kMaxBands);
+  _mags.reserve(kMaxFft / 2 + 1);
+  _harmMag.reserve(kMaxFft / 2 + 1);  _percMag.reserve(kMaxFft / 2 + 1);
+  _harmBands.reserve(SpectrumFrame::kMaxBands);  _percBands.reserve(SpectrumFrame::kMaxBands);
+  _harmLevel.reserve(SpectrumFrame::kMaxBands);  _percLevel.reserve(SpectrumFrame::kMaxBands);
+  _hpss.reserve(kMaxFft / 2 + 1);
+  _dynamics.reserve(SpectrumFrame::kMaxBands);
+  _srMapper.reserve(SpectrumFrame::kMaxBands);
+  _winL.reserve(2 * kMaxFft);  _winR.reserve(2 * kMaxFft);
+  bindMetrics();
+}
 
 AudioProcessor::~AudioProcessor() {
+  metrics::removeProbes(this);
   cleanup();
+  _framePool->close();   // frames still queued elsewhere keep the pool alive
+}
+
+void AudioProcessor::setZone(const std::string& zone, const std::string& cpuThread) {
+  _zone = zone;
+  _cpuThread = cpuThread;
+  bindMetrics();
+}
+
+void AudioProcessor::bindMetrics() {
+  metrics::removeProbes(this);
+  const std::string zone = _zone.empty() ? std::string() : metrics::labels({{"zone", _zone}});
+  const std::string dsp = _zone.empty() ? metrics::labels({{"ring", "dsp"}})
+                                        : metrics::labels({{"ring", "dsp"}, {"zone", _zone}});
+  _hops.bind("wledqt_dsp_hops_total", zone, "Analysis hops processed");
+  _framesOut.bind("wledqt_dsp_frames_total", zone, "Frames handed to the consumers");
+  _hopSeconds.bind("wledqt_dsp_hop_seconds", zone, "Wall time of the last hop");
+  _hopCostSeconds.bind("wledqt_dsp_hop_cost_seconds", zone, "Smoothed wall time per hop");
+  if (_cpuThread.empty()) _cpu.release();
+  else _cpu.bind(_cpuThread.c_str());
+
+  // Read on the metrics thread: the ring's and the pool's own atomics
+  const StereoRingBuffer* ring = &_input;
+  metrics::addProbe(this, "wledqt_ring_overruns_total", dsp, "Capture writes that did not fit the ring",
+                    metrics::Kind::Counter, [ring] { return double(ring->overruns()); });
+  metrics::addProbe(this, "wledqt_ring_dropped_frames_total", dsp, "Frames lost to ring overruns",
+                    metrics::Kind::Counter, [ring] { return double(ring->droppedFrames()); });
+  metrics::addProbe(this, "wledqt_ring_fill_frames", dsp, "Frames waiting in the ring",
+                    metrics::Kind::Gauge, [ring] { return double(ring->framesWritten() - ring->framesRead()); });
+  const SpectrumFramePool* pool = _framePool;
+  metrics::addProbe(this, "wledqt_frames_in_flight", zone, "Pooled frames still held by consumers",
+                    metrics::Kind::Gauge, [pool] { return double(pool->inUse()); });
+  metrics::addProbe(this, "wledqt_frames_pool_exhausted_total", zone, "Hops dropped because every frame was in use",
+                    metrics::Kind::Counter, [pool] { return double(pool->exhausted()); });
 }
 
 void AudioProcessor::cleanup() {
-  if (_cfg) { 
-    kiss_fftr_free(_cfg); 
-    _cfg = nullptr; 
-  }
-  _fifoL.clear(); 
-  _fifoR.clear();
+  _winL.clear();
+  _winR.clear();
 }
 
 void AudioProcessor::requestStop() {
   if (!_running.exchange(false)) return;
+  QMetaObject::invokeMethod(this, [this] { finishStop(); }, Qt::QueuedConnection);
+}
+
+void AudioProcessor::finishStop() {
+  if (_running.load()) return;   // restarted before this got to run
+  if (_pollTimer) _pollTimer->stop();
   cleanup();
+  _cpu.clear();
   emit stopped();
 }
 
 void AudioProcessor::start() {
   // Prevent double-start.
   if (_running.exchange(true)) return;
-  _initialized = false;
   cleanup();
+  _dcBlockerXprevL = _dcBlockerYprevL = 0.0f;
+  _dcBlockerXprevR = _dcBlockerYprevR = 0.0f;
+  _frameIndex = 0;
+  _lastAutoNs = 0;
+  _dynamics.reset();
+  _hpss.reset();
+  _cpu.mark();
+
+  // Drop whatever queued up while we were stopped, then poll the ring on this thread.
+  _input.discard();
+  if (!_pollTimer) {
+    _pollTimer = new QTimer(this);
+    _pollTimer->setTimerType(Qt::PreciseTimer);
+    connect(_pollTimer, &QTimer::timeout, this, &AudioProcessor::drainInput);
+  }
+  _pollTimer->start(kPollIntervalMs);
 }
 
 void AudioProcessor::initialize() {
   if (_initialized) return;
-
-  // Allocate FFT plan
-  _cfg = kiss_fftr_alloc(_N, 0, nullptr, nullptr);
-  if (!_cfg) { 
-    qWarning("kiss_fftr_alloc failed"); 
-    return; 
+  if (!_hasPending.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(_configMutex);
+    publishRequested();
   }
+  if (adoptPending())
+    qDebug() << "AudioProcessor: using" << _kernels->name << "kernels," << fft::backendName(fft::defaultBackend());
+}
 
-  // Buffers sized to FFT
-  _window.assign(_N, 0.0f);
-  _frameL.assign(_N, 0.0f);
-  _specL.assign(_N/2 + 1, kiss_fft_cpx{0,0});
-  _magL.assign(_N/2 + 1, 0.0f);
-  _frameR.assign(_N, 0.0f);
-  _specR.assign(_N/2 + 1, kiss_fft_cpx{0,0});
-  _magR.assign(_N/2 + 1, 0.0f);
+// --- configuration ---
+
+// Fetch (or build, on this thread) the setup for the requested settings and
+// leave it for the DSP thread.
+void AudioProcessor::publishRequested() {
+  Config next;
+  next.setup = _setups->get(DspSetupKey{_reqSr, _reqN, _reqBands});
+  next.hop = _reqHop;
+  next.layout = _reqLayout;
+  next.mix = _reqMix;
+  next.normalize = _reqNormalize;
+  if (!next.setup) {
+    qWarning("AudioProcessor: could not build an FFT setup (N=%d)", _reqN);
+    return;
+  }
+  _pending = std::move(next);
+  _hasPending.store(true, std::memory_order_release);
+}
 
-  // Setup all components
-  computeWindow();
-  computeDCBlockerCoeff();  // <-- ADD THIS LINE
-  setupFrequencyBands();
+// Swap in the pending config. Runs on the DSP thread between two hops, so the
+// current frame is finished with the old layout and the next uses the new one.
+bool AudioProcessor::adoptPending() {
+  if (!_hasPending.load(std::memory_order_acquire)) return false;
+  Config next;
+  {
+    std::lock_guard<std::mutex> lock(_configMutex);
+    next = std::move(_pending);
+    _pending = Config{};
+    _hasPending.store(false, std::memory_order_relaxed);
+  }
+  if (!next.setup) return false;
+
+  const DspSetupKey& k = next.setup->key;
+  const bool rateChanged = _setup && k.sampleRate != _sr;
+  const bool layoutChanged = next.setup != _setup || next.hop != _hop;
+  _setup = std::move(next.setup);   // the old one stays cached (or dies here)
+  _sr = k.sampleRate;
+  _N = k.fftSize;
+  _hop = next.hop;
+  _numBands = k.numBands;
+
+  // Everything below stays within what the constructor reserved (scratch,
+  // windows, mapper, dynamics, HPSS): no allocation on this thread. Only the
+  // analysisChanged payload at the end is built per layout change.
+  _frameL.assign(size_t(_N), 0.0f);
+  _frameR.assign(size_t(_N), 0.0f);
+  _specL.assign(size_t(_N / 2 + 1), fft::Complex{0, 0});
+  _specR.assign(size_t(_N / 2 + 1), fft::Complex{0, 0});
+  _magL.assign(size_t(_N / 2 + 1), 0.0f);
+  _magR.assign(size_t(_N / 2 + 1), 0.0f);
+  _mags.configure(_N / 2 + 1, float(_sr) / float(_N));
+  _harmMag.assign(size_t(_N / 2 + 1), 0.0f);
+  _percMag.assign(size_t(_N / 2 + 1), 0.0f);
+  _hpss.configure(_N / 2 + 1, float(_sr) / float(_N), double(_hop) / double(_sr));   // keeps its history unless the windows changed
+  _bandsL.assign(size_t(_numBands), 0.0f);
+  _bandsR.assign(size_t(_numBands), 0.0f);
+  _levelL.assign(size_t(_numBands), 0.0f);
+  _levelR.assign(size_t(_numBands), 0.0f);
+  for (auto* v : {&_harmBands, &_percBands, &_harmLevel, &_percLevel}) v->assign(size_t(_numBands), 0.0f);
+  _dynamics.configure(_numBands, double(_hop) / double(_sr));   // keeps its trackers unless the band count changed
+  _dcBlockerCoeff = _setup->dcCoeff;
+  _srMapper.setLayout(next.layout);
+  _srMapper.setMix(next.mix);
+  _srMapper.setNormalize(next.normalize);
+  _srMapper.build(_setup->filterbank);
+
+  // Keep what the windows hold (the newest 2N at most); samples from another
+  // sample rate would only smear the first frames, so those go
+  if (rateChanged) cleanup();
+  _winL.resize(2 * _N);
+  _winR.resize(2 * _N);
+  _hopCostNs = 0.0;                 // measured again at the new size
 
   _initialized = true;
+  if (!layoutChanged) return true;   // only the SR mapping changed
+
+  // Tell recorders / snapshot sizing what the analysis looks like now
+  const QVector<float> edges(_setup->bandEdgesHz.begin(), _setup->bandEdgesHz.end());
+  emit analysisChanged(_sr, _N, _hop, edges);
+  return true;
 }
 
 static int nearestPow2Clamped(int x, int lo = 1024, int hi = 4096) {
@@ -66,335 +203,371 @@ static int nearestPow2Clamped(int x, int lo = 1024, int hi = 4096) {
 
 void AudioProcessor::setSampleRate(int sr) {
   if (sr <= 0) return;
+  std::lock_guard<std::mutex> lock(_configMutex);
   // If SR is unchanged, nothing to do.
-  if (sr == _sr) return;
-  _sr = sr;
-  // Optional: keep a roughly constant time window (~43 ms)
-  const int targetSamples = int(std::lround(_sr * 0.043));  // ~43 ms
+  if (sr == _reqSr) return;
+  _reqSr = sr;
+  // Optional: keep a roughly constant time window (~43 ms); auto mode re-picks later
+  const int targetSamples = int(std::lround(_reqSr * 0.043));  // ~43 ms
   const int newN = nearestPow2Clamped(targetSamples, 1024, 4096);
-  if (newN != _N) {
-    _N   = newN;
-    _hop = _N / 2;                  // 50% overlap
+  if (newN != _reqN) {
+    _reqN   = newN;
+    _reqHop = _reqN / 2;            // 50% overlap
   }
-  // Force a fresh DSP init on next frames
-  _initialized = false;
-  cleanup();                        // free old FFT plan/buffers so initialize() rebuilds with new SR/_N
+  if (_autoTune.load()) prewarmAuto(_reqSr, _reqBands);
+  publishRequested();
 }
 
-void AudioProcessor::computeWindow() {
-  // Hann window
-  for (int n = 0; n < _N; ++n) {
-    _window[n] = 0.5f * (1.0f - std::cos(2.0f * float(M_PI) * n / (_N - 1)));
-  }
+void AudioProcessor::setNumBands(int n) {
+  if (!isSupportedBandCount(n)) return;
+  std::lock_guard<std::mutex> lock(_configMutex);
+  if (n == _reqBands) return;
+  _reqBands = n;
+  if (_autoTune.load()) prewarmAuto(_reqSr, _reqBands);
+  publishRequested();
 }
 
-void AudioProcessor::setNumBands(int n) {
-  // clamp to allowed values; expand later if you want.
-  if (n != 16 && n != 32 && n != 64) return;
-  if (n == _numBands) return;
-  _numBands = n;
-  _initialized = false;
-  cleanup();              // rebuild edges on next initialize()
+void AudioProcessor::setFftSize(int n, int hop) {
+  if (n < kMinFft || n > kMaxFft || (n & (n - 1)) != 0) return;
+  if (hop <= 0 || hop > n) hop = n / 2;
+  std::lock_guard<std::mutex> lock(_configMutex);
+  _autoTune.store(false);           // an explicit size wins over auto mode
+  if (n == _reqN && hop == _reqHop) return;
+  _reqN = n;
+  _reqHop = hop;
+  publishRequested();
+}
+
+// --- auto N / hop ---
+
+namespace {
+constexpr int kAutoSizes[] = {512, 1024, 2048, 4096, 8192};
+constexpr int kAutoMinHop = 128;
+constexpr int64_t kAutoPeriodNs = 2000000000;   // re-evaluate every 2 s
+}
+
+void AudioProcessor::setAutoTuning(bool on, double cpuBudget, double targetLatencyMs) {
+  std::lock_guard<std::mutex> lock(_configMutex);
+  _autoBudget = std::clamp(cpuBudget, 0.001, 1.0);
+  _autoLatencyMs = std::clamp(targetLatencyMs, 5.0, 500.0);
+  _autoVotes = 0;
+  if (on) prewarmAuto(_reqSr, _reqBands);
+  _autoTune.store(on);
+}
+
+// Build every candidate now (on the caller's thread) so a switch is a cache hit.
+void AudioProcessor::prewarmAuto(int sr, int bands) {
+  for (int n : kAutoSizes) _setups->get(DspSetupKey{sr, n, bands});
 }
 
-void AudioProcessor::setupFrequencyBands() {
-  _kLo.resize(_numBands);
-  _kHi.resize(_numBands);
-  _bandsL.assign(_numBands, 0.0f);
-  _bandsR.assign(_numBands, 0.0f);
-
-  const float fNyq = 0.5f * _sr;
-  const float fMin = 20.0f;
-  const float fMax = std::min(18000.0f, 0.98f * fNyq);
-
-  // Log-spaced edges: (_numBands + 1) points
-  std::vector<float> edges(_numBands + 1);
-  const float ratio = fMax / fMin;
-  for (int i = 0; i <= _numBands; ++i) {
-    float t = float(i) / float(_numBands);
-    edges[i] = fMin * std::pow(ratio, t);
+void AudioProcessor::autoTune() {
+  const int64_t now = monotonicNs();
+  if (_lastAutoNs == 0) { _lastAutoNs = now; return; }
+  if (now - _lastAutoNs < kAutoPeriodNs || _hopCostNs <= 0.0) return;
+  _lastAutoNs = now;
+
+  double budget, latencyMs;
+  {
+    std::lock_guard<std::mutex> lock(_configMutex);
+    budget = _autoBudget;
+    latencyMs = _autoLatencyMs;
   }
 
-  auto hzToK = [&](float f)->int {
-    int k = int(std::floor(f * _N / _sr));
-    int kMin = 1;
-    int kMax = std::max(2, _N/2);
-    return std::clamp(k, kMin, kMax);
-  };
-
-  for (int i = 0; i < _numBands; ++i) {
-    int k0 = hzToK(edges[i]);
-    int k1 = hzToK(edges[i+1]);
-    if (k1 <= k0) k1 = std::min(k0 + 1, _N/2);
-    _kLo[i] = k0;
-    _kHi[i] = k1;
+  // Cost of the current size scaled by N log N to the others: the FFT and
+  // magnitude passes dominate, the band stage is roughly linear in N too
+  const double measuredPerUnit = _hopCostNs / (double(_N) * std::log2(double(_N)));
+  int bestN = 0, bestHop = 0;
+  int fallbackN = 0, fallbackHop = 0;
+  double fallbackLoad = 1e30;
+  for (int n : kAutoSizes) {
+    const double cost = measuredPerUnit * double(n) * std::log2(double(n));
+    for (int hop = n / 2; hop >= std::max(kAutoMinHop, n / 8); hop /= 2) {
+      const double load = cost / (double(hop) / double(_sr) * 1e9);
+      const double lat = (double(n) / 2.0 + double(hop)) / double(_sr) * 1000.0;
+      if (load < fallbackLoad) { fallbackLoad = load; fallbackN = n; fallbackHop = hop; }
+      if (load > budget || lat > latencyMs) continue;
+      // Largest N first, then the smallest hop that still fits
+      if (n > bestN || (n == bestN && hop < bestHop)) { bestN = n; bestHop = hop; }
+    }
   }
+  if (bestN == 0) { bestN = fallbackN; bestHop = fallbackHop; }
+  if (bestN == _N && bestHop == _hop) { _autoVotes = 0; return; }
+
+  // Two evaluations in a row must agree before switching (no flapping on a
+  // single noisy measurement)
+  if (bestN != _autoN || bestHop != _autoHop) { _autoN = bestN; _autoHop = bestHop; _autoVotes = 1; return; }
+  if (++_autoVotes < 2) return;
+  _autoVotes = 0;
+
+  std::lock_guard<std::mutex> lock(_configMutex);
+  if (!_autoTune.load()) return;
+  _reqN = bestN;
+  _reqHop = bestHop;
+  publishRequested();               // prewarmed: a cache hit
+  qDebug() << "AudioProcessor: auto N" << bestN << "hop" << bestHop
+           << "| hop cost" << _hopCostNs * 1e-3 << "us";
+}
+
+void AudioProcessor::setSrBinMapping(int layout, int mix, int normalize) {
+  std::lock_guard<std::mutex> lock(_configMutex);
+  _reqLayout = SrBinMapper::Layout(std::clamp(layout, 0, SrBinMapper::kLayouts - 1));
+  _reqMix = SrBinMapper::Mix(std::clamp(mix, 0, SrBinMapper::kMixes - 1));
+  _reqNormalize = SrBinMapper::Normalize(std::clamp(normalize, 0, SrBinMapper::kNormalizes - 1));
+  publishRequested();               // same setup (a cache hit), new mapping
 }
 
-// Receive LEFT/RIGHT samples from capture and append to their FIFOs.
-void AudioProcessor::onFrames(const QVector<float>& left, const QVector<float>& right)
+// Pull everything the capture callback has queued into the analysis windows.
+void AudioProcessor::drainInput()
 {
-  if (!_running.load()) return;
-  if (left.isEmpty() || right.isEmpty()) return;
-
-  // Enforce alignment: use the smaller of the two to avoid drift.
-  int nL = left.size();
-  int nR = right.size();
-  int n  = (nL < nR) ? nL : nR;
-  if (n <= 0) return;
-
-  if (nL != nR) {
-    // Optional: warn about mismatch, but still process the smaller chunk.
-    qWarning("AudioProcessor::onFrames: left/right size mismatch %d != %d", nL, nR);
+  if (!_running.load()) {
+    if (_pollTimer) _pollTimer->stop();   // stop from our own thread
+    return;
   }
 
-    // === LOG INCOMING AUDIO (Remove after debugging) ===
-  static int logCounter = 0;
-  if (logCounter++ % 50 == 0) {  // Log every 50th frame to avoid spam
-    logAudioStats(left, "LEFT_IN ");
-    logAudioStats(right, "RIGHT_IN");
+  initialize();
+  if (!_initialized) return;  // if initialization failed, bail safely
+
+  // Top the windows up to capacity, process every complete hop, repeat.
+  // processAvailableStereo() always leaves < N samples, so space() >= N here.
+  while (_running.load()) {
+    const int room = _winL.space();
+    const std::size_t got = _input.consume(std::size_t(room),
+      [this](const float* l, const float* r, std::size_t count) {
+        pushBlock(l, r, int(count));
+      });
+    if (got == 0) break;
+
+    // Latency: capture stamp of the newest frame we just pulled -> now
+    if (_tracer) {
+      const int64_t captured = _input.captureTimeOf(_input.framesRead() - 1);
+      if (captured) _tracer->record(LatencyTracer::Dequeue, monotonicNs() - captured);
+    }
+
+    // Drive stereo processing (will consume in lock-step by _hop).
+    processAvailableStereo();
   }
-  // === END LOG ===
-
-  // Append to L FIFO.
-  const int prevL = _fifoL.size();
-  _fifoL.reserve(prevL + n);          // no-op if already large enough
-  _fifoL.resize(prevL + n);
-  std::memcpy(_fifoL.data() + prevL, left.constData(), n * sizeof(float));
-
-  // Append to R FIFO.
-  const int prevR = _fifoR.size();
-  _fifoR.reserve(prevR + n);
-  _fifoR.resize(prevR + n);
-  std::memcpy(_fifoR.data() + prevR, right.constData(), n * sizeof(float));
-
-  // Drive stereo processing (will consume in lock-step by _hop).
-  processAvailableStereo();
-}
 
-void AudioProcessor::processAvailableStereo() {
-  initialize();
-  if (!_initialized || !_cfg) return;  // if initialization failed, bail safely
+  if (++_ringStatsPolls % kRingStatsPolls == 0) reportRingStats();
+}
 
-  // Consume while both channels have at least N samples.
-  while (_running.load() && (int)_fifoL.size() >= _N && (int)_fifoR.size() >= _N){
-    processOneFrameStereo();  // copies N from each FIFO, windows, FFTs L/R, bands, etc.
-
-    // --- TEMPORARY: 32 (L/R) -> 16 mono control bins (simple & fast) ---
-    // TODO: This is a temporary solution, should be refactored
-    QVector<float> bins16(16, 0.0f);
-
-    if (_bandsL.size() == 32 && _bandsR.size() == 32) {
-      // Pair adjacent 32-bins, average L/R then average the pair.
-      for (int i = 0; i < 16; ++i) {
-        const int k0 = 2*i;
-        const int k1 = k0 + 1;
-
-        float lPair = 0.5f * (_bandsL[k0] + _bandsL[k1]);
-        float rPair = 0.5f * (_bandsR[k0] + _bandsR[k1]);
-        float mono  = 0.5f * (lPair + rPair);   // simple LR average
-
-        bins16[i] = mono;  // raw linear magnitude for now
-      }
-
-      // Per-frame normalize to 0..1 so UDP sender can map to 0..255 cleanly.
-      float mx = 0.0f;
-      for (float v : bins16) if (v > mx) mx = v;
-      if (mx > 0.0f) {
-        const float inv = 1.0f / mx;
-        for (float &v : bins16) v = std::clamp(v * inv, 0.0f, 1.0f);
-      }
-    } else {
-      // If 32s aren't ready for some reason, emit zeros (valid shape).
-      // bins16 already zero-initialized.
-    }
+// DC-block each sample exactly once on the way in, then append to the windows.
+// Works through a small stack block so nothing is allocated.
+void AudioProcessor::pushBlock(const float* l, const float* r, int count)
+{
+  constexpr int kBlock = 256;
+  float tmpL[kBlock], tmpR[kBlock];
+  while (count > 0) {
+    const int n = std::min(count, kBlock);
+    std::memcpy(tmpL, l, n * sizeof(float));
+    std::memcpy(tmpR, r, n * sizeof(float));
+    applyDCBlocker(tmpL, n, _dcBlockerXprevL, _dcBlockerYprevL);
+    applyDCBlocker(tmpR, n, _dcBlockerXprevR, _dcBlockerYprevR);
+    _winL.push(tmpL, n);
+    _winR.push(tmpR, n);
+    l += n; r += n; count -= n;
+  }
+}
 
-    emit binsReady(bins16);
-    // --- END TEMPORARY BLOCK ---
+void AudioProcessor::reportRingStats() {
+  const uint64_t over = _input.overruns();
+  if (over == _reportedOverruns) return;
+  _reportedOverruns = over;
+  const QString msg = QString("Input ring: %1 overruns (%2 frames dropped)")
+                        .arg(over).arg(_input.droppedFrames());
+  qWarning().noquote() << msg;
+  emit status(msg);
+}
 
-    // Slide both FIFOs forward by hop in lock-step.
-    _fifoL.erase(_fifoL.begin(), _fifoL.begin() + _hop);
-    _fifoR.erase(_fifoR.begin(), _fifoR.begin() + _hop);
+void AudioProcessor::processAvailableStereo() {
+  // Consume while both channels have at least N samples.
+  while (_running.load()) {
+    adoptPending();           // settings changes land between hops
+    if (!_winL.canRead(_N) || !_winR.canRead(_N)) break;
+
+    const int64_t t0 = monotonicNs();
+    processOneFrameStereo();  // windows N from each ring in place, FFTs L/R, bands, etc.
+    const double ns = double(monotonicNs() - t0);
+    _hopCostNs = _hopCostNs == 0.0 ? ns : 0.98 * _hopCostNs + 0.02 * ns;
+    _hops.add();
+    _hopSeconds.set(ns * 1e-9);
+    _hopCostSeconds.set(_hopCostNs * 1e-9);
+    if (_autoTune.load(std::memory_order_relaxed)) autoTune();
+
+
+    // Slide both windows forward by hop in lock-step (index move, no memmove).
+    _winL.advance(_hop);
+    _winR.advance(_hop);
   }
 }
 
 void AudioProcessor::processOneFrameStereo() {
-  // 1) Copy first N from FIFOs
-  std::memcpy(_frameL.data(), _fifoL.data(), _N * sizeof(float));
-  std::memcpy(_frameR.data(), _fifoR.data(), _N * sizeof(float));
-
-    // === LOG BEFORE DC BLOCKER ===
-  static int frameCounter = 0;
-  bool shouldLog = (frameCounter++ % 50 == 0);
-  
-  if (shouldLog) {
-    QVector<float> beforeL(_frameL.begin(), _frameL.end());
-    logAudioStats(beforeL, "BEFORE_DC");
-  }
-  // === END LOG ===
-
-    // 1.5) Apply DC blocker BEFORE windowing
-  applyDCBlocker(_frameL, _dcBlockerXprevL, _dcBlockerYprevL);
-  applyDCBlocker(_frameR, _dcBlockerXprevR, _dcBlockerYprevR);
-
-    // === LOG AFTER DC BLOCKER ===
-  if (shouldLog) {
-    QVector<float> afterL(_frameL.begin(), _frameL.end());
-    logAudioStats(afterL, "AFTER_DC ");
-    
-    // Also log DC blocker state
-    qDebug() << "DC_STATE | xPrevL:" << _dcBlockerXprevL 
-             << "| yPrevL:" << _dcBlockerYprevL
-             << "| coeff:" << _dcBlockerCoeff;
-  }
-  // === END LOG ===
+  // 1) Oldest N samples of each window, contiguous thanks to the mirror.
+  //    (Already DC-blocked on ingestion, see pushBlock.)
+  const float* srcL = _winL.peek(_N);
+  const float* srcR = _winR.peek(_N);
 
-  // 2) Window (Hann precomputed)
-  for (int i = 0; i < _N; ++i) {
-    _frameL[i] *= _window[i];
-    _frameR[i] *= _window[i];
-  }
+  // 2) Window (Hann precomputed) straight from the ring into the FFT input
+  _kernels->applyWindowStereo(_frameL.data(), _frameR.data(), srcL, srcR, _setup->window.data(), _N);
+
+  // Newest sample in this frame, as an absolute ring position (windows hold the
+  // last size() frames read), and when it was captured
+  const uint64_t frameEnd = _input.framesRead() - uint64_t(_winL.size()) + uint64_t(_N) - 1;
+  _frameCaptureNs = _input.captureTimeOf(frameEnd);
 
   // 3) FFT (sequential, single plan is fine)
-  kiss_fftr(_cfg, _frameL.data(), _specL.data());
-  kiss_fftr(_cfg, _frameR.data(), _specR.data());
+  const int64_t t0 = _tracer ? monotonicNs() : 0;
+  _setup->plan->forward(_frameL.data(), _specL.data());
+  _setup->plan->forward(_frameR.data(), _specR.data());
+  const int64_t t1 = _tracer ? monotonicNs() : 0;
 
   // 4) Compute frequency bands
   computeFrequencyBands();
+  if (_tracer) {
+    _tracer->record(LatencyTracer::Fft, t1 - t0);
+    _tracer->record(LatencyTracer::Bands, monotonicNs() - t1);
+  }
 
   // 5) Emit results
   emitResults();
 }
 
 void AudioProcessor::computeFrequencyBands() {
-  for (int b = 0; b < _numBands; ++b) {
-    float sumL = 0.0f, sumR = 0.0f;
-    const int k0 = _kLo[b];
-    const int k1 = _kHi[b]; // exclusive
-    for (int k = k0; k < k1; ++k) {
-      const kiss_fft_cpx &XL = _specL[k];
-      const kiss_fft_cpx &XR = _specR[k];
-      sumL += std::hypot((float)XL.r, (float)XL.i);
-      sumR += std::hypot((float)XR.r, (float)XR.i);
-    }
-    _bandsL[b] = sumL;
-    _bandsR[b] = sumR;
-  }
+  // One vectorized magnitude pass per channel, then one sparse mat-vec for
+  // both channels. fft::Complex is {r, i}, i.e. interleaved floats.
+  const int K = _N/2 + 1;
+  _kernels->magnitude(_magL.data(), reinterpret_cast<const float*>(_specL.data()), K);
+  _kernels->magnitude(_magR.data(), reinterpret_cast<const float*>(_specR.data()), K);
+  _setup->filterbank.applyStereo(_magL.data(), _magR.data(), _bandsL.data(), _bandsR.data());
+  _mags.update(_magL.data(), _magR.data());
+
+  // Harmonic / percussive split of the mono spectrum, through the same
+  // filterbank (its stereo kernel takes the two parts as "L" and "R")
+  _hpss.process(_mags.mag(), _harmMag.data(), _percMag.data());
+  _setup->filterbank.applyStereo(_harmMag.data(), _percMag.data(), _harmBands.data(), _percBands.data());
 }
 
-static QVector<float> downmixToN(const std::vector<float>& src, int dstN) {
-  const int srcN = (int)src.size();
-  if (srcN <= 0 || dstN <= 0) return QVector<float>(dstN, 0.0f);
-
-  QVector<float> out(dstN, 0.0f);
-
-  // Simple energy-preserving bucket average (contiguous groups).
-  // Map each dst bin to a [a,z) range in src indices.
-  for (int i = 0; i < dstN; ++i) {
-    const float aF = (float(i)    / dstN) * srcN;
-    const float zF = (float(i+1)  / dstN) * srcN;
-    const int   a  = std::max(0, (int)std::floor(aF));
-    const int   z  = std::min(srcN, (int)std::ceil (zF));
-    float acc = 0.0f;
-    int   cnt = 0;
-    for (int k = a; k < z; ++k) { acc += src[k]; ++cnt; }
-    out[i] = (cnt > 0) ? acc / float(cnt) : 0.0f;
+// Amplitude-weighted band index of the bins above a small threshold (-1 if silent)
+static float bandCentroid(const float* bins, int n) {
+  const float threshold = 0.001f;
+  float weightedSum = 0.0f, totalWeight = 0.0f;
+  for (int i = 0; i < n; ++i) {
+    if (bins[i] > threshold) {
+      weightedSum += i * bins[i];
+      totalWeight += bins[i];
+    }
   }
-  return out;
+  return (totalWeight > threshold) ? weightedSum / totalWeight : -1.0f;
 }
 
 void AudioProcessor::emitResults() {
-  // Emit raw current-size bands to the widget
-  QVector<float> qL(_bandsL.begin(), _bandsL.end());
-  QVector<float> qR(_bandsR.begin(), _bandsR.end());
-  emit binsReadyRaw(qL, qR);
-
-  // Always provide 16 for UDP sender (from whatever _numBands is)
-  QVector<float> bins16 = downmixToN(_bandsL, 16);
-  // normalize 0..1 like you did
-  float mx = 0.0f; for (float v : bins16) mx = std::max(mx, v);
-  if (mx > 0.0f) {
-    const float inv = 1.0f / mx;
-    for (float &v : bins16) v = std::clamp(v * inv, 0.0f, 1.0f);
-  }
-  emit binsReady(bins16);
-
   // Levels (unchanged)
   float rmsL = computeRMS(_frameL);
   float rmsR = computeRMS(_frameR);
   float dbL = 20.0f * std::log10(std::max(rmsL, 1e-6f));
   float dbR = 20.0f * std::log10(std::max(rmsR, 1e-6f));
-  emit levelsReady(dbL, dbR);
-}
 
-float AudioProcessor::computeRMS(const std::vector<float>& frame) {
-  float rms = 0.0f;
-  for (int n = 0; n < _N; ++n) {
-    rms += frame[n] * frame[n];
+  // The one dynamics stage: AGC'd 0..1 levels, gate and peak for every consumer
+  _dynamics.process(_bandsL.data(), _bandsR.data(), rmsL, rmsR, _levelL.data(), _levelR.data());
+  const bool gate = isSignalAboveNoiseFloor(rmsL, rmsR);
+
+  // 16 bins for the SR sender: the single N -> 16 output stage (see SrBinMapper)
+  float bins16[SpectrumFrame::kSrBins];
+  if (_srMapper.normalize() == SrBinMapper::Normalize::Dynamics)
+    _srMapper.map(_levelL.data(), _levelR.data(), bins16);
+  else
+    _srMapper.map(_bandsL.data(), _bandsR.data(), bins16);
+
+  // The HPSS parts on the same scale: each band's level split by its harmonic
+  // share (the two parts of a band add up to the band), then the same mapping
+  float harmShare = 0.5f;
+  {
+    double total = 0.0, harm = 0.0;
+    for (int b = 0; b < _numBands; ++b) {
+      const float h = _harmBands[size_t(b)], p = _percBands[size_t(b)];
+      const float share = h + p > 1e-12f ? h / (h + p) : 0.5f;
+      const float lv = 0.5f * (_levelL[size_t(b)] + _levelR[size_t(b)]);
+      _harmLevel[size_t(b)] = lv * share;
+      _percLevel[size_t(b)] = lv - _harmLevel[size_t(b)];
+      total += lv;
+      harm += _harmLevel[size_t(b)];
+    }
+    if (total > 1e-9) harmShare = float(harm / total);
+  }
+  float harm16[SpectrumFrame::kSrBins], perc16[SpectrumFrame::kSrBins];
+  if (_srMapper.normalize() == SrBinMapper::Normalize::Dynamics) {
+    _srMapper.map(_harmLevel.data(), _harmLevel.data(), harm16);
+    _srMapper.map(_percLevel.data(), _percLevel.data(), perc16);
+  } else {
+    _srMapper.map(_harmBands.data(), _harmBands.data(), harm16);
+    _srMapper.map(_percBands.data(), _percBands.data(), perc16);
+  }
+
+  // One pooled frame for every consumer. If the pool is empty the consumers
+  // are behind; drop this hop rather than queue more.
+  const uint64_t index = _frameIndex++;
+  if (SpectrumFramePtr f = _framePool->acquire()) {
+    const int n = std::min(_numBands, SpectrumFrame::kMaxBands);
+    f->numBands = n;
+    std::copy(_bandsL.begin(), _bandsL.begin() + n, f->bandsL);
+    std::copy(_bandsR.begin(), _bandsR.begin() + n, f->bandsR);
+    std::copy(_levelL.begin(), _levelL.begin() + n, f->levelL);
+    std::copy(_levelR.begin(), _levelR.begin() + n, f->levelR);
+    std::copy(bins16, bins16 + SpectrumFrame::kSrBins, f->bins16);
+    std::copy(_harmBands.begin(), _harmBands.begin() + n, f->harmonic);
+    std::copy(_percBands.begin(), _percBands.begin() + n, f->percussive);
+    std::copy(harm16, harm16 + SpectrumFrame::kSrBins, f->harmonic16);
+    std::copy(perc16, perc16 + SpectrumFrame::kSrBins, f->percussive16);
+    f->harmonicShare = harmShare;
+    f->level = _dynamics.level();
+    f->peak = _dynamics.peak();
+    f->gate = gate;
+    f->noiseFloorDb = _dynamics.noiseFloorDb();
+    f->rmsL = rmsL;  f->rmsR = rmsR;
+    f->dbL = dbL;    f->dbR = dbR;
+    f->centroidL = bandCentroid(f->bandsL, n);
+    f->centroidR = bandCentroid(f->bandsR, n);
+    f->spectralCentroidHz = _mags.centroidHz(1, _N / 2);
+    f->spectralRolloffHz = _mags.rolloffHz(0.9f, 1, _N / 2);
+    f->spectralFlatness = _mags.flatness(1, _N / 2);
+    _setup->chroma.fold(_mags, f->chroma);
+    f->frameIndex = index;
+    f->timestampNs = monotonicNs();
+    f->captureNs = _frameCaptureNs;
+    _framesOut.add();
+    emit frameReady(f);
+  }
+
+  // Legacy per-signal outputs: only pay for the vectors if someone listens
+  static const QMetaMethod rawSignal    = QMetaMethod::fromSignal(&AudioProcessor::binsReadyRaw);
+  static const QMetaMethod binsSignal   = QMetaMethod::fromSignal(&AudioProcessor::binsReady);
+  static const QMetaMethod levelsSignal = QMetaMethod::fromSignal(&AudioProcessor::levelsReady);
+  if (isSignalConnected(rawSignal)) {
+    emit binsReadyRaw(QVector<float>(_bandsL.begin(), _bandsL.end()),
+                      QVector<float>(_bandsR.begin(), _bandsR.end()));
+  }
+  if (isSignalConnected(binsSignal)) {
+    emit binsReady(QVector<float>(bins16, bins16 + SpectrumFrame::kSrBins));
   }
-  return std::sqrt(rms / float(_N));
+  if (isSignalConnected(levelsSignal)) emit levelsReady(dbL, dbR);
 }
 
-void AudioProcessor::computeDCBlockerCoeff() {
-  // DC blocker is a 1st-order high-pass filter
-  // Transfer function: H(z) = (1 - z^-1) / (1 - R*z^-1)
-  // where R = 1 - (2*pi*fc/fs)
-  // For fc = 20Hz cutoff
-  
-  const float fc = 20.0f;  // Cutoff frequency in Hz
-  const float fs = static_cast<float>(_sr);
-  
-  // Calculate coefficient (closer to 1.0 = higher cutoff)
-  _dcBlockerCoeff = 1.0f - (2.0f * float(M_PI) * fc / fs);
-  
-  // Clamp to safe range
-  _dcBlockerCoeff = std::clamp(_dcBlockerCoeff, 0.9f, 0.999f);
+// Gate from the dynamics stage (tracked floor), plus the absolute silence threshold
+bool AudioProcessor::isSignalAboveNoiseFloor(float rmsL, float rmsR) {
+  return std::max(rmsL, rmsR) > _noiseGateThreshold && _dynamics.gate();
 }
 
-// Apply DC blocker to a frame
-void AudioProcessor::applyDCBlocker(std::vector<float>& frame, float& xPrev, float& yPrev) {
-  // Process each sample in the frame
-  for (int i = 0; i < _N; ++i) {
-    const float x = frame[i];
-    const float y = x - xPrev + _dcBlockerCoeff * yPrev;
-    
-    xPrev = x;
-    yPrev = y;
-    frame[i] = y;
-  }
+float AudioProcessor::computeRMS(const std::vector<float>& frame) {
+  return std::sqrt(_kernels->sumSquares(frame.data(), _N) / float(_N));
 }
 
-void AudioProcessor::logAudioStats(const QVector<float>& samples, const QString& label) {
-  if (samples.isEmpty()) return;
-  
-  float minVal = samples[0];
-  float maxVal = samples[0];
-  float sumAbs = 0.0f;
-  float sumSq = 0.0f;
-  int zeroCount = 0;
-  
-  for (float s : samples) {
-    minVal = std::min(minVal, s);
-    maxVal = std::max(maxVal, s);
-    sumAbs += std::abs(s);
-    sumSq += s * s;
-    if (s == 0.0f) zeroCount++;
-  }
-  
-  float mean = sumAbs / samples.size();
-  float rms = std::sqrt(sumSq / samples.size());
-  
-  qDebug() << label 
-           << "| samples:" << samples.size()
-           << "| min:" << minVal 
-           << "| max:" << maxVal
-           << "| mean(abs):" << mean
-           << "| rms:" << rms
-           << "| zeros:" << zeroCount;
+// Apply DC blocker to a block of consecutive samples (state carries across blocks)
+void AudioProcessor::applyDCBlocker(float* x, int n, float& xPrev, float& yPrev) {
+  _kernels->dcBlock(x, n, _dcBlockerCoeff, xPrev, yPrev);
 }
 
 
 
+
 // LEGACY CODE - COMMENTED OUT FOR REFERENCE
 // void AudioProcessor::processAvailable() {
 //   ensureInit();
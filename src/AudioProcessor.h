@@ -2,103 +2,214 @@
 #include <QObject>
 #include <QVector>
 #include <atomic>
+#include <memory>
+#include <mutex>
 #include <vector>
-
-extern "C" {
-  #include "kiss_fftr.h"
-}
-
-// class CircularBuffer {
-//     QVector<float> _data;
-//     int _writePos = 0;
-//     int _readPos = 0;
-//     int _size = 0;
-    
-// public:
-//     void push(const float* samples, int count) {
-//         // Write without shifting existing data
-//     }
-//     bool canRead(int samples) const {
-//         return _size >= samples;
-//     }
-//     void read(float* out, int count, bool advance = true) {
-//         // Read without erasing
-//     }
-// };
-
+#include "StereoRingBuffer.h"
+#include "CircularBuffer.h"
+#include "DspKernels.h"
+#include "BandFilterbank.h"
+#include "DspSetup.h"
+#include "MagnitudeCache.h"
+#include "SpectrumFrame.h"
+#include "SrBinMapper.h"
+#include "DynamicsProcessor.h"
+#include "HpssProcessor.h"
+#include "LatencyTracer.h"
+#include "Metrics.h"
+
+class QTimer;
+
+// Settings changes (sample rate, FFT size / hop, band count, SR bin mapping) never stall the
+// stream: the setters are thread-safe, fetch the new plan/window/filterbank
+// from a DspSetupCache (building it on the calling thread on a miss) and
+// publish it as a pending config. The DSP thread swaps it in between two hops
+// and keeps the analysis windows, so the next frame simply uses the new
+// layout. Only a sample-rate change empties them (old samples are at the old rate).
 class AudioProcessor : public QObject {
   Q_OBJECT
 public:
   explicit AudioProcessor(QObject* parent = nullptr);
   ~AudioProcessor();
 
+  // Ring the capture callback writes into (attach with AudioCapture::attachRing).
+  StereoRingBuffer* inputRing() { return &_input; }
+
+  // Optional per-stage latency recording (set before start; not owned).
+  void setLatencyTracer(LatencyTracer* tracer) { _tracer = tracer; }
+
+  // Processors on one DSP thread can share a cache, so each layout's FFT
+  // plan, window and filterbank exist once (a plan is only ever run by one
+  // thread at a time). Set before start.
+  void shareSetups(std::shared_ptr<DspSetupCache> cache) { if (cache) _setups = std::move(cache); }
+
+  // Zone processor (see CaptureZone): series get zone="name", the thread's
+  // CPU series is bound as `cpuThread` (empty: another processor on the same
+  // thread reports it). Before start.
+  void setZone(const std::string& zone, const std::string& cpuThread);
+
+  // Frames emitted so far (any thread; consumers compare it with what they took)
+  uint64_t framesEmitted() const { return _framesOut.value(); }
+
+  // Band counts setNumBands accepts
+  static bool isSupportedBandCount(int n) { return n == 16 || n == 32 || n == 64 || n == 128 || n == 256; }
+
+  // FFT sizes setFftSize accepts
+  static constexpr int kMinFft = 256, kMaxFft = 16384;
+
+  // Auto mode: pick N and hop from the measured per-hop cost, the largest N
+  // (finest resolution), then the smallest hop, with
+  //   (N/2 + hop) / sr <= targetLatencyMs  and  cost / hop period <= cpuBudget,
+  // re-evaluated every couple of seconds. Candidate setups are built up front
+  // on the calling thread. setFftSize turns it off. Any thread.
+  void setAutoTuning(bool on, double cpuBudget = 0.05, double targetLatencyMs = 40.0);
+  bool autoTuning() const { return _autoTune.load(); }
+
 public slots:
   // state management
   void start();
+  // Any thread: only raises the flag. The teardown (finishStop) runs on the
+  // DSP thread once the current drainInput has returned; then stopped().
   void requestStop();
-  // ---- Active path: receive R and L frames ----
-  void onFrames(const QVector<float>& left, const QVector<float>& right);
+  // ---- Active path: pull R and L frames from the input ring ----
+  void drainInput();
+  // The four below may be called from any thread (see the class comment).
   // receive sample rate from capture
   void setSampleRate(int sr);
-  // set number of frequency bands (16, 32, 64)
+  // set number of frequency bands (16, 32, 64, 128, 256)
   void setNumBands(int n);
+  // FFT size (power of two, kMinFft..kMaxFft) and hop (0 = N/2). A later
+  // sample-rate change picks N again from the rate.
+  void setFftSize(int n, int hop = 0);
+  // WLED output stage: SrBinMapper::Layout / Mix / Normalize as ints,
+  // applied with the next config swap
+  void setSrBinMapping(int layout, int mix, int normalize);
 
 signals:
   // state management
   void status(const QString& msg);
   void stopped();
 
-  // 32 bins, raw linear magnitudes for BarsWidget
+  // Everything from one hop in one pooled frame (bands, levels, bins16, RMS,
+  // centroid, spectral features, chroma).
+  // This is the main output; the vector signals below are only built when connected.
+  void frameReady(const SpectrumFramePtr& frame);
+
+  // _numBands bins, raw linear magnitudes
   void binsReadyRaw(const QVector<float>& left, const QVector<float>& right);
-  // 16 bins, normalized 0..1 (per-frame), ready for UDP sender.
+  // 16 bins, normalized 0..1 (same values as SpectrumFrame::bins16), once per hop.
   void binsReady(const QVector<float>& bins16);
 
+  // Emitted after every (re)initialization: sample rate, FFT size, hop and the
+  // filterbank points (numBands + 2; band b spans edges[b]..edges[b+2]).
+  void analysisChanged(int sampleRate, int fftSize, int hop, const QVector<float>& bandEdgesHz);
+
   // RMS levels in dBFS
   void levelsReady(float leftDb, float rightDb);  // RMS levels in dBFS
 
 private:
   // state management
   std::atomic<bool> _running{false};
-  bool _initialized = false;
-  void initialize();                          // Main initialization
+  bool _initialized = false;                  // a setup is active
+  void initialize();                          // adopt the first setup
   void cleanup();                            // Resource cleanup
-
-
-  // FFT parameters
+  void finishStop();                         // DSP thread, queued by requestStop
+
+  // --- configuration ---
+  // Requested settings (any thread, under _configMutex) -> pending config ->
+  // adopted by the DSP thread between hops (_hasPending).
+  struct Config {
+    DspSetupPtr setup;
+    int hop = 0;
+    SrBinMapper::Layout layout = SrBinMapper::Layout::Contiguous;
+    SrBinMapper::Mix mix = SrBinMapper::Mix::Mean;
+    SrBinMapper::Normalize normalize = SrBinMapper::Normalize::Dynamics;
+  };
+  std::shared_ptr<DspSetupCache> _setups{std::make_shared<DspSetupCache>()};
+  std::mutex _configMutex;
+  int _reqSr = 48000, _reqN = 1024, _reqHop = 512, _reqBands = 16;
+  SrBinMapper::Layout _reqLayout = SrBinMapper::Layout::Contiguous;
+  SrBinMapper::Mix _reqMix = SrBinMapper::Mix::Mean;
+  SrBinMapper::Normalize _reqNormalize = SrBinMapper::Normalize::Dynamics;
+  Config _pending;                            // guarded by _configMutex
+  std::atomic<bool> _hasPending{false};
+  void publishRequested();                    // caller holds _configMutex
+  bool adoptPending();                        // DSP thread; true if a config was swapped in
+
+  // Auto N/hop (see setAutoTuning)
+  std::atomic<bool> _autoTune{false};
+  double _autoBudget = 0.05, _autoLatencyMs = 40.0;   // guarded by _configMutex
+  double _hopCostNs = 0.0;                    // EWMA of processOneFrameStereo, DSP thread
+  int64_t _lastAutoNs = 0;
+  int _autoVotes = 0, _autoN = 0, _autoHop = 0;
+  void prewarmAuto(int sr, int bands);        // caller holds _configMutex
+  void autoTune();                            // DSP thread, every few seconds
+
+  // Active FFT parameters (DSP thread; mirror _setup and the adopted hop)
   int _sr   = 48000;   // Sample rate
   int _N    = 1024;    // FFT size (~21.3 ms @ 48k)
   int _hop  = 512;     // Hop size (~5.3 ms update cadence)
 
-  int _numBands = 16;                // << one knob: 16, 32, 64
-  QVector<int> _kLo, _kHi;           // size = _numBands
+  int _numBands = 16;                // << one knob: 16 .. 256
+  DspSetupPtr _setup;                // plan, window, filterbank for (_sr, _N, _numBands)
+  SrBinMapper _srMapper;             // N bands -> 16 WLED bins, rebuilt with the filterbank
   std::vector<float> _bandsL, _bandsR; // size = _numBands
+  DynamicsProcessor _dynamics;       // AGC / noise floor / peak, shared by every consumer
+  std::vector<float> _levelL, _levelR; // size = _numBands, 0..1
+  HpssProcessor _hpss;               // harmonic / percussive split of the mono magnitudes
+  std::vector<float> _harmBands, _percBands; // size = _numBands, raw linear (mono)
+  std::vector<float> _harmLevel, _percLevel; // size = _numBands, 0..1 share of the band levels
 
-  // FFT resources
-  kiss_fftr_cfg _cfg = nullptr;
-  std::vector<float> _window;                 // Hann window (length N)
+  // FFT scratch, reserved for kMaxFft so a config swap never allocates
   std::vector<float> _frameL;                 // Left channel frame (length N)
   std::vector<float> _frameR;                 // Right channel frame (length N)
-  std::vector<kiss_fft_cpx> _specL;          // Left spectrum (N/2+1)
-  std::vector<kiss_fft_cpx> _specR;          // Right spectrum (N/2+1)
-  std::vector<float> _magL;                   // Left magnitudes (N/2+1) - unused but kept for compatibility
-  std::vector<float> _magR;                   // Right magnitudes (N/2+1) - unused but kept for compatibility
-
-  // Audio input buffers
-  std::vector<float> _fifoL;                  // Left channel FIFO
-  std::vector<float> _fifoR;                  // Right channel FIFO
+  std::vector<fft::Complex> _specL;          // Left spectrum (N/2+1)
+  std::vector<fft::Complex> _specR;          // Right spectrum (N/2+1)
+  std::vector<float> _magL;                   // Left magnitudes (N/2+1)
+  std::vector<float> _magR;                   // Right magnitudes (N/2+1)
+  MagnitudeCache _mags;                       // mono / power / log + prefix sums, for the features
+  std::vector<float> _harmMag, _percMag;      // HPSS parts of _mags.mag() (N/2+1)
+
+  // Output frames: fixed pool, recycled once every consumer has let go
+  static constexpr int kFramePoolSize = 32;
+  SpectrumFramePool* _framePool = nullptr;
+  uint64_t _frameIndex = 0;
+  int64_t _frameCaptureNs = 0;                // capture stamp of the newest sample in the current frame
+  LatencyTracer* _tracer = nullptr;
+
+  // Metrics (Metrics.h), all written on the DSP thread; the ring and pool are probed
+  metrics::Counter _hops, _framesOut;
+  metrics::Gauge _hopSeconds;                 // wall time of the last hop
+  metrics::Gauge _hopCostSeconds;             // its EWMA (what auto mode sees)
+  metrics::ThreadCpu _cpu;
+  std::string _zone, _cpuThread{"dsp"};
+  void bindMetrics();
+
+  // SIMD kernels for the hot loops (best ISA picked at startup, see DspKernels.h)
+  const dsp::Kernels* _kernels = &dsp::kernels();
+
+  // Audio input: SPSC ring from the capture callback, polled on the DSP thread
+  StereoRingBuffer _input{1u << 15};          // ~680 ms @ 48k
+  QTimer* _pollTimer = nullptr;
+  static constexpr int kPollIntervalMs = 2;   // well under the 10 ms capture period
+  uint64_t _reportedOverruns = 0;
+  unsigned _ringStatsPolls = 0;
+  static constexpr unsigned kRingStatsPolls = 250;   // ring report every ~0.5 s of polls
+  void reportRingStats();
+
+  // Sliding analysis windows (mirrored, so an N-frame is always contiguous).
+  // Samples enter already DC-blocked; frames are read in place and the
+  // window slides by _hop without moving any memory.
+  CircularBuffer _winL;                       // Left channel window (capacity 2N)
+  CircularBuffer _winR;                       // Right channel window (capacity 2N)
 
   // Core processing methods
   void processAvailableStereo();             // Process available stereo samples
   void processOneFrameStereo();              // Process one frame of stereo audio
   
-  // Setup methods
-  void computeWindow();                      // Compute Hann window
-
-  void setupFrequencyBands();                // Setup 32-band frequency layout
-  
   // Analysis methods
   void computeFrequencyBands();              // Compute band magnitudes from FFT
-  void emitResults();                        // Emit all signals
+  void emitResults();                        // Fill a pooled frame and emit it
   float computeRMS(const std::vector<float>& frame);  // Compute RMS of frame
 
 
@@ -109,15 +220,14 @@ private:
   float _dcBlockerYprevR = 0.0f;   // Previous output sample (Right)
   
   // Helper method
-  void computeDCBlockerCoeff();
-  void applyDCBlocker(std::vector<float>& frame, float& xPrev, float& yPrev);
+  void applyDCBlocker(float* x, int n, float& xPrev, float& yPrev);
+  void pushBlock(const float* l, const float* r, int count);  // DC-block + append to windows
 
-  void logAudioStats(const QVector<float>& samples, const QString& label);
 
     // Noise gate
-  float _noiseGateThreshold = 0.001f;  // RMS threshold for silence detection
+  float _noiseGateThreshold = 0.001f;  // absolute RMS below which the gate stays shut
   
   // Helper methods
   QVector<float> resampleBandsTo16(const std::vector<float>& bandsL, const std::vector<float>& bandsR);
-  bool isSignalAboveNoiseFloor(float rmsL, float rmsR);
+  bool isSignalAboveNoiseFloor(float rmsL, float rmsR);   // after _dynamics.process()
 };
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "BandFilterbank.h"
+#include "DspKernels.h"
+#include <algorithm>
+#include <cmath>
+
+void BandFilterbank::build(int sampleRate, int N, int bands, float fMin, float fMax) {
+  _bands = std::max(1, bands);
+  _bins = N/2 + 1;
+
+  const float fNyq = 0.5f * float(sampleRate);
+  const float hzPerBin = float(sampleRate) / float(N);
+  fMax = std::min(fMax, 0.98f * fNyq);
+  // Nothing below the first bin is resolvable; starting there keeps the lowest
+  // bands distinct (interpolated) rather than all reading bin 1.
+  fMin = std::clamp(std::max(fMin, hzPerBin), 1.0f, 0.5f * fMax);
+
+  // bands + 2 log-spaced points: edge, centres..., edge
+  _centers.resize(_bands + 2);
+  const float ratio = fMax / fMin;
+  for (int i = 0; i < _bands + 2; ++i)
+    _centers[i] = fMin * std::pow(ratio, float(i) / float(_bands + 1));
+
+  _rowStart.assign(1, 0);
+  _binIndex.clear();
+  _weights.clear();
+
+  const int kMax = _bins - 1;
+
+  for (int b = 0; b < _bands; ++b) {
+    // Triangle corners in (fractional) bin units
+    const float kl = _centers[b]     / hzPerBin;
+    const float kc = _centers[b + 1] / hzPerBin;
+    const float kr = _centers[b + 2] / hzPerBin;
+
+    const int first = std::max(1, int(std::ceil(kl)));     // skip DC
+    const int last  = std::min(kMax, int(std::floor(kr)));
+    const size_t rowBegin = _weights.size();
+    for (int k = first; k <= last; ++k) {
+      const float fk = float(k);
+      const float w = fk <= kc ? (fk - kl) / std::max(kc - kl, 1e-6f)
+                               : (kr - fk) / std::max(kr - kc, 1e-6f);
+      if (w > 1e-4f) {
+        _binIndex.push_back(k);
+        _weights.push_back(std::min(w, 1.0f));
+      }
+    }
+
+    // Triangle narrower than the bin spacing: interpolate the centre instead
+    if (_weights.size() == rowBegin) {
+      const float kcc = std::clamp(kc, 1.0f, float(kMax));
+      const int k0 = std::min(int(std::floor(kcc)), kMax - 1);
+      const float frac = kcc - float(k0);
+      _binIndex.push_back(k0);
+      _weights.push_back(1.0f - frac);
+      if (frac > 1e-4f) {
+        _binIndex.push_back(k0 + 1);
+        _weights.push_back(frac);
+      }
+    }
+    _rowStart.push_back(int(_weights.size()));
+  }
+}
+
+void BandFilterbank::apply(const float* mag, float* out) const {
+  dsp::kernels().sparseMatVec(out, mag, _rowStart.data(), _binIndex.data(), _weights.data(), _bands);
+}
+
+void BandFilterbank::applyStereo(const float* magL, const float* magR, float* outL, float* outR) const {
+  dsp::kernels().sparseMatVecStereo(outL, outR, magL, magR,
+                                    _rowStart.data(), _binIndex.data(), _weights.data(), _bands);
+}
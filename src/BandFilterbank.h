@@ -0,0 +1,44 @@
+#pragma once
+#include <vector>
+
+// Sparse triangular filterbank over a one-sided magnitude spectrum.
+//
+// Band centres are log-spaced between fMin and fMax; band b is a triangle
+// rising from centre b-1 to centre b and falling to centre b+1, evaluated at
+// the FFT bin frequencies. Weights are stored in CSR form (rowStart / bins /
+// weights) so applying the bank is one pass over the non-zeros.
+//
+// Narrow low bands whose triangle falls between two bins get the centre
+// frequency linearly interpolated between its neighbouring bins instead, so
+// no band is empty and adjacent low bands no longer read the same bin.
+class BandFilterbank {
+public:
+  // Rebuild for `bands` bands on an N-point FFT at `sampleRate`.
+  void build(int sampleRate, int N, int bands, float fMin = 20.0f, float fMax = 18000.0f);
+
+  int bands() const { return _bands; }
+  int bins() const { return _bins; }            // N/2 + 1
+  int nonZeros() const { return int(_weights.size()); }
+
+  // out[b] = sum_k W[b][k] * mag[k]
+  void apply(const float* mag, float* out) const;
+  void applyStereo(const float* magL, const float* magR, float* outL, float* outR) const;
+
+  // Band centre and -3 dB-ish edges (neighbouring centres) in Hz
+  float centerHz(int b) const { return _centers[b + 1]; }
+  float lowHz(int b)    const { return _centers[b]; }
+  float highHz(int b)   const { return _centers[b + 2]; }
+
+  // CSR arrays (rowStart has bands+1 entries)
+  const std::vector<int>&   rowStart() const { return _rowStart; }
+  const std::vector<int>&   binIndex() const { return _binIndex; }
+  const std::vector<float>& weights()  const { return _weights; }
+
+private:
+  int _bands = 0;
+  int _bins = 0;
+  std::vector<float> _centers;    // bands + 2 log-spaced points (outer two are edges)
+  std::vector<int>   _rowStart;
+  std::vector<int>   _binIndex;
+  std::vector<float> _weights;
+};
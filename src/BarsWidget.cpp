@@ -1,6 +1,8 @@
 // BarsWidget.cpp
 #include "BarsWidget.h"
 #include <QPainter>
+#include <QScreen>
+#include <QResizeEvent>
 #include <QDateTime>
 #include <algorithm>
 #include <cmath>
@@ -9,60 +11,74 @@ BarsWidget::BarsWidget(QWidget* parent)
   : QWidget(parent)
 {
   setMinimumSize(200, 120);
-  setAutoFillBackground(true);
+  setAttribute(Qt::WA_OpaquePaintEvent);   // the background pixmap covers everything
   
   // Initialize trails
   _centroidLTrail.reserve(TRAIL_LEN);
   _centroidRTrail.reserve(TRAIL_LEN);
+
+  _renderTimer.setTimerType(Qt::PreciseTimer);
+  connect(&_renderTimer, &QTimer::timeout, this, &BarsWidget::onRenderTick);
+  applyRenderInterval();
 }
 
 QSize BarsWidget::sizeHint() const {
   return { 480, 240 };
 }
 
-void BarsWidget::setBinsRawStereo(const QVector<float>& left,
-                                  const QVector<float>& right)
+// --- render pacing ---
+
+void BarsWidget::setMaxFps(int fps)
 {
-  // Store copies
-  _left  = left;
-  _right = right;
-  
-  // Calculate centroids (equal weights - simple average of active bins)
-  _centroidL32 = calculateCentroid(_left);
-  _centroidR32 = calculateCentroid(_right);
-  
-  // Update trails
-  updateTrail(_centroidLTrail, _centroidL32);
-  updateTrail(_centroidRTrail, _centroidR32);
-  
-    _frameCounter++;
-    emit snapshotReady(captureSnapshot());
+  _maxFps = std::max(0, fps);
+  applyRenderInterval();
+}
 
-  update(); // trigger repaint
+void BarsWidget::applyRenderInterval()
+{
+  double hz = _maxFps;
+  if (hz <= 0) {
+    const QScreen* s = screen();
+    hz = (s && s->refreshRate() > 1.0) ? s->refreshRate() : 60.0;
+  }
+  _renderTimer.start(std::max(1, int(std::lround(1000.0 / hz))));
 }
 
-Snapshot BarsWidget::captureSnapshot() const
+void BarsWidget::showEvent(QShowEvent* ev)
 {
-    return Snapshot(_left, _right, _centroidL32, _centroidR32, _frameCounter);
+  QWidget::showEvent(ev);
+  applyRenderInterval();   // may be on a different screen than at construction
 }
 
-float BarsWidget::calculateCentroid(const QVector<float>& bins)
+void BarsWidget::changeEvent(QEvent* ev)
 {
-    if (bins.isEmpty()) return -1.0f;
-    
-    float weightedSum = 0.0f;
-    float totalWeight = 0.0f;
-    const float threshold = 0.001f;
-    
-    for (int i = 0; i < bins.size(); ++i) {
-        float weight = bins[i];
-        if (weight > threshold) {
-            weightedSum += i * weight;  // bin index * amplitude
-            totalWeight += weight;      // sum of amplitudes
-        }
-    }
-    
-    return (totalWeight > threshold) ? weightedSum / totalWeight : -1.0f;
+  QWidget::changeEvent(ev);
+  if (ev->type() == QEvent::PaletteChange) _geomBands = 0;   // background colour changed
+}
+
+void BarsWidget::setFrame(const SpectrumFramePtr& frame)
+{
+  if (!frame) return;
+  _frame = frame;   // shares the processor's frame; releases the previous one
+  _dirty = true;
+}
+
+void BarsWidget::onRenderTick()
+{
+  if (!_dirty || !isVisible()) return;
+  _dirty = false;
+
+  // Centroids come precomputed with the frame; the trail advances per drawn frame
+  updateTrail(_centroidLTrail, _frame->centroidL);
+  updateTrail(_centroidRTrail, _frame->centroidR);
+
+  _frameCounter++;
+  update(); // trigger repaint
+}
+
+Snapshot BarsWidget::captureSnapshot() const
+{
+    return _frame ? Snapshot(*_frame) : Snapshot();
 }
 
 void BarsWidget::updateTrail(QVector<float>& trail, float newCentroid)
@@ -77,57 +93,84 @@ void BarsWidget::updateTrail(QVector<float>& trail, float newCentroid)
   }
 }
 
-void BarsWidget::paintEvent(QPaintEvent*)
-{
-  QPainter p(this);
-  p.setRenderHint(QPainter::Antialiasing, true); // enable for smooth dots
+// --- geometry ---
 
-  const int n = std::min(_left.size(), _right.size());
-  if (n <= 0) {
-    p.fillRect(rect(), palette().window());
-    return;
-  }
+void BarsWidget::resizeEvent(QResizeEvent* ev)
+{
+  QWidget::resizeEvent(ev);
+  _geomBands = 0;   // rebuilt on next paint
+}
 
+void BarsWidget::rebuildGeometry(int n)
+{
   const QRect r = rect();
   const int rowH = r.height() / 2;
 
+  // Top: Left channel, Bottom: Right channel
+  _leftRect  = QRect(r.left(), r.top(), r.width(), rowH);
+  _rightRect = QRect(r.left(), r.top() + rowH, r.width(), r.height() - rowH);
+
   // Bar geometry
   const float gap = 1.0f;
-  const float barW = (r.width() - (n - 1) * gap) / float(n);
-  const int   barWi = std::max(1, int(std::floor(barW)));
-
-  auto drawRow = [&](const QVector<float>& bins, int y0, int h, const QColor& color)
+  _barW  = (r.width() - (n - 1) * gap) / float(n);
+  _barWi = std::max(1, int(std::floor(_barW)));
+  _barX.resize(n);
+  for (int i = 0; i < n; ++i) _barX[i] = r.left() + int(i * (_barW + gap));
+  _rects.resize(n);
+
+  // Static layer: window fill plus a faint divider between the two rows
+  const qreal dpr = devicePixelRatioF();
+  _background = QPixmap(r.size() * dpr);
+  _background.setDevicePixelRatio(dpr);
+  _background.fill(palette().window().color());
   {
-    float mx = 0.f;
-    for (float v : bins) mx = std::max(mx, v);
-    if (mx <= 0.f) mx = 1.f;
+    QPainter bg(&_background);
+    bg.setPen(palette().mid().color());
+    bg.drawLine(0, rowH, r.width(), rowH);
+  }
 
-    const float pad = 0.98f;
+  _geomBands = n;
+  _geomSize = r.size();
+}
+
+void BarsWidget::drawBars(QPainter& p, const float* bins, const QRect& row, const QColor& color)
+{
+  // bins are the frame's 0..1 dynamics levels: a fixed scale, no per-frame max
+  const int n = _geomBands;
+  const float pad = 0.98f;
+  const int h = row.height();
+  const float scale = pad * float(h - 1);
+
+  for (int i = 0; i < n; ++i) {
+    const int bh = std::clamp(int(std::lround(bins[i] * scale)), 0, h - 1);
+    _rects[i].setRect(_barX[i], row.top() + (h - bh), _barWi, bh);
+  }
+  // One batched call per channel
+  p.setBrush(color);
+  p.drawRects(_rects.constData(), n);
+}
 
-    for (int i = 0; i < n; ++i) {
-      const float v = std::clamp(bins[i] / mx, 0.f, 1.f) * pad;
-      const int   x = r.left() + int(i * (barW + gap));
-      const int   bh = std::max(0, int(std::round(v * (h - 1))));
-      const int   y = y0 + (h - bh);
+void BarsWidget::paintEvent(QPaintEvent*)
+{
+  QPainter p(this);
 
-      QRect bar(x, y, barWi, bh);
-      p.fillRect(bar, color);
-    }
-  };
+  const int n = _frame ? _frame->numBands : 0;
+  if (n <= 0) {
+    p.fillRect(rect(), palette().window());
+    return;
+  }
+  if (n != _geomBands || size() != _geomSize) rebuildGeometry(n);
 
-  // Clear background and draw bars
-  p.fillRect(r, palette().window());
-  
-  // Top: Left channel, Bottom: Right channel
-  const QRect leftRect(r.left(), r.top(), r.width(), rowH);
-  const QRect rightRect(r.left(), r.top() + rowH, r.width(), r.height() - rowH);
-  
-  drawRow(_left,  leftRect.top(),  leftRect.height(), QColor(80, 220, 120));
-  drawRow(_right, rightRect.top(), rightRect.height(), QColor(90, 160, 255));
+  // Background from cache, bars without antialiasing (axis-aligned anyway)
+  p.drawPixmap(0, 0, _background);
+  p.setPen(Qt::NoPen);
+  drawBars(p, _frame->levelL, _leftRect,  QColor(80, 220, 120));
+  drawBars(p, _frame->levelR, _rightRect, QColor(90, 160, 255));
   
   // Draw centroid trails and current positions
-  drawCentroidAndTrail(p, leftRect, n, _centroidL32, _centroidLTrail, QColor(255, 0, 0));
-  drawCentroidAndTrail(p, rightRect, n, _centroidR32, _centroidRTrail, QColor(255, 0, 0));
+  p.setRenderHint(QPainter::Antialiasing, true); // enable for smooth dots
+  drawCentroidAndTrail(p, _leftRect, n, _frame->centroidL, _centroidLTrail, QColor(255, 0, 0));
+  drawCentroidAndTrail(p, _rightRect, n, _frame->centroidR, _centroidRTrail, QColor(255, 0, 0));
 }
 
 void BarsWidget::drawCentroidAndTrail(QPainter& p, const QRect& barsRect, int numBars, 
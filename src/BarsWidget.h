@@ -1,7 +1,10 @@
 #pragma once
 #include <QWidget>
 #include <QVector>
+#include <QPixmap>
+#include <QTimer>
 #include <Snapshot.h>
+#include "SpectrumFrame.h"
 
 class BarsWidget : public QWidget {
   Q_OBJECT
@@ -10,23 +13,44 @@ public:
 
   QSize sizeHint() const override;
 
+  // Repaint cap. 0 = follow the screen's refresh rate (default).
+  void setMaxFps(int fps);
+  int maxFps() const { return _maxFps; }
+
 public slots:
-  void setBinsRawStereo(const QVector<float>& left, const QVector<float>& right);
+  // Hold on to the processor's frame (no copy). Cheap: the render timer picks
+  // up whatever frame is newest, so hops faster than the display are skipped.
+  void setFrame(const SpectrumFramePtr& frame);
 
   Snapshot captureSnapshot() const;
 
-signals:
-  void snapshotReady(const Snapshot& snapshot);
-
 protected:
   void paintEvent(QPaintEvent* ev) override;
+  void resizeEvent(QResizeEvent* ev) override;
+  void showEvent(QShowEvent* ev) override;
+  void changeEvent(QEvent* ev) override;
 
 private:
   int _frameCounter = 0;
-  QVector<float> _left, _right;
-  
-  float _centroidL32 = -1.0f;
-  float _centroidR32 = -1.0f;
+  SpectrumFramePtr _frame;          // latest frame (bands + centroids)
+  bool _dirty = false;              // new frame since the last paint
+
+  // --- render pacing ---
+  QTimer _renderTimer;
+  int _maxFps = 0;
+  void applyRenderInterval();
+  void onRenderTick();
+
+  // --- cached geometry (rebuilt on resize / band count change) ---
+  int _geomBands = 0;
+  QSize _geomSize;
+  QRect _leftRect, _rightRect;
+  QVector<int> _barX;               // left edge of each bar
+  int _barWi = 1;
+  float _barW = 1.0f;
+  QPixmap _background;              // window fill + row divider
+  QVector<QRect> _rects;            // reused per paint, one batch per channel
+  void rebuildGeometry(int numBands);
 
   // Trail data for each channel
   QVector<float> _centroidLTrail;
@@ -34,11 +58,11 @@ private:
   static constexpr int TRAIL_LEN = 12;
 
   // Helper methods
-  float calculateCentroid(const QVector<float>& bins);
   void updateTrail(QVector<float>& trail, float newCentroid);
+  void drawBars(QPainter& p, const float* bins, const QRect& row, const QColor& color);
   void drawCentroidAndTrail(QPainter& p, const QRect& barsRect, int numBars, 
                            float centroid, const QVector<float>& trail, 
                            const QColor& color);
 
 
-};
\ No newline at end of file
+};
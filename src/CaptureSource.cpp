@@ -0,0 +1,180 @@
+#include "CaptureSource.h"
+#include "MiniaudioSource.h"
+#include "FileCaptureSource.h"
+#include "UdpPcmSource.h"
+#include <QStringList>
+#include <QHostAddress>
+#include <QRegularExpression>
+#include <algorithm>
+#include <cstring>
+
+// --- PCM conversion ---
+
+int pcmBytesPerSample(PcmFormat f) {
+  switch (f) {
+    case PcmFormat::S16LE: case PcmFormat::S16BE: return 2;
+    case PcmFormat::S24LE: return 3;
+    case PcmFormat::S32LE: case PcmFormat::F32LE: return 4;
+  }
+  return 2;
+}
+
+static inline float pcmSample(const unsigned char* p, PcmFormat f) {
+  switch (f) {
+    case PcmFormat::S16LE: return float(int16_t(uint16_t(p[0] | (p[1] << 8)))) * (1.0f / 32768.0f);
+    case PcmFormat::S16BE: return float(int16_t(uint16_t((p[0] << 8) | p[1]))) * (1.0f / 32768.0f);
+    case PcmFormat::S24LE:
+      return float(int32_t((uint32_t(p[0]) << 8) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 24)) >> 8)
+             * (1.0f / 8388608.0f);
+    case PcmFormat::S32LE:
+      return float(double(int32_t(uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) |
+                                  (uint32_t(p[3]) << 24))) * (1.0 / 2147483648.0));
+    case PcmFormat::F32LE: { float v; std::memcpy(&v, p, 4); return v; }
+  }
+  return 0.0f;
+}
+
+void pushPcm(CaptureSink* sink, const char* data, int frames, int channels, PcmFormat fmt, int64_t stampNs) {
+  if (!sink || frames <= 0 || channels <= 0) return;
+  const auto* p = reinterpret_cast<const unsigned char*>(data);
+  const int bps = pcmBytesPerSample(fmt);
+  const int used = std::min(channels, CaptureSpec::kMaxChannels);   // every channel: rings pick their own pair
+
+  // Convert through a small stack block; the ring copy is the only other pass
+  constexpr int kBlockSamples = 1024;
+  float tmp[kBlockSamples];
+  const int block = kBlockSamples / used;
+  while (frames > 0) {
+    const int n = std::min(frames, block);
+    for (int i = 0; i < n; ++i, p += size_t(bps) * channels) {
+      for (int c = 0; c < used; ++c) tmp[i * used + c] = pcmSample(p + c * bps, fmt);
+    }
+    sink->pushFrames(tmp, unsigned(n), unsigned(used), stampNs);
+    frames -= n;
+  }
+}
+
+// --- spec parsing ---
+
+static bool parseFormat(const QString& s, PcmFormat& out) {
+  const QString v = s.toLower();
+  if (v == "s16le" || v == "s16") { out = PcmFormat::S16LE; return true; }
+  if (v == "s16be" || v == "l16") { out = PcmFormat::S16BE; return true; }
+  if (v == "s24le" || v == "s24") { out = PcmFormat::S24LE; return true; }
+  if (v == "s32le" || v == "s32") { out = PcmFormat::S32LE; return true; }
+  if (v == "f32le" || v == "f32" || v == "float") { out = PcmFormat::F32LE; return true; }
+  return false;
+}
+
+bool CaptureSpec::parse(const QString& text, CaptureSpec& out, QString* error) {
+  auto fail = [&](const QString& msg) { if (error) *error = msg; return false; };
+
+  CaptureSpec spec;
+  QString s = text.trimmed();
+  if (s.isEmpty()) { out = spec; return true; }
+
+  // kind[:arg][?k=v&k=v]; the arg may itself hold ':' (Windows paths)
+  QString query;
+  const int q = s.lastIndexOf('?');
+  if (q >= 0) { query = s.mid(q + 1); s.truncate(q); }
+  const int colon = s.indexOf(':');
+  const QString kind = (colon >= 0 ? s.left(colon) : s).toLower();
+  const QString arg = colon >= 0 ? s.mid(colon + 1) : QString();
+
+  if (kind == "loopback")    spec.kind = Kind::Loopback;
+  else if (kind == "device") { spec.kind = Kind::Device; spec.device = arg; }
+  else if (kind == "file")   { spec.kind = Kind::File; spec.path = arg; }
+  else if (kind == "raw")    { spec.kind = Kind::Raw; spec.path = arg; }
+  else if (kind == "udp" || kind == "rtp") {
+    spec.kind = kind == "udp" ? Kind::Udp : Kind::Rtp;
+    if (spec.kind == Kind::Rtp) spec.format = PcmFormat::S16BE;
+    bool ok = false;
+    const uint port = arg.toUInt(&ok);
+    if (!ok || port == 0 || port > 65535) return fail(QString("capture: bad port '%1'").arg(arg));
+    spec.port = quint16(port);
+  } else {
+    return fail(QString("capture: unknown source '%1' (loopback, device, file, raw, udp, rtp)").arg(kind));
+  }
+  if ((spec.kind == Kind::File || spec.kind == Kind::Raw) && spec.path.isEmpty())
+    return fail("capture: missing file path");
+
+  for (const QString& kv : query.split('&', Qt::SkipEmptyParts)) {
+    const int eq = kv.indexOf('=');
+    const QString key = (eq >= 0 ? kv.left(eq) : kv).toLower();
+    const QString val = eq >= 0 ? kv.mid(eq + 1) : QString();
+    bool ok = true;
+    if (key == "loop")      spec.loop = val.isEmpty() || val != "0";
+    else if (key == "rate") { spec.sampleRate = val.toInt(&ok); ok = ok && spec.sampleRate >= 8000 && spec.sampleRate <= 384000; }
+    else if (key == "ch")   {
+      // ch=0 opens a device with its native channel count; file/network input must say
+      spec.channels = val.toInt(&ok);
+      const bool native = spec.kind == Kind::Loopback || spec.kind == Kind::Device;
+      ok = ok && spec.channels >= (native ? 0 : 1) && spec.channels <= kMaxChannels;
+    }
+    else if (key == "fmt")  ok = parseFormat(val, spec.format);
+    else if (key == "group") { spec.group = val; ok = QHostAddress(val).isMulticast(); }
+    else return fail(QString("capture: unknown option '%1'").arg(key));
+    if (!ok) return fail(QString("capture: bad value for '%1': '%2'").arg(key, val));
+  }
+  out = spec;
+  return true;
+}
+
+bool CaptureZone::parseList(const QString& text, QVector<CaptureZone>& out, QString* error) {
+  auto fail = [&](const QString& msg) { if (error) *error = "zones: " + msg; return false; };
+
+  QVector<CaptureZone> zones;
+  // Not split at spaces: device names have them
+  for (const QString& raw : text.split(QRegularExpression("[,;]"), Qt::SkipEmptyParts)) {
+    const QString item = raw.trimmed();
+    if (item.isEmpty()) continue;
+    const int eq = item.indexOf('=');
+    if (eq <= 0) return fail(QString("expected name=[source]#channels, got '%1'").arg(item));
+
+    CaptureZone z;
+    z.name = item.left(eq).trimmed();
+    if (!QRegularExpression("^[A-Za-z0-9_-]+$").match(z.name).hasMatch() || z.name == "main")
+      return fail(QString("bad zone name '%1'").arg(z.name));
+    for (const CaptureZone& other : zones)
+      if (other.name == z.name) return fail(QString("duplicate zone '%1'").arg(z.name));
+
+    QString rest = item.mid(eq + 1).trimmed();
+    const int hash = rest.lastIndexOf('#');
+    if (hash >= 0) {
+      const QString ch = rest.mid(hash + 1).trimmed();
+      rest.truncate(hash);
+      const QStringList parts = ch.split('-');
+      bool okL = false, okR = true;
+      const int l = parts.value(0).toInt(&okL);
+      const int r = parts.size() > 1 ? parts[1].toInt(&okR) : l;
+      if (parts.size() > 2 || !okL || !okR || l < 1 || r < 1
+          || l > CaptureSpec::kMaxChannels || r > CaptureSpec::kMaxChannels)
+        return fail(QString("bad channels '#%1' for zone '%2' (1-%3, e.g. #3 or #3-4)")
+                      .arg(ch, z.name).arg(CaptureSpec::kMaxChannels));
+      z.left = l - 1;
+      z.right = r - 1;
+    }
+    z.source = rest.trimmed();
+    CaptureSpec spec;
+    QString specError;
+    if (!CaptureSpec::parse(z.source, spec, &specError))
+      return fail(QString("zone '%1': %2").arg(z.name, specError));
+
+    if (zones.size() >= kMaxZones) return fail(QString("at most %1").arg(kMaxZones));
+    zones.push_back(z);
+  }
+  out = zones;
+  return true;
+}
+
+std::unique_ptr<CaptureSource> CaptureSource::create(const CaptureSpec& spec) {
+  switch (spec.kind) {
+    case CaptureSpec::Kind::Loopback: return std::make_unique<MiniaudioSource>(MiniaudioSource::Loopback, QString(), spec.channels);
+    case CaptureSpec::Kind::Device:   return std::make_unique<MiniaudioSource>(MiniaudioSource::Capture, spec.device, spec.channels);
+    case CaptureSpec::Kind::File:
+    case CaptureSpec::Kind::Raw:      return std::make_unique<FileCaptureSource>(spec);
+    case CaptureSpec::Kind::Udp:
+    case CaptureSpec::Kind::Rtp:      return std::make_unique<UdpPcmSource>(spec);
+  }
+  return nullptr;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <cstdint>
+#include <memory>
+
+// Pluggable audio inputs for AudioCapture.
+//
+// A source produces interleaved PCM and hands it to a CaptureSink (AudioCapture),
+// which de-interleaves straight into every attached StereoRingBuffer and stamps
+// the write. Sources only ever call the sink from one thread at a time (the
+// miniaudio callback, or the capture thread for timer/socket driven sources).
+//
+// Sources are picked with a spec string (AudioCapture::setSourceSpec, or the
+// WLEDQT_CAPTURE environment variable):
+//
+//   loopback                         system output (WASAPI loopback; default)
+//   device[:name][?ch=N]             capture device whose name contains `name`
+//                                    (line-in, or a PulseAudio "*.monitor" source);
+//                                    ch=0 opens every input of a multichannel interface
+//   file:path.wav[?loop]             WAV file, paced at its own sample rate
+//   raw:path?rate=48000&ch=2&fmt=s16le[&loop]    headerless PCM (s16le, s24le, s32le, f32le)
+//   udp:port[?rate=..&ch=..&fmt=..&group=239.x.x.x]   raw PCM datagrams (default s16le 48k stereo)
+//   rtp:port[?rate=..&ch=..&group=..]               RTP L16 (RFC 3551, big-endian 16-bit)
+
+class CaptureSink {
+public:
+  virtual ~CaptureSink() = default;
+  // Interleaved float frames, any channel count (each ring takes its own L/R pair).
+  virtual void pushFrames(const float* interleaved, unsigned frames, unsigned channels, int64_t stampNs) = 0;
+  // Keep cadence through a glitch / lost packets.
+  virtual void pushSilence(unsigned frames, int64_t stampNs) = 0;
+  // Non-looping file ran out (called on the capture thread).
+  virtual void sourceFinished() = 0;
+};
+
+// Sample formats for file / network input
+enum class PcmFormat { S16LE, S24LE, S32LE, F32LE, S16BE };
+int pcmBytesPerSample(PcmFormat f);
+// Convert `frames` interleaved frames of `channels` into float, in blocks, calling
+// sink->pushFrames for each block (no allocation).
+void pushPcm(CaptureSink* sink, const char* data, int frames, int channels, PcmFormat fmt, int64_t stampNs);
+
+struct CaptureSpec {
+  enum class Kind { Loopback, Device, File, Raw, Udp, Rtp };
+  Kind kind = Kind::Loopback;
+  QString device;                 // Device: name substring (empty = default device)
+  QString path;                   // File / Raw
+  bool loop = false;              // File / Raw
+  quint16 port = 0;               // Udp / Rtp
+  QString group;                  // Udp / Rtp: optional multicast group to join
+  int sampleRate = 48000;         // Raw / Udp / Rtp (files with a header report their own)
+  int channels = 2;               // Device / Loopback: 0 = native count
+  PcmFormat format = PcmFormat::S16LE;
+  static constexpr int kMaxChannels = 32;
+
+  // Returns false (and a message) for an unknown kind or bad option.
+  static bool parse(const QString& spec, CaptureSpec& out, QString* error = nullptr);
+};
+
+// Analysis zones: channel groups, each analysed by its own AudioProcessor, e.g.
+//
+//   kick=device:Focusrite?ch=0#1, bass=#2, vocals=#3-4, room=device:USB Mic#1
+//
+// name=[source]#ch[-ch], comma or semicolon separated. `source` is a
+// CaptureSpec; empty means the pipeline's main source, and zones naming the
+// same spec share one capture. Channels are 1-based: "#3" is mono, "#3-4" a
+// stereo pair (default "#1-2").
+struct CaptureZone {
+  QString name;
+  QString source;
+  int left = 0, right = 1;        // 0-based channels within the source
+
+  static constexpr int kMaxZones = 8;
+  static bool parseList(const QString& text, QVector<CaptureZone>& out, QString* error = nullptr);
+};
+
+class CaptureSource {
+public:
+  virtual ~CaptureSource() = default;
+
+  // Open and start producing into `sink`. On success fills the actual sample
+  // rate / channel count and a one-line description; on failure an error.
+  virtual bool start(CaptureSink* sink, int& sampleRate, int& channels, QString& info) = 0;
+  virtual void stop() = 0;
+
+  static std::unique_ptr<CaptureSource> create(const CaptureSpec& spec);
+};
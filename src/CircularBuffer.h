@@ -0,0 +1,97 @@
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// Mirrored ring buffer for sliding analysis windows.
+//
+// Every sample is stored twice, at i and at i + capacity, so any run of up to
+// `capacity` samples is one contiguous block of memory. FFT frames can be read
+// straight out of the buffer (peek) and the window slides by moving an index
+// (advance) instead of erasing from the front of a vector.
+//
+// Single-threaded: owned and used by one DSP thread.
+class CircularBuffer {
+public:
+  CircularBuffer() = default;
+  explicit CircularBuffer(int capacity) { reset(capacity); }
+
+  // Storage for capacities up to `maxCapacity`, so later reset() / resize()
+  // calls within it don't allocate.
+  void reserve(int maxCapacity) { _data.reserve(size_t(2 * std::max(1, maxCapacity))); }
+
+  // (Re)allocate for `capacity` samples and empty the buffer.
+  void reset(int capacity) {
+    _capacity = std::max(1, capacity);
+    _data.assign(size_t(2 * _capacity), 0.0f);
+    clear();
+  }
+
+  void clear() { _writePos = 0; _size = 0; }
+
+  // Change the capacity keeping the newest min(size, capacity) samples
+  // (e.g. a new FFT size without losing the audio already buffered). In
+  // place: the kept run moves to the front and is mirrored again, so within
+  // reserve() nothing is allocated.
+  void resize(int capacity) {
+    capacity = std::max(1, capacity);
+    if (capacity == _capacity) return;
+    const int keep = std::min(_size, capacity);
+    const int from = _writePos - keep + _capacity;   // newest(keep), contiguous
+    if (_data.size() < size_t(2 * capacity)) _data.resize(size_t(2 * capacity));
+    std::memmove(_data.data(), _data.data() + from, size_t(keep) * sizeof(float));
+    std::memcpy(_data.data() + capacity, _data.data(), size_t(keep) * sizeof(float));
+    _capacity = capacity;
+    _writePos = keep % capacity;
+    _size = keep;
+  }
+
+  int capacity() const { return _capacity; }
+  int size()     const { return _size; }
+  int space()    const { return _capacity - _size; }
+  bool canRead(int count) const { return _size >= count; }
+
+  // Append samples. If more arrive than fit, the oldest are overwritten.
+  void push(const float* samples, int count) {
+    if (count <= 0) return;
+    if (count > _capacity) {              // only the newest `capacity` can survive
+      samples += count - _capacity;
+      count = _capacity;
+    }
+    const int first = std::min(count, _capacity - _writePos);
+    writeMirrored(_writePos, samples, first);
+    writeMirrored(0, samples + first, count - first);
+    _writePos = (_writePos + count) % _capacity;
+    _size = std::min(_capacity, _size + count);
+  }
+
+  // Contiguous view of the oldest `count` samples (requires canRead(count)).
+  const float* peek(int count) const {
+    (void)count;
+    return _data.data() + readPos();
+  }
+
+  // Contiguous view of the newest `count` samples (requires canRead(count)).
+  const float* newest(int count) const {
+    return _data.data() + (_writePos - count + _capacity);
+  }
+
+  // Drop the oldest `count` samples (slide the window forward).
+  void advance(int count) {
+    _size = std::max(0, _size - std::max(0, count));
+  }
+
+private:
+  int readPos() const { return (_writePos - _size + _capacity) % _capacity; }
+
+  void writeMirrored(int pos, const float* src, int count) {
+    if (count <= 0) return;
+    std::memcpy(_data.data() + pos, src, size_t(count) * sizeof(float));
+    std::memcpy(_data.data() + pos + _capacity, src, size_t(count) * sizeof(float));
+  }
+
+  std::vector<float> _data;   // 2 * capacity, second half mirrors the first
+  int _capacity = 0;
+  int _writePos = 0;          // next write index in [0, capacity)
+  int _size = 0;              // valid samples
+};
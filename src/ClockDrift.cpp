@@ -0,0 +1,82 @@
+#include "ClockDrift.h"
+#include <algorithm>
+
+void ClockDrift::reset() {
+  _rate.store(0, std::memory_order_relaxed);
+  restart(0);
+}
+
+void ClockDrift::restart(int rate) {
+  _appliedRate = rate;
+  _nsPerFrame = rate > 0 ? 1e9 / rate : 0.0;
+  _started = false;
+  _count = _head = 0;
+  _haveFit = false;
+  _a = _b = 0.0;
+  _ppm.store(0.0, std::memory_order_relaxed);
+  _settled.store(false, std::memory_order_relaxed);
+}
+
+int64_t ClockDrift::update(uint64_t frames, int64_t ns) {
+  const int rate = _rate.load(std::memory_order_relaxed);
+  if (rate != _appliedRate) restart(rate);
+  if (_nsPerFrame <= 0.0) return ns;
+  if (!_started) {
+    _started = true;
+    _t0 = ns;
+    _f0 = frames;
+    _blockMin = 0.0;
+    _blockAt = 0.0;
+    _blockEnd = ns + kBlockNs;
+    return ns;
+  }
+
+  const double t = double(ns - _t0);
+  const double expected = double(frames - _f0) * _nsPerFrame;
+  const double offset = t - expected;
+
+  if (ns >= _blockEnd) {
+    _x[_head] = _blockAt;
+    _y[_head] = _blockMin;
+    _head = (_head + 1) % kBlocks;
+    _count = std::min(_count + 1, kBlocks);
+    fit();
+    _blockMin = offset;
+    _blockAt = t;
+    _blockEnd = ns + kBlockNs;
+  } else if (offset < _blockMin) {
+    _blockMin = offset;
+    _blockAt = t;
+  }
+
+  if (!_haveFit) return ns;
+  // t = expected + a + b*t, solved for t
+  const int64_t fitted = _t0 + int64_t((expected + _a) / (1.0 - _b));
+  // Far later than the line: frames went missing (stream gap, device hiccup), start over
+  if (ns - fitted > kResyncNs) {
+    restart(_appliedRate);
+    return ns;
+  }
+  return std::min(fitted, ns);
+}
+
+void ClockDrift::fit() {
+  if (_count < kMinBlocks) return;
+  double mx = 0.0, my = 0.0;
+  for (int i = 0; i < _count; ++i) { mx += _x[i]; my += _y[i]; }
+  mx /= _count;
+  my /= _count;
+  double sxy = 0.0, sxx = 0.0;
+  for (int i = 0; i < _count; ++i) {
+    const double dx = _x[i] - mx;
+    sxy += dx * (_y[i] - my);
+    sxx += dx * dx;
+  }
+  if (sxx <= 0.0) return;
+  _b = sxy / sxx;
+  _a = my - _b * mx;
+  _haveFit = true;
+  // Offset growing = frames arriving later than nominal = device clock slow
+  _ppm.store(-_b * 1e6, std::memory_order_relaxed);
+  _settled.store(true, std::memory_order_relaxed);
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// How fast a capture device's clock runs against the steady clock, from the
+// stamps of its callbacks alone.
+//
+// Every callback gives (frames delivered so far, when). The offset between
+// the stamp and where a perfect clock at the nominal rate would be grows
+// linearly with drift, but each stamp also carries scheduling jitter of up to
+// a period, for 10 ms periods far more than the drift over a minute. Jitter
+// only ever makes a callback late, so the minimum offset of each 2 s block
+// tracks the true line closely; a least-squares line through the last 32
+// block minima (about a minute) gives the drift, and the line itself gives
+// de-jittered capture times for the ring stamps. A stamp far behind the line
+// means frames were lost rather than late, and the fit starts over.
+//
+// update() runs in the capture callback: fixed arrays, no allocation, a
+// 32-point fit once per block. ppm() is readable from any thread.
+class ClockDrift {
+public:
+  // Before the callback starts; stamps pass through until a rate is set
+  void reset();
+  // Any thread (the source may already be delivering): the fit starts over at this rate
+  void setNominalRate(int rate) { _rate.store(rate, std::memory_order_relaxed); }
+
+  // Callback thread: `frames` delivered in total after this block, raw stamp
+  // of its newest frame. Returns the stamp to use (raw until the fit settles,
+  // otherwise the earlier of raw and the fitted line).
+  int64_t update(uint64_t frames, int64_t ns);
+
+  // Device clock against the steady clock, parts per million (+ = device fast); 0 until settled
+  double ppm() const { return _ppm.load(std::memory_order_relaxed); }
+  bool settled() const { return _settled.load(std::memory_order_relaxed); }
+
+  static constexpr int64_t kBlockNs = 2000000000;   // one minimum per 2 s
+  static constexpr int kBlocks = 32;
+  static constexpr int kMinBlocks = 4;               // before ppm() / fitted stamps
+  static constexpr int64_t kResyncNs = 50000000;    // raw this far behind the line = lost frames
+
+private:
+  void fit();
+  void restart(int rate);
+
+  std::atomic<int> _rate{0};
+  int     _appliedRate = 0;
+  double  _nsPerFrame = 0.0;  // at the nominal rate
+  int64_t _t0 = 0;            // first stamp; everything below is relative to it
+  uint64_t _f0 = 0;
+  bool    _started = false;
+
+  double  _blockMin = 0.0;     // smallest offset (ns) in the current block
+  double  _blockAt = 0.0;      // its time since _t0 (ns)
+  int64_t _blockEnd = 0;
+
+  double  _x[kBlocks] = {};    // block minima: time since _t0, offset
+  double  _y[kBlocks] = {};
+  int     _count = 0, _head = 0;
+
+  double  _a = 0.0, _b = 0.0;  // offset(t) = _a + _b * t
+  bool    _haveFit = false;
+  std::atomic<double> _ppm{0.0};
+  std::atomic<bool>   _settled{false};
+};
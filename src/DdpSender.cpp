@@ -0,0 +1,480 @@
+#include "DdpSender.h"
+#include "AdvancedAudioProcessor.h"
+#include "LatencyTracer.h"
+#include "NodeProbe.h"
+#include <QUdpSocket>
+#include <QTimer>
+#include <QRegularExpression>
+#include <QMutexLocker>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// DDP (http://www.3waylabs.com/ddp/): 10-byte header, then channel data
+constexpr int     kDdpHeader   = 10;
+constexpr int     kDdpMaxData  = 1440;          // 480 RGB pixels, what WLED expects
+constexpr uint8_t kDdpVer1     = 0x40;
+constexpr uint8_t kDdpPush     = 0x01;
+constexpr uint8_t kDdpTypeRgb8 = 0x0B;          // RGB, 8 bits per channel
+constexpr uint8_t kDdpIdDisplay = 1;
+
+// WLED UDP realtime: [protocol, timeout s, (DNRGB: start index hi, lo)], then RGB
+constexpr uint8_t kDrgb = 2, kDnrgb = 4;
+constexpr int     kDrgbMaxLeds  = 490;
+constexpr int     kDnrgbMaxLeds = 489;
+constexpr uint8_t kRealtimeTimeoutS = 2;        // WLED returns to its own effects after this
+
+constexpr quint16 kDdpPort = 4048, kRealtimePort = 21324;
+}
+
+struct DdpSender::Segment {
+  LedSegment      cfg;
+  LedSegmentStats stats;
+  SendPolicy      policy;
+  // One-deep queue: the current frame's packets back to back in `data`,
+  // `ends[i]` = end offset of packet i. Sized once in setSegments().
+  std::vector<char> data;
+  std::vector<int>  ends;
+  int  next = 0;                   // first packet not sent yet
+  bool pending = false;
+  uint8_t seq = 0;                 // DDP sequence, 1..15
+  // Same events as stats, for the metrics endpoint (never reset)
+  metrics::Counter frames, packets, errors, superseded, suppressed;
+};
+
+DdpSender::DdpSender(QObject* parent) : QObject(parent) {
+}
+
+DdpSender::~DdpSender() {
+  for (Segment* s : _segments) delete s;
+}
+
+// --- segments ---
+
+bool DdpSender::parseSegments(const QString& text, QVector<LedSegment>& out, QString* error) {
+  out.clear();
+  auto fail = [&](const QString& msg) { if (error) *error = msg; return false; };
+  static const QRegularExpression sep("[,;\\s]+");
+  int cursor = 0;                  // next unassigned pixel for "/leds" entries
+  for (QString item : text.split(sep, Qt::SkipEmptyParts)) {
+    LedSegment seg;
+    const int q = item.indexOf('?');
+    if (q >= 0) {
+      for (const QString& o : item.mid(q + 1).split('&', Qt::SkipEmptyParts)) {
+        const QString opt = o.toLower();
+        if (opt == "drgb" || opt == "dnrgb") seg.protocol = LedSegment::Protocol::Drgb;
+        else if (opt == "ddp") seg.protocol = LedSegment::Protocol::Ddp;
+        else if (opt == "harm" || opt == "harmonic") seg.source = LedSegment::Source::Harmonic;
+        else if (opt == "perc" || opt == "percussive") seg.source = LedSegment::Source::Percussive;
+        else if (opt == "full") seg.source = LedSegment::Source::Full;
+        else if (opt.startsWith("zone=") && o.size() > 5) seg.zoneName = o.mid(5);   // names keep their case
+        else return fail(QString("LEDs: unknown option '%1' (ddp, drgb, full, harm, perc, zone=name)").arg(opt));
+      }
+      item.truncate(q);
+    }
+    seg.port = seg.protocol == LedSegment::Protocol::Ddp ? kDdpPort : kRealtimePort;
+
+    const int slash = item.indexOf('/');
+    if (slash < 0) return fail(QString("LEDs: missing '/leds' in '%1'").arg(item));
+    const QString range = item.mid(slash + 1);
+    item.truncate(slash);
+    const int dash = range.indexOf('-');
+    bool ok1 = false, ok2 = true;
+    if (dash >= 0) {
+      seg.first = range.left(dash).toInt(&ok1);
+      const int last = range.mid(dash + 1).toInt(&ok2);
+      seg.count = last - seg.first + 1;
+    } else {
+      seg.first = cursor;
+      seg.count = range.toInt(&ok1);
+    }
+    if (!ok1 || !ok2 || seg.first < 0 || seg.count <= 0 || seg.first + seg.count > kMaxLeds)
+      return fail(QString("LEDs: bad range '%1' (1..%2 pixels)").arg(range).arg(kMaxLeds));
+    cursor = std::max(cursor, seg.first + seg.count);
+
+    const int colon = item.lastIndexOf(':');
+    if (colon >= 0) {
+      bool ok = false;
+      const int p = item.mid(colon + 1).toInt(&ok);
+      if (!ok || p <= 0 || p > 65535) return fail(QString("LEDs: bad port in '%1'").arg(item));
+      seg.port = quint16(p);
+      item.truncate(colon);
+    }
+    if (!seg.address.setAddress(item) || seg.address.protocol() != QAbstractSocket::IPv4Protocol)
+      return fail(QString("LEDs: bad IPv4 address '%1'").arg(item));
+    out.push_back(seg);
+  }
+  return true;
+}
+
+void DdpSender::setSegments(const QVector<LedSegment>& segments) {
+  QMutexLocker lock(&_statsMutex);
+  for (Segment* s : _segments) delete s;
+  _segments.clear();
+  _segments.reserve(segments.size());
+  int leds = 0;
+  _used = 0;
+  for (const LedSegment& cfg : segments) {
+    if (cfg.count <= 0 || cfg.first < 0 || cfg.first + cfg.count > kMaxLeds) continue;
+    if (cfg.zone < 0 || cfg.zone >= LedSegment::kZones) continue;
+    auto* s = new Segment;
+    s->cfg = cfg;
+    s->stats.address = cfg.address;
+    s->stats.first = cfg.first;
+    s->stats.count = cfg.count;
+    // Worst case per protocol: DDP 480 px/packet, realtime 489 px/packet
+    const int perPacket = cfg.protocol == LedSegment::Protocol::Ddp ? kDdpMaxData / 3 : kDnrgbMaxLeds;
+    const int packets = (cfg.count + perPacket - 1) / perPacket;
+    s->data.resize(size_t(packets) * kDdpHeader + size_t(cfg.count) * 3);
+    s->ends.reserve(size_t(packets));
+    s->policy.configure(_policy);
+    const std::string seg = metrics::labels({
+      {"target", QString("%1:%2").arg(cfg.address.toString()).arg(cfg.port).toStdString()},
+      {"pixels", QString("%1-%2").arg(cfg.first).arg(cfg.first + cfg.count - 1).toStdString()}});
+    s->frames.bind("wledqt_led_frames_total", seg, "LED frames completely sent");
+    s->packets.bind("wledqt_led_packets_total", seg, "LED datagrams sent");
+    s->errors.bind("wledqt_led_errors_total", seg, "LED datagrams the socket refused");
+    s->superseded.bind("wledqt_led_superseded_total", seg, "LED frames replaced while still queued");
+    s->suppressed.bind("wledqt_led_suppressed_total", seg, "LED frames held back by the send policy");
+    _segments.push_back(s);
+    leds = std::max(leds, cfg.first + cfg.count);
+    _used |= 1u << (cfg.zone * LedSegment::kSources + int(cfg.source));
+  }
+  _ledCount = leds;
+  for (int z = 0; z < LedSegment::kZones; ++z)
+    for (int src = 0; src < LedSegment::kSources; ++src)
+      _engines[z][src].setLedCount(_used & (1u << (z * LedSegment::kSources + src)) ? leds : 0);
+  updateProbeNodes();
+}
+
+// --- send policy ---
+
+void DdpSender::setSendPolicy(const SendPolicyConfig& cfg) {
+  QMutexLocker lock(&_statsMutex);
+  _policy = cfg;
+  for (Segment* s : _segments) s->policy.configure(cfg);
+  updateProbeNodes();
+}
+
+// Caller holds _statsMutex.
+void DdpSender::updateProbeNodes() {
+  if (!_probe) return;
+  QVector<QHostAddress> nodes;
+  if (_policy.enabled)
+    for (const Segment* s : _segments) nodes.push_back(s->cfg.address);
+  _probe->setNodes(nodes);
+}
+
+void DdpSender::onProbe(const QHostAddress& node, float rttMs, bool ok) {
+  QMutexLocker lock(&_statsMutex);
+  for (Segment* s : _segments) {
+    if (!(s->cfg.address == node)) continue;
+    if (ok) s->policy.reportRtt(rttMs); else s->policy.reportProbeLost();
+    s->stats.rttMs = s->policy.rttMs();
+    s->stats.intervalMs = float(s->policy.intervalMs());
+  }
+}
+
+// --- stats ---
+
+QVector<LedSegmentStats> DdpSender::segmentStats() const {
+  QMutexLocker lock(&_statsMutex);
+  QVector<LedSegmentStats> out;
+  out.reserve(int(_segments.size()));
+  for (const Segment* s : _segments) out.push_back(s->stats);
+  return out;
+}
+
+void DdpSender::resetStats() {
+  QMutexLocker lock(&_statsMutex);
+  for (Segment* s : _segments) {
+    LedSegmentStats blank{s->stats.address, s->stats.first, s->stats.count};
+    blank.intervalMs = s->stats.intervalMs;
+    blank.rttMs = s->stats.rttMs;
+    s->stats = blank;
+  }
+}
+
+// --- settings ---
+
+void DdpSender::setEnabled(bool on) {
+  _enabled = on;
+  _lastRenderNs = 0;               // no catch-up step after a pause
+  if (_probe) { if (on) _probe->start(); else _probe->stop(); }
+}
+
+void DdpSender::setEffect(int effect) {
+  if (effect >= 0 && effect < int(LedEffectEngine::Effect::Count))
+    for (auto& zone : _engines)
+      for (LedEffectEngine& e : zone) e.setEffect(LedEffectEngine::Effect(effect));
+}
+
+void DdpSender::setBrightness(double b) {
+  for (auto& zone : _engines)
+    for (LedEffectEngine& e : zone) e.setBrightness(float(b));
+}
+
+void DdpSender::setFps(double fps) {
+  _fps = std::clamp(fps, 1.0, 240.0);
+  _periodNs = int64_t(1e9 / _fps);
+}
+
+// --- producers ---
+
+void DdpSender::submitZoneFrame(int zone, const SpectrumFramePtr& frame) {
+  if (!frame || zone < 0 || zone >= LedSegment::kZones) return;
+  LevelsSlot& s = _zones[zone].mailbox.writeBuffer();
+  std::copy(frame->bins16, frame->bins16 + LedInput::kBins, s.bins16);
+  std::copy(frame->harmonic16, frame->harmonic16 + LedInput::kBins, s.harm16);
+  std::copy(frame->percussive16, frame->percussive16 + LedInput::kBins, s.perc16);
+  s.rms = 0.5f * (frame->rmsL + frame->rmsR);
+  s.level = frame->level;
+  s.harmShare = frame->harmonicShare;
+  s.stampNs = monotonicNs();
+  s.captureNs = frame->captureNs;
+  _zones[zone].mailbox.publish();
+}
+
+void DdpSender::submitAnalysis(const MultiResolutionData& data) {
+  // Events are counted, not latched, so none is lost between two renders
+  if (data.isBeat) _beats.fetch_add(1, std::memory_order_relaxed);
+  if (data.isOnset) _onsets.fetch_add(1, std::memory_order_relaxed);
+
+  AnalysisSlot& s = _analysis.writeBuffer();
+  const int n = std::min(12, int(data.chromagram.size()));
+  std::fill(s.chroma, s.chroma + 12, 0.0f);
+  std::copy(data.chromagram.constData(), data.chromagram.constData() + n, s.chroma);
+  s.beatPhase = data.beatPeriod > 0.0f ? std::clamp(data.beatPhase / data.beatPeriod, 0.0f, 1.0f) : 0.0f;
+  s.confidence = data.beatConfidence;
+  s.stampNs = monotonicNs();
+  _analysis.publish();
+}
+
+// --- clock ---
+
+void DdpSender::start() {
+  _cpu.bind("led");
+  _cpu.mark();
+  if (!_sock) {
+    _sock = new QUdpSocket(this);
+    if (!_sock->bind(QHostAddress::AnyIPv4, 0))
+      qWarning() << "DdpSender: bind failed:" << _sock->errorString();
+    // Room for a few frames of a long strip in flight
+    _sock->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, 1 << 20);
+  }
+  if (!_probe) {
+    _probe = new NodeProbe(this);
+    connect(_probe, &NodeProbe::result, this, &DdpSender::onProbe);
+    QMutexLocker lock(&_statsMutex);
+    updateProbeNodes();
+  }
+  if (_enabled) _probe->start();
+  if (!_timer) {
+    _timer = new QTimer(this);
+    _timer->setTimerType(Qt::PreciseTimer);
+    _timer->setSingleShot(true);
+    connect(_timer, &QTimer::timeout, this, &DdpSender::tick);
+  }
+  if (!_retry) {
+    _retry = new QTimer(this);
+    _retry->setTimerType(Qt::PreciseTimer);
+    _retry->setSingleShot(true);
+    connect(_retry, &QTimer::timeout, this, &DdpSender::flushAll);
+  }
+  _nextDeadlineNs = monotonicNs();
+  _lastStatsNs = _nextDeadlineNs;
+  scheduleNext();
+}
+
+void DdpSender::stop() {
+  if (_timer) _timer->stop();
+  if (_retry) _retry->stop();
+  if (_probe) _probe->stop();
+  _cpu.release();
+  emit stopped();
+}
+
+// Same deadline scheme as UdpSrSender: exact average rate, resync when far behind.
+void DdpSender::scheduleNext() {
+  const int64_t now = monotonicNs();
+  _nextDeadlineNs += _periodNs;
+  if (_nextDeadlineNs <= now) _nextDeadlineNs = now + _periodNs;
+  _timer->start(int((_nextDeadlineNs - now + 500000) / 1000000));
+}
+
+const DdpSender::LevelsSlot& DdpSender::levelsAt(int zone, int64_t alignNs) const {
+  const ZoneLevels& z = _zones[zone];
+  for (int i = 1; i <= z.count; ++i) {
+    const LevelsSlot& s = z.history[(z.head + kAlignDepth - i) % kAlignDepth];
+    if (s.captureNs <= alignNs || i == z.count) return s;
+  }
+  return z.newest();
+}
+
+void DdpSender::tick() {
+  scheduleNext();
+  _analysis.update();
+  const int64_t now = monotonicNs();
+  const int64_t staleNs = int64_t(kStaleMs) * 1000000;
+
+  // --- zones: collect arrivals, find the common capture time ---
+  bool live[LedSegment::kZones] = {};
+  int liveZones = 0;
+  int64_t alignNs = INT64_MAX;
+  for (int z = 0; z < LedSegment::kZones; ++z) {
+    if (!(_used & (((1u << LedSegment::kSources) - 1) << (z * LedSegment::kSources)))) continue;
+    ZoneLevels& zl = _zones[z];
+    if (zl.mailbox.update()) {
+      zl.history[zl.head] = zl.mailbox.readBuffer();
+      zl.head = (zl.head + 1) % kAlignDepth;
+      zl.count = std::min(zl.count + 1, kAlignDepth);
+    }
+    const LevelsSlot& newest = zl.newest();
+    live[z] = zl.count > 0 && now - newest.stampNs <= staleNs;
+    if (!live[z]) continue;
+    ++liveZones;
+    // Unstamped frames (no capture time) render as they come
+    if (newest.captureNs) alignNs = std::min(alignNs, newest.captureNs);
+  }
+  if (!_enabled || liveZones == 0 || _segments.empty() || ledCount() == 0) {
+    _lastRenderNs = 0;
+    return;
+  }
+  if (liveZones == 1) alignNs = INT64_MAX;   // nothing to line up with: newest
+
+  // --- render ---
+  const uint32_t beats = _beats.load(std::memory_order_relaxed);
+  const uint32_t onsets = _onsets.load(std::memory_order_relaxed);
+  _input.beat = beats != _seenBeats;
+  _input.onset = onsets != _seenOnsets;
+  _seenBeats = beats;
+  _seenOnsets = onsets;
+  const AnalysisSlot& an = _analysis.readBuffer();
+  _input.haveChroma = an.stampNs != 0 && now - an.stampNs <= int64_t(kStaleMs) * 1000000;
+  std::copy(an.chroma, an.chroma + 12, _input.chroma);
+  _input.beatPhase = an.beatPhase;
+  _input.beatConfidence = an.confidence;
+
+  const double dt = _lastRenderNs ? double(now - _lastRenderNs) * 1e-9 : 1.0 / _fps;
+  _lastRenderNs = now;
+  // Each (zone, source) in use renders the whole strip from its own bins and share of the level
+  const uint8_t* rgb[LedSegment::kZones][LedSegment::kSources] = {};
+  for (int z = 0; z < LedSegment::kZones; ++z) {
+    if (!live[z]) continue;
+    const LevelsSlot& lv = levelsAt(z, alignNs);
+    _input.rms = lv.rms;
+    for (int src = 0; src < LedSegment::kSources; ++src) {
+      if (!(_used & (1u << (z * LedSegment::kSources + src)))) continue;
+      const float* bins = lv.bins16;
+      float level = lv.level;
+      if (src == int(LedSegment::Source::Harmonic)) { bins = lv.harm16; level *= lv.harmShare; }
+      else if (src == int(LedSegment::Source::Percussive)) { bins = lv.perc16; level *= 1.0f - lv.harmShare; }
+      std::copy(bins, bins + LedInput::kBins, _input.bins16);
+      _input.level = level;
+      rgb[z][src] = _engines[z][src].render(_input, dt);
+    }
+  }
+
+  // --- policy + queue + send ---
+  const bool transient = _input.onset || _input.beat;
+  {
+    QMutexLocker lock(&_statsMutex);
+    for (Segment* s : _segments) {
+      const uint8_t* frame = rgb[s->cfg.zone][int(s->cfg.source)];
+      if (!frame) continue;        // its zone went quiet; the others keep going
+      const uint8_t* px = frame + 3 * s->cfg.first;
+      if (SendPolicy::sends(s->policy.decide(px, 3 * s->cfg.count, now, transient))) enqueue(*s, px);
+      else { ++s->stats.suppressed; s->suppressed.add(); }
+    }
+  }
+  flushAll();
+
+  if (now - _lastStatsNs >= 1000000000) {
+    _lastStatsNs = now;
+    emit statsReady(segmentStats());
+  }
+}
+
+// Packetise one frame into the segment's buffer (caller holds _statsMutex).
+void DdpSender::enqueue(Segment& s, const uint8_t* rgb) {
+  if (s.pending) { ++s.stats.superseded; s.superseded.add(); }
+  s.ends.clear();
+  s.next = 0;
+  s.pending = true;
+
+  char* out = s.data.data();
+  int pos = 0;
+  const int count = s.cfg.count;
+  if (s.cfg.protocol == LedSegment::Protocol::Ddp) {
+    const int bytes = count * 3;
+    for (int off = 0; off < bytes; off += kDdpMaxData) {
+      const int len = std::min(kDdpMaxData, bytes - off);
+      s.seq = uint8_t(s.seq % 15 + 1);
+      auto* h = reinterpret_cast<uint8_t*>(out + pos);
+      h[0] = uint8_t(kDdpVer1 | (off + len == bytes ? kDdpPush : 0));
+      h[1] = s.seq;
+      h[2] = kDdpTypeRgb8;
+      h[3] = kDdpIdDisplay;
+      h[4] = uint8_t(off >> 24); h[5] = uint8_t(off >> 16); h[6] = uint8_t(off >> 8); h[7] = uint8_t(off);
+      h[8] = uint8_t(len >> 8);  h[9] = uint8_t(len);
+      std::memcpy(out + pos + kDdpHeader, rgb + off, size_t(len));
+      pos += kDdpHeader + len;
+      s.ends.push_back(pos);
+    }
+  } else if (count <= kDrgbMaxLeds) {
+    out[0] = char(kDrgb);
+    out[1] = char(kRealtimeTimeoutS);
+    std::memcpy(out + 2, rgb, size_t(count) * 3);
+    pos = 2 + count * 3;
+    s.ends.push_back(pos);
+  } else {
+    for (int first = 0; first < count; first += kDnrgbMaxLeds) {
+      const int n = std::min(kDnrgbMaxLeds, count - first);
+      auto* h = reinterpret_cast<uint8_t*>(out + pos);
+      h[0] = kDnrgb;
+      h[1] = kRealtimeTimeoutS;
+      h[2] = uint8_t(first >> 8);
+      h[3] = uint8_t(first);
+      std::memcpy(out + pos + 4, rgb + 3 * first, size_t(n) * 3);
+      pos += 4 + n * 3;
+      s.ends.push_back(pos);
+    }
+  }
+}
+
+// Send what the socket takes; stop at the first refusal and leave the rest
+// queued (caller holds _statsMutex).
+bool DdpSender::flush(Segment& s) {
+  while (s.pending && s.next < int(s.ends.size())) {
+    const int begin = s.next ? s.ends[size_t(s.next - 1)] : 0;
+    const int len = s.ends[size_t(s.next)] - begin;
+    const bool ok = _sock->writeDatagram(s.data.data() + begin, len, s.cfg.address, s.cfg.port) == len;
+    s.policy.reportSend(ok);
+    s.stats.intervalMs = float(s.policy.intervalMs());
+    if (!ok) {
+      ++s.stats.errors;
+      s.errors.add();
+      return false;
+    }
+    ++s.stats.packets;
+    s.packets.add();
+    if (++s.next == int(s.ends.size())) {
+      s.pending = false;
+      ++s.stats.frames;
+      s.frames.add();
+    }
+  }
+  return true;
+}
+
+void DdpSender::flushAll() {
+  if (!_sock) return;
+  bool done = true;
+  {
+    QMutexLocker lock(&_statsMutex);
+    for (Segment* s : _segments) done = flush(*s) && done;
+  }
+  // Retry soon; the next frame replaces whatever is still queued by then
+  if (!done && _retry && !_retry->isActive()) _retry->start(kRetryMs);
+}
@@ -0,0 +1,198 @@
+#pragma once
+#include <QObject>
+#include <QVector>
+#include <QHostAddress>
+#include <QMutex>
+#include <QMetaType>
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include "TripleBuffer.h"
+#include "SpectrumFrame.h"
+#include "LedEffectEngine.h"
+#include "SendPolicy.h"
+#include "Metrics.h"
+
+class QUdpSocket;
+class QTimer;
+class NodeProbe;
+struct MultiResolutionData;
+
+// One WLED node fed with a slice of the virtual strip. Pixels [first, first+count)
+// of the rendered frame go to the node's LEDs 0..count-1.
+struct LedSegment {
+  enum class Protocol {
+    Ddp,       // DDP (port 4048), 480 px per packet, push flag on the last one
+    Drgb       // WLED UDP realtime (port 21324): DRGB up to 490 px, DNRGB chunks above
+  };
+  QHostAddress address;
+  enum class Source {
+    Full,      // the whole spectrum (bins16)
+    Harmonic,  // sustained content only (HPSS harmonic16)
+    Percussive // transients only (HPSS percussive16)
+  };
+  static constexpr int kSources = 3;
+  // Analysis zone driving the segment: 0 = the main processor, 1..kMaxZones
+  // the pipeline's CaptureZones in order (resolved from `zoneName`)
+  static constexpr int kMaxZones = 8;
+  static constexpr int kZones = 1 + kMaxZones;
+  quint16  port = 4048;
+  int      first = 0;
+  int      count = 0;
+  Protocol protocol = Protocol::Ddp;
+  Source   source = Source::Full;
+  int      zone = 0;
+  QString  zoneName;               // "?zone=name", empty = main
+};
+Q_DECLARE_METATYPE(LedSegment)
+
+struct LedSegmentStats {
+  QHostAddress address;
+  int      first = 0, count = 0;
+  uint64_t frames = 0;         // frames completely sent
+  uint64_t packets = 0;
+  uint64_t superseded = 0;     // a newer frame replaced one still (partly) queued
+  uint64_t errors = 0;         // datagrams the socket refused
+  uint64_t suppressed = 0;     // frames held back by the send policy
+  float    intervalMs = 0.0f;  // current adaptive minimum send interval
+  float    rttMs = 0.0f;
+};
+Q_DECLARE_METATYPE(LedSegmentStats)
+
+// Direct pixel streaming: renders per-LED RGB on the host (LedEffectEngine)
+// and streams it to one or more WLED segments, instead of leaving the effect
+// to the ESP via SR packets.
+//
+// Lives on its own thread like UdpSrSender. The DSP thread drops the newest
+// bins/level into a mailbox (submitFrame), the advanced processor drops its
+// chroma/beat phase into another and bumps beat/onset counters
+// (submitAnalysis), both DirectConnection and lock-free. A deadline timer
+// renders the whole strip at a fixed rate (60 fps default) and hands each
+// segment its slice.
+//
+// Zone processors (see CaptureZone) have a mailbox each (submitZoneFrame).
+// Zones on different devices arrive with different latencies, so each tick
+// renders every zone from the frame captured closest to the newest capture
+// time all live zones have reached: a hit picked up by two inputs shows on
+// both zones' segments in the same frame.
+//
+// Every segment has its own one-deep send queue: the frame is packetised into
+// a preallocated buffer and flushed without blocking; packets the socket
+// refuses stay queued and are retried shortly, a newer frame replaces
+// whatever is left (latest wins). A slow or unreachable node never holds the
+// others back. When audio stops (or streaming is disabled) sending stops and
+// WLED falls back to its own effects after its realtime timeout.
+//
+// Before queueing, each segment's SendPolicy drops frames whose pixels are
+// unchanged (keyframe once a second) or that come faster than the node's link
+// currently allows; frames with a new onset or beat always go.
+class DdpSender : public QObject {
+  Q_OBJECT
+public:
+  explicit DdpSender(QObject* parent=nullptr);
+  ~DdpSender() override;
+
+  // Parse "ip[:port]/leds[?opt[&opt]], ..." (commas, spaces or semicolons).
+  // `/leds` takes the next `leds` pixels of the strip; `/first-last` an
+  // explicit inclusive range (segments may overlap to mirror). `?drgb` uses
+  // WLED's UDP realtime protocol (default port 21324) instead of DDP; `?harm`
+  // / `?perc` drive the segment from the harmonic / percussive part of the
+  // spectrum only. IPv4 only.
+  // `?zone=name` drives the segment from an analysis zone (the caller
+  // resolves LedSegment::zone from the name).
+  static bool parseSegments(const QString& text, QVector<LedSegment>& out, QString* error = nullptr);
+
+  // Producer sides, each from one thread at a time (DirectConnection); never block.
+  void submitFrame(const SpectrumFramePtr& frame) { submitZoneFrame(0, frame); }  // DSP thread
+  void submitZoneFrame(int zone, const SpectrumFramePtr& frame);                 // that zone's DSP thread
+  void submitAnalysis(const MultiResolutionData& data);     // advanced processor thread
+
+  QVector<LedSegmentStats> segmentStats() const;            // any thread
+  int ledCount() const { return _ledCount; }                // sender thread
+
+  static constexpr double kDefaultFps = 60.0;
+  static constexpr int kStaleMs = 250;      // stop streaming when no frame arrived for this long
+  static constexpr int kMaxLeds = 16384;    // whole virtual strip
+  static constexpr int kRetryMs = 2;
+  static constexpr int kAlignDepth = 8;     // frames per zone kept for alignment (~80 ms at a 10 ms hop)
+
+public slots:
+  void start();
+  void stop();
+  void setSegments(const QVector<LedSegment>& segments);
+  void setEnabled(bool on);
+  void setEffect(int effect);               // LedEffectEngine::Effect
+  void setBrightness(double b);             // 0..1
+  void setFps(double fps);
+  void setSendPolicy(const SendPolicyConfig& cfg);
+  void resetStats();
+
+signals:
+  // About once a second while streaming.
+  void statsReady(const QVector<LedSegmentStats>& stats);
+  void stopped();
+
+private:
+  struct Segment;
+
+  struct LevelsSlot {
+    float   bins16[LedInput::kBins];
+    float   harm16[LedInput::kBins];
+    float   perc16[LedInput::kBins];
+    float   rms = 0.0f;
+    float   level = 0.0f;
+    float   harmShare = 0.5f;
+    int64_t stampNs = 0;          // when it was submitted (staleness)
+    int64_t captureNs = 0;        // SpectrumFrame::captureNs (alignment)
+  };
+  struct ZoneLevels {
+    TripleBuffer<LevelsSlot> mailbox;          // zone's DSP thread -> sender thread
+    LevelsSlot history[kAlignDepth];           // sender thread: last arrivals, ring
+    int count = 0, head = 0;                   // head = next slot to write
+    const LevelsSlot& newest() const { return history[(head + kAlignDepth - 1) % kAlignDepth]; }
+  };
+  struct AnalysisSlot {
+    float   chroma[12];
+    float   beatPhase = 0.0f;     // 0..1
+    float   confidence = 0.0f;
+    int64_t stampNs = 0;
+  };
+
+  void tick();
+  // Newest frame of `zone` captured no later than `alignNs` (its oldest kept one if none)
+  const LevelsSlot& levelsAt(int zone, int64_t alignNs) const;
+  void scheduleNext();
+  void enqueue(Segment& s, const uint8_t* rgb);
+  bool flush(Segment& s);          // false: something is still queued
+  void flushAll();
+  void onProbe(const QHostAddress& node, float rttMs, bool ok);
+  void updateProbeNodes();
+
+  QUdpSocket* _sock{nullptr};
+  QTimer*     _timer{nullptr};
+  QTimer*     _retry{nullptr};
+  NodeProbe*  _probe{nullptr};
+  SendPolicyConfig _policy{SendPolicyConfig::fromEnvironment()};
+  double      _fps{kDefaultFps};
+  int64_t     _periodNs{int64_t(1e9 / kDefaultFps)};
+  int64_t     _nextDeadlineNs{0};
+  int64_t     _lastRenderNs{0};
+  int64_t     _lastStatsNs{0};
+  bool        _enabled{false};
+
+  ZoneLevels _zones[LedSegment::kZones];  // DSP threads -> sender thread
+  TripleBuffer<AnalysisSlot> _analysis;   // advanced processor -> sender thread
+  std::atomic<uint32_t> _beats{0}, _onsets{0};
+  uint32_t _seenBeats{0}, _seenOnsets{0};
+
+  // One engine per zone and LedSegment::Source (effects keep state between
+  // frames, so they can't share one); only those some segment uses are sized
+  // and rendered
+  LedEffectEngine _engines[LedSegment::kZones][LedSegment::kSources];
+  uint32_t _used = 0;              // bit zone * kSources + source
+  int      _ledCount = 0;
+  LedInput _input;
+  std::vector<Segment*> _segments;
+  mutable QMutex _statsMutex;      // guards Segment::stats and the list for segmentStats()
+  metrics::ThreadCpu _cpu;
+};
@@ -0,0 +1,276 @@
+#include "DspKernels.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define DSP_HAVE_SSE2 1
+  #include <emmintrin.h>
+#endif
+
+#if defined(WLEDQT_HAVE_AVX2_KERNELS) && defined(_MSC_VER)
+  #include <intrin.h>
+#endif
+
+namespace dsp {
+
+// --- scalar reference ---
+
+static void applyWindowStereoScalar(float* dstL, float* dstR, const float* srcL, const float* srcR,
+                                    const float* win, int n) {
+  for (int i = 0; i < n; ++i) {
+    dstL[i] = srcL[i] * win[i];
+    dstR[i] = srcR[i] * win[i];
+  }
+}
+
+static void dcBlockScalar(float* x, int n, float coeff, float& xPrev, float& yPrev) {
+  float xp = xPrev, yp = yPrev;
+  for (int i = 0; i < n; ++i) {
+    const float xn = x[i];
+    const float yn = xn - xp + coeff * yp;
+    x[i] = yn;
+    xp = xn;
+    yp = yn;
+  }
+  xPrev = xp;
+  yPrev = yp;
+}
+
+static void magnitudeScalar(float* mag, const float* cplx, int n) {
+  for (int k = 0; k < n; ++k) {
+    const float re = cplx[2*k], im = cplx[2*k + 1];
+    mag[k] = std::sqrt(re * re + im * im);
+  }
+}
+
+static float sumSquaresScalar(const float* x, int n) {
+  float s = 0.0f;
+  for (int i = 0; i < n; ++i) s += x[i] * x[i];
+  return s;
+}
+
+static void sparseMatVecScalar(float* out, const float* x, const int* rowStart, const int* idx,
+                               const float* w, int rows) {
+  for (int r = 0; r < rows; ++r) {
+    float s = 0.0f;
+    for (int j = rowStart[r]; j < rowStart[r + 1]; ++j) s += w[j] * x[idx[j]];
+    out[r] = s;
+  }
+}
+
+static void sparseMatVecStereoScalar(float* outL, float* outR, const float* xL, const float* xR,
+                                     const int* rowStart, const int* idx, const float* w, int rows) {
+  for (int r = 0; r < rows; ++r) {
+    float sl = 0.0f, sr = 0.0f;
+    for (int j = rowStart[r]; j < rowStart[r + 1]; ++j) {
+      sl += w[j] * xL[idx[j]];
+      sr += w[j] * xR[idx[j]];
+    }
+    outL[r] = sl;
+    outR[r] = sr;
+  }
+}
+
+static const Kernels kScalar = {
+  Isa::Scalar, "scalar",
+  applyWindowStereoScalar, dcBlockScalar, magnitudeScalar, sumSquaresScalar,
+  sparseMatVecScalar, sparseMatVecStereoScalar
+};
+
+// --- SSE2 ---
+#ifdef DSP_HAVE_SSE2
+
+static inline float hsum(__m128 v) {
+  __m128 t = _mm_add_ps(v, _mm_movehl_ps(v, v));
+  t = _mm_add_ss(t, _mm_shuffle_ps(t, t, 0x55));
+  return _mm_cvtss_f32(t);
+}
+
+static void applyWindowStereoSse2(float* dstL, float* dstR, const float* srcL, const float* srcR,
+                                  const float* win, int n) {
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m128 w = _mm_loadu_ps(win + i);
+    _mm_storeu_ps(dstL + i, _mm_mul_ps(_mm_loadu_ps(srcL + i), w));
+    _mm_storeu_ps(dstR + i, _mm_mul_ps(_mm_loadu_ps(srcR + i), w));
+  }
+  applyWindowStereoScalar(dstL + i, dstR + i, srcL + i, srcR + i, win + i, n - i);
+}
+
+// The IIR is serial, but four outputs can be produced at once from the four
+// input differences d[j] and the previous output: y[j] = sum_m c^(j-m) d[m] + c^(j+1) y[-1].
+// That leaves one dependency (yPrev) per four samples instead of one per sample.
+static void dcBlockSse2(float* x, int n, float coeff, float& xPrev, float& yPrev) {
+  const float c1 = coeff, c2 = c1 * c1, c3 = c2 * c1, c4 = c3 * c1;
+  const __m128 col0 = _mm_setr_ps(1.0f, c1, c2, c3);
+  const __m128 col1 = _mm_setr_ps(0.0f, 1.0f, c1, c2);
+  const __m128 col2 = _mm_setr_ps(0.0f, 0.0f, 1.0f, c1);
+  const __m128 col3 = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+  const __m128 carry = _mm_setr_ps(c1, c2, c3, c4);
+
+  float xp = xPrev, yp = yPrev;
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m128 cur = _mm_loadu_ps(x + i);
+    // [xp, x0, x1, x2]
+    const __m128 prev = _mm_move_ss(_mm_shuffle_ps(cur, cur, _MM_SHUFFLE(2, 1, 0, 0)), _mm_set_ss(xp));
+    const __m128 d = _mm_sub_ps(cur, prev);
+
+    __m128 y = _mm_mul_ps(_mm_set1_ps(yp), carry);
+    y = _mm_add_ps(y, _mm_mul_ps(_mm_shuffle_ps(d, d, 0x00), col0));
+    y = _mm_add_ps(y, _mm_mul_ps(_mm_shuffle_ps(d, d, 0x55), col1));
+    y = _mm_add_ps(y, _mm_mul_ps(_mm_shuffle_ps(d, d, 0xAA), col2));
+    y = _mm_add_ps(y, _mm_mul_ps(_mm_shuffle_ps(d, d, 0xFF), col3));
+
+    xp = x[i + 3];
+    _mm_storeu_ps(x + i, y);
+    yp = _mm_cvtss_f32(_mm_shuffle_ps(y, y, 0xFF));
+  }
+  dcBlockScalar(x + i, n - i, coeff, xp, yp);
+  xPrev = xp;
+  yPrev = yp;
+}
+
+static void magnitudeSse2(float* mag, const float* cplx, int n) {
+  int k = 0;
+  for (; k + 4 <= n; k += 4) {
+    const __m128 a = _mm_loadu_ps(cplx + 2*k);       // r0 i0 r1 i1
+    const __m128 b = _mm_loadu_ps(cplx + 2*k + 4);   // r2 i2 r3 i3
+    const __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    const __m128 p = _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im));
+    _mm_storeu_ps(mag + k, _mm_sqrt_ps(p));
+  }
+  magnitudeScalar(mag + k, cplx + 2*k, n - k);
+}
+
+static float sumSquaresSse2(const float* x, int n) {
+  __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128 a = _mm_loadu_ps(x + i);
+    const __m128 b = _mm_loadu_ps(x + i + 4);
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(a, a));
+    acc1 = _mm_add_ps(acc1, _mm_mul_ps(b, b));
+  }
+  float s = hsum(_mm_add_ps(acc0, acc1));
+  for (; i < n; ++i) s += x[i] * x[i];
+  return s;
+}
+
+// No gather in SSE2: the four inputs are loaded scalar, the weights and the
+// multiply-accumulate are vector.
+static void sparseMatVecSse2(float* out, const float* x, const int* rowStart, const int* idx,
+                             const float* w, int rows) {
+  for (int r = 0; r < rows; ++r) {
+    int j = rowStart[r];
+    const int end = rowStart[r + 1];
+    __m128 acc = _mm_setzero_ps();
+    for (; j + 4 <= end; j += 4) {
+      const __m128 v = _mm_setr_ps(x[idx[j]], x[idx[j + 1]], x[idx[j + 2]], x[idx[j + 3]]);
+      acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(w + j), v));
+    }
+    float s = hsum(acc);
+    for (; j < end; ++j) s += w[j] * x[idx[j]];
+    out[r] = s;
+  }
+}
+
+static void sparseMatVecStereoSse2(float* outL, float* outR, const float* xL, const float* xR,
+                                   const int* rowStart, const int* idx, const float* w, int rows) {
+  for (int r = 0; r < rows; ++r) {
+    int j = rowStart[r];
+    const int end = rowStart[r + 1];
+    __m128 accL = _mm_setzero_ps(), accR = _mm_setzero_ps();
+    for (; j + 4 <= end; j += 4) {
+      const int i0 = idx[j], i1 = idx[j + 1], i2 = idx[j + 2], i3 = idx[j + 3];
+      const __m128 ww = _mm_loadu_ps(w + j);
+      accL = _mm_add_ps(accL, _mm_mul_ps(ww, _mm_setr_ps(xL[i0], xL[i1], xL[i2], xL[i3])));
+      accR = _mm_add_ps(accR, _mm_mul_ps(ww, _mm_setr_ps(xR[i0], xR[i1], xR[i2], xR[i3])));
+    }
+    float sl = hsum(accL), sr = hsum(accR);
+    for (; j < end; ++j) {
+      sl += w[j] * xL[idx[j]];
+      sr += w[j] * xR[idx[j]];
+    }
+    outL[r] = sl;
+    outR[r] = sr;
+  }
+}
+
+static const Kernels kSse2 = {
+  Isa::Sse2, "sse2",
+  applyWindowStereoSse2, dcBlockSse2, magnitudeSse2, sumSquaresSse2,
+  sparseMatVecSse2, sparseMatVecStereoSse2
+};
+
+#endif // DSP_HAVE_SSE2
+
+// --- dispatch ---
+
+static bool cpuHasAvx2Fma() {
+#if defined(WLEDQT_HAVE_AVX2_KERNELS)
+  #if defined(_MSC_VER) && !defined(__clang__)
+    int r[4];
+    __cpuid(r, 0);
+    if (r[0] < 7) return false;
+    __cpuid(r, 1);
+    const bool fma     = (r[2] & (1 << 12)) != 0;
+    const bool osxsave = (r[2] & (1 << 27)) != 0;
+    const bool avx     = (r[2] & (1 << 28)) != 0;
+    if (!fma || !osxsave || !avx) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;     // OS saves XMM+YMM state
+    __cpuidex(r, 7, 0);
+    return (r[1] & (1 << 5)) != 0;
+  #else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  #endif
+#else
+  return false;
+#endif
+}
+
+bool isaSupported(Isa isa) {
+  switch (isa) {
+    case Isa::Scalar: return true;
+#ifdef DSP_HAVE_SSE2
+    case Isa::Sse2:   return true;
+#else
+    case Isa::Sse2:   return false;
+#endif
+    case Isa::Avx2: {
+      static const bool ok = cpuHasAvx2Fma();
+      return ok;
+    }
+  }
+  return false;
+}
+
+const Kernels& kernelsFor(Isa isa) {
+#if defined(WLEDQT_HAVE_AVX2_KERNELS)
+  if (isa == Isa::Avx2 && isaSupported(Isa::Avx2)) return detail::avx2Kernels();
+#endif
+#ifdef DSP_HAVE_SSE2
+  if (isa != Isa::Scalar) return kSse2;
+#endif
+  (void)isa;
+  return kScalar;
+}
+
+static const Kernels& selectKernels() {
+  if (const char* env = std::getenv("WLEDQT_SIMD")) {
+    if (std::strcmp(env, "scalar") == 0) return kernelsFor(Isa::Scalar);
+    if (std::strcmp(env, "sse2") == 0)   return kernelsFor(Isa::Sse2);
+    if (std::strcmp(env, "avx2") == 0)   return kernelsFor(Isa::Avx2);
+  }
+  return kernelsFor(Isa::Avx2);
+}
+
+const Kernels& kernels() {
+  static const Kernels& k = selectKernels();
+  return k;
+}
+
+} // namespace dsp
@@ -0,0 +1,55 @@
+#pragma once
+
+// Hot-loop DSP kernels with runtime ISA dispatch.
+//
+// kernels() picks the best implementation for the running CPU once
+// (AVX2+FMA > SSE2 > scalar). Setting WLEDQT_SIMD=scalar|sse2|avx2 in the
+// environment forces a specific table, which is handy for checking the
+// vector paths against the scalar reference.
+//
+// All kernels take plain float pointers; complex spectra are the interleaved
+// {re, im} layout of fft::Complex (and kiss_fft_cpx). No alignment requirements.
+namespace dsp {
+
+enum class Isa { Scalar, Sse2, Avx2 };
+
+struct Kernels {
+  Isa isa;
+  const char* name;
+
+  // dst[i] = src[i] * win[i] for both channels (window loaded once)
+  void (*applyWindowStereo)(float* dstL, float* dstR, const float* srcL, const float* srcR,
+                            const float* win, int n);
+
+  // In-place DC blocker y[n] = x[n] - x[n-1] + coeff * y[n-1]; state carries across calls
+  void (*dcBlock)(float* x, int n, float coeff, float& xPrev, float& yPrev);
+
+  // mag[k] = sqrt(re^2 + im^2) over n interleaved complex values
+  void (*magnitude)(float* mag, const float* cplx, int n);
+
+  // sum of x[i]^2
+  float (*sumSquares)(const float* x, int n);
+
+  // CSR sparse mat-vec: out[r] = sum_{j in [rowStart[r], rowStart[r+1])} w[j] * x[idx[j]]
+  void (*sparseMatVec)(float* out, const float* x, const int* rowStart, const int* idx,
+                       const float* w, int rows);
+  // Same matrix applied to two vectors (indices and weights loaded once)
+  void (*sparseMatVecStereo)(float* outL, float* outR, const float* xL, const float* xR,
+                             const int* rowStart, const int* idx, const float* w, int rows);
+};
+
+// Best table for this CPU (selected on first call, thread-safe).
+const Kernels& kernels();
+
+// A specific table; falls back to the next best if the CPU (or build) lacks it.
+const Kernels& kernelsFor(Isa isa);
+
+// True if the running CPU and this build support `isa`.
+bool isaSupported(Isa isa);
+
+} // namespace dsp
+
+namespace dsp::detail {
+// Defined in DspKernelsAvx2.cpp (only built on x86; see CMakeLists.txt)
+const Kernels& avx2Kernels();
+}
@@ -0,0 +1,160 @@
+// AVX2 + FMA variants of the DSP kernels.
+// This file alone is compiled with -mavx2 -mfma (/arch:AVX2 on MSVC); it is
+// only reached through dsp::kernels() after the CPU check in DspKernels.cpp.
+#include "DspKernels.h"
+#include <immintrin.h>
+#include <cmath>
+
+namespace dsp {
+
+static inline float hsum(__m256 v) {
+  __m128 t = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  t = _mm_add_ps(t, _mm_movehl_ps(t, t));
+  t = _mm_add_ss(t, _mm_shuffle_ps(t, t, 0x55));
+  return _mm_cvtss_f32(t);
+}
+
+static void applyWindowStereoAvx2(float* dstL, float* dstR, const float* srcL, const float* srcR,
+                                  const float* win, int n) {
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256 w = _mm256_loadu_ps(win + i);
+    _mm256_storeu_ps(dstL + i, _mm256_mul_ps(_mm256_loadu_ps(srcL + i), w));
+    _mm256_storeu_ps(dstR + i, _mm256_mul_ps(_mm256_loadu_ps(srcR + i), w));
+  }
+  for (; i < n; ++i) {
+    dstL[i] = srcL[i] * win[i];
+    dstR[i] = srcR[i] * win[i];
+  }
+}
+
+// Same block formulation as the SSE2 version, eight outputs per step.
+static void dcBlockAvx2(float* x, int n, float coeff, float& xPrev, float& yPrev) {
+  alignas(32) float cols[8][8];
+  alignas(32) float carryPow[8];
+  float p = 1.0f;
+  for (int j = 0; j < 8; ++j) {
+    p *= coeff;
+    carryPow[j] = p;                                  // c^(j+1)
+  }
+  for (int m = 0; m < 8; ++m)
+    for (int j = 0; j < 8; ++j)
+      cols[m][j] = j < m ? 0.0f : (j == m ? 1.0f : carryPow[j - m - 1]);
+  const __m256 carry = _mm256_load_ps(carryPow);
+  const __m256i shiftIdx = _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6);
+
+  alignas(32) float d[8];
+  float xp = xPrev, yp = yPrev;
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256 cur = _mm256_loadu_ps(x + i);
+    const __m256 prev = _mm256_blend_ps(_mm256_permutevar8x32_ps(cur, shiftIdx), _mm256_set1_ps(xp), 0x01);
+    _mm256_store_ps(d, _mm256_sub_ps(cur, prev));
+
+    __m256 y = _mm256_mul_ps(_mm256_set1_ps(yp), carry);
+    for (int m = 0; m < 8; ++m)
+      y = _mm256_fmadd_ps(_mm256_broadcast_ss(d + m), _mm256_load_ps(cols[m]), y);
+
+    xp = x[i + 7];
+    _mm256_storeu_ps(x + i, y);
+    yp = x[i + 7];
+  }
+  for (; i < n; ++i) {
+    const float xn = x[i];
+    const float yn = xn - xp + coeff * yp;
+    x[i] = yn;
+    xp = xn;
+    yp = yn;
+  }
+  xPrev = xp;
+  yPrev = yp;
+}
+
+static void magnitudeAvx2(float* mag, const float* cplx, int n) {
+  int k = 0;
+  for (; k + 8 <= n; k += 8) {
+    const __m256 a = _mm256_loadu_ps(cplx + 2*k);       // bins k..k+3
+    const __m256 b = _mm256_loadu_ps(cplx + 2*k + 8);   // bins k+4..k+7
+    // hadd pairs re^2+im^2 per 128-bit lane, then restore bin order across lanes
+    const __m256 h = _mm256_hadd_ps(_mm256_mul_ps(a, a), _mm256_mul_ps(b, b));
+    const __m256 p = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(h), _MM_SHUFFLE(3, 1, 2, 0)));
+    _mm256_storeu_ps(mag + k, _mm256_sqrt_ps(p));
+  }
+  for (; k < n; ++k) {
+    const float re = cplx[2*k], im = cplx[2*k + 1];
+    mag[k] = std::sqrt(re * re + im * im);
+  }
+}
+
+static float sumSquaresAvx2(const float* x, int n) {
+  __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+  int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m256 a = _mm256_loadu_ps(x + i);
+    const __m256 b = _mm256_loadu_ps(x + i + 8);
+    acc0 = _mm256_fmadd_ps(a, a, acc0);
+    acc1 = _mm256_fmadd_ps(b, b, acc1);
+  }
+  float s = hsum(_mm256_add_ps(acc0, acc1));
+  for (; i < n; ++i) s += x[i] * x[i];
+  return s;
+}
+
+static void sparseMatVecAvx2(float* out, const float* x, const int* rowStart, const int* idx,
+                             const float* w, int rows) {
+  for (int r = 0; r < rows; ++r) {
+    int j = rowStart[r];
+    const int end = rowStart[r + 1];
+    float s = 0.0f;
+    if (end - j >= 8) {
+      __m256 acc = _mm256_setzero_ps();
+      for (; j + 8 <= end; j += 8) {
+        const __m256i ii = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx + j));
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(w + j), _mm256_i32gather_ps(x, ii, 4), acc);
+      }
+      s = hsum(acc);
+    }
+    for (; j < end; ++j) s += w[j] * x[idx[j]];
+    out[r] = s;
+  }
+}
+
+static void sparseMatVecStereoAvx2(float* outL, float* outR, const float* xL, const float* xR,
+                                   const int* rowStart, const int* idx, const float* w, int rows) {
+  for (int r = 0; r < rows; ++r) {
+    int j = rowStart[r];
+    const int end = rowStart[r + 1];
+    float sl = 0.0f, sr = 0.0f;
+    if (end - j >= 8) {
+      __m256 accL = _mm256_setzero_ps(), accR = _mm256_setzero_ps();
+      for (; j + 8 <= end; j += 8) {
+        const __m256i ii = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx + j));
+        const __m256 ww = _mm256_loadu_ps(w + j);
+        accL = _mm256_fmadd_ps(ww, _mm256_i32gather_ps(xL, ii, 4), accL);
+        accR = _mm256_fmadd_ps(ww, _mm256_i32gather_ps(xR, ii, 4), accR);
+      }
+      sl = hsum(accL);
+      sr = hsum(accR);
+    }
+    for (; j < end; ++j) {
+      sl += w[j] * xL[idx[j]];
+      sr += w[j] * xR[idx[j]];
+    }
+    outL[r] = sl;
+    outR[r] = sr;
+  }
+}
+
+namespace detail {
+
+const Kernels& avx2Kernels() {
+  static const Kernels k = {
+    Isa::Avx2, "avx2",
+    applyWindowStereoAvx2, dcBlockAvx2, magnitudeAvx2, sumSquaresAvx2,
+    sparseMatVecAvx2, sparseMatVecStereoAvx2
+  };
+  return k;
+}
+
+} // namespace detail
+} // namespace dsp
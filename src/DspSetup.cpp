@@ -0,0 +1,52 @@
+#include "DspSetup.h"
+#include <algorithm>
+#include <cmath>
+
+DspSetup::DspSetup(const DspSetupKey& k) : key(k) {
+  const int N = k.fftSize;
+  plan = fft::makeReal(N);
+  if (!plan) return;
+
+  window.resize(size_t(N));
+  for (int n = 0; n < N; ++n)
+    window[size_t(n)] = 0.5f * (1.0f - std::cos(2.0f * float(M_PI) * n / (N - 1)));
+
+  filterbank.build(k.sampleRate, N, k.numBands, 20.0f, 18000.0f);
+  bandEdgesHz.resize(size_t(k.numBands + 2));
+  for (int b = 0; b < k.numBands; ++b) bandEdgesHz[size_t(b + 1)] = filterbank.centerHz(b);
+  bandEdgesHz[0] = filterbank.lowHz(0);
+  bandEdgesHz[size_t(k.numBands + 1)] = filterbank.highHz(k.numBands - 1);
+  chroma.build(k.sampleRate, N);
+
+  // H(z) = (1 - z^-1) / (1 - R z^-1), R = 1 - 2*pi*fc/fs with fc = 20 Hz
+  dcCoeff = std::clamp(1.0f - (2.0f * float(M_PI) * 20.0f / float(k.sampleRate)), 0.9f, 0.999f);
+}
+
+DspSetupPtr DspSetupCache::get(const DspSetupKey& key) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = std::find_if(_entries.begin(), _entries.end(),
+                           [&](const DspSetupPtr& s) { return s->key == key; });
+    if (it != _entries.end()) {
+      DspSetupPtr hit = *it;
+      _entries.erase(it);
+      _entries.push_back(hit);
+      return hit;
+    }
+  }
+
+  // Build without holding the lock; two racing misses just build twice
+  auto built = std::make_shared<const DspSetup>(key);
+  if (!built->valid()) return nullptr;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _entries.push_back(built);
+  if (int(_entries.size()) > _capacity) _entries.erase(_entries.begin());
+  return built;
+}
+
+bool DspSetupCache::contains(const DspSetupKey& key) const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return std::any_of(_entries.begin(), _entries.end(),
+                     [&](const DspSetupPtr& s) { return s->key == key; });
+}
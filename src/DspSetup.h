@@ -0,0 +1,58 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "BandFilterbank.h"
+#include "FftBackend.h"
+#include "MagnitudeCache.h"
+
+struct DspSetupKey {
+  int sampleRate = 0;
+  int fftSize = 0;
+  int numBands = 0;
+  bool operator==(const DspSetupKey& o) const {
+    return sampleRate == o.sampleRate && fftSize == o.fftSize && numBands == o.numBands;
+  }
+};
+
+// Everything AudioProcessor derives from (sample rate, N, bands): the real-FFT
+// plan, the Hann window, the band filterbank, the chroma map and the DC blocker
+// coefficient.
+// Built once, off the DSP thread when possible, then only read.
+//
+// FFT plans keep their scratch inside (see FftBackend.h), so a setup must only
+// be transformed with by one thread at a time (each AudioProcessor has its own
+// cache, and only its DSP thread runs FFTs).
+struct DspSetup {
+  explicit DspSetup(const DspSetupKey& k);
+  DspSetup(const DspSetup&) = delete;
+  DspSetup& operator=(const DspSetup&) = delete;
+
+  bool valid() const { return plan != nullptr; }
+
+  DspSetupKey key;
+  std::unique_ptr<fft::RealFft> plan;   // default backend (fft::defaultBackend)
+  std::vector<float> window;          // Hann, N
+  BandFilterbank filterbank;          // 20 Hz .. 18 kHz, log-spaced triangles
+  std::vector<float> bandEdgesHz;     // numBands + 2 (see AudioProcessor::analysisChanged)
+  ChromaMap chroma;                   // bins -> 12 pitch classes
+  float dcCoeff = 0.995f;             // 20 Hz one-pole DC blocker
+};
+
+using DspSetupPtr = std::shared_ptr<const DspSetup>;
+
+// Small LRU of setups. get() is thread-safe: a hit is a lookup, a miss builds
+// the setup on the calling thread (outside the lock) and keeps it, so flipping
+// back and forth between settings never rebuilds.
+class DspSetupCache {
+public:
+  explicit DspSetupCache(int capacity = 12) : _capacity(capacity) {}
+
+  DspSetupPtr get(const DspSetupKey& key);
+  bool contains(const DspSetupKey& key) const;
+
+private:
+  mutable std::mutex _mutex;
+  std::vector<DspSetupPtr> _entries;  // most recently used last
+  int _capacity;
+};
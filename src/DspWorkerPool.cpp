@@ -0,0 +1,91 @@
+#include "DspWorkerPool.h"
+#include <algorithm>
+
+void DspWorkerPool::setThreadCount(int threads) {
+  threads = std::max(0, threads);
+  if (threads == int(_workers.size())) return;
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _quit = true;
+  }
+  _wake.notify_all();
+  for (std::thread& t : _workers) t.join();
+  _workers.clear();
+  _cpu.clear();
+
+  _quit = false;
+  _workers.reserve(size_t(threads));
+  for (int i = 0; i < threads; ++i) {
+    _cpu.push_back(std::make_unique<metrics::ThreadCpu>());
+    _cpu.back()->bind((_name + "-" + std::to_string(i)).c_str());
+    metrics::ThreadCpu* cpu = _cpu.back().get();
+    _workers.emplace_back([this, cpu] { cpu->mark(); workerLoop(); cpu->clear(); });
+  }
+}
+
+int DspWorkerPool::defaultThreadCount() {
+  const int cores = int(std::thread::hardware_concurrency());
+  return std::clamp(cores - 1, 0, 3);
+}
+
+void DspWorkerPool::drain(Task task, void* ctx, int count) {
+  for (int i = _next.fetch_add(1, std::memory_order_relaxed); i < count;
+       i = _next.fetch_add(1, std::memory_order_relaxed)) {
+    task(ctx, i);
+  }
+}
+
+void DspWorkerPool::dispatch(int count, Task task, void* ctx) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _task = task;
+    _ctx = ctx;
+    _count = count;
+    _next.store(0, std::memory_order_relaxed);
+    _open = true;
+    ++_generation;
+  }
+  _wake.notify_all();
+
+  drain(task, ctx, count);
+
+  // Every index has been claimed; wait for workers still finishing theirs,
+  // then close the job in the same critical section. Workers join only under
+  // the lock and only an open job, so one that wakes after this skips the
+  // generation instead of claiming indexes of the next run with this (dead) ctx.
+  std::unique_lock<std::mutex> lock(_mutex);
+  _done.wait(lock, [this] { return _busy == 0; });
+  _open = false;
+  _task = nullptr;
+  _ctx = nullptr;
+}
+
+void DspWorkerPool::workerLoop() {
+  unsigned seen = 0;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    seen = _generation;
+  }
+  for (;;) {
+    Task task;
+    void* ctx;
+    int count;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _wake.wait(lock, [&] { return _quit || _generation != seen; });
+      if (_quit) return;
+      seen = _generation;
+      if (!_open) continue;           // woke after the run returned: nothing to join
+      task = _task;
+      ctx = _ctx;
+      count = _count;
+      ++_busy;
+    }
+
+    drain(task, ctx, count);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (--_busy == 0) _done.notify_one();
+  }
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "Metrics.h"
+
+// Small fixed pool for fork/join work on a DSP thread.
+//
+// run(count, fn) calls fn(i) for every i in [0, count) and returns when all
+// calls have finished. The calling thread takes tasks too, so a pool with zero
+// workers is just a plain loop. Tasks are claimed in any order but each one
+// does the same arithmetic wherever it runs, so results don't depend on the
+// thread count as long as tasks write disjoint state.
+//
+// One owner thread calls run() / setThreadCount(); not reentrant. Workers
+// sleep on a condition variable between runs (no spinning while idle).
+class DspWorkerPool {
+public:
+  explicit DspWorkerPool(int threads = 0) { setThreadCount(threads); }
+  ~DspWorkerPool() { setThreadCount(0); }
+  DspWorkerPool(const DspWorkerPool&) = delete;
+  DspWorkerPool& operator=(const DspWorkerPool&) = delete;
+
+  // Extra worker threads besides the caller (0 = run everything inline).
+  // Joins the old workers first; call between runs.
+  void setThreadCount(int threads);
+  int threadCount() const { return int(_workers.size()); }
+  // Workers show up in the metrics as thread="<name>-<i>" (set before setThreadCount)
+  void setName(const std::string& name) { _name = name; }
+
+  template <typename Fn>
+  void run(int count, Fn&& fn) {
+    if (count <= 0) return;
+    if (count == 1 || _workers.empty()) {
+      for (int i = 0; i < count; ++i) fn(i);
+      return;
+    }
+    using F = std::remove_reference_t<Fn>;
+    dispatch(count, [](void* ctx, int i) { (*static_cast<F*>(ctx))(i); }, &fn);
+  }
+
+  // Helpers to use when nothing is configured: cores - 1, capped (the analysis
+  // never has more than a few independent stages per hop).
+  static int defaultThreadCount();
+
+private:
+  using Task = void (*)(void*, int);
+  void dispatch(int count, Task task, void* ctx);
+  void workerLoop();
+  void drain(Task task, void* ctx, int count);
+
+  std::vector<std::thread> _workers;
+  std::vector<std::unique_ptr<metrics::ThreadCpu>> _cpu;   // one per worker
+  std::string _name = "pool";
+  std::mutex _mutex;
+  std::condition_variable _wake;      // owner -> workers: new generation (or quit)
+  std::condition_variable _done;      // workers -> owner: last busy worker left
+  unsigned _generation = 0;
+  bool _quit = false;
+  int _busy = 0;                      // workers inside the current generation
+  bool _open = false;                 // job joinable; dispatch() closes it before returning
+
+  // Current job (written under _mutex before _generation is bumped)
+  Task _task = nullptr;
+  void* _ctx = nullptr;
+  int _count = 0;
+  std::atomic<int> _next{0};
+};
@@ -0,0 +1,107 @@
+#include "DynamicsProcessor.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+inline float toDb(float x) { return 20.0f * std::log10(std::max(x, 1e-9f)); }
+inline float onePole(float ms, double hop) {
+  return ms <= 0.0f ? 0.0f : float(std::exp(-hop / (double(ms) * 1e-3)));
+}
+}
+
+void DynamicsProcessor::reserve(int maxBands) {
+  const size_t n = size_t(std::max(0, maxBands));
+  _band.reserve(n);
+  _smoothL.reserve(n);
+  _smoothR.reserve(n);
+}
+
+void DynamicsProcessor::configure(int numBands, double hopSeconds) {
+  _hop = std::max(hopSeconds, 1e-4);
+  updateCoefficients();
+  if (numBands == _bands) return;
+  _bands = std::max(0, numBands);
+  reset();
+}
+
+void DynamicsProcessor::reset() {
+  _band.assign(size_t(_bands), Tracker{});
+  _smoothL.assign(size_t(_bands), 0.0f);
+  _smoothR.assign(size_t(_bands), 0.0f);
+  _global = Tracker{};
+  _level = _instant = 0.0f;
+  _shortAvgDb = _globalFloor = -120.0f;
+  _peak = _gate = false;
+  _sincePeak = 0;
+}
+
+void DynamicsProcessor::updateCoefficients() {
+  _attackA = onePole(_cfg.attackMs, _hop);
+  _releaseA = onePole(_cfg.releaseMs, _hop);
+  _floorFallA = onePole(_cfg.floorFallMs, _hop);
+  _envFall = float(_cfg.releaseDbPerSec * _hop);
+  _floorRise = float(_cfg.floorRiseDbPerSec * _hop);
+  _refractoryHops = std::max(1, int(std::lround(_cfg.peakRefractoryMs * 1e-3 / _hop)));
+}
+
+void DynamicsProcessor::track(Tracker& t, float xDb) {
+  if (!t.init) {
+    t.floor = xDb;
+    t.env = xDb + _cfg.minRangeDb;
+    t.init = true;
+    return;
+  }
+  // Floor: falls towards quieter input quickly, rises only by creeping
+  if (xDb < t.floor) t.floor = xDb + (t.floor - xDb) * _floorFallA;
+  else               t.floor = std::min(xDb, t.floor + _floorRise);
+  // Envelope: instant attack, linear-in-dB release, kept above the floor
+  t.env = std::max({xDb, t.env - _envFall, t.floor + _cfg.minRangeDb});
+}
+
+float DynamicsProcessor::levelOf(const Tracker& t, float xDb, float refDb) const {
+  const float lo = t.floor + _cfg.gateDb;
+  const float span = std::max(refDb - lo, 1.0f);
+  return std::clamp((xDb - lo) / span, 0.0f, 1.0f);
+}
+
+float DynamicsProcessor::smooth(float& state, float target) const {
+  const float a = target > state ? _attackA : _releaseA;
+  state = target + (state - target) * a;
+  return state;
+}
+
+void DynamicsProcessor::process(const float* bandsL, const float* bandsR, float rmsL, float rmsR,
+                                float* levelL, float* levelR) {
+  // --- per band trackers (shared L/R so the stereo image survives) ---
+  float loudestEnv = -1e9f;
+  double power = 0.0;
+  for (int b = 0; b < _bands; ++b) {
+    const float m = std::max(bandsL[b], bandsR[b]);
+    track(_band[size_t(b)], toDb(m));
+    loudestEnv = std::max(loudestEnv, _band[size_t(b)].env);
+    power += 0.5 * (double(bandsL[b]) * bandsL[b] + double(bandsR[b]) * bandsR[b]);
+  }
+  for (int b = 0; b < _bands; ++b) {
+    const Tracker& t = _band[size_t(b)];
+    const float ref = std::max(t.env, loudestEnv - _cfg.bandRangeDb);
+    levelL[b] = smooth(_smoothL[size_t(b)], levelOf(t, toDb(bandsL[b]), ref));
+    levelR[b] = smooth(_smoothR[size_t(b)], levelOf(t, toDb(bandsR[b]), ref));
+  }
+
+  // --- overall level, gate, peak ---
+  const float xDb = 10.0f * std::log10(std::max(power, 1e-18));
+  track(_global, xDb);
+  _globalFloor = _global.floor;
+  _instant = levelOf(_global, xDb, _global.env);
+  _level = smooth(_global.smooth, _instant);
+
+  const float rmsDb = toDb(std::max(rmsL, rmsR));
+  _gate = rmsDb > _cfg.gateRmsDb && xDb > _global.floor + _cfg.gateDb;
+
+  // Peak: a jump over the ~100 ms average, at most once per refractory time
+  ++_sincePeak;
+  _peak = _gate && xDb - _shortAvgDb > _cfg.peakDb && _sincePeak >= _refractoryHops;
+  if (_peak) _sincePeak = 0;
+  const float avgA = onePole(100.0f, _hop);
+  _shortAvgDb = _shortAvgDb <= -119.0f ? xDb : xDb + (_shortAvgDb - xDb) * avgA;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <vector>
+
+// The one loudness model: raw band magnitudes in, 0..1 levels out, once per hop
+// on the DSP thread. Every consumer (bars, SR bins, SR level/peak, LED effects)
+// reads these instead of normalizing on its own.
+//
+// Per band, in dB:
+//   floor  - noise floor: follows drops quickly, creeps up slowly (minimum tracking)
+//   env    - peak envelope: instant attack, `releaseDbPerSec` release, never
+//            below floor + `minRangeDb`
+//   ref    - max(env, loudest band's env - `bandRangeDb`): each band scales to
+//            its own peak, but a band can't be boosted more than bandRangeDb
+//            over the loudest one (so hiss doesn't fill the screen)
+//   level  - (x - floor - gate) / (ref - floor - gate), clamped, then
+//            attack/release smoothed
+// The overall level (all bands' power) runs the same model; peak() fires when
+// it jumps `peakDb` above its short-term average (with a refractory time), and
+// the gate is open while it sits `gateDb` over its own floor and the frame RMS
+// is above an absolute threshold.
+class DynamicsProcessor {
+public:
+  struct Config {
+    float attackMs = 10.0f;          // level smoothing
+    float releaseMs = 150.0f;
+    float releaseDbPerSec = 6.0f;    // envelope (AGC) release
+    float floorRiseDbPerSec = 1.0f;  // noise floor creep
+    float floorFallMs = 200.0f;
+    float minRangeDb = 24.0f;        // envelope stays at least this far above the floor
+    float bandRangeDb = 18.0f;
+    float gateDb = 6.0f;
+    float gateRmsDb = -70.0f;        // absolute: below this the gate is shut
+    float peakDb = 6.0f;
+    float peakRefractoryMs = 120.0f;
+  };
+
+  void setConfig(const Config& c) { _cfg = c; updateCoefficients(); }
+  const Config& config() const { return _cfg; }
+
+  // So later configure() calls up to maxBands don't allocate
+  void reserve(int maxBands);
+  // Band count and hop period; resets the trackers when the band count changes.
+  void configure(int numBands, double hopSeconds);
+  void reset();
+
+  // Raw linear band magnitudes in (numBands each), levels 0..1 out.
+  void process(const float* bandsL, const float* bandsR, float rmsL, float rmsR,
+               float* levelL, float* levelR);
+
+  float level() const { return _level; }          // overall, smoothed 0..1
+  float levelInstant() const { return _instant; } // overall, before smoothing
+  bool  peak() const { return _peak; }
+  bool  gate() const { return _gate; }            // signal above the noise floor
+  float noiseFloorDb() const { return _globalFloor; }
+
+private:
+  struct Tracker { float floor = 0.0f, env = 0.0f, smooth = 0.0f; bool init = false; };
+  void updateCoefficients();
+  void track(Tracker& t, float xDb);
+  float levelOf(const Tracker& t, float xDb, float refDb) const;
+  float smooth(float& state, float target) const;
+
+  Config _cfg;
+  int _bands = 0;
+  double _hop = 512.0 / 48000.0;
+  float _attackA = 0.0f, _releaseA = 0.0f;     // one-pole coefficients per hop
+  float _floorFallA = 0.0f;
+  float _envFall = 0.0f, _floorRise = 0.0f;    // dB per hop
+  int   _refractoryHops = 1;
+
+  std::vector<Tracker> _band;                  // per band, L/R share one (max of the two)
+  std::vector<float> _smoothL, _smoothR;
+  Tracker _global;
+  float _level = 0.0f, _instant = 0.0f;
+  float _shortAvgDb = -120.0f;
+  float _globalFloor = -120.0f;
+  bool  _peak = false, _gate = false;
+  int   _sincePeak = 0;
+};
@@ -0,0 +1,137 @@
+#include "FftBackend.h"
+#include <cstdlib>
+#include <cstring>
+
+extern "C" {
+  #include "kiss_fft.h"
+  #include "kiss_fftr.h"
+}
+
+namespace fft {
+
+static_assert(sizeof(Complex) == sizeof(kiss_fft_cpx), "fft::Complex must match kiss_fft_cpx");
+
+// --- kissfft ---
+
+namespace {
+
+class KissReal final : public RealFft {
+public:
+  KissReal(int n, bool inverse)
+    : RealFft(n),
+      _fwd(kiss_fftr_alloc(n, 0, nullptr, nullptr)),
+      _inv(inverse ? kiss_fftr_alloc(n, 1, nullptr, nullptr) : nullptr) {}
+  ~KissReal() override {
+    if (_fwd) kiss_fftr_free(_fwd);
+    if (_inv) kiss_fftr_free(_inv);
+  }
+  bool ok(bool inverse) const { return _fwd && (!inverse || _inv); }
+
+  void forward(const float* in, Complex* out) override {
+    kiss_fftr(_fwd, in, reinterpret_cast<kiss_fft_cpx*>(out));
+  }
+  void inverse(const Complex* in, float* out) override {
+    if (_inv) kiss_fftri(_inv, reinterpret_cast<const kiss_fft_cpx*>(in), out);
+  }
+
+private:
+  kiss_fftr_cfg _fwd;
+  kiss_fftr_cfg _inv;
+};
+
+class KissComplex final : public ComplexFft {
+public:
+  explicit KissComplex(int n) : ComplexFft(n), _cfg(kiss_fft_alloc(n, 0, nullptr, nullptr)) {}
+  ~KissComplex() override { if (_cfg) kiss_fft_free(_cfg); }
+  bool ok() const { return _cfg != nullptr; }
+
+  void forward(const Complex* in, Complex* out) override {
+    kiss_fft(_cfg, reinterpret_cast<const kiss_fft_cpx*>(in), reinterpret_cast<kiss_fft_cpx*>(out));
+  }
+
+private:
+  kiss_fft_cfg _cfg;
+};
+
+Backend selectBackend() {
+  if (const char* env = std::getenv("WLEDQT_FFT")) {
+    if (std::strcmp(env, "kiss") == 0) return Backend::Kiss;
+    if (std::strcmp(env, "fftw") == 0 && backendAvailable(Backend::Fftw)) return Backend::Fftw;
+  }
+  return backendAvailable(Backend::Fftw) ? Backend::Fftw : Backend::Kiss;
+}
+
+} // namespace
+
+// --- selection ---
+
+const char* backendName(Backend b) {
+  switch (b) {
+    case Backend::Kiss: return "kissfft";
+    case Backend::Fftw: return "fftw3f";
+  }
+  return "?";
+}
+
+bool backendAvailable(Backend b) {
+#if defined(WLEDQT_HAVE_FFTW)
+  return b == Backend::Kiss || b == Backend::Fftw;
+#else
+  return b == Backend::Kiss;
+#endif
+}
+
+Backend defaultBackend() {
+  static const Backend b = selectBackend();
+  return b;
+}
+
+std::unique_ptr<RealFft> makeReal(int n, bool inverse) {
+  return makeReal(n, inverse, defaultBackend());
+}
+
+std::unique_ptr<RealFft> makeReal(int n, bool inverse, Backend b) {
+  if (n < 2 || (n & 1)) return nullptr;
+#if defined(WLEDQT_HAVE_FFTW)
+  if (b == Backend::Fftw) return detail::makeFftwReal(n, inverse);
+#endif
+  (void)b;
+  auto k = std::make_unique<KissReal>(n, inverse);
+  if (!k->ok(inverse)) return nullptr;
+  return k;
+}
+
+std::unique_ptr<ComplexFft> makeComplex(int n) {
+  return makeComplex(n, defaultBackend());
+}
+
+std::unique_ptr<ComplexFft> makeComplex(int n, Backend b) {
+  if (n < 1) return nullptr;
+#if defined(WLEDQT_HAVE_FFTW)
+  if (b == Backend::Fftw) return detail::makeFftwComplex(n);
+#endif
+  (void)b;
+  auto k = std::make_unique<KissComplex>(n);
+  if (!k->ok()) return nullptr;
+  return k;
+}
+
+bool loadWisdom(const std::string& path) {
+#if defined(WLEDQT_HAVE_FFTW)
+  return detail::loadFftwWisdom(path);
+#else
+  (void)path;
+  return false;
+#endif
+}
+
+bool saveWisdom(const std::string& path) {
+#if defined(WLEDQT_HAVE_FFTW)
+  return detail::saveFftwWisdom(path);
+#else
+  (void)path;
+  return false;
+#endif
+}
+
+} // namespace fft
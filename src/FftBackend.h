@@ -0,0 +1,84 @@
+#pragma once
+#include <memory>
+#include <string>
+
+// FFT plans behind one small interface, so the processors don't care which
+// library does the transform.
+//
+// kissfft is always built and is the fallback. With the CMake option
+// WLEDQT_WITH_FFTW (and libfftw3f found) FFTW becomes the default; setting
+// WLEDQT_FFT=kiss|fftw in the environment picks one explicitly.
+//
+// A plan is only ever used by one thread at a time (both backends keep
+// scratch inside the plan). Creating plans is thread-safe.
+namespace fft {
+
+// Interleaved {re, im}: the same layout as kiss_fft_cpx and fftwf_complex
+struct Complex {
+  float r;
+  float i;
+};
+
+enum class Backend { Kiss, Fftw };
+
+// Real-input transform of size n (even).
+class RealFft {
+public:
+  explicit RealFft(int n) : _n(n) {}
+  virtual ~RealFft() = default;
+  RealFft(const RealFft&) = delete;
+  RealFft& operator=(const RealFft&) = delete;
+
+  int size() const { return _n; }
+
+  // n samples -> n/2+1 bins, unnormalized
+  virtual void forward(const float* in, Complex* out) = 0;
+  // n/2+1 bins -> n samples, unnormalized (scaled by n); `in` is left as is.
+  // Only on plans made with inverse = true.
+  virtual void inverse(const Complex* in, float* out) = 0;
+
+protected:
+  int _n;
+};
+
+// Complex transform of size n (forward only).
+class ComplexFft {
+public:
+  explicit ComplexFft(int n) : _n(n) {}
+  virtual ~ComplexFft() = default;
+  ComplexFft(const ComplexFft&) = delete;
+  ComplexFft& operator=(const ComplexFft&) = delete;
+
+  int size() const { return _n; }
+  virtual void forward(const Complex* in, Complex* out) = 0;
+
+protected:
+  int _n;
+};
+
+const char* backendName(Backend b);
+// True if this build has `b`.
+bool backendAvailable(Backend b);
+// The backend plans are made with (WLEDQT_FFT, else the fastest built; fixed on first call).
+Backend defaultBackend();
+
+// nullptr if the size isn't supported or planning failed.
+std::unique_ptr<RealFft> makeReal(int n, bool inverse = false);
+std::unique_ptr<RealFft> makeReal(int n, bool inverse, Backend b);
+std::unique_ptr<ComplexFft> makeComplex(int n);
+std::unique_ptr<ComplexFft> makeComplex(int n, Backend b);
+
+// FFTW planner wisdom: load before the first plan, save at exit, and planning
+// the same sizes again is instant. No-ops (false) without FFTW.
+bool loadWisdom(const std::string& path);
+bool saveWisdom(const std::string& path);
+
+} // namespace fft
+
+namespace fft::detail {
+// Defined in FftBackendFftw.cpp (only built with FFTW; see CMakeLists.txt)
+std::unique_ptr<RealFft> makeFftwReal(int n, bool inverse);
+std::unique_ptr<ComplexFft> makeFftwComplex(int n);
+bool loadFftwWisdom(const std::string& path);
+bool saveFftwWisdom(const std::string& path);
+}
@@ -0,0 +1,146 @@
+// FFTW3 (single precision) plans for FftBackend. Only compiled when CMake
+// finds fftw3f (WLEDQT_WITH_FFTW); FftBackend.cpp falls back to kissfft otherwise.
+#include "FftBackend.h"
+#include <cstring>
+#include <mutex>
+#include <fftw3.h>
+
+namespace fft::detail {
+
+static_assert(sizeof(Complex) == sizeof(fftwf_complex), "fft::Complex must match fftwf_complex");
+
+namespace {
+
+// Everything but fftwf_execute_* must be serialized
+std::mutex& plannerMutex() {
+  static std::mutex m;
+  return m;
+}
+
+// MEASURE times a few algorithms per size; with wisdom loaded this is a lookup
+constexpr unsigned kPlanFlags = FFTW_MEASURE;
+
+// Plans are made on FFTW-allocated (SIMD-aligned) buffers. A call whose
+// arrays have the same alignment runs on them directly (new-array execute);
+// anything else goes through the plan's own buffers.
+template <typename T>
+bool sameAlignment(const T* a, const T* planned) {
+  return fftwf_alignment_of(reinterpret_cast<float*>(const_cast<T*>(a))) ==
+         fftwf_alignment_of(reinterpret_cast<float*>(const_cast<T*>(planned)));
+}
+
+class FftwReal final : public RealFft {
+public:
+  FftwReal(int n, bool inverse) : RealFft(n) {
+    _real = fftwf_alloc_real(size_t(n));
+    _cplx = fftwf_alloc_complex(size_t(n / 2 + 1));
+    if (!_real || !_cplx) return;
+    std::lock_guard<std::mutex> lock(plannerMutex());
+    // Planning may scribble over the buffers; they're scratch anyway
+    _fwd = fftwf_plan_dft_r2c_1d(n, _real, _cplx, kPlanFlags);
+    if (inverse) _inv = fftwf_plan_dft_c2r_1d(n, _cplx, _real, kPlanFlags);
+  }
+  ~FftwReal() override {
+    {
+      std::lock_guard<std::mutex> lock(plannerMutex());
+      if (_fwd) fftwf_destroy_plan(_fwd);
+      if (_inv) fftwf_destroy_plan(_inv);
+    }
+    fftwf_free(_real);
+    fftwf_free(_cplx);
+  }
+  bool ok(bool inverse) const { return _fwd && (!inverse || _inv); }
+
+  void forward(const float* in, Complex* out) override {
+    // Out-of-place r2c leaves its input alone
+    auto* o = reinterpret_cast<fftwf_complex*>(out);
+    if (sameAlignment(in, _real) && sameAlignment(o, _cplx)) {
+      fftwf_execute_dft_r2c(_fwd, const_cast<float*>(in), o);
+      return;
+    }
+    std::memcpy(_real, in, sizeof(float) * size_t(_n));
+    fftwf_execute(_fwd);
+    std::memcpy(o, _cplx, sizeof(fftwf_complex) * size_t(_n / 2 + 1));
+  }
+
+  void inverse(const Complex* in, float* out) override {
+    if (!_inv) return;
+    // c2r destroys its input: always work on the plan's copy
+    std::memcpy(_cplx, in, sizeof(fftwf_complex) * size_t(_n / 2 + 1));
+    if (sameAlignment(out, _real)) {
+      fftwf_execute_dft_c2r(_inv, _cplx, out);
+      return;
+    }
+    fftwf_execute(_inv);
+    std::memcpy(out, _real, sizeof(float) * size_t(_n));
+  }
+
+private:
+  float*         _real = nullptr;
+  fftwf_complex* _cplx = nullptr;
+  fftwf_plan     _fwd = nullptr;
+  fftwf_plan     _inv = nullptr;
+};
+
+class FftwComplex final : public ComplexFft {
+public:
+  explicit FftwComplex(int n) : ComplexFft(n) {
+    _in = fftwf_alloc_complex(size_t(n));
+    _out = fftwf_alloc_complex(size_t(n));
+    if (!_in || !_out) return;
+    std::lock_guard<std::mutex> lock(plannerMutex());
+    _plan = fftwf_plan_dft_1d(n, _in, _out, FFTW_FORWARD, kPlanFlags);
+  }
+  ~FftwComplex() override {
+    {
+      std::lock_guard<std::mutex> lock(plannerMutex());
+      if (_plan) fftwf_destroy_plan(_plan);
+    }
+    fftwf_free(_in);
+    fftwf_free(_out);
+  }
+  bool ok() const { return _plan != nullptr; }
+
+  void forward(const Complex* in, Complex* out) override {
+    const auto* i = reinterpret_cast<const fftwf_complex*>(in);
+    auto* o = reinterpret_cast<fftwf_complex*>(out);
+    if (sameAlignment(i, _in) && sameAlignment(o, _out)) {
+      fftwf_execute_dft(_plan, const_cast<fftwf_complex*>(i), o);   // out-of-place: input preserved
+      return;
+    }
+    std::memcpy(_in, i, sizeof(fftwf_complex) * size_t(_n));
+    fftwf_execute(_plan);
+    std::memcpy(o, _out, sizeof(fftwf_complex) * size_t(_n));
+  }
+
+private:
+  fftwf_complex* _in = nullptr;
+  fftwf_complex* _out = nullptr;
+  fftwf_plan     _plan = nullptr;
+};
+
+} // namespace
+
+std::unique_ptr<RealFft> makeFftwReal(int n, bool inverse) {
+  auto f = std::make_unique<FftwReal>(n, inverse);
+  if (!f->ok(inverse)) return nullptr;
+  return f;
+}
+
+std::unique_ptr<ComplexFft> makeFftwComplex(int n) {
+  auto f = std::make_unique<FftwComplex>(n);
+  if (!f->ok()) return nullptr;
+  return f;
+}
+
+bool loadFftwWisdom(const std::string& path) {
+  std::lock_guard<std::mutex> lock(plannerMutex());
+  return fftwf_import_wisdom_from_filename(path.c_str()) != 0;
+}
+
+bool saveFftwWisdom(const std::string& path) {
+  std::lock_guard<std::mutex> lock(plannerMutex());
+  return fftwf_export_wisdom_to_filename(path.c_str()) != 0;
+}
+
+} // namespace fft::detail
@@ -0,0 +1,144 @@
+#include "FileCaptureSource.h"
+#include "LatencyTracer.h"
+#include <QTimer>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+FileCaptureSource::FileCaptureSource(const CaptureSpec& spec) : _spec(spec) {}
+
+FileCaptureSource::~FileCaptureSource() {
+  stop();
+}
+
+bool FileCaptureSource::openWav(QString& error) {
+  char riff[12];
+  if (_file.read(riff, 12) != 12 || std::memcmp(riff, "RIFF", 4) || std::memcmp(riff + 8, "WAVE", 4)) {
+    error = "not a RIFF/WAVE file";
+    return false;
+  }
+  int tag = 0, bits = 0;
+  bool haveFmt = false;
+  for (;;) {
+    char hdr[8];
+    if (_file.read(hdr, 8) != 8) break;
+    const quint32 size = qFromLittleEndian<quint32>(hdr + 4);
+    const qint64 body = _file.pos();
+    if (!std::memcmp(hdr, "fmt ", 4) && size >= 16) {
+      QByteArray f = _file.read(std::min<quint32>(size, 40));
+      tag       = qFromLittleEndian<quint16>(f.constData());
+      _channels = qFromLittleEndian<quint16>(f.constData() + 2);
+      _rate     = int(qFromLittleEndian<quint32>(f.constData() + 4));
+      bits      = qFromLittleEndian<quint16>(f.constData() + 14);
+      if (tag == 0xFFFE && f.size() >= 26) tag = qFromLittleEndian<quint16>(f.constData() + 24);  // extensible
+      haveFmt = true;
+    } else if (!std::memcmp(hdr, "data", 4)) {
+      _dataStart = body;
+      _dataBytes = std::min<qint64>(size, _file.size() - body);   // tolerate truncated / streaming headers
+      break;
+    }
+    _file.seek(body + size + (size & 1));
+  }
+  if (!haveFmt || _dataStart == 0) { error = "missing fmt or data chunk"; return false; }
+
+  if (tag == 1 && bits == 16)      _format = PcmFormat::S16LE;
+  else if (tag == 1 && bits == 24) _format = PcmFormat::S24LE;
+  else if (tag == 1 && bits == 32) _format = PcmFormat::S32LE;
+  else if (tag == 3 && bits == 32) _format = PcmFormat::F32LE;
+  else { error = QString("unsupported sample format (tag %1, %2 bit)").arg(tag).arg(bits); return false; }
+  if (_channels <= 0 || _rate <= 0) { error = "bad channel count / sample rate"; return false; }
+  return true;
+}
+
+bool FileCaptureSource::start(CaptureSink* sink, int& sampleRate, int& channels, QString& info) {
+  stop();
+  _file.setFileName(_spec.path);
+  if (!_file.open(QIODevice::ReadOnly)) {
+    info = QString("capture: cannot open %1: %2").arg(_spec.path, _file.errorString());
+    return false;
+  }
+
+  if (_spec.kind == CaptureSpec::Kind::File) {
+    QString err;
+    if (!openWav(err)) {
+      info = QString("capture: %1: %2").arg(_spec.path, err);
+      _file.close();
+      return false;
+    }
+  } else {
+    _rate = _spec.sampleRate;
+    _channels = _spec.channels;
+    _format = _spec.format;
+    _dataStart = 0;
+    _dataBytes = _file.size();
+  }
+  const qint64 frameBytes = qint64(pcmBytesPerSample(_format)) * _channels;
+  _dataBytes -= _dataBytes % frameBytes;
+  if (_dataBytes <= 0) {
+    info = QString("capture: %1 has no audio").arg(_spec.path);
+    _file.close();
+    return false;
+  }
+
+  _sink = sink;
+  _readPos = 0;
+  _framesSent = 0;
+  _file.seek(_dataStart);
+  _buf.resize(int(frameBytes * (qint64(_rate) * kMaxCatchUpMs / 1000 + 1)));
+
+  _timer = new QTimer;
+  _timer->setTimerType(Qt::PreciseTimer);
+  QObject::connect(_timer, &QTimer::timeout, _timer, [this] { onTick(); });
+  _clock.start();
+  _timer->start(kTickMs);
+
+  sampleRate = _rate;
+  channels = _channels;
+  info = QString("file %1: %2 Hz, %3 ch, %4 s%5").arg(_spec.path).arg(_rate).arg(_channels)
+           .arg(double(_dataBytes / frameBytes) / _rate, 0, 'f', 1).arg(_spec.loop ? ", looping" : "");
+  return true;
+}
+
+void FileCaptureSource::stop() {
+  if (_timer) { _timer->stop(); delete _timer; _timer = nullptr; }
+  if (_file.isOpen()) _file.close();
+  _sink = nullptr;
+}
+
+void FileCaptureSource::onTick() {
+  if (!_sink) return;
+  const qint64 frameBytes = qint64(pcmBytesPerSample(_format)) * _channels;
+
+  // Frames due by now; after a long stall jump ahead instead of bursting
+  qint64 due = _clock.nsecsElapsed() * _rate / 1000000000 - _framesSent;
+  const qint64 maxFrames = qint64(_rate) * kMaxCatchUpMs / 1000;
+  if (due > maxFrames) { _framesSent += due - maxFrames; due = maxFrames; }
+  if (due <= 0) return;
+
+  const int64_t now = monotonicNs();
+  while (due > 0 && _sink) {
+    if (_readPos >= _dataBytes) {
+      if (!_spec.loop) {
+        CaptureSink* sink = _sink;
+        if (_timer) _timer->stop();
+        sink->sourceFinished();       // may stop() us
+        return;
+      }
+      _readPos = 0;
+      _file.seek(_dataStart);
+    }
+    const qint64 want = std::min(due * frameBytes, _dataBytes - _readPos);
+    const qint64 got = _file.read(_buf.data(), want);
+    if (got <= 0) {                     // read error / file shrank: end of input
+      CaptureSink* sink = _sink;
+      if (_timer) _timer->stop();
+      sink->sourceFinished();
+      return;
+    }
+    const int frames = int(got / frameBytes);
+    pushPcm(_sink, _buf.constData(), frames, _channels, _format, now);
+    _readPos += got;
+    _framesSent += frames;
+    due -= frames;
+  }
+}
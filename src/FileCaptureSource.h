@@ -0,0 +1,39 @@
+#pragma once
+#include "CaptureSource.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QByteArray>
+
+class QTimer;
+
+// WAV or headerless PCM file, played into the sink at its own sample rate
+// (a 10 ms PreciseTimer on the capture thread tops it up against a clock, so
+// the processors see the same cadence as from a device). Optionally loops.
+class FileCaptureSource : public CaptureSource {
+public:
+  explicit FileCaptureSource(const CaptureSpec& spec);
+  ~FileCaptureSource() override;
+
+  bool start(CaptureSink* sink, int& sampleRate, int& channels, QString& info) override;
+  void stop() override;
+
+private:
+  bool openWav(QString& error);         // fills format + data range from the RIFF header
+  void onTick();
+
+  CaptureSpec _spec;
+  CaptureSink* _sink = nullptr;
+  QFile _file;
+  qint64 _dataStart = 0, _dataBytes = 0;
+  int _rate = 48000, _channels = 2;
+  PcmFormat _format = PcmFormat::S16LE;
+
+  QTimer* _timer = nullptr;
+  QElapsedTimer _clock;
+  qint64 _framesSent = 0;               // since the clock started
+  qint64 _readPos = 0;                  // bytes into the data chunk
+  QByteArray _buf;                      // one tick's worth (max), reused
+
+  static constexpr int kTickMs = 10;
+  static constexpr int kMaxCatchUpMs = 100;   // after a stall, skip ahead rather than burst
+};
@@ -0,0 +1,327 @@
+// GlSpectrumView.cpp
+#include "GlSpectrumView.h"
+#include <QOpenGLContext>
+#include <QSurfaceFormat>
+#include <QScreen>
+#include <QVector3D>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// Full-view quad; v_uv is 0..1 with y up
+const char* kVertex = R"(
+in vec2 a_pos;
+out vec2 v_uv;
+void main() {
+  v_uv = a_pos * 0.5 + 0.5;
+  gl_Position = vec4(a_pos, 0.0, 1.0);
+}
+)";
+
+// Shared by all modes; u_mode picks the lookup. Values texture is R32F:
+//   Bars/Chroma: width n, height rows (row 0 = top channel)
+//   Waterfall:   width n (bands), height depth (time ring, u_head = oldest row)
+const char* kFragment = R"(
+precision highp float;
+precision highp int;
+in vec2 v_uv;
+out vec4 o_color;
+uniform sampler2D u_values;
+uniform int   u_mode;       // 0 bars, 1 waterfall, 2 chroma
+uniform int   u_n;
+uniform int   u_rows;
+uniform int   u_head;
+uniform float u_fill;       // fraction of a bar slot that is filled (gap between bars)
+uniform vec3  u_bg;
+
+vec3 heat(float t) {        // same stops as SpectrogramWidget
+  vec3 c0 = vec3(0.0, 0.0, 8.0) / 255.0;
+  vec3 c1 = vec3(40.0, 10.0, 100.0) / 255.0;
+  vec3 c2 = vec3(150.0, 30.0, 110.0) / 255.0;
+  vec3 c3 = vec3(240.0, 110.0, 30.0) / 255.0;
+  vec3 c4 = vec3(255.0, 250.0, 180.0) / 255.0;
+  t = clamp(t, 0.0, 1.0) * 4.0;
+  if (t < 1.0) return mix(c0, c1, t);
+  if (t < 2.0) return mix(c1, c2, t - 1.0);
+  if (t < 3.0) return mix(c2, c3, t - 2.0);
+  return mix(c3, c4, t - 3.0);
+}
+
+vec3 hue(float h) {
+  vec3 k = clamp(abs(fract(h + vec3(0.0, 2.0, 1.0) / 3.0) * 6.0 - 3.0) - 1.0, 0.0, 1.0);
+  return mix(vec3(1.0), k, 0.8) * 0.9;
+}
+
+void main() {
+  if (u_mode == 1) {
+    int t = min(int(v_uv.x * float(u_rows)), u_rows - 1);
+    int row = (u_head + t) % u_rows;
+    int b = min(int(v_uv.y * float(u_n)), u_n - 1);
+    o_color = vec4(heat(texelFetch(u_values, ivec2(b, row), 0).r), 1.0);
+    return;
+  }
+
+  float rowf = (1.0 - v_uv.y) * float(u_rows);
+  int row = min(int(rowf), u_rows - 1);
+  float y = 1.0 - (rowf - float(row));          // 0 at the row's bottom
+  float fb = v_uv.x * float(u_n);
+  int b = min(int(fb), u_n - 1);
+  float v = texelFetch(u_values, ivec2(b, row), 0).r;
+
+  vec3 bar;
+  if (u_mode == 2) bar = hue(float(b) / 12.0);
+  else bar = (row == 0) ? vec3(80.0, 220.0, 120.0) / 255.0 : vec3(90.0, 160.0, 255.0) / 255.0;
+
+  bool on = (y <= v * 0.98) && (fb - float(b) < u_fill);
+  o_color = vec4(on ? bar : u_bg, 1.0);
+}
+)";
+
+}
+
+GlSpectrumView::GlSpectrumView(Mode mode, QWidget* parent)
+  : QOpenGLWidget(parent), _mode(mode)
+{
+  setMinimumSize(200, 120);
+
+  // 3.3 core (or ES 3.0 where that's what the platform gives us): texelFetch + R32F
+  QSurfaceFormat fmt = format();
+  if (QOpenGLContext::openGLModuleType() == QOpenGLContext::LibGL) {
+    fmt.setVersion(3, 3);
+    fmt.setProfile(QSurfaceFormat::CoreProfile);
+  }
+  setFormat(fmt);
+
+  _renderTimer.setTimerType(Qt::PreciseTimer);
+  connect(&_renderTimer, &QTimer::timeout, this, &GlSpectrumView::onRenderTick);
+  applyRenderInterval();
+}
+
+GlSpectrumView::~GlSpectrumView()
+{
+  makeCurrent();
+  releaseGl();
+  doneCurrent();
+}
+
+bool GlSpectrumView::requested()
+{
+  const char* env = std::getenv("WLEDQT_RENDER");
+  return env && (std::strcmp(env, "gl") == 0 || std::strcmp(env, "opengl") == 0);
+}
+
+QSize GlSpectrumView::sizeHint() const {
+  return { 480, 240 };
+}
+
+// --- configuration ---
+
+void GlSpectrumView::setValueScale(float scale)
+{
+  _scale = std::max(0.0f, scale);
+}
+
+void GlSpectrumView::setHistoryDepth(int rows)
+{
+  _depth = std::clamp(rows, 2, 4096);
+  _history.clear();   // re-sized by the next pushHistory
+  _n = 0;
+  _reshape = true;
+}
+
+void GlSpectrumView::setMaxFps(int fps)
+{
+  _maxFps = std::max(0, fps);
+  applyRenderInterval();
+}
+
+void GlSpectrumView::applyRenderInterval()
+{
+  double hz = _maxFps;
+  if (hz <= 0) {
+    const QScreen* s = screen();
+    hz = (s && s->refreshRate() > 1.0) ? s->refreshRate() : 60.0;
+  }
+  _renderTimer.start(std::max(1, int(std::lround(1000.0 / hz))));
+}
+
+void GlSpectrumView::showEvent(QShowEvent* ev)
+{
+  QOpenGLWidget::showEvent(ev);
+  applyRenderInterval();
+}
+
+void GlSpectrumView::onRenderTick()
+{
+  if (_dirty && isVisible()) update();
+}
+
+// --- data in ---
+
+void GlSpectrumView::normalizeInto(float* dst, const float* src, int n, float scale) const
+{
+  if (scale > 0.0f) {
+    for (int i = 0; i < n; ++i) dst[i] = std::clamp(src[i] * scale, 0.0f, 1.0f);
+    return;
+  }
+  float mx = 0.0f;
+  for (int i = 0; i < n; ++i) mx = std::max(mx, src[i]);
+  const float k = mx > 0.0f ? 1.0f / mx : 0.0f;
+  for (int i = 0; i < n; ++i) dst[i] = src[i] * k;
+}
+
+void GlSpectrumView::setValues(const float* a, const float* b, int n, bool levels)
+{
+  if (!a || n <= 0) return;
+  const int rows = b ? 2 : 1;
+  if (n != _n || rows != _rows) {
+    _n = n;
+    _rows = rows;
+    _values.assign(size_t(rows) * n, 0.0f);
+    _reshape = true;
+  }
+  const float scale = levels ? 1.0f : _scale;
+  normalizeInto(_values.data(), a, n, scale);
+  if (b) normalizeInto(_values.data() + n, b, n, scale);
+  _dirty = true;
+}
+
+void GlSpectrumView::pushHistory(const float* v, int n)
+{
+  if (!v || n <= 0) return;
+  if (n != _n || _history.empty()) {
+    _n = n;
+    _history.assign(size_t(_depth) * n, 0.0f);
+    _head = 0;
+    _pending = 0;
+    _reshape = true;
+  }
+  normalizeInto(_history.data() + size_t(_head) * n, v, n, _scale);
+  _head = (_head + 1) % _depth;
+  _pending = std::min(_pending + 1, _depth);
+  _dirty = true;
+}
+
+void GlSpectrumView::setFrame(const SpectrumFramePtr& frame)
+{
+  if (frame) setValues(frame->levelL, frame->levelR, frame->numBands, true);
+}
+
+// --- GL ---
+
+void GlSpectrumView::initializeGL()
+{
+  initializeOpenGLFunctions();
+
+  const bool es = context()->isOpenGLES();
+  const QByteArray header = es ? "#version 300 es\n" : "#version 330 core\n";
+
+  _prog = new QOpenGLShaderProgram;
+  _glOk = _prog->addShaderFromSourceCode(QOpenGLShader::Vertex, header + kVertex)
+       && _prog->addShaderFromSourceCode(QOpenGLShader::Fragment, header + kFragment)
+       && _prog->link();
+  if (!_glOk) {
+    qWarning() << "GlSpectrumView: shader setup failed:" << _prog->log();
+    return;
+  }
+
+  static const float quad[] = { -1.f, -1.f,  1.f, -1.f,  -1.f, 1.f,  1.f, 1.f };
+  _vao.create();
+  QOpenGLVertexArrayObject::Binder bind(&_vao);
+  _quad.create();
+  _quad.bind();
+  _quad.allocate(quad, sizeof(quad));
+  _prog->enableAttributeArray("a_pos");
+  _prog->setAttributeBuffer("a_pos", GL_FLOAT, 0, 2);
+
+  glGenTextures(1, &_tex);
+  glBindTexture(GL_TEXTURE_2D, _tex);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  _reshape = true;
+
+  // The context goes away with the widget's top-level window
+  connect(context(), &QOpenGLContext::aboutToBeDestroyed, this, [this]() {
+    makeCurrent();
+    releaseGl();
+    doneCurrent();
+  });
+}
+
+void GlSpectrumView::releaseGl()
+{
+  if (_tex) { glDeleteTextures(1, &_tex); _tex = 0; }
+  _quad.destroy();
+  _vao.destroy();
+  delete _prog;
+  _prog = nullptr;
+  _glOk = false;
+}
+
+void GlSpectrumView::resizeGL(int, int)
+{
+  _dirty = true;
+}
+
+void GlSpectrumView::paintGL()
+{
+  const QColor bg = palette().window().color();
+  glClearColor(bg.redF(), bg.greenF(), bg.blueF(), 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+  _dirty = false;
+
+  const bool waterfall = _mode == Mode::Waterfall;
+  if (!_glOk || _n <= 0 || (waterfall ? _history.empty() : _values.empty())) return;
+
+  glBindTexture(GL_TEXTURE_2D, _tex);
+  const int texW = _n;
+  const int texH = waterfall ? _depth : _rows;
+  if (_reshape || texW != _texW || texH != _texH) {
+    // (Re)allocate with everything we have
+    const float* all = waterfall ? _history.data() : _values.data();
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, texW, texH, 0, GL_RED, GL_FLOAT, all);
+    _texW = texW;
+    _texH = texH;
+    _reshape = false;
+    _pending = 0;
+  } else if (waterfall) {
+    // Only the rows pushed since the last paint: at most two runs around the ring
+    int first = (_head - _pending + _depth) % _depth;
+    int left = _pending;
+    while (left > 0) {
+      const int run = std::min(left, _depth - first);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, first, _n, run, GL_RED, GL_FLOAT,
+                      _history.data() + size_t(first) * _n);
+      first = (first + run) % _depth;
+      left -= run;
+    }
+    _pending = 0;
+  } else {
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, _n, _rows, GL_RED, GL_FLOAT, _values.data());
+  }
+
+  // Leave a one-pixel gap between bars once they're wide enough to show it
+  const float slotPx = width() * devicePixelRatioF() / float(_n);
+  const float fill = slotPx > 3.0f ? 1.0f - 1.0f / slotPx : 1.0f;
+
+  _prog->bind();
+  _prog->setUniformValue("u_values", 0);
+  _prog->setUniformValue("u_mode", waterfall ? 1 : (_mode == Mode::Chroma ? 2 : 0));
+  _prog->setUniformValue("u_n", _n);
+  _prog->setUniformValue("u_rows", texH);
+  _prog->setUniformValue("u_head", _head);
+  _prog->setUniformValue("u_fill", fill);
+  _prog->setUniformValue("u_bg", QVector3D(bg.redF(), bg.greenF(), bg.blueF()));
+
+  glActiveTexture(GL_TEXTURE0);
+  QOpenGLVertexArrayObject::Binder bind(&_vao);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  _prog->release();
+}
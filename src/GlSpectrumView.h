@@ -0,0 +1,90 @@
+#pragma once
+#include <QOpenGLWidget>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLBuffer>
+#include <QOpenGLVertexArrayObject>
+#include <QTimer>
+#include <vector>
+#include "SpectrumFrame.h"
+
+// GPU render backend for the band displays (built when Qt6::OpenGLWidgets is
+// available, see WLEDQT_WITH_OPENGL; selected at runtime with WLEDQT_RENDER=gl).
+//
+// The CPU side only copies the value arrays; drawing is one full-view quad
+// whose fragment shader looks the values up in a float texture. Bars and
+// chroma upload n floats per frame, the waterfall uploads the new history
+// rows into a ring texture. Per-frame cost does not depend on the band count
+// or the history depth.
+class GlSpectrumView : public QOpenGLWidget, protected QOpenGLExtraFunctions {
+  Q_OBJECT
+public:
+  enum class Mode {
+    Bars,        // one row of bars per channel (1 or 2), BarsWidget replacement
+    Waterfall,   // history of one value row per frame, time left -> right
+    Chroma,      // 12 pitch-class bars, colour per class
+  };
+
+  explicit GlSpectrumView(Mode mode, QWidget* parent = nullptr);
+  ~GlSpectrumView() override;
+
+  // True when the user asked for the GL views (WLEDQT_RENDER=gl).
+  static bool requested();
+
+  QSize sizeHint() const override;
+
+  // 0 = divide by the frame's maximum, otherwise value * scale, clamped to 0..1.
+  // setFrame() ignores this: frame levels are already 0..1.
+  void setValueScale(float scale);
+  // Waterfall rows kept (default 200)
+  void setHistoryDepth(int rows);
+  // Repaint cap. 0 = follow the screen's refresh rate (default).
+  void setMaxFps(int fps);
+
+  // Bars / Chroma: replace the values (`b` may be null for one channel).
+  // `levels`: already 0..1 (the frame's dynamics levels), only clamped.
+  void setValues(const float* a, const float* b, int n, bool levels = false);
+  // Waterfall: append one row
+  void pushHistory(const float* v, int n);
+
+public slots:
+  // Stereo bars from a processor frame's 0..1 levels (Bars mode)
+  void setFrame(const SpectrumFramePtr& frame);
+
+protected:
+  void initializeGL() override;
+  void resizeGL(int w, int h) override;
+  void paintGL() override;
+  void showEvent(QShowEvent* ev) override;
+
+private:
+  void onRenderTick();
+  void applyRenderInterval();
+  void normalizeInto(float* dst, const float* src, int n, float scale) const;
+  void releaseGl();
+
+  Mode _mode;
+  float _scale = 0.0f;
+
+  // CPU copies, uploaded in paintGL
+  int _n = 0;                        // values per row
+  int _rows = 0;                     // Bars: channels
+  std::vector<float> _values;        // Bars/Chroma: rows x n
+  std::vector<float> _history;       // Waterfall: depth x n ring
+  int _depth = 200;
+  int _head = 0;                     // next history row to write (= oldest once full)
+  int _pending = 0;                  // history rows not uploaded yet
+  bool _dirty = false;
+  bool _reshape = true;              // texture size must be (re)allocated
+
+  // GL objects
+  bool _glOk = false;
+  QOpenGLShaderProgram* _prog = nullptr;
+  QOpenGLBuffer _quad{QOpenGLBuffer::VertexBuffer};
+  QOpenGLVertexArrayObject _vao;
+  GLuint _tex = 0;
+  int _texW = 0, _texH = 0;
+
+  QTimer _renderTimer;
+  int _maxFps = 0;
+};
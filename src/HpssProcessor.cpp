@@ -0,0 +1,208 @@
+#include "HpssProcessor.h"
+#include <algorithm>
+#include <cmath>
+
+// --- sliding median ---
+
+void SlidingMedian::reserve(int maxWindow) {
+  const size_t n = size_t(std::max(0, maxWindow));
+  for (auto* v : {&_lo, &_hi, &_where}) v->reserve(n);
+  _val.reserve(n);
+}
+
+void SlidingMedian::setWindow(int window) {
+  _window = std::max(0, window);
+  const size_t n = size_t(_window);
+  _val.assign(n, 0.0f);
+  _lo.assign(n, 0);
+  _hi.assign(n, 0);
+  _where.assign(n, 0);
+  clear();
+}
+
+void SlidingMedian::clear() {
+  _count = _head = 0;
+  _nLo = _nHi = 0;
+}
+
+void SlidingMedian::push(float x) {
+  if (_window == 0) return;
+  if (_count < _window) {
+    const int slot = _count++;
+    _val[size_t(slot)] = x;
+    insert(slot);
+    return;
+  }
+  // Full: the oldest slot takes the new value
+  const int slot = _head;
+  _head = (_head + 1) % _window;
+  _val[size_t(slot)] = x;
+  replaced(slot);
+}
+
+void SlidingMedian::insert(int slot) {
+  if (_nLo == 0 || !less(_lo[0], slot)) { setLo(_nLo, slot); siftUpLo(_nLo++); }
+  else                                  { setHi(_nHi, slot); siftUpHi(_nHi++); }
+
+  // Keep _nLo == _nHi or _nHi + 1, so the median is the lower heap's top
+  if (_nLo > _nHi + 1) {
+    const int top = _lo[0];
+    if (--_nLo > 0) { setLo(0, _lo[size_t(_nLo)]); siftDownLo(0); }
+    setHi(_nHi, top); siftUpHi(_nHi++);
+  } else if (_nHi > _nLo) {
+    const int top = _hi[0];
+    if (--_nHi > 0) { setHi(0, _hi[size_t(_nHi)]); siftDownHi(0); }
+    setLo(_nLo, top); siftUpLo(_nLo++);
+  }
+}
+
+void SlidingMedian::replaced(int slot) {
+  const int w = _where[size_t(slot)];
+  if (w >= 0) { siftUpLo(w);  siftDownLo(_where[size_t(slot)]); }
+  else        { siftUpHi(~w); siftDownHi(~_where[size_t(slot)]); }
+
+  // Only one value moved, so at most the two tops are out of order
+  if (_nHi > 0 && less(_hi[0], _lo[0])) {
+    const int a = _lo[0], b = _hi[0];
+    setLo(0, b); setHi(0, a);
+    siftDownLo(0);
+    siftDownHi(0);
+  }
+}
+
+void SlidingMedian::siftUpLo(int pos) {
+  while (pos > 0) {
+    const int parent = (pos - 1) / 2;
+    if (!less(_lo[size_t(parent)], _lo[size_t(pos)])) break;
+    const int a = _lo[size_t(parent)], b = _lo[size_t(pos)];
+    setLo(parent, b); setLo(pos, a);
+    pos = parent;
+  }
+}
+
+void SlidingMedian::siftDownLo(int pos) {
+  for (;;) {
+    int best = pos;
+    const int l = 2 * pos + 1, r = l + 1;
+    if (l < _nLo && less(_lo[size_t(best)], _lo[size_t(l)])) best = l;
+    if (r < _nLo && less(_lo[size_t(best)], _lo[size_t(r)])) best = r;
+    if (best == pos) return;
+    const int a = _lo[size_t(pos)], b = _lo[size_t(best)];
+    setLo(pos, b); setLo(best, a);
+    pos = best;
+  }
+}
+
+void SlidingMedian::siftUpHi(int pos) {
+  while (pos > 0) {
+    const int parent = (pos - 1) / 2;
+    if (!less(_hi[size_t(pos)], _hi[size_t(parent)])) break;
+    const int a = _hi[size_t(parent)], b = _hi[size_t(pos)];
+    setHi(parent, b); setHi(pos, a);
+    pos = parent;
+  }
+}
+
+void SlidingMedian::siftDownHi(int pos) {
+  for (;;) {
+    int best = pos;
+    const int l = 2 * pos + 1, r = l + 1;
+    if (l < _nHi && less(_hi[size_t(l)], _hi[size_t(best)])) best = l;
+    if (r < _nHi && less(_hi[size_t(r)], _hi[size_t(best)])) best = r;
+    if (best == pos) return;
+    const int a = _hi[size_t(pos)], b = _hi[size_t(best)];
+    setHi(pos, b); setHi(best, a);
+    pos = best;
+  }
+}
+
+// --- HPSS ---
+
+static int oddWindow(double x) {
+  int n = int(std::lround(x));
+  if (n % 2 == 0) ++n;
+  return std::clamp(n, 3, HpssProcessor::kMaxWindow);
+}
+
+void HpssProcessor::reserve(int maxBins) {
+  const size_t groups = size_t(std::max(1, std::min(maxBins, _cfg.maxBins)));
+  _x.reserve(groups);
+  _mask.reserve(groups);
+  if (_time.size() < groups) _time.resize(groups);
+  for (SlidingMedian& m : _time) m.reserve(kMaxWindow);
+  _freq.reserve(kMaxWindow);
+}
+
+void HpssProcessor::configure(int bins, float binHz, double hopSeconds) {
+  bins = std::max(0, bins);
+  const int maxBins = std::max(1, _cfg.maxBins);
+  const int group = std::max(1, (bins + maxBins - 1) / maxBins);
+  const int groups = (bins + group - 1) / group;
+  const int timeLen = oddWindow(_cfg.harmonicMs * 1e-3 / std::max(hopSeconds, 1e-6));
+  const int freqLen = oddWindow(_cfg.percussiveHz / std::max(binHz * float(group), 1e-3f));
+  _binHz = binHz;
+  _hop = hopSeconds;
+  if (bins == _bins && group == _group && timeLen == _timeLen && freqLen == _freqLen) return;
+
+  _bins = bins;
+  _group = group;
+  _groups = groups;
+  _timeLen = timeLen;
+  _freqLen = freqLen;
+  _x.assign(size_t(groups), 0.0f);
+  _mask.assign(size_t(groups), 0.5f);
+  if (_time.size() < size_t(groups)) _time.resize(size_t(groups));   // beyond reserve(): allocates
+  for (int g = 0; g < groups; ++g) _time[size_t(g)].setWindow(timeLen);
+  _freq.setWindow(freqLen);
+  _harmEnergy = _percEnergy = 0.0f;
+}
+
+void HpssProcessor::reset() {
+  for (int g = 0; g < _groups; ++g) _time[size_t(g)].clear();
+  std::fill(_mask.begin(), _mask.end(), 0.5f);
+  _harmEnergy = _percEnergy = 0.0f;
+}
+
+void HpssProcessor::process(const float* mag, float* harmonic, float* percussive) {
+  if (_bins == 0) return;
+
+  // Group means (one bin per group unless the spectrum is wider than maxBins)
+  for (int g = 0; g < _groups; ++g) {
+    const int lo = g * _group, hi = std::min(_bins, lo + _group);
+    float s = 0.0f;
+    for (int k = lo; k < hi; ++k) s += mag[k];
+    _x[size_t(g)] = s / float(hi - lo);
+  }
+
+  // Harmonic: each group's median over the last _timeLen hops (kept in _mask for now)
+  for (int g = 0; g < _groups; ++g) {
+    SlidingMedian& m = _time[size_t(g)];
+    m.push(_x[size_t(g)]);
+    _mask[size_t(g)] = m.median();
+  }
+
+  // Percussive: median across _freqLen neighbours, edges clamped, slid along
+  // the spectrum; then the soft mask
+  const int half = _freqLen / 2;
+  auto at = [&](int g) { return _x[size_t(std::clamp(g, 0, _groups - 1))]; };
+  _freq.clear();
+  for (int j = -half; j <= half; ++j) _freq.push(at(j));
+  for (int g = 0; g < _groups; ++g) {
+    const float h = _mask[size_t(g)], p = _freq.median();
+    const float h2 = h * h, p2 = p * p;
+    _mask[size_t(g)] = h2 + p2 > 1e-24f ? h2 / (h2 + p2) : 0.5f;
+    _freq.push(at(g + half + 1));
+  }
+
+  float he = 0.0f, pe = 0.0f;
+  for (int k = 0; k < _bins; ++k) {
+    const float hm = mag[k] * _mask[size_t(k / _group)];
+    const float pm = mag[k] - hm;
+    harmonic[k] = hm;
+    percussive[k] = pm;
+    he += hm * hm;
+    pe += pm * pm;
+  }
+  _harmEnergy = he;
+  _percEnergy = pe;
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Median of the last `window` values pushed, updated in O(log window).
+//
+// Two indexed heaps over a fixed ring of slots: the lower half as a max-heap,
+// the upper half as a min-heap, and every slot knows where it sits. Once the
+// window is full a push overwrites the oldest slot in place, re-sifts it in
+// its own heap and, if that pushed it across the middle, swaps the two tops.
+// No allocation after reserve() / setWindow() within the reserved size.
+class SlidingMedian {
+public:
+  void reserve(int maxWindow);
+  void setWindow(int window);      // clears
+  void clear();
+  int  window() const { return _window; }
+  int  size() const { return _count; }
+
+  void  push(float x);
+  float median() const { return _count ? _val[size_t(_lo[0])] : 0.0f; }   // lower median while filling
+
+private:
+  bool less(int a, int b) const { return _val[size_t(a)] < _val[size_t(b)]; }
+  void siftUpLo(int pos);
+  void siftDownLo(int pos);
+  void siftUpHi(int pos);
+  void siftDownHi(int pos);
+  void setLo(int pos, int slot) { _lo[size_t(pos)] = slot; _where[size_t(slot)] = pos; }
+  void setHi(int pos, int slot) { _hi[size_t(pos)] = slot; _where[size_t(slot)] = ~pos; }
+  void insert(int slot);           // filling: new slot into the heaps, halves rebalanced
+  void replaced(int slot);         // full: slot's value changed, restore the order
+
+  int _window = 0, _count = 0, _head = 0;
+  int _nLo = 0, _nHi = 0;
+  std::vector<float> _val;         // ring of the window's values
+  std::vector<int> _lo, _hi;       // heaps of slot indices
+  std::vector<int> _where;         // slot -> heap position (>= 0 in _lo, ~pos in _hi)
+};
+
+// Streaming harmonic/percussive separation by median filtering (Fitzgerald):
+// a bin that holds steady over time is harmonic, one that is broad across
+// frequency in a single hop is percussive.
+//
+// Per hop, on the L/R-mean magnitudes:
+//   H[k] - median of bin k over the last `harmonicMs` of hops (causal, one
+//          SlidingMedian per bin)
+//   P[k] - median of this hop across `percussiveHz` of neighbouring bins (one
+//          SlidingMedian slid along the spectrum)
+//   soft (Wiener) masks H^2 / (H^2 + P^2) and P^2 / (H^2 + P^2), which sum to
+//   one, applied to the magnitudes
+// Cost per hop is O(bins x log window). Spectra wider than `maxBins` are
+// averaged into groups first (the masks are shared within a group), so the
+// cost stays bounded at any FFT size.
+class HpssProcessor {
+public:
+  struct Config {
+    float harmonicMs = 200.0f;       // time median length
+    float percussiveHz = 500.0f;     // frequency median width
+    int   maxBins = 1024;            // analysis bins per hop at most (cost bound)
+  };
+  static constexpr int kMaxWindow = 31;  // either median, in hops / bins
+
+  void setConfig(const Config& c) { _cfg = c; }
+  const Config& config() const { return _cfg; }
+
+  // Largest spectrum configure() may see without allocating.
+  void reserve(int maxBins);
+  // bins = N/2 + 1; clears the history when the layout changes.
+  void configure(int bins, float binHz, double hopSeconds);
+  void reset();
+
+  // mag in, the harmonic and percussive parts out (bins each, harmonic +
+  // percussive = mag).
+  void process(const float* mag, float* harmonic, float* percussive);
+
+  int   bins() const { return _bins; }
+  int   harmonicWindow() const { return _timeLen; }     // hops
+  int   percussiveWindow() const { return _freqLen; }   // analysis bins
+  float harmonicEnergy() const { return _harmEnergy; }  // sum of harmonic^2 this hop
+  float percussiveEnergy() const { return _percEnergy; }
+
+private:
+  Config _cfg;
+  int _bins = 0, _group = 1, _groups = 0;
+  int _timeLen = 0, _freqLen = 0;
+  float _binHz = 0.0f;
+  double _hop = 0.0;
+
+  std::vector<float> _x;             // grouped magnitudes (_groups)
+  std::vector<float> _mask;          // harmonic mask per group
+  std::vector<SlidingMedian> _time;  // per group
+  SlidingMedian _freq;
+  float _harmEnergy = 0.0f, _percEnergy = 0.0f;
+};
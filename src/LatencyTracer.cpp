@@ -0,0 +1,107 @@
+#include "LatencyTracer.h"
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+
+// --- LatencyHistogram ---
+
+int LatencyHistogram::bucketOf(int64_t ns) {
+  const uint64_t v = uint64_t(std::max<int64_t>(ns, 0));
+  if (v < uint64_t(kSub)) return int(v);                        // 0..7 ns: exact buckets
+  const int msb = 63 - std::countl_zero(v);
+  const int sub = int((v >> (msb - kSubBits)) & (kSub - 1));
+  return std::min(kBuckets - 1, (msb - kSubBits + 1) * kSub + sub);
+}
+
+int64_t LatencyHistogram::bucketLowNs(int i) {
+  if (i < kSub) return i;
+  const int octave = i / kSub - 1 + kSubBits;
+  const int sub = i % kSub;
+  return int64_t(kSub + sub) << (octave - kSubBits);
+}
+
+int64_t LatencyHistogram::bucketHighNs(int i) {
+  return i + 1 < kBuckets ? bucketLowNs(i + 1) : bucketLowNs(i) * 2;
+}
+
+void LatencyHistogram::record(int64_t ns) {
+  _buckets[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+  _count.fetch_add(1, std::memory_order_relaxed);
+  _sum.fetch_add(ns, std::memory_order_relaxed);
+  if (ns > _max.load(std::memory_order_relaxed)) _max.store(ns, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::reset() {
+  for (auto& b : _buckets) b.store(0, std::memory_order_relaxed);
+  _count.store(0, std::memory_order_relaxed);
+  _sum.store(0, std::memory_order_relaxed);
+  _max.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::meanNs() const {
+  const uint64_t n = count();
+  return n ? double(_sum.load(std::memory_order_relaxed)) / double(n) : 0.0;
+}
+
+int64_t LatencyHistogram::quantileNs(double q) const {
+  uint64_t total = 0;
+  for (const auto& b : _buckets) total += b.load(std::memory_order_relaxed);
+  if (total == 0) return 0;
+  const uint64_t rank = std::max<uint64_t>(1, uint64_t(q * double(total) + 0.5));
+  uint64_t acc = 0;
+  for (int i = 0; i < kBuckets; ++i) {
+    acc += _buckets[i].load(std::memory_order_relaxed);
+    if (acc >= rank) return (bucketLowNs(i) + bucketHighNs(i)) / 2;
+  }
+  return maxNs();
+}
+
+// --- LatencyTracer ---
+
+const char* LatencyTracer::stageName(Stage s) {
+  switch (s) {
+    case Dequeue:  return "callback_to_dequeue";
+    case Fft:      return "fft";
+    case Bands:    return "band_compute";
+    case Send:     return "send";
+    case EndToEnd: return "capture_to_datagram";
+    default:       return "?";
+  }
+}
+
+LatencyTracer::Summary LatencyTracer::summary(Stage s) const {
+  const LatencyHistogram& h = _stages[s];
+  Summary out;
+  out.count  = h.count();
+  out.meanUs = h.meanNs() * 1e-3;
+  out.p50Us  = double(h.quantileNs(0.50)) * 1e-3;
+  out.p95Us  = double(h.quantileNs(0.95)) * 1e-3;
+  out.p99Us  = double(h.quantileNs(0.99)) * 1e-3;
+  out.maxUs  = double(h.maxNs()) * 1e-3;
+  return out;
+}
+
+std::string LatencyTracer::toCsv() const {
+  std::string csv = "stage,count,mean_us,p50_us,p95_us,p99_us,max_us\n";
+  char line[256];
+  for (int s = 0; s < StageCount; ++s) {
+    const Summary m = summary(Stage(s));
+    std::snprintf(line, sizeof(line), "%s,%llu,%.2f,%.2f,%.2f,%.2f,%.2f\n",
+                  stageName(Stage(s)), (unsigned long long)m.count,
+                  m.meanUs, m.p50Us, m.p95Us, m.p99Us, m.maxUs);
+    csv += line;
+  }
+  csv += "\nstage,bucket_low_us,bucket_high_us,count\n";
+  for (int s = 0; s < StageCount; ++s) {
+    const LatencyHistogram& h = _stages[s];
+    for (int i = 0; i < LatencyHistogram::kBuckets; ++i) {
+      const uint64_t c = h.bucketCount(i);
+      if (!c) continue;
+      std::snprintf(line, sizeof(line), "%s,%.3f,%.3f,%llu\n", stageName(Stage(s)),
+                    double(LatencyHistogram::bucketLowNs(i)) * 1e-3,
+                    double(LatencyHistogram::bucketHighNs(i)) * 1e-3, (unsigned long long)c);
+      csv += line;
+    }
+  }
+  return csv;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Monotonic clock shared by every latency stamp (capture callback, DSP, sender).
+inline int64_t monotonicNs() {
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Log-bucketed histogram of durations in nanoseconds.
+// Eight buckets per power of two (<= 12.5% relative error), 0 ns .. ~18 min.
+// record() is lock-free and allocation-free; one writer thread per histogram,
+// readers on any thread.
+class LatencyHistogram {
+public:
+  static constexpr int kSubBits = 3;                          // 8 buckets per octave
+  static constexpr int kSub = 1 << kSubBits;
+  static constexpr int kOctaves = 41;                         // up to 2^40 ns
+  static constexpr int kBuckets = kOctaves * kSub;
+
+  void record(int64_t ns);
+  void reset();
+
+  uint64_t count() const { return _count.load(std::memory_order_relaxed); }
+  int64_t  maxNs() const { return _max.load(std::memory_order_relaxed); }
+  double   meanNs() const;
+  // q in [0,1]; returns the midpoint of the bucket holding that quantile (0 if empty)
+  int64_t  quantileNs(double q) const;
+
+  uint64_t bucketCount(int i) const { return _buckets[i].load(std::memory_order_relaxed); }
+  static int64_t bucketLowNs(int i);
+  static int64_t bucketHighNs(int i);
+
+private:
+  static int bucketOf(int64_t ns);
+
+  std::array<std::atomic<uint64_t>, kBuckets> _buckets{};
+  std::atomic<uint64_t> _count{0};
+  std::atomic<int64_t>  _sum{0};
+  std::atomic<int64_t>  _max{0};
+};
+
+// Per-stage latency histograms for the capture -> light path.
+//
+//   Dequeue  capture callback stamp -> DSP thread pulls those frames off the ring
+//   Fft      the two real FFTs of one hop
+//   Bands    magnitudes + filterbank of one hop
+//   Send     packet fan-out (all targets) for one frame
+//   EndToEnd capture stamp of the newest sample in a frame -> its datagram sent
+class LatencyTracer {
+public:
+  enum Stage { Dequeue, Fft, Bands, Send, EndToEnd, StageCount };
+
+  struct Summary {
+    uint64_t count = 0;
+    double meanUs = 0, p50Us = 0, p95Us = 0, p99Us = 0, maxUs = 0;
+  };
+
+  static const char* stageName(Stage s);
+
+  void record(Stage s, int64_t ns) { if (ns >= 0) _stages[s].record(ns); }
+  void reset() { for (auto& h : _stages) h.reset(); }
+
+  Summary summary(Stage s) const;
+  const LatencyHistogram& histogram(Stage s) const { return _stages[s]; }
+
+  // Summary table followed by the non-empty buckets of every stage.
+  std::string toCsv() const;
+
+private:
+  std::array<LatencyHistogram, StageCount> _stages;
+};
@@ -0,0 +1,160 @@
+#include "LedEffectEngine.h"
+#include <algorithm>
+#include <cmath>
+
+const char* LedEffectEngine::effectName(Effect e) {
+  switch (e) {
+    case Effect::Spectrum: return "Spectrum";
+    case Effect::Pulse:    return "Pulse";
+    case Effect::Meter:    return "Meter";
+    case Effect::Scroll:   return "Scroll";
+    case Effect::Count:    break;
+  }
+  return "?";
+}
+
+void LedEffectEngine::setLedCount(int n) {
+  n = std::max(0, n);
+  if (n == _count) return;
+  _count = n;
+  _rgb.assign(size_t(3 * n), 0);
+  _level.assign(size_t(n), 0.0f);
+  _trail.assign(size_t(3 * n), 0.0f);
+}
+
+void LedEffectEngine::setBrightness(float b) {
+  _brightness = std::clamp(b, 0.0f, 1.0f);
+}
+
+const uint8_t* LedEffectEngine::render(const LedInput& in, double dtSeconds) {
+  const float dt = float(std::clamp(dtSeconds, 0.0, 0.25));
+  _hue = std::fmod(_hue + dt * 0.02f, 1.0f);        // one turn every 50 s
+  switch (_effect) {
+    case Effect::Spectrum: renderSpectrum(in, dt); break;
+    case Effect::Pulse:    renderPulse(in, dt); break;
+    case Effect::Meter:    renderMeter(in, dt); break;
+    case Effect::Scroll:   renderScroll(in, dt); break;
+    case Effect::Count:    break;
+  }
+  return _rgb.data();
+}
+
+void LedEffectEngine::put(int i, float r, float g, float b) {
+  const float k = 255.0f * _brightness;
+  uint8_t* p = _rgb.data() + 3 * i;
+  p[0] = uint8_t(std::clamp(r * k + 0.5f, 0.0f, 255.0f));
+  p[1] = uint8_t(std::clamp(g * k + 0.5f, 0.0f, 255.0f));
+  p[2] = uint8_t(std::clamp(b * k + 0.5f, 0.0f, 255.0f));
+}
+
+void LedEffectEngine::hsv(float h, float s, float v, float& r, float& g, float& b) {
+  h = (h - std::floor(h)) * 6.0f;
+  const int sector = int(h) % 6;
+  const float f = h - std::floor(h);
+  const float p = v * (1.0f - s), q = v * (1.0f - s * f), t = v * (1.0f - s * (1.0f - f));
+  switch (sector) {
+    case 0:  r = v; g = t; b = p; break;
+    case 1:  r = q; g = v; b = p; break;
+    case 2:  r = p; g = v; b = t; break;
+    case 3:  r = p; g = q; b = v; break;
+    case 4:  r = t; g = p; b = v; break;
+    default: r = v; g = p; b = q; break;
+  }
+}
+
+// --- effects ---
+
+void LedEffectEngine::renderSpectrum(const LedInput& in, float dt) {
+  const float decay = std::exp(-dt * 6.0f);         // ~170 ms fall
+  const int n = _count;
+  for (int i = 0; i < n; ++i) {
+    // Position along the spectrum: 0 = lowest bin
+    float t = n > 1 ? float(i) / float(n - 1) : 0.0f;
+    if (_mirror) t = std::fabs(2.0f * t - 1.0f);
+    const float x = t * float(LedInput::kBins - 1);
+    const int b0 = std::min(int(x), LedInput::kBins - 2);
+    const float f = x - float(b0);
+    const float v = in.bins16[b0] * (1.0f - f) + in.bins16[b0 + 1] * f;
+
+    _level[i] = std::max(v, _level[i] * decay);      // instant attack, smooth release
+    float r, g, b;
+    hsv(_hue + t * 0.8f, 1.0f, _level[i] * _level[i], r, g, b);   // squared: more contrast
+    put(i, r, g, b);
+  }
+}
+
+void LedEffectEngine::renderPulse(const LedInput& in, float dt) {
+  if (in.beat) _pulse = 1.0f;
+  else if (in.onset) _pulse = std::max(_pulse, 0.6f);
+  _pulse *= std::exp(-dt * 5.0f);
+
+  // Colour follows the dominant pitch class when there is one, else the base hue
+  float target = _hue;
+  if (in.haveChroma) {
+    int best = 0;
+    for (int c = 1; c < 12; ++c) if (in.chroma[c] > in.chroma[best]) best = c;
+    if (in.chroma[best] > 0.0f) target = float(best) / 12.0f;
+  }
+  float d = target - _pulseHue;
+  d -= std::floor(d + 0.5f);                        // shortest way round
+  _pulseHue += d * std::min(1.0f, dt * 4.0f);
+
+  const int n = _count;
+  for (int i = 0; i < n; ++i) {
+    // Brightest in the middle while fading out
+    const float t = n > 1 ? std::fabs(2.0f * float(i) / float(n - 1) - 1.0f) : 0.0f;
+    const float v = _pulse * (1.0f - 0.6f * t * (1.0f - _pulse));
+    float r, g, b;
+    hsv(_pulseHue, 1.0f - 0.3f * _pulse, v, r, g, b);
+    put(i, r, g, b);
+  }
+}
+
+void LedEffectEngine::renderMeter(const LedInput& in, float dt) {
+  const float fill = std::clamp(in.level, 0.0f, 1.0f);
+  _peakHold = std::max(fill, _peakHold - dt * 0.5f);
+
+  const int n = _count;
+  const int lit = int(fill * float(n) + 0.5f);
+  const int peak = std::min(n - 1, int(_peakHold * float(n)));
+  for (int i = 0; i < n; ++i) {
+    const float t = n > 1 ? float(i) / float(n - 1) : 0.0f;
+    if (i < lit) {
+      // green -> yellow -> red along the strip
+      put(i, std::min(1.0f, 2.0f * t), std::min(1.0f, 2.0f * (1.0f - t)), 0.0f);
+    } else if (i == peak && _peakHold > 0.02f) {
+      put(i, 1.0f, 1.0f, 1.0f);
+    } else {
+      put(i, 0.0f, 0.0f, 0.0f);
+    }
+  }
+}
+
+void LedEffectEngine::renderScroll(const LedInput& in, float dt) {
+  const int n = _count;
+  if (n == 0) return;
+
+  // Head colour: low bins red, mids green, highs blue
+  auto band = [&](int lo, int hi) {
+    float s = 0.0f;
+    for (int k = lo; k < hi; ++k) s += in.bins16[k];
+    return s / float(hi - lo);
+  };
+  float r = band(0, 4), g = band(4, 10), b = band(10, 16);
+  if (in.onset) { r = std::min(1.0f, r + 0.3f); g = std::min(1.0f, g + 0.3f); b = std::min(1.0f, b + 0.3f); }
+
+  // Cross the whole strip in ~2 s whatever its length
+  _scrollAcc += dt * float(n) * 0.5f;
+  int shift = std::min(n, int(_scrollAcc));
+  _scrollAcc -= float(shift);
+  if (shift > 0) {
+    std::copy_backward(_trail.begin(), _trail.end() - 3 * shift, _trail.end());
+    for (int i = 0; i < shift; ++i) {
+      _trail[3 * i] = r; _trail[3 * i + 1] = g; _trail[3 * i + 2] = b;
+    }
+  } else {
+    // Keep the head live between shifts
+    _trail[0] = std::max(_trail[0], r); _trail[1] = std::max(_trail[1], g); _trail[2] = std::max(_trail[2], b);
+  }
+  for (int i = 0; i < n; ++i) put(i, _trail[3 * i], _trail[3 * i + 1], _trail[3 * i + 2]);
+}
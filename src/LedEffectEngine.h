@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// What an effect gets to look at each render: the newest analysis, plus beat
+// and onset events that happened since the previous render.
+struct LedInput {
+  static constexpr int kBins = 16;
+  float bins16[kBins] = {};        // 0..1, the same bins WLED gets over SR
+  float rms = 0.0f;                // linear, mean of L/R
+  float level = 0.0f;              // 0..1, AGC'd overall level (DynamicsProcessor)
+  bool  beat = false;              // >= 1 tracked beat since the last render
+  bool  onset = false;             // >= 1 onset since the last render
+  float beatPhase = 0.0f;          // 0..1, 0 = on the beat
+  float beatConfidence = 0.0f;
+  float chroma[12] = {};           // pitch-class energy (C, C#, ...), 0 if unknown
+  bool  haveChroma = false;
+};
+
+// Renders one RGB frame per call for a strip of `ledCount` pixels.
+//
+// Effects are plain functions of LedInput plus a little state (smoothed
+// levels, decays, a scroll buffer), advanced by the real time between calls,
+// so output looks the same at any render rate. No allocation after
+// setLedCount(); single-threaded (the LED sender thread owns it).
+class LedEffectEngine {
+public:
+  enum class Effect {
+    Spectrum,   // 16 bins across the strip, rainbow, mirrored from the middle
+    Pulse,      // whole strip flashes on beats/onsets, colour from the dominant pitch class
+    Meter,      // VU fill from the AGC'd level with a peak-hold pixel
+    Scroll,     // colour from low/mid/high energy pushed in at one end and scrolled along
+    Count
+  };
+  static const char* effectName(Effect e);
+
+  void setLedCount(int n);
+  int ledCount() const { return _count; }
+  void setEffect(Effect e) { _effect = e; }
+  Effect effect() const { return _effect; }
+  void setBrightness(float b);     // 0..1
+  void setMirror(bool on) { _mirror = on; }   // Spectrum: low bins in the middle
+
+  // Render a frame; returns ledCount() * 3 bytes (RGB), valid until the next call.
+  const uint8_t* render(const LedInput& in, double dtSeconds);
+
+private:
+  void renderSpectrum(const LedInput& in, float dt);
+  void renderPulse(const LedInput& in, float dt);
+  void renderMeter(const LedInput& in, float dt);
+  void renderScroll(const LedInput& in, float dt);
+  void put(int i, float r, float g, float b);
+  static void hsv(float h, float s, float v, float& r, float& g, float& b);   // h in turns
+
+  int _count = 0;
+  Effect _effect = Effect::Spectrum;
+  float _brightness = 0.8f;
+  bool _mirror = true;
+
+  std::vector<uint8_t> _rgb;       // output, 3 * _count
+  std::vector<float> _level;       // per-LED smoothed value (Spectrum)
+  std::vector<float> _trail;       // 3 * _count float RGB (Scroll)
+  float _hue = 0.0f;               // slowly rotating base hue (turns)
+  float _pulse = 0.0f;
+  float _pulseHue = 0.0f;
+  float _peakHold = 0.0f;
+  float _scrollAcc = 0.0f;         // fractional pixels to scroll
+};
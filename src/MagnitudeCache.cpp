@@ -0,0 +1,94 @@
+#include "MagnitudeCache.h"
+#include <algorithm>
+#include <cmath>
+
+void MagnitudeCache::reserve(int maxBins) {
+  const size_t n = size_t(std::max(0, maxBins));
+  for (auto* v : {&_mag, &_pow, &_log}) v->reserve(n);
+  for (auto* v : {&_cumMag, &_cumKMag, &_cumPow, &_cumLog}) v->reserve(n + 1);
+}
+
+void MagnitudeCache::configure(int bins, float binHz) {
+  _bins = std::max(0, bins);
+  _binHz = binHz;
+  _mag.assign(size_t(_bins), 0.0f);
+  _pow.assign(size_t(_bins), 0.0f);
+  _log.assign(size_t(_bins), 0.0f);
+  _cumMag.assign(size_t(_bins + 1), 0.0);
+  _cumKMag.assign(size_t(_bins + 1), 0.0);
+  _cumPow.assign(size_t(_bins + 1), 0.0);
+  _cumLog.assign(size_t(_bins + 1), 0.0);
+}
+
+void MagnitudeCache::update(const float* magL, const float* magR) {
+  constexpr float kEps = 1e-9f;
+  double cm = 0.0, ckm = 0.0, cp = 0.0, cl = 0.0;
+  for (int k = 0; k < _bins; ++k) {
+    const float m = (magL[k] + magR[k]) * 0.5f;
+    const float p = m * m;
+    const float l = std::log(m + kEps);
+    _mag[size_t(k)] = m;
+    _pow[size_t(k)] = p;
+    _log[size_t(k)] = l;
+    cm += m;
+    ckm += double(k) * m;
+    cp += p;
+    cl += l;
+    _cumMag[size_t(k + 1)] = cm;
+    _cumKMag[size_t(k + 1)] = ckm;
+    _cumPow[size_t(k + 1)] = cp;
+    _cumLog[size_t(k + 1)] = cl;
+  }
+}
+
+float MagnitudeCache::centroidHz(int lo, int hi) const {
+  const double total = magSum(lo, hi);
+  if (!(total > 0.0)) return 0.0f;
+  return float((_cumKMag[size_t(hi)] - _cumKMag[size_t(lo)]) / total * _binHz);
+}
+
+float MagnitudeCache::rolloffHz(float fraction, int lo, int hi) const {
+  const double total = magSum(lo, hi);
+  if (!(total > 0.0)) return 0.0f;
+  // First k in [lo, hi) whose running sum (through k) reaches the target
+  const double target = _cumMag[size_t(lo)] + double(fraction) * total;
+  auto first = _cumMag.begin() + (lo + 1), last = _cumMag.begin() + (hi + 1);
+  auto it = std::lower_bound(first, last, target);
+  const int k = int(std::min(it, last - 1) - _cumMag.begin()) - 1;
+  return float(k) * _binHz;
+}
+
+float MagnitudeCache::flatness(int lo, int hi) const {
+  const int n = hi - lo;
+  if (n <= 0) return 0.0f;
+  const double mean = magSum(lo, hi) / n;
+  if (!(mean > 1e-9)) return 0.0f;
+  const double geo = std::exp((_cumLog[size_t(hi)] - _cumLog[size_t(lo)]) / n);
+  return float(std::clamp(geo / mean, 0.0, 1.0));
+}
+
+// --- chroma ---
+
+void ChromaMap::build(int sampleRate, int fftSize) {
+  _lo.clear(); _hi.clear(); _cls.clear();
+  const float A4 = 440.0f;
+  const int half = fftSize / 2;
+  for (int c = 0; c < 12; ++c) {
+    for (int octave = 1; octave <= 7; ++octave) {
+      const float semitone = float(c - 9);   // A = 0, so C = -9, C# = -8, etc.
+      const float freq = A4 * std::pow(2.0f, float(octave - 4) + semitone / 12.0f);
+      if (freq > sampleRate / 2) break;
+      const int k = int(freq * fftSize / sampleRate);
+      if (k < 1 || k >= half) continue;
+      _lo.push_back(k);
+      _hi.push_back(std::min(k + 2, half));  // include the next bin
+      _cls.push_back(c);
+    }
+  }
+}
+
+void ChromaMap::fold(const MagnitudeCache& m, float* chroma12) const {
+  std::fill(chroma12, chroma12 + 12, 0.0f);
+  for (size_t i = 0; i < _lo.size(); ++i)
+    chroma12[_cls[i]] += float(m.magSum(_lo[i], _hi[i]));
+}
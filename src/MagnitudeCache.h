@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+
+// One hop's one-sided spectrum in the forms the features want, derived once
+// from the L/R magnitudes and then only read:
+//   mag      (|L| + |R|) / 2 per bin
+//   power    mag^2
+//   logMag   ln(mag + eps)
+// plus prefix sums (double, so short ranges of a long spectrum keep their
+// precision) of mag, k * mag, power and logMag. Any range sum, the centroid,
+// the rolloff bin (binary search) and the flatness are then O(1) / O(log K).
+//
+// configure() allocates (within reserve() it doesn't); update() never does.
+class MagnitudeCache {
+public:
+  void reserve(int maxBins);                 // so later configure() calls up to maxBins don't allocate
+  void configure(int bins, float binHz);     // bins = N/2 + 1
+  void update(const float* magL, const float* magR);
+
+  int   bins() const { return _bins; }
+  float binHz() const { return _binHz; }
+
+  const float* mag() const { return _mag.data(); }
+  const float* power() const { return _pow.data(); }
+  const float* logMag() const { return _log.data(); }
+
+  // Sums over bins [lo, hi)
+  double magSum(int lo, int hi) const { return _cumMag[hi] - _cumMag[lo]; }
+  double powerSum(int lo, int hi) const { return _cumPow[hi] - _cumPow[lo]; }
+
+  // Magnitude-weighted mean frequency over [lo, hi); 0 if silent
+  float centroidHz(int lo, int hi) const;
+  // Lowest frequency below which `fraction` of the magnitude in [lo, hi) lies; 0 if silent
+  float rolloffHz(float fraction, int lo, int hi) const;
+  // Geometric / arithmetic mean of mag over [lo, hi): ~1 for noise, ~0 for tones
+  float flatness(int lo, int hi) const;
+
+private:
+  int _bins = 0;
+  float _binHz = 0.0f;
+  std::vector<float> _mag, _pow, _log;
+  std::vector<double> _cumMag, _cumKMag, _cumPow, _cumLog;   // bins + 1, [0] = 0
+};
+
+// Bin -> pitch class folding: for every octave of every pitch class, the bins
+// around its frequency. fold() is 12 x octaves range sums from the cache.
+class ChromaMap {
+public:
+  // Pitch classes C, C#, ... B (A4 = 440 Hz), octaves 1..7, up to Nyquist
+  void build(int sampleRate, int fftSize);
+  void fold(const MagnitudeCache& m, float* chroma12) const;
+  bool empty() const { return _lo.empty(); }
+
+private:
+  std::vector<int> _lo, _hi, _cls;            // one entry per (class, octave)
+};
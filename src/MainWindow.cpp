@@ -1,12 +1,20 @@
 #include "MainWindow.h"
+#include "Pipeline.h"
 #include "AudioCapture.h"
 #include "AudioProcessor.h"
 #include "AdvancedAudioProcessor.h"
 #include "MultiResolutionVisualizerWidget.h"
 #include "BarsWidget.h"
+#ifdef WLEDQT_HAVE_OPENGL
+#include "GlSpectrumView.h"
+#endif
 #include "UdpSrSender.h"
+#include "DdpSender.h"
 #include "SnapshotManager.h"
 #include "SnapshotViewer.h"
+#include "LatencyTracer.h"
+#include "SnapshotRecording.h"
+#include "MetricsServer.h"
 
 #include <QtNetwork/QHostAddress>
 #include <QPushButton>
@@ -14,6 +22,14 @@
 #include <QProgressBar>
 #include <QVBoxLayout>
 #include <QWidget>
+#include <QTimer>
+#include <QFile>
+#include <QFileDialog>
+#include <QComboBox>
+#include <QSpinBox>
+#include <QSignalBlocker>
+#include <QCheckBox>
+#include <cstdlib>
 
 //local helper: dB to 0..100%
 namespace {
@@ -41,7 +57,7 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
   _binsEdit  = new QLineEdit(this);
   _binsApply = new QPushButton("Apply bins", this);
 
-  _binsEdit->setPlaceholderText("16, 32, or 64");
+  _binsEdit->setPlaceholderText("16 .. 256");
   _binsEdit->setFixedWidth(100);
 
   // (Optional) pre-fill current
@@ -50,11 +66,68 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
   binsRow->addWidget(new QLabel("Bands:", this));
   binsRow->addWidget(_binsEdit);
   binsRow->addWidget(_binsApply);
+  _autoFft = new QCheckBox("Auto FFT", this);
+  _autoFft->setToolTip("Pick FFT size / hop from CPU cost and a 40 ms latency target");
+  binsRow->addWidget(_autoFft);
   binsRow->addStretch();
 
   // add to main layout (e.g., after meters)
   layout->addLayout(binsRow);
 
+  // --- WLED targets row ---
+  auto* targetsRow = new QHBoxLayout();
+  _targetsEdit  = new QLineEdit(this);
+  _targetsApply = new QPushButton("Apply targets", this);
+  _targetsEdit->setPlaceholderText("192.168.1.20, 192.168.1.21:11988, 239.0.0.1");
+  _targetsEdit->setText("192.168.50.165:11988");
+  targetsRow->addWidget(new QLabel("WLED:", this));
+  targetsRow->addWidget(_targetsEdit, 1);
+  targetsRow->addWidget(_targetsApply);
+  // How the bands become the 16 SR bins (SrBinMapper)
+  _srLayout = new QComboBox(this);
+  for (int i = 0; i < SrBinMapper::kLayouts; ++i) _srLayout->addItem(SrBinMapper::layoutName(SrBinMapper::Layout(i)));
+  _srMix = new QComboBox(this);
+  for (int i = 0; i < SrBinMapper::kMixes; ++i) _srMix->addItem(SrBinMapper::mixName(SrBinMapper::Mix(i)));
+  _srNormalize = new QComboBox(this);
+  for (int i = 0; i < SrBinMapper::kNormalizes; ++i)
+    _srNormalize->addItem(SrBinMapper::normalizeName(SrBinMapper::Normalize(i)));
+  _srNormalize->setCurrentIndex(int(SrBinMapper::Normalize::Dynamics));
+  _srLayout->setToolTip("Bands -> 16 bins: equal runs of bands, or WLED's GEQ channel ranges");
+  _srMix->setToolTip("How L and R combine per band");
+  _srNormalize->setToolTip("How the 16 bins are scaled to 0..1");
+  targetsRow->addWidget(_srLayout);
+  targetsRow->addWidget(_srMix);
+  targetsRow->addWidget(_srNormalize);
+  layout->addLayout(targetsRow);
+
+  // --- LED streaming row (pixels rendered here, DDP / DRGB) ---
+  auto* ledRow = new QHBoxLayout();
+  _ledSegmentsEdit = new QLineEdit(this);
+  _ledSegmentsEdit->setPlaceholderText("192.168.1.20/300, 192.168.1.21/300, 192.168.1.22/0-143?drgb&perc");
+  _ledEffect = new QComboBox(this);
+  for (int e = 0; e < int(LedEffectEngine::Effect::Count); ++e)
+    _ledEffect->addItem(LedEffectEngine::effectName(LedEffectEngine::Effect(e)), e);
+  _ledBrightness = new QSpinBox(this);
+  _ledBrightness->setRange(0, 100);
+  _ledBrightness->setValue(80);
+  _ledBrightness->setSuffix(" %");
+  _ledStream = new QPushButton("Stream LEDs", this);
+  _ledStream->setCheckable(true);
+  ledRow->addWidget(new QLabel("LEDs:", this));
+  ledRow->addWidget(_ledSegmentsEdit, 1);
+  ledRow->addWidget(_ledEffect);
+  ledRow->addWidget(_ledBrightness);
+  ledRow->addWidget(_ledStream);
+  layout->addLayout(ledRow);
+
+  // --- Capture source row (applied on Start) ---
+  auto* sourceRow = new QHBoxLayout();
+  _sourceEdit = new QLineEdit(this);
+  _sourceEdit->setPlaceholderText("loopback | device:monitor | file:song.wav?loop | udp:5004 | rtp:5004?rate=48000");
+  sourceRow->addWidget(new QLabel("Source:", this));
+  sourceRow->addWidget(_sourceEdit, 1);
+  layout->addLayout(sourceRow);
+
   // meters under that
   _meterL = new QProgressBar(this);
   _meterR = new QProgressBar(this);
@@ -64,45 +137,102 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
   _meterR->setFormat("R: %p%");
 
   // Widgets
-  _bars = new BarsWidget(this);
+  QWidget* barsView = nullptr;
+#ifdef WLEDQT_HAVE_OPENGL
+  if (GlSpectrumView::requested()) {
+    _glBars = new GlSpectrumView(GlSpectrumView::Mode::Bars, this);
+    barsView = _glBars;
+  }
+#endif
+  if (!barsView) {
+    _bars = new BarsWidget(this);
+    barsView = _bars;
+  }
   //_visualizer = new MultiResolutionVisualizerWidget(this);
 
   //snapshot manager + button
   _snapshotManager = new SnapshotManager(this);
   _snapshotButton = new QPushButton("View Snapshots", this);
+  _visualizerButton = new QPushButton("Advanced Analysis", this);
+  _recordButton = new QPushButton("Record...", this);
+  _recordQuant = new QComboBox(this);
+  _recordQuant->addItem("float32", int(rec::Quant::Float32));
+  _recordQuant->addItem("uint16", int(rec::Quant::UInt16));
+  _recordQuant->addItem("uint8", int(rec::Quant::UInt8));
+  _recordQuant->setCurrentIndex(1);
+  _recorder = new SnapshotRecorder;
+
+  auto* viewersRow = new QHBoxLayout();
+  viewersRow->addWidget(_snapshotButton);
+  viewersRow->addWidget(_visualizerButton);
+  viewersRow->addWidget(_recordButton);
+  viewersRow->addWidget(_recordQuant);
+  _paintFps = new QSpinBox(this);
+  _paintFps->setRange(0, 240);
+  _paintFps->setSpecialValueText("display");
+  _paintFps->setSuffix(" fps");
+  viewersRow->addWidget(new QLabel("Bars:", this));
+  viewersRow->addWidget(_paintFps);
+  viewersRow->addStretch();
 
   // add to layout top down
   layout->addWidget(_btnStart);
   layout->addWidget(_btnStop);
   layout->addWidget(_status);
+  _udpStats = new QLabel("UDP: idle", this);
+  layout->addWidget(_udpStats);
+  _ledStats = new QLabel("LEDs: off", this);
+  layout->addWidget(_ledStats);
+
+  auto* latencyRow = new QHBoxLayout();
+  _latencyLabel = new QLabel("Latency: -", this);
+  _latencyLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+  _latencyDump = new QPushButton("Dump latency CSV", this);
+  latencyRow->addWidget(_latencyLabel, 1);
+  latencyRow->addWidget(_latencyDump);
+  layout->addLayout(latencyRow);
   layout->addWidget(_meterL);
   layout->addWidget(_meterR);
-  layout->addWidget(_bars);
-  //layout->addWidget(_visualizer);
+  layout->addWidget(barsView);
+  layout->addLayout(viewersRow);
 
   setCentralWidget(central);
   setWindowTitle("WLED Audio Processor Beta");
 
-  // --- Workers (created on UI thread, then moved to their threads) ---
-  _audio = new AudioCapture;
-  _dsp   = new AudioProcessor;
-  //_adsp = new AdvancedAudioProcessor;
-  _audio->moveToThread(&_audioThread);
-  _dsp->moveToThread(&_dspThread);
-  //_adsp->moveToThread(&_adspThread);
-
-  _srSender = new UdpSrSender(this);
-  // Unicast to a specific device:
-  _srSender->setTarget(QHostAddress("192.168.50.165"), 11988);
-  // If you want multicast instead, do: setTarget(QHostAddress("239.0.0.1"), 11988);
+  // --- Workers: the pipeline creates them and moves them to their threads (senders start now) ---
+  _pipeline  = new Pipeline;
+  _audio     = _pipeline->capture();
+  _dsp       = _pipeline->processor();
+  _adsp      = _pipeline->advanced();
+  _srSender  = _pipeline->srSender();
+  _ddpSender = _pipeline->ddpSender();
+  _latency   = _pipeline->latency();
+  _sourceEdit->setText(_audio->sourceSpec());   // WLEDQT_CAPTURE, if set
+  // Analysis zones for ?zone= LED segments (no UI for them yet)
+  if (const char* env = std::getenv("WLEDQT_ZONES")) {
+    QString error;
+    if (!_pipeline->setZones(QString::fromLocal8Bit(env), &error)) _status->setText(error);
+  }
+  // Unicast and/or multicast targets come from the WLED field (default: one node)
+  onApplyTargets();
 
   wireUp();
+  setupMetrics();
+
+  _latencyTimer = new QTimer(this);
+  connect(_latencyTimer, &QTimer::timeout, this, &MainWindow::refreshLatency);
+  _latencyTimer->start(1000);
 
 
 }
 
 MainWindow::~MainWindow() {
-  teardownThreads();
+  metrics::removeProbes(this);   // before the pipeline's workers go
+  delete _pipeline;  // joins every thread; the viewers' destroyed handlers check these
+  _pipeline = nullptr;
+  _audio = nullptr; _dsp = nullptr; _adsp = nullptr;
+  _srSender = nullptr; _ddpSender = nullptr; _latency = nullptr;
+  delete _recorder;  // flushes an open recording
 }
 
 void MainWindow::wireUp() {
@@ -110,30 +240,39 @@ void MainWindow::wireUp() {
   connect(_btnStart, &QPushButton::clicked, this, &MainWindow::onStart);
   connect(_btnStop,  &QPushButton::clicked, this, &MainWindow::onStop);
   connect(_snapshotButton, &QPushButton::clicked, this, &MainWindow::openSnapshotViewer);
+  connect(_visualizerButton, &QPushButton::clicked, this, &MainWindow::openVisualizer);
   connect(_binsApply, &QPushButton::clicked, this, &MainWindow::onApplyBins);
-  // Start workers when threads start
-  connect(&_audioThread, &QThread::started, _audio, &AudioCapture::start);
-  connect(&_dspThread,   &QThread::started, _dsp,   &AudioProcessor::start);
-  //connect(&_adspThread,  &QThread::started, _adsp,  &AdvancedAudioProcessor::start);
-
-  // When workers signal 'stopped', quit their threads
-  connect(_audio, &AudioCapture::stopped, &_audioThread, &QThread::quit);
-  connect(_dsp,   &AudioProcessor::stopped, &_dspThread, &QThread::quit);
-  //connect(_adsp,  &AdvancedAudioProcessor::stopped, &_adspThread, &QThread::quit);
-
-  // Pipeline: audio -> dsp (queued across threads safely)
-  connect(_audio, &AudioCapture::deviceSampleRateChanged, _dsp,   &AudioProcessor::setSampleRate, Qt::QueuedConnection);
-  connect(_audio, &AudioCapture::framesReady, _dsp,   &AudioProcessor::onFrames, Qt::QueuedConnection);
-  //connect(_audio, &AudioCapture::framesReady, _adsp,  &AdvancedAudioProcessor::onFrames, Qt::QueuedConnection);
-
-  // UI feedback
-  connect(_audio, &AudioCapture::status,   this, &MainWindow::onAudioStatus);
-  connect(_dsp,   &AudioProcessor::levelsReady, this, &MainWindow::onLevels);
-  connect(_dsp,  &AudioProcessor::binsReadyRaw, _bars, &BarsWidget::setBinsRawStereo, Qt::QueuedConnection); //crosses threads?
-  // Send UDP whenever bins are ready (sender throttles to 50 FPS).
-  connect(_dsp, &AudioProcessor::binsReady, _srSender, &UdpSrSender::sendFromBins);
-  //connect(_adsp, &AdvancedAudioProcessor::multiResolutionAnalysisReady, _visualizer, &MultiResolutionVisualizerWidget::onMultiResolutionData, Qt::QueuedConnection);
-  connect(_bars, &BarsWidget::snapshotReady, _snapshotManager, &SnapshotManager::addSnapshot);
+  connect(_targetsApply, &QPushButton::clicked, this, &MainWindow::onApplyTargets);
+  connect(_targetsEdit, &QLineEdit::returnPressed, this, &MainWindow::onApplyTargets);
+  connect(_latencyDump, &QPushButton::clicked, this, &MainWindow::onDumpLatency);
+  connect(_autoFft, &QCheckBox::toggled, this, [this](bool on) {
+    if (on) _pipeline->setAutoTuning(true);
+    else    _pipeline->setFftSize(1024, 512);      // back to the default layout
+  });
+  connect(_recordButton, &QPushButton::clicked, this, &MainWindow::onToggleRecording);
+  if (_bars) connect(_paintFps, QOverload<int>::of(&QSpinBox::valueChanged), _bars, &BarsWidget::setMaxFps);
+#ifdef WLEDQT_HAVE_OPENGL
+  if (_glBars) connect(_paintFps, QOverload<int>::of(&QSpinBox::valueChanged), _glBars, &GlSpectrumView::setMaxFps);
+#endif
+  // UI feedback (the workers are wired to each other inside the pipeline)
+  connect(_pipeline, &Pipeline::status, this, &MainWindow::onAudioStatus);
+  // One pooled frame per hop feeds meters, bars and snapshots. The GUI only
+  // takes the newest (see postFrame); the senders take theirs on the DSP thread.
+  connect(_dsp, &AudioProcessor::frameReady, this,
+          [this](const SpectrumFramePtr& f) { postFrame(f); }, Qt::DirectConnection);
+  connect(_srSender, &UdpSrSender::statsReady, this, &MainWindow::onUdpStats);
+  connect(_ddpSender, &DdpSender::statsReady, this, &MainWindow::onLedStats);
+  connect(_ledStream, &QPushButton::toggled, this, &MainWindow::onToggleLedStream);
+  Pipeline* pipeline = _pipeline;
+  connect(_ledEffect, QOverload<int>::of(&QComboBox::currentIndexChanged), pipeline, &Pipeline::setLedEffect);
+  const auto applySrMapping = [this] {
+    _pipeline->setSrBinMapping(_srLayout->currentIndex(), _srMix->currentIndex(), _srNormalize->currentIndex());
+  };
+  for (QComboBox* box : {_srLayout, _srMix, _srNormalize})
+    connect(box, QOverload<int>::of(&QComboBox::currentIndexChanged), this, applySrMapping);
+  connect(_ledBrightness, QOverload<int>::of(&QSpinBox::valueChanged), pipeline,
+          [pipeline](int pct) { pipeline->setLedBrightness(pct / 100.0); });
+  connect(_dsp, &AudioProcessor::analysisChanged, this, &MainWindow::onAnalysisChanged, Qt::QueuedConnection);
 
 }
 
@@ -146,9 +285,18 @@ void MainWindow::openSnapshotViewer()
         _snapshotViewer->setWindowFlags(Qt::Window);
         _snapshotViewer->setAttribute(Qt::WA_DeleteOnClose);
         
+        // Replay drives the sender through its own mailbox (GUI thread is its only producer)
+        UdpSrSender* sender = _srSender;
+        connect(_snapshotViewer, &SnapshotViewer::replayBins,
+                sender, &UdpSrSender::submitReplayBins, Qt::DirectConnection);
+        connect(_snapshotViewer, &SnapshotViewer::replayActiveChanged, this, [sender](bool active) {
+            sender->setSource(active ? UdpSrSender::Source::Replay : UdpSrSender::Source::Live);
+        });
+        
         // Reset pointer when window closes
         connect(_snapshotViewer, &QObject::destroyed, [this]() {
             _snapshotViewer = nullptr;
+            if (_srSender) _srSender->setSource(UdpSrSender::Source::Live);
         });
     }
     
@@ -157,58 +305,212 @@ void MainWindow::openSnapshotViewer()
     _snapshotViewer->activateWindow();
 }
 
+void MainWindow::openVisualizer()
+{
+    if (!_visualizer) {
+        _visualizer = new MultiResolutionVisualizerWidget(this);
+        _visualizer->setWindowFlags(Qt::Window);
+        _visualizer->setAttribute(Qt::WA_DeleteOnClose);
+        _visualizer->setWindowTitle("Multi-Resolution Analysis");
+
+        connect(_adsp, &AdvancedAudioProcessor::multiResolutionAnalysisReady,
+                _visualizer, &MultiResolutionVisualizerWidget::onMultiResolutionData, Qt::QueuedConnection);
+        connect(_visualizer, &QObject::destroyed, [this]() {
+            _visualizer = nullptr;
+        });
+    }
+
+    _visualizer->show();
+    _visualizer->raise();
+    _visualizer->activateWindow();
+}
+
 void MainWindow::onApplyBins() {
   bool ok = false;
   const int n = _binsEdit->text().trimmed().toInt(&ok);
-  if (!ok || (n != 16 && n != 32 && n != 64)) {
-    _status->setText("Bands must be 16, 32, or 64");
+  if (!ok || !AudioProcessor::isSupportedBandCount(n)) {
+    _status->setText("Bands must be 16, 32, 64, 128, or 256");
     return;
   }
 
-  // Make sure setNumBands is a slot (or Q_INVOKABLE)
-  QMetaObject::invokeMethod(_dsp, "setNumBands",
-                            Qt::QueuedConnection,
-                            Q_ARG(int, n));
+  // Thread-safe: the filterbank is built here and the DSP threads swap it in
+  // between hops, so the bars don't blink (zone processors follow)
+  _pipeline->setNumBands(n);
 
   _status->setText(QString("Bands set to %1").arg(n));
 }
 
-void MainWindow::teardownThreads() {
-  if (_running) {
-    _audio->requestStop();
-    _dsp->requestStop();
-    //_adsp->requestStop();
+void MainWindow::onApplyTargets() {
+  QString error;
+  int count = 0;
+  if (!_pipeline->setTargets(_targetsEdit->text(), &error, &count)) {
+    _status->setText(error);
+    return;
+  }
+  _status->setText(QString("Sending to %1 target(s)").arg(count));
+}
+
+void MainWindow::onUdpStats(const QVector<SrTargetStats>& stats) {
+  uint64_t sent = 0, dropped = 0, suppressed = 0;
+  float avgUs = 0.0f, maxUs = 0.0f;
+  QString worst;
+  for (const SrTargetStats& s : stats) {
+    sent += s.sent;
+    dropped += s.dropped;
+    suppressed += s.suppressed;
+    avgUs += s.avgSendUs;
+    if (s.maxSendUs >= maxUs) {
+      maxUs = s.maxSendUs;
+      worst = s.address.toString();
+    }
+  }
+  if (!stats.isEmpty()) avgUs /= float(stats.size());
+  _udpStats->setText(QString("UDP: %1 targets | sent %2 | dropped %3 | suppressed %4 | avg %5 us | max %6 us (%7)")
+                       .arg(stats.size()).arg(sent).arg(dropped).arg(suppressed)
+                       .arg(avgUs, 0, 'f', 1).arg(maxUs, 0, 'f', 1).arg(worst));
+}
+
+void MainWindow::onToggleLedStream(bool on) {
+  if (!on) {
+    _pipeline->stopLedStreaming();
+    _ledStats->setText("LEDs: off");
+    return;
+  }
+  QString error;
+  int count = 0;
+  if (!_pipeline->startLedStreaming(_ledSegmentsEdit->text(), &error, &count)) {
+    _status->setText(error);
+    QSignalBlocker block(_ledStream);
+    _ledStream->setChecked(false);
+    return;
+  }
+  _ledStats->setText(QString("LEDs: streaming to %1 segment(s)").arg(count));
+}
+
+void MainWindow::onLedStats(const QVector<LedSegmentStats>& stats) {
+  if (!_ledStream->isChecked()) return;
+  uint64_t frames = 0, superseded = 0, errors = 0, suppressed = 0;
+  int leds = 0;
+  for (const LedSegmentStats& s : stats) {
+    frames += s.frames;
+    suppressed += s.suppressed;
+    superseded += s.superseded;
+    errors += s.errors;
+    leds += s.count;
   }
-  _audioThread.quit(); _audioThread.wait();
-  _dspThread.quit();   _dspThread.wait();
-  //_adspThread.quit();  _adspThread.wait();
+  _ledStats->setText(QString("LEDs: %1 segments, %2 px | frames %3 | suppressed %4 | superseded %5 | errors %6")
+                       .arg(stats.size()).arg(leds).arg(frames).arg(suppressed).arg(superseded).arg(errors));
+}
+
+void MainWindow::refreshLatency() {
+  // p50/p95/p99 in ms per stage; stages with no samples yet are skipped
+  QStringList parts;
+  for (int s = 0; s < LatencyTracer::StageCount; ++s) {
+    const auto stage = LatencyTracer::Stage(s);
+    const LatencyTracer::Summary m = _latency->summary(stage);
+    if (m.count == 0) continue;
+    parts << QString("%1 %2/%3/%4")
+               .arg(LatencyTracer::stageName(stage))
+               .arg(m.p50Us * 1e-3, 0, 'f', 2).arg(m.p95Us * 1e-3, 0, 'f', 2).arg(m.p99Us * 1e-3, 0, 'f', 2);
+  }
+  _latencyLabel->setText(parts.isEmpty() ? QString("Latency: -")
+                                         : "Latency ms p50/p95/p99: " + parts.join(" | "));
+}
+
+void MainWindow::onDumpLatency() {
+  const QString path = QFileDialog::getSaveFileName(this, "Save latency histograms",
+                                                    "latency.csv", "CSV (*.csv)");
+  if (path.isEmpty()) return;
+  QFile f(path);
+  if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+    _status->setText("Could not write " + path);
+    return;
+  }
+  const std::string csv = _latency->toCsv();
+  f.write(csv.data(), qint64(csv.size()));
+  _status->setText("Latency written to " + path);
+}
 
-  // Delete workers on UI thread
-  if (_audio) { _audio->deleteLater(); _audio = nullptr; }
-  if (_dsp)   { _dsp->deleteLater();   _dsp   = nullptr; }
-  //if (_adsp)  { _adsp->deleteLater();  _adsp  = nullptr; }
+void MainWindow::onAnalysisChanged(int sampleRate, int fftSize, int hop, const QVector<float>& bandEdgesHz) {
+  _anaSampleRate = sampleRate;
+  _anaFftSize = fftSize;
+  _anaHop = hop;
+  _anaEdges = bandEdgesHz;
+  if (hop > 0) _snapshotManager->setExpectedFrameRate(double(sampleRate) / hop);
+  _snapshotManager->setBandEdges(bandEdgesHz);
+
+  // A recording has one layout; a change (new device rate, band count) ends it
+  if (_recorder->isOpen()) {
+    const QString name = _recorder->fileName();
+    _recorder->close();
+    _recordButton->setText("Record...");
+    _status->setText("Analysis changed, recording stopped: " + name);
+  }
+}
+
+void MainWindow::onToggleRecording() {
+  if (_recorder->isOpen()) {
+    _recorder->close();
+    _recordButton->setText("Record...");
+    _status->setText(QString("Recorded %1 frames (%2 MB) to %3")
+                       .arg(_recorder->framesWritten())
+                       .arg(_recorder->bytesWritten() / 1048576.0, 0, 'f', 1)
+                       .arg(_recorder->fileName()));
+    return;
+  }
+
+  const QString path = QFileDialog::getSaveFileName(this, "Record frames to",
+                                                    "show.wqsr", "Recordings (*.wqsr)");
+  if (path.isEmpty()) return;
+
+  RecordingLayout layout;
+  layout.sampleRate = _anaSampleRate;
+  layout.fftSize = _anaFftSize;
+  layout.hop = _anaHop;
+  layout.bandEdgesHz.assign(_anaEdges.begin(), _anaEdges.end());
+  const auto quant = rec::Quant(_recordQuant->currentData().toInt());
+
+  QString error;
+  if (!_recorder->open(path, layout, quant, &error)) {
+    _status->setText("Recording failed: " + error);
+    return;
+  }
+  _recordButton->setText("Stop Recording");
+  _status->setText("Recording to " + path);
+}
+
+// Counters/gauges for unattended installs; served over HTTP only with WLEDQT_METRICS
+void MainWindow::setupMetrics() {
+  _guiCpu.bind("gui");
+  _guiCpu.mark();
+  _framesShown.bind("wledqt_gui_frames_total", {}, "Frames the GUI took from the handoff");
+  const std::atomic<bool>* posted = &_framePosted;
+  metrics::addProbe(this, "wledqt_gui_queue_frames", {}, "Frames waiting for the GUI (bars), 0 or 1",
+                    metrics::Kind::Gauge, [posted] { return posted->load(std::memory_order_relaxed) ? 1.0 : 0.0; });
+
+  QHostAddress address;
+  quint16 port = 0;
+  if (MetricsServer::fromEnvironment(address, port)) _pipeline->startMetrics(address, port);
 }
 
 // --- Slots ---
 
 void MainWindow::onStart() {
-  if (_running) return;
-  _running = true;
+  if (_pipeline->isRunning()) return;
+
+  QString error;
+  if (!_pipeline->setSource(_sourceEdit->text(), &error)) {
+    _status->setText(error);
+    return;
+  }
   _status->setText("Starting…");
-  _audioThread.start();
-  _dspThread.start();
-  //_adspThread.start();
+  _pipeline->start();
 }
 
 void MainWindow::onStop() {
-  if (!_running) return;
-  _running = false;
+  if (!_pipeline->isRunning()) return;
   _status->setText("Stopping…");
-  _audioThread.quit();
-  _dspThread.quit();
-  _audio->requestStop();
-  _dsp->requestStop();
-  //_adsp->requestStop();
+  _pipeline->stop();
 }
 
 void MainWindow::onAudioStatus(const QString& msg) {
@@ -219,3 +521,39 @@ void MainWindow::onLevels(float lDb, float rDb) {
   _meterL->setValue(dbToPct(lDb));
   _meterR->setValue(dbToPct(rDb));
 }
+
+// DSP thread: replace the pending frame (a skipped one goes straight back to
+// the pool) and queue one takeFrame() unless one is already on its way
+void MainWindow::postFrame(const SpectrumFramePtr& frame) {
+  SpectrumFramePtr previous;
+  {
+    std::lock_guard<std::mutex> lock(_frameMutex);
+    previous = std::move(_pendingFrame);
+    _pendingFrame = frame;
+  }
+  if (!_framePosted.exchange(true, std::memory_order_acq_rel))
+    QMetaObject::invokeMethod(this, &MainWindow::takeFrame, Qt::QueuedConnection);
+}
+
+void MainWindow::takeFrame() {
+  // Clear first: a frame posted from here on queues the next takeFrame()
+  _framePosted.store(false, std::memory_order_release);
+  SpectrumFramePtr frame;
+  {
+    std::lock_guard<std::mutex> lock(_frameMutex);
+    frame = std::move(_pendingFrame);
+  }
+  onFrame(frame);
+}
+
+void MainWindow::onFrame(const SpectrumFramePtr& frame) {
+  _framesShown.add();
+  if (!frame) return;
+  onLevels(frame->dbL, frame->dbR);
+  if (_bars) _bars->setFrame(frame);
+#ifdef WLEDQT_HAVE_OPENGL
+  if (_glBars) _glBars->setFrame(frame);
+#endif
+  _snapshotManager->addFrame(frame);
+  if (_recorder->isOpen()) _recorder->addFrame(frame);
+}
@@ -1,9 +1,12 @@
 #pragma once
 #include <QMainWindow>
-#include <QThread>
 #include <QString>
 #include <QVector>
 #include <QLineEdit>
+#include <atomic>
+#include <mutex>
+#include "Metrics.h"
+#include "SpectrumFrame.h"
 
 
 // ── Forward declarations (no heavy headers here) ──
@@ -15,6 +18,7 @@ class QPushButton;
 
 // ADD: forward declare your custom widget (only include its header in MainWindow.cpp)
 class BarsWidget;
+class GlSpectrumView;
 
 // Workers
 class AudioCapture;
@@ -24,12 +28,24 @@ class AudioProcessor;
 class Snapshot;
 class SnapshotManager;
 class SnapshotViewer;
+class SnapshotRecorder;
+class QComboBox;
+class QSpinBox;
+class QCheckBox;
 
 class UdpSrSender;
+class LatencyTracer;
+class QTimer;
+struct SrTargetStats;
+class DdpSender;
+struct LedSegmentStats;
+class Pipeline;
+Q_MOC_INCLUDE("UdpSrSender.h")
+Q_MOC_INCLUDE("DdpSender.h")
 
 // forward declare the advanced processor and visualizer
-//class MultiResolutionVisualizerWidget;
-//class AdvancedAudioProcessor;
+class MultiResolutionVisualizerWidget;
+class AdvancedAudioProcessor;
 
 
 
@@ -47,6 +63,27 @@ private:
   // new for variable bins
   QLineEdit*  _binsEdit{};
   QPushButton*_binsApply{};
+  QCheckBox*  _autoFft{};      // AudioProcessor::setAutoTuning
+  // WLED targets ("ip[:port], ...") + per-target send stats
+  QLineEdit*  _targetsEdit{};
+  QPushButton*_targetsApply{};
+  QComboBox*  _srLayout{};     // SrBinMapper Layout / Mix / Normalize
+  QComboBox*  _srMix{};
+  QComboBox*  _srNormalize{};
+  QLabel*     _udpStats{};
+  // Direct pixel streaming: "ip[:port]/leds, ..." + effect + on/off
+  QLineEdit*  _ledSegmentsEdit{};
+  QComboBox*  _ledEffect{};
+  QSpinBox*   _ledBrightness{};
+  QPushButton*_ledStream{};
+  QLabel*     _ledStats{};
+  // Capture source spec (see CaptureSource.h); empty = loopback
+  QLineEdit*  _sourceEdit{};
+  // Latency tracing (capture -> datagram), refreshed once a second
+  LatencyTracer* _latency{};
+  QLabel*     _latencyLabel{};
+  QPushButton*_latencyDump{};
+  QTimer*     _latencyTimer{};
 
   // Level meters (0..100%)
   QProgressBar* _meterL{};     // Left RMS meter
@@ -54,29 +91,50 @@ private:
 
   // ADD: the widgets
   BarsWidget*   _bars{};
-  //MultiResolutionVisualizerWidget* _visualizer{};
+  GlSpectrumView* _glBars{};       // instead of _bars with WLEDQT_RENDER=gl (OpenGL builds)
+  QSpinBox*     _paintFps{};       // bars repaint cap (0 = display refresh)
+  MultiResolutionVisualizerWidget* _visualizer = nullptr;   // separate window, created on demand
+  QPushButton* _visualizerButton = nullptr;
 
   // Snapshot manager + viewer
   SnapshotManager* _snapshotManager = nullptr;
   SnapshotViewer* _snapshotViewer = nullptr;
   QPushButton* _snapshotButton = nullptr;
 
-  // ── Threads & workers ──
-  QThread        _audioThread;
-  QThread        _dspThread;
-  //QThread        _adspThread;
+  // Show recording (append-only file of every frame)
+  SnapshotRecorder* _recorder = nullptr;
+  QPushButton* _recordButton = nullptr;
+  QComboBox* _recordQuant = nullptr;
+  // Analysis layout as last reported by the processor (header of new recordings)
+  int _anaSampleRate = 0, _anaFftSize = 0, _anaHop = 0;
+  QVector<float> _anaEdges;
+
+  // ── Threads & workers: all in the Pipeline (shared with wledqt-daemon); the
+  // pointers below are its workers, for the GUI's own connections ──
+  Pipeline*      _pipeline{};
   AudioCapture*  _audio{};
   AudioProcessor*_dsp{};
-  //AdvancedAudioProcessor* _adsp{};
-  
-  bool _running{false};
-
+  AdvancedAudioProcessor* _adsp{};
   UdpSrSender* _srSender{nullptr};
+  DdpSender*   _ddpSender{nullptr};
+
+  // Latest-only handoff from the DSP thread: one pending frame and at most one
+  // queued takeFrame(), so a stalled GUI never keeps more of the pool
+  std::mutex        _frameMutex;
+  SpectrumFramePtr  _pendingFrame;
+  std::atomic<bool> _framePosted{false};
+  void postFrame(const SpectrumFramePtr& frame);  // DSP thread
+  void takeFrame();                               // GUI thread
+
+  // GUI side of the metrics: frames taken from the handoff (vs. AudioProcessor::framesEmitted)
+  metrics::Counter   _framesShown;
+  metrics::ThreadCpu _guiCpu;
+  void setupMetrics();
 
   // ── Internal helpers ──
-  void wireUp();          // connect signals/slots across threads
-  void teardownThreads(); // graceful shutdown
+  void wireUp();          // connect the UI to the pipeline's workers
   void openSnapshotViewer(); // show the snapshot viewer window
+  void openVisualizer();     // show the multi-resolution analysis window
 
 private slots:
   // ── Slots (keep these signatures; they're connected in MainWindow.cpp) ──
@@ -84,5 +142,14 @@ private slots:
   void onStop();
   void onAudioStatus(const QString& msg);
   void onLevels(float lDb, float rDb);          // updates meters
+  void onFrame(const SpectrumFramePtr& frame);  // meters + bars + snapshots from one frame
   void onApplyBins();                          // apply new # of bins from UI
+  void onApplyTargets();                       // parse + apply the WLED target list
+  void onUdpStats(const QVector<SrTargetStats>& stats);
+  void onToggleLedStream(bool on);             // parse segments + start/stop pixel streaming
+  void onLedStats(const QVector<LedSegmentStats>& stats);
+  void refreshLatency();                       // p50/p95/p99 per stage into the status area
+  void onDumpLatency();                        // save the latency histograms as CSV
+  void onAnalysisChanged(int sampleRate, int fftSize, int hop, const QVector<float>& bandEdgesHz);
+  void onToggleRecording();                    // start/stop writing frames to a recording file
 };
@@ -0,0 +1,279 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(_WIN32)
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  include <windows.h>
+#elif defined(__linux__)
+#  include <pthread.h>
+#  include <time.h>
+#endif
+
+namespace metrics {
+
+namespace {
+
+enum class Source { Value, Probe, Cpu };
+
+struct Series {
+  std::string name, labels, help;
+  Kind kind = Kind::Counter;
+  Source source = Source::Value;
+  std::unique_ptr<Slot> slot;         // Value / Cpu (thread id + 1, 0 = none)
+  std::function<double()> read;       // Probe
+  const void* owner = nullptr;
+  double prev = 0.0, rate = 0.0;      // sample(): last value and per-second rate
+  int64_t prevNs = 0;
+#if defined(_WIN32)
+  uint64_t openedId = 0;
+  HANDLE handle = nullptr;
+#endif
+};
+
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Series>> series;
+};
+
+Registry& registry() {
+  static Registry r;
+  return r;
+}
+
+Slot* addSeries(const char* name, const std::string& labels, const char* help, Kind kind, Source source) {
+  auto s = std::make_unique<Series>();
+  s->name = name;
+  s->labels = labels;
+  s->help = help ? help : "";
+  s->kind = kind;
+  s->source = source;
+  s->slot = std::make_unique<Slot>();
+  Slot* slot = s->slot.get();
+  Registry& r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  r.series.push_back(std::move(s));
+  return slot;
+}
+
+void closeThread(Series& s) {
+#if defined(_WIN32)
+  if (s.handle) CloseHandle(s.handle);
+  s.handle = nullptr;
+  s.openedId = 0;
+#else
+  (void)s;
+#endif
+}
+
+void removeSeries(Slot* slot) {
+  if (!slot) return;
+  Registry& r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  auto it = std::find_if(r.series.begin(), r.series.end(),
+                         [slot](const std::unique_ptr<Series>& s) { return s->slot.get() == slot; });
+  if (it == r.series.end()) return;
+  closeThread(**it);
+  r.series.erase(it);
+}
+
+// CPU seconds of the thread that last marked the series (0 if none / gone)
+double cpuSeconds(Series& s) {
+  const uint64_t id = s.slot->bits.load(std::memory_order_relaxed);
+  if (id == 0) return s.prev;        // cleared: hold the last reading
+#if defined(_WIN32)
+  if (id != s.openedId) {
+    closeThread(s);
+    s.handle = OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, DWORD(id - 1));
+    s.openedId = id;
+  }
+  FILETIME created, exited, kernel, user;
+  if (!s.handle || !GetThreadTimes(s.handle, &created, &exited, &kernel, &user)) return s.prev;
+  auto ticks = [](const FILETIME& f) { return (uint64_t(f.dwHighDateTime) << 32) | f.dwLowDateTime; };
+  return double(ticks(kernel) + ticks(user)) * 1e-7;   // 100 ns units
+#elif defined(__linux__)
+  timespec ts;
+  if (clock_gettime(clockid_t(id - 1), &ts) != 0) return s.prev;
+  return double(ts.tv_sec) + double(ts.tv_nsec) * 1e-9;
+#else
+  return 0.0;
+#endif
+}
+
+double current(Series& s) {
+  switch (s.source) {
+    case Source::Probe: return s.read ? s.read() : 0.0;
+    case Source::Cpu:   return cpuSeconds(s);
+    case Source::Value: break;
+  }
+  const uint64_t bits = s.slot->bits.load(std::memory_order_relaxed);
+  return s.kind == Kind::Counter ? double(bits) : std::bit_cast<double>(bits);
+}
+
+std::string formatValue(double v) {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%.10g", v);
+  return buf;
+}
+
+std::string seriesName(const Series& s) {
+  return s.labels.empty() ? s.name : s.name + "{" + s.labels + "}";
+}
+
+// Series grouped by name (the exposition format wants each family contiguous)
+std::vector<Series*> sorted(Registry& r) {
+  std::vector<Series*> out;
+  out.reserve(r.series.size());
+  for (auto& s : r.series) out.push_back(s.get());
+  std::stable_sort(out.begin(), out.end(), [](const Series* a, const Series* b) { return a->name < b->name; });
+  return out;
+}
+
+} // namespace
+
+std::string labels(std::initializer_list<std::pair<const char*, std::string>> kv) {
+  std::string out;
+  for (const auto& [key, value] : kv) {
+    if (!out.empty()) out += ',';
+    out += key;
+    out += "=\"";
+    for (char c : value) {
+      if (c == '\\' || c == '"') { out += '\\'; out += c; }
+      else if (c == '\n') out += "\\n";
+      else out += c;
+    }
+    out += '"';
+  }
+  return out;
+}
+
+// --- handles ---
+
+void Counter::bind(const char* name, const std::string& labels, const char* help) {
+  release();
+  _s = addSeries(name, labels, help, Kind::Counter, Source::Value);
+}
+
+void Counter::release() {
+  removeSeries(_s);
+  _s = nullptr;
+}
+
+void Gauge::bind(const char* name, const std::string& labels, const char* help) {
+  release();
+  _s = addSeries(name, labels, help, Kind::Gauge, Source::Value);
+}
+
+void Gauge::release() {
+  removeSeries(_s);
+  _s = nullptr;
+}
+
+void ThreadCpu::bind(const char* thread) {
+  release();
+  _s = addSeries("wledqt_thread_cpu_seconds_total", labels({{"thread", thread}}),
+           "CPU time used by the thread", Kind::Counter, Source::Cpu);
+}
+
+void ThreadCpu::release() {
+  removeSeries(_s);
+  _s = nullptr;
+}
+
+void ThreadCpu::mark() {
+  if (!_s) return;
+#if defined(_WIN32)
+  const uint64_t id = uint64_t(GetCurrentThreadId()) + 1;
+#elif defined(__linux__)
+  clockid_t cid;
+  if (pthread_getcpuclockid(pthread_self(), &cid) != 0) return;
+  const uint64_t id = uint64_t(uint32_t(cid)) + 1;
+#else
+  const uint64_t id = 0;
+#endif
+  if (_s->bits.load(std::memory_order_relaxed) != id) _s->bits.store(id, std::memory_order_relaxed);
+}
+
+void ThreadCpu::clear() {
+  if (_s) _s->bits.store(0, std::memory_order_relaxed);
+}
+
+// --- probes ---
+
+void addProbe(const void* owner, const char* name, const std::string& labels, const char* help,
+              Kind kind, std::function<double()> read) {
+  auto s = std::make_unique<Series>();
+  s->name = name;
+  s->labels = labels;
+  s->help = help ? help : "";
+  s->kind = kind;
+  s->source = Source::Probe;
+  s->read = std::move(read);
+  s->owner = owner;
+  Registry& r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  r.series.push_back(std::move(s));
+}
+
+void removeProbes(const void* owner) {
+  Registry& r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  r.series.erase(std::remove_if(r.series.begin(), r.series.end(),
+                                [owner](const std::unique_ptr<Series>& s) {
+                                  return s->source == Source::Probe && s->owner == owner;
+                                }),
+                 r.series.end());
+}
+
+// --- metrics thread ---
+
+void sample(int64_t nowNs) {
+  Registry& r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  for (auto& s : r.series) {
+    const double v = current(*s);
+    if (s->kind == Kind::Counter && s->prevNs != 0 && nowNs > s->prevNs)
+      s->rate = std::max(0.0, (v - s->prev) / (double(nowNs - s->prevNs) * 1e-9));
+    s->prev = v;
+    s->prevNs = nowNs;
+  }
+}
+
+std::string prometheus() {
+  Registry& r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  std::string out;
+  out.reserve(64 * r.series.size());
+  const std::string* family = nullptr;
+  for (Series* s : sorted(r)) {
+    if (!family || *family != s->name) {
+      family = &s->name;
+      if (!s->help.empty()) out += "# HELP " + s->name + " " + s->help + "\n";
+      out += "# TYPE " + s->name + (s->kind == Kind::Counter ? " counter\n" : " gauge\n");
+    }
+    out += seriesName(*s) + " " + formatValue(current(*s)) + "\n";
+  }
+  return out;
+}
+
+std::string summary() {
+  Registry& r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  std::string out;
+  for (Series* s : sorted(r)) {
+    out += seriesName(*s) + " " + formatValue(current(*s));
+    if (s->kind == Kind::Counter && s->prevNs != 0) out += "  (" + formatValue(s->rate) + "/s)";
+    out += "\n";
+  }
+  return out;
+}
+
+} // namespace metrics
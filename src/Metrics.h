@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <utility>
+
+// Process-wide counters and gauges, so an unattended install can be watched
+// without the GUI (MetricsServer serves them over HTTP).
+//
+// Every value sits in its own cache line and has exactly one writer thread:
+// add() / set() are a relaxed load + store on that slot. No lock, no CAS, no
+// allocation, so the capture callback and the DSP threads update them freely.
+// Registering (bind / release, at setup or reconfiguration) and reading
+// (sample / render, on the metrics thread) share a mutex the writers never
+// touch.
+//
+//   Counter    only goes up (callbacks, hops, datagrams); rendered as <name>
+//              with TYPE counter, so names end in _total
+//   Gauge      last value set (hop time)
+//   probe      a function the metrics thread calls to read something its owner
+//              already keeps in an atomic (ring overruns, frames in flight).
+//              Probes must only load atomics: they run under the registry lock
+//   ThreadCpu  the thread publishes its id (lock-free); the metrics thread
+//              samples that thread's CPU time
+//
+// sample() (about once a second) also keeps a per-second rate for every
+// counter, shown by summary(); Prometheus computes its own from the totals.
+namespace metrics {
+
+enum class Kind { Counter, Gauge };
+
+// One value, one writer; own cache line so writers on different threads never share one
+struct alignas(64) Slot {
+  std::atomic<uint64_t> bits{0};
+};
+
+// `thread="dsp",target="10.0.0.5:21324"` (values escaped)
+std::string labels(std::initializer_list<std::pair<const char*, std::string>> kv);
+
+class Counter {
+public:
+  Counter() = default;
+  ~Counter() { release(); }
+  Counter(const Counter&) = delete;
+  Counter& operator=(const Counter&) = delete;
+
+  void bind(const char* name, const std::string& labels, const char* help);
+  void release();
+  bool bound() const { return _s != nullptr; }
+
+  // Writer thread only (load + store: one writer, so no read-modify-write needed)
+  void add(uint64_t n = 1) {
+    if (_s) _s->bits.store(_s->bits.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+  uint64_t value() const { return _s ? _s->bits.load(std::memory_order_relaxed) : 0; }
+
+private:
+  Slot* _s = nullptr;
+};
+
+class Gauge {
+public:
+  Gauge() = default;
+  ~Gauge() { release(); }
+  Gauge(const Gauge&) = delete;
+  Gauge& operator=(const Gauge&) = delete;
+
+  void bind(const char* name, const std::string& labels, const char* help);
+  void release();
+
+  void set(double v) { if (_s) _s->bits.store(std::bit_cast<uint64_t>(v), std::memory_order_relaxed); }
+  double value() const { return _s ? std::bit_cast<double>(_s->bits.load(std::memory_order_relaxed)) : 0.0; }
+
+private:
+  Slot* _s = nullptr;
+};
+
+// CPU time of one thread: wledqt_thread_cpu_seconds_total{thread="..."}.
+// mark() from the thread itself (an id lookup and a relaxed store: fine in the
+// audio callback, so a callback thread can simply mark every time), clear()
+// before it ends.
+class ThreadCpu {
+public:
+  ThreadCpu() = default;
+  ~ThreadCpu() { release(); }
+  ThreadCpu(const ThreadCpu&) = delete;
+  ThreadCpu& operator=(const ThreadCpu&) = delete;
+
+  void bind(const char* thread);
+  void release();
+
+  void mark();
+  void clear();
+
+private:
+  Slot* _s = nullptr;
+};
+
+// Probes, removed together by owner (before the owner's atomics go away).
+void addProbe(const void* owner, const char* name, const std::string& labels, const char* help,
+              Kind kind, std::function<double()> read);
+void removeProbes(const void* owner);
+
+// --- metrics thread ---
+void sample(int64_t nowNs);          // thread CPU + per-second rates
+std::string prometheus();            // text exposition format 0.0.4
+std::string summary();               // "name{labels} value [rate/s]" per line
+
+} // namespace metrics
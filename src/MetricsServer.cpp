@@ -0,0 +1,102 @@
+#include "MetricsServer.h"
+#include "LatencyTracer.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <cstdlib>
+
+MetricsServer::MetricsServer(QObject* parent) : QObject(parent) {
+}
+
+bool MetricsServer::parseListen(const QString& spec, QHostAddress& address, quint16& port) {
+  const QString s = spec.trimmed();
+  if (s.isEmpty()) return false;
+  const int colon = s.lastIndexOf(':');
+  bool ok = false;
+  const int p = (colon >= 0 ? s.mid(colon + 1) : s).toInt(&ok);
+  if (!ok || p <= 0 || p > 65535) return false;
+  port = quint16(p);
+  if (colon < 0) { address = QHostAddress(QHostAddress::LocalHost); return true; }
+  const QString host = s.left(colon);
+  if (host.isEmpty()) { address = QHostAddress(QHostAddress::Any); return true; }
+  return address.setAddress(host);
+}
+
+bool MetricsServer::fromEnvironment(QHostAddress& address, quint16& port) {
+  const char* env = std::getenv("WLEDQT_METRICS");
+  return env && parseListen(QString::fromLocal8Bit(env), address, port);
+}
+
+void MetricsServer::start() {
+  _cpu.bind("metrics");
+  _cpu.mark();
+  if (!_sampler) {
+    _sampler = new QTimer(this);
+    connect(_sampler, &QTimer::timeout, this, [] { metrics::sample(monotonicNs()); });
+  }
+  metrics::sample(monotonicNs());
+  _sampler->start(kSampleMs);
+
+  if (!_server) {
+    _server = new QTcpServer(this);
+    connect(_server, &QTcpServer::newConnection, this, &MetricsServer::onConnection);
+  }
+  if (!_server->isListening() && !_server->listen(_address, _port)) {
+    emit status(QString("Metrics: cannot listen on %1:%2 (%3)")
+                  .arg(_address.toString()).arg(_port).arg(_server->errorString()));
+    return;
+  }
+  emit status(QString("Metrics on http://%1:%2/metrics").arg(_address.toString()).arg(_server->serverPort()));
+}
+
+void MetricsServer::stop() {
+  if (_sampler) _sampler->stop();
+  if (_server) _server->close();
+  _cpu.clear();
+  _cpu.release();
+  emit stopped();
+}
+
+void MetricsServer::onConnection() {
+  while (_server->hasPendingConnections()) {
+    QTcpSocket* sock = _server->nextPendingConnection();
+    connect(sock, &QTcpSocket::disconnected, sock, &QObject::deleteLater);
+    connect(sock, &QTcpSocket::readyRead, this, [this, sock] { onReadyRead(sock); });
+    // A client that never finishes its request line doesn't get to keep the socket
+    QTimer::singleShot(kRequestTimeoutMs, sock, [sock] { sock->abort(); });
+  }
+}
+
+void MetricsServer::onReadyRead(QTcpSocket* sock) {
+  if (!sock->canReadLine()) {
+    if (sock->bytesAvailable() > kMaxRequestBytes) reply(sock, 400, "Bad Request", "text/plain", "request too long\n");
+    return;
+  }
+  // "GET /metrics HTTP/1.1"; headers are ignored, the connection closes after the reply
+  const QList<QByteArray> parts = sock->readLine().trimmed().split(' ');
+  if (parts.size() < 2 || parts[0] != "GET") {
+    reply(sock, 400, "Bad Request", "text/plain", "only GET\n");
+    return;
+  }
+  QByteArray path = parts[1];
+  const int q = path.indexOf('?');
+  if (q >= 0) path.truncate(q);
+
+  if (path == "/metrics")
+    reply(sock, 200, "OK", "text/plain; version=0.0.4", QByteArray::fromStdString(metrics::prometheus()));
+  else if (path == "/")
+    reply(sock, 200, "OK", "text/plain", QByteArray::fromStdString(metrics::summary()));
+  else
+    reply(sock, 404, "Not Found", "text/plain", "try /metrics\n");
+}
+
+void MetricsServer::reply(QTcpSocket* sock, int code, const char* reason, const char* contentType, const QByteArray& body) {
+  QByteArray head = "HTTP/1.1 " + QByteArray::number(code) + " " + reason + "\r\n";
+  head += "Content-Type: " + QByteArray(contentType) + "\r\n";
+  head += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+  head += "Connection: close\r\n\r\n";
+  sock->disconnect(this);       // one request per connection: ignore the rest of it
+  sock->write(head);
+  sock->write(body);
+  sock->disconnectFromHost();   // after the buffered bytes are written
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <QObject>
+#include <QHostAddress>
+#include <QString>
+#include "Metrics.h"
+
+class QTcpServer;
+class QTcpSocket;
+class QTimer;
+
+// Tiny HTTP endpoint for the metrics registry (Metrics.h), for installs
+// nobody is looking at:
+//   GET /metrics   Prometheus text format
+//   GET /          the same series, one per line, with per-second rates
+//
+// Lives on its own thread: sampling (once a second) and rendering only take
+// the registry lock, which the audio/DSP writers never touch, so a slow
+// scraper can't hold any of them up. One short request per connection, then
+// close; anything else gets 404 / 400.
+//
+// Off unless WLEDQT_METRICS is set: "9464" (localhost), ":9464" or
+// "0.0.0.0:9464" (every interface), "192.168.1.5:9464".
+class MetricsServer : public QObject {
+  Q_OBJECT
+public:
+  explicit MetricsServer(QObject* parent=nullptr);
+
+  static bool parseListen(const QString& spec, QHostAddress& address, quint16& port);
+  // From WLEDQT_METRICS; false if unset or malformed
+  static bool fromEnvironment(QHostAddress& address, quint16& port);
+
+  void setListen(const QHostAddress& address, quint16 port) { _address = address; _port = port; }
+
+  static constexpr int kSampleMs = 1000;
+  static constexpr int kRequestTimeoutMs = 2000;
+  static constexpr int kMaxRequestBytes = 8192;
+
+public slots:
+  void start();
+  void stop();
+
+signals:
+  void status(const QString& msg);
+  void stopped();
+
+private:
+  void onConnection();
+  void onReadyRead(QTcpSocket* sock);
+  void reply(QTcpSocket* sock, int code, const char* reason, const char* contentType, const QByteArray& body);
+
+  QHostAddress _address{QHostAddress::LocalHost};
+  quint16 _port = 9464;
+  QTcpServer* _server{nullptr};
+  QTimer* _sampler{nullptr};
+  metrics::ThreadCpu _cpu;
+};
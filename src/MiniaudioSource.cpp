@@ -0,0 +1,137 @@
+#include "MiniaudioSource.h"
+#include "LatencyTracer.h"
+#include <QStringList>
+
+MiniaudioSource::MiniaudioSource(Mode mode, const QString& deviceName, int channels)
+  : _mode(mode), _deviceName(deviceName), _channels(channels) {}
+
+MiniaudioSource::~MiniaudioSource() {
+  stop();
+}
+
+void MiniaudioSource::stop() {
+  // It's safe to call ma_device_stop() even if not started, but guard anyway.
+  if (_dev) {
+    ma_device_stop(_dev);
+    ma_device_uninit(_dev);
+    delete _dev; _dev = nullptr;
+  }
+  if (_ctx) {
+    ma_context_uninit(_ctx);
+    delete _ctx; _ctx = nullptr;
+  }
+  _sink = nullptr;
+}
+
+bool MiniaudioSource::findDevice(ma_device_id& id, QString& name, QString& error) {
+  ma_device_info* infos = nullptr;
+  ma_uint32 count = 0;
+  if (ma_context_get_devices(_ctx, nullptr, nullptr, &infos, &count) != MA_SUCCESS) {
+    error = "miniaudio: device enumeration failed";
+    return false;
+  }
+  QStringList names;
+  for (ma_uint32 i = 0; i < count; ++i) {
+    const QString n = QString::fromUtf8(infos[i].name);
+    names << n;
+    if (n.contains(_deviceName, Qt::CaseInsensitive)) {
+      id = infos[i].id;
+      name = n;
+      return true;
+    }
+  }
+  error = QString("miniaudio: no capture device matching '%1' (have: %2)").arg(_deviceName, names.join(", "));
+  return false;
+}
+
+bool MiniaudioSource::start(CaptureSink* sink, int& sampleRate, int& channels, QString& info) {
+  stop();
+  _sink = sink;
+
+  // 1) Context
+  _ctx = new ma_context{};
+  if (ma_context_init(nullptr, 0, nullptr, _ctx) != MA_SUCCESS) {
+    info = "miniaudio: context init failed";
+    delete _ctx; _ctx = nullptr;
+    return false;
+  }
+
+  // 2) Device config
+  ma_device_config cfg = ma_device_config_init(_mode == Loopback ? ma_device_type_loopback
+                                                                 : ma_device_type_capture);
+  ma_device_id id{};
+  QString deviceLabel = _mode == Loopback ? "loopback" : "default capture device";
+  if (_mode == Capture && !_deviceName.isEmpty()) {
+    QString err;
+    if (!findDevice(id, deviceLabel, err)) { info = err; stop(); return false; }
+    cfg.capture.pDeviceID = &id;
+  }
+
+  // Inherit rate/channels, but force f32 so callback casting is safe.
+  cfg.sampleRate         = 0;                   // inherit device rate 48000, 44100 common
+  cfg.capture.channels   = ma_uint32(_channels); // 0 = device's native count; default 2
+  cfg.capture.format     = ma_format_f32;       // force float32 to avoid ambiguity
+  cfg.capture.shareMode  = ma_share_mode_shared;
+
+  // WASAPI specifics: predictable behavior, avoid redundant SRC.
+  cfg.wasapi.noAutoConvertSRC      = MA_TRUE;
+  cfg.wasapi.noHardwareOffloading  = MA_TRUE;
+
+  // Performance / callback sizing (request, not guaranteed).
+  cfg.performanceProfile     = ma_performance_profile_low_latency;
+  cfg.periodSizeInFrames     = 480;     // ~10 ms @ 48 kHz (tune to taste)
+  cfg.periods                = 3;       // triple buffering
+  cfg.noFixedSizedCallback   = MA_FALSE; // prefer fixed-size callbacks
+
+  // give miniaudio a pointer to this object and a function to call when a period is ready
+  cfg.dataCallback = &MiniaudioSource::dataCallback;
+  cfg.pUserData    = this;
+
+  // 3) Create and bind device to context and config, catch failures.
+  _dev = new ma_device{};
+  if (ma_device_init(_ctx, &cfg, _dev) != MA_SUCCESS) {
+    info = QString("miniaudio: %1 init failed").arg(deviceLabel);
+    delete _dev; _dev = nullptr;
+    stop();
+    return false;
+  }
+
+  sampleRate = int(_dev->sampleRate);
+  channels   = int(_dev->capture.channels);
+  info = QStringLiteral("%1 actual: %2 Hz, %3 ch, fmt=%4 (period = %5 frames x %6)")
+    .arg(deviceLabel)
+    .arg(sampleRate)
+    .arg(channels)
+    .arg(int(_dev->capture.format))
+    .arg(cfg.periodSizeInFrames)
+    .arg(cfg.periods);
+
+  // 4) Start device
+  if (ma_device_start(_dev) != MA_SUCCESS) {
+    info = "miniaudio: device start failed";
+    stop();
+    return false;
+  }
+  return true;
+}
+
+// static audio thread callback
+void MiniaudioSource::dataCallback(ma_device* dev, void* pOutput, const void* pInput, ma_uint32 frameCount) {
+  (void)pOutput; // capture-only
+  auto* self = static_cast<MiniaudioSource*>(dev ? dev->pUserData : nullptr);
+  if (!self || !self->_sink || frameCount == 0) return;
+
+  // Monotonic stamp for latency tracing: roughly when the newest frame of this
+  // period was captured (the oldest is one period earlier).
+  const int64_t now = monotonicNs();
+
+  // We forced f32 above, so this cast is safe.
+  const ma_uint32 ch = (dev->capture.channels > 0) ? dev->capture.channels : 2;
+
+  if (pInput == nullptr) {
+    // Keep cadence stable on silence/glitch.
+    self->_sink->pushSilence(frameCount, now);
+    return;
+  }
+  self->_sink->pushFrames(static_cast<const float*>(pInput), frameCount, ch, now);
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "CaptureSource.h"
+#include "miniaudio.h"
+
+// miniaudio input: WASAPI loopback of the system output, or a capture device
+// (line-in, mic, or on Linux a PulseAudio/PipeWire "*.monitor" source, which
+// is how loopback works there). The data callback pushes straight into the sink.
+class MiniaudioSource : public CaptureSource {
+public:
+  enum Mode { Loopback, Capture };
+  // channels: what to open the device with, 0 = its native count (all inputs of a multichannel interface)
+  explicit MiniaudioSource(Mode mode, const QString& deviceName = {}, int channels = 2);
+  ~MiniaudioSource() override;
+
+  bool start(CaptureSink* sink, int& sampleRate, int& channels, QString& info) override;
+  void stop() override;
+
+private:
+  static void dataCallback(ma_device* dev, void* pOutput, const void* pInput, ma_uint32 frameCount);
+  // First capture device whose name contains _deviceName (case-insensitive)
+  bool findDevice(ma_device_id& id, QString& name, QString& error);
+
+  Mode _mode;
+  QString _deviceName;
+  int _channels = 2;
+  CaptureSink* _sink = nullptr;
+  ma_context* _ctx = nullptr;
+  ma_device*  _dev = nullptr;
+};
@@ -1,5 +1,8 @@
 // MultiResolutionVisualizerWidget.cpp
 #include "MultiResolutionVisualizerWidget.h"
+#ifdef WLEDQT_HAVE_OPENGL
+#include "GlSpectrumView.h"
+#endif
 #include <QPaintEvent>
 #include <QApplication>
 #include <algorithm>
@@ -18,6 +21,17 @@ MultiResolutionVisualizerWidget::MultiResolutionVisualizerWidget(QWidget* parent
   _chromaLevels.fill(0.0f, 12);
   
   setupLayout();
+
+#ifdef WLEDQT_HAVE_OPENGL
+  // Shader-drawn chromagram + bass history; cost stays flat with MAX_HISTORY
+  if (GlSpectrumView::requested()) {
+    _glChroma = new GlSpectrumView(GlSpectrumView::Mode::Chroma, this);
+    _glChroma->setValueScale(0.1f);
+    _glEvolution = new GlSpectrumView(GlSpectrumView::Mode::Waterfall, this);
+    _glEvolution->setValueScale(0.1f);
+    _glEvolution->setHistoryDepth(MAX_HISTORY);
+  }
+#endif
   
   // Update timer for smooth animation
   QTimer* updateTimer = new QTimer(this);
@@ -85,6 +99,10 @@ void MultiResolutionVisualizerWidget::onMultiResolutionData(const MultiResolutio
   _beatPhaseHistory.push_back(data.beatPhase);
   _onsetHistory.push_back(data.onsetStrength.isEmpty() ? 0.0f : data.onsetStrength[0]);
   _bassHistory.push_back(data.bass);
+#ifdef WLEDQT_HAVE_OPENGL
+  if (_glChroma) _glChroma->setValues(data.chromagram.constData(), nullptr, int(data.chromagram.size()));
+  if (_glEvolution) _glEvolution->pushHistory(data.bass.constData(), int(data.bass.size()));
+#endif
   
   // Limit history size
   while (_spectralCentroidHistory.size() > MAX_HISTORY) _spectralCentroidHistory.pop_front();
@@ -100,8 +118,7 @@ void MultiResolutionVisualizerWidget::updateLabels() {
   _spectralRolloffLabel->setText(QString("Rolloff: %1 Hz").arg(int(_currentData.spectralRolloff)));
   _zeroCrossingLabel->setText(QString("Noisiness: %1").arg(_currentData.zeroCrossingRate, 0, 'f', 2));
   
-  float bpm = (_currentData.beatPeriod > 0) ? (60.0f * 20.0f / _currentData.beatPeriod) : 0; // Assuming 20fps
-  _beatBPMLabel->setText(QString("BPM: %1").arg(int(bpm)));
+  _beatBPMLabel->setText(QString("BPM: %1").arg(int(std::lround(_currentData.beatBpm))));
   _beatConfidenceLabel->setText(QString("Beat Conf: %1%").arg(int(_currentData.beatConfidence * 100)));
   _harmonicPercRatioLabel->setText(QString("H/P Ratio: %1").arg(_currentData.harmonicPercussiveRatio, 0, 'f', 1));
   
@@ -136,6 +153,12 @@ void MultiResolutionVisualizerWidget::resizeEvent(QResizeEvent* event) {
   _spectralRect = QRect(cellW, startY + cellH, cellW, cellH);
   _beatRect = QRect(cellW * 2, startY + cellH, cellW, cellH);
   _onsetRect = QRect(cellW * 3, startY + cellH, cellW, cellH);
+
+#ifdef WLEDQT_HAVE_OPENGL
+  // GL panels sit under each cell's title line
+  if (_glChroma) _glChroma->setGeometry(_chromaRect.adjusted(0, 20, 0, -20));
+  if (_glEvolution) _glEvolution->setGeometry(_evolutionRect.adjusted(0, 20, 0, -10));
+#endif
 }
 
 void MultiResolutionVisualizerWidget::paintEvent(QPaintEvent* event) {
@@ -242,6 +265,13 @@ void MultiResolutionVisualizerWidget::drawChromagram(QPainter& painter, const QR
                                         "F#", "G", "G#", "A", "A#", "B"};
   
   int barWidth = rect.width() / _chromaLevels.size();
+  if (_glChroma) {
+    // bars come from the GL panel; just the note labels here
+    for (int i = 0; i < _chromaLevels.size(); ++i)
+      painter.drawText(rect.left() + i * barWidth + 5, rect.bottom() - 5, noteNames.value(i));
+    return;
+  }
+  
   int maxHeight = rect.height() - 50;
   
   for (int i = 0; i < _chromaLevels.size(); ++i) {
@@ -266,14 +296,16 @@ void MultiResolutionVisualizerWidget::drawBassEvolution(QPainter& painter, const
   painter.setPen(Qt::white);
   painter.drawText(rect.topLeft() + QPoint(5, 15), "Bass Evolution Over Time");
   
-  if (_bassHistory.empty()) return;
+  if (_bassHistory.empty() || _glEvolution) return;   // GL panel draws the history
   
   int width = rect.width();
   int height = rect.height() - 30;
   
-  // Draw bass evolution as a spectrogram
-  for (int t = 0; t < std::min(width, (int)_bassHistory.size()); ++t) {
-    const QVector<float>& bassFrame = _bassHistory[_bassHistory.size() - width + t];
+  // Draw bass evolution as a spectrogram (newest frames, right-aligned history tail)
+  const int count = std::min(width, (int)_bassHistory.size());
+  const int first = (int)_bassHistory.size() - count;
+  for (int t = 0; t < count; ++t) {
+    const QVector<float>& bassFrame = _bassHistory[first + t];
     
     const int bands = std::min(16, static_cast<int>(bassFrame.size()));
     for (int b = 0; b < bands; ++b) {
@@ -308,9 +340,11 @@ void MultiResolutionVisualizerWidget::drawSpectralEvolution(QPainter& painter, c
   if (maxFreq <= minFreq) maxFreq = minFreq + 1;
   
   // Draw line graph
-  for (int i = 1; i < std::min(width, (int)_spectralCentroidHistory.size()); ++i) {
-    float freq1 = _spectralCentroidHistory[_spectralCentroidHistory.size() - width + i - 1];
-    float freq2 = _spectralCentroidHistory[_spectralCentroidHistory.size() - width + i];
+  const int count = std::min(width, (int)_spectralCentroidHistory.size());
+  const int first = (int)_spectralCentroidHistory.size() - count;
+  for (int i = 1; i < count; ++i) {
+    float freq1 = _spectralCentroidHistory[first + i - 1];
+    float freq2 = _spectralCentroidHistory[first + i];
     
     int y1 = rect.bottom() - int((freq1 - minFreq) / (maxFreq - minFreq) * height);
     int y2 = rect.bottom() - int((freq2 - minFreq) / (maxFreq - minFreq) * height);
@@ -363,9 +397,11 @@ void MultiResolutionVisualizerWidget::drawOnsetDetection(QPainter& painter, cons
   int height = rect.height() - 30;
   
   // Draw onset strength over time
-  for (int i = 1; i < std::min(width, (int)_onsetHistory.size()); ++i) {
-    float onset1 = _onsetHistory[_onsetHistory.size() - width + i - 1];
-    float onset2 = _onsetHistory[_onsetHistory.size() - width + i];
+  const int count = std::min(width, (int)_onsetHistory.size());
+  const int first = (int)_onsetHistory.size() - count;
+  for (int i = 1; i < count; ++i) {
+    float onset1 = _onsetHistory[first + i - 1];
+    float onset2 = _onsetHistory[first + i];
     
     int y1 = rect.bottom() - int(std::clamp(onset1 * 0.1f, 0.0f, 1.0f) * height);
     int y2 = rect.bottom() - int(std::clamp(onset2 * 0.1f, 0.0f, 1.0f) * height);
@@ -12,6 +12,8 @@
 #include <deque>
 #include "AdvancedAudioProcessor.h" // For MultiResolutionData struct
 
+class GlSpectrumView;
+
 class MultiResolutionVisualizerWidget : public QWidget {
   Q_OBJECT
 public:
@@ -64,6 +66,10 @@ private:
   bool _isOnset = false;
   int _onsetFlashTimer = 0;
   QColor _onsetColor = QColor(255, 0, 0, 200);
+
+  // GPU panels for the chromagram and bass waterfall (WLEDQT_RENDER=gl, OpenGL builds)
+  GlSpectrumView* _glChroma = nullptr;
+  GlSpectrumView* _glEvolution = nullptr;
   
   // Drawing methods
   void drawBassSpectrum(QPainter& painter, const QRect& rect);
@@ -0,0 +1,50 @@
+#include "NodeProbe.h"
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QUrl>
+
+NodeProbe::NodeProbe(QObject* parent) : QObject(parent) {
+}
+
+void NodeProbe::setNodes(const QVector<QHostAddress>& nodes) {
+  _nodes.clear();
+  for (const QHostAddress& a : nodes) {
+    if (a.isNull() || a.isMulticast() || _nodes.contains(a)) continue;
+    _nodes.push_back(a);
+  }
+}
+
+void NodeProbe::start(int intervalMs, int timeoutMs) {
+  _timeoutMs = timeoutMs;
+  if (!_nam) _nam = new QNetworkAccessManager(this);
+  if (!_timer) {
+    _timer = new QTimer(this);
+    connect(_timer, &QTimer::timeout, this, &NodeProbe::probeAll);
+  }
+  _timer->start(intervalMs);
+}
+
+void NodeProbe::stop() {
+  if (_timer) _timer->stop();
+}
+
+void NodeProbe::probeAll() {
+  for (const QHostAddress& node : _nodes) {
+    if (_inFlight.contains(node)) continue;
+    QNetworkRequest req(QUrl(QString("http://%1/json/info").arg(node.toString())));
+    req.setTransferTimeout(_timeoutMs);
+    QElapsedTimer clock;
+    clock.start();
+    QNetworkReply* reply = _nam->get(req);
+    _inFlight.push_back(node);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, node, clock]() {
+      const bool ok = reply->error() == QNetworkReply::NoError;
+      _inFlight.removeAll(node);
+      reply->deleteLater();
+      emit result(node, ok ? float(clock.nsecsElapsed()) * 1e-6f : -1.0f, ok);
+    });
+  }
+}
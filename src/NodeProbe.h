@@ -0,0 +1,36 @@
+#pragma once
+#include <QObject>
+#include <QVector>
+#include <QHostAddress>
+
+class QNetworkAccessManager;
+class QTimer;
+
+// Round-trip probe for WLED nodes: every few seconds one small HTTP GET of
+// /json/info per unicast node (WLED answers it on port 80 whatever else it is
+// doing), reported as an RTT or, after the timeout, a loss. UDP gives no
+// delivery feedback, so this is what SendPolicy's rate adaptation sees of the
+// link beyond local send refusals. Multicast groups are not probed.
+//
+// Lives on the sender's thread; at most one request per node in flight.
+class NodeProbe : public QObject {
+  Q_OBJECT
+public:
+  explicit NodeProbe(QObject* parent=nullptr);
+
+  void setNodes(const QVector<QHostAddress>& nodes);
+  void start(int intervalMs = 2000, int timeoutMs = 1000);
+  void stop();
+
+signals:
+  void result(const QHostAddress& node, float rttMs, bool ok);
+
+private:
+  void probeAll();
+
+  QNetworkAccessManager* _nam{nullptr};
+  QTimer* _timer{nullptr};
+  QVector<QHostAddress> _nodes;
+  QVector<QHostAddress> _inFlight;
+  int _timeoutMs{1000};
+};
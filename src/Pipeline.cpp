@@ -0,0 +1,409 @@
+#include "Pipeline.h"
+#include "PipelineConfig.h"
+#include "AudioCapture.h"
+#include "AudioProcessor.h"
+#include "AdvancedAudioProcessor.h"
+#include "CaptureSource.h"
+#include "UdpSrSender.h"
+#include "DdpSender.h"
+#include "LatencyTracer.h"
+#include "MetricsServer.h"
+#include "DspSetup.h"
+#include <algorithm>
+#include <cstdlib>
+
+static_assert(CaptureZone::kMaxZones == LedSegment::kMaxZones, "one DdpSender mailbox per zone");
+
+Pipeline::Pipeline(QObject* parent) : QObject(parent) {
+  // --- Workers (created here, then moved to their threads) ---
+  _audio = new AudioCapture;
+  _dsp   = new AudioProcessor;
+  _adsp  = new AdvancedAudioProcessor;
+  _audio->moveToThread(&_audioThread);
+  _dsp->moveToThread(&_dspThread);
+  _adsp->moveToThread(&_adspThread);
+
+  // Capture callback writes straight into each processor's lock-free input ring.
+  _audio->attachRing(_dsp->inputRing());
+  _audio->attachRing(_adsp->inputRing());
+
+  // Latency tracing: stamped in the capture callback, recorded by DSP + sender
+  _latency = new LatencyTracer;
+  _dsp->setLatencyTracer(_latency);
+
+  // Senders get their own threads so the owner's work (GUI repaints, logging) can't delay packets
+  _srSender = new UdpSrSender;
+  _srSender->moveToThread(&_netThread);
+  _srSender->setLatencyTracer(_latency);
+
+  // Pixel streaming renders on its own thread too; idle until startLedStreaming()
+  _ddpSender = new DdpSender;
+  _ddpSender->moveToThread(&_ledThread);
+
+  wireUp();
+  _netThread.start();
+  _ledThread.start();
+}
+
+Pipeline::~Pipeline() {
+  shutdown();
+}
+
+void Pipeline::wireUp() {
+  // Start workers when threads start
+  connect(&_audioThread, &QThread::started, _audio, &AudioCapture::start);
+  connect(&_dspThread,   &QThread::started, _dsp,   &AudioProcessor::start);
+  connect(&_adspThread,  &QThread::started, _adsp,  &AdvancedAudioProcessor::start);
+  connect(&_netThread,   &QThread::started, _srSender, &UdpSrSender::start);
+  connect(&_netThread,   &QThread::finished, _srSender, &QObject::deleteLater);
+  connect(&_ledThread,   &QThread::started, _ddpSender, &DdpSender::start);
+  connect(&_ledThread,   &QThread::finished, _ddpSender, &QObject::deleteLater);
+
+  // When workers signal 'stopped', quit their threads
+  connect(_audio, &AudioCapture::stopped, &_audioThread, &QThread::quit);
+  connect(_dsp,   &AudioProcessor::stopped, &_dspThread, &QThread::quit);
+  connect(_adsp,  &AdvancedAudioProcessor::stopped, &_adspThread, &QThread::quit);
+
+  // Pipeline: audio -> dsp (queued across threads safely)
+  // Direct: the new FFT setup is built on the capture thread and swapped in by the DSP thread between hops
+  connect(_audio, &AudioCapture::deviceSampleRateChanged, _dsp,   &AudioProcessor::setSampleRate, Qt::DirectConnection);
+  connect(_audio, &AudioCapture::deviceSampleRateChanged, _adsp,  &AdvancedAudioProcessor::setSampleRate, Qt::QueuedConnection);
+
+  connect(_audio, &AudioCapture::status,   this, &Pipeline::status);
+  connect(_dsp,   &AudioProcessor::status, this, &Pipeline::status);
+
+  // The senders copy what they need into their mailboxes on the DSP / analysis
+  // threads; their own threads send the newest at a fixed rate.
+  connect(_dsp, &AudioProcessor::frameReady, _srSender, &UdpSrSender::submitFrame, Qt::DirectConnection);
+  connect(_dsp, &AudioProcessor::frameReady, _ddpSender, &DdpSender::submitFrame, Qt::DirectConnection);
+  connect(_adsp, &AdvancedAudioProcessor::multiResolutionAnalysisReady,
+          _ddpSender, &DdpSender::submitAnalysis, Qt::DirectConnection);
+  // Onsets bypass the SR send policy (counter bump only, on the analysis thread)
+  UdpSrSender* sr = _srSender;
+  connect(_adsp, &AdvancedAudioProcessor::multiResolutionAnalysisReady, sr,
+          [sr](const MultiResolutionData& d) { if (d.isOnset) sr->markTransient(); }, Qt::DirectConnection);
+}
+
+// --- configuration ---
+
+bool Pipeline::setSource(const QString& spec, QString* error) {
+  CaptureSpec parsed;
+  if (!CaptureSpec::parse(spec, parsed, error)) return false;
+  // Read by AudioCapture::start, i.e. only once the capture thread runs again
+  QMetaObject::invokeMethod(_audio, [a = _audio, spec]() { a->setSourceSpec(spec); },
+                            _running ? Qt::QueuedConnection : Qt::DirectConnection);
+  return true;
+}
+
+// --- zones ---
+
+int Pipeline::zoneThreadCount(int zones) {
+  int n = std::clamp(QThread::idealThreadCount() / 2, 1, 4);
+  if (const char* env = std::getenv("WLEDQT_ZONE_THREADS")) {
+    const int v = std::atoi(env);
+    if (v > 0) n = v;
+  }
+  return std::min(n, zones);
+}
+
+bool Pipeline::setZones(const QString& text, QString* error) {
+  if (_running) {
+    if (error) *error = "zones: stop the pipeline first";
+    return false;
+  }
+  QVector<CaptureZone> specs;
+  if (!CaptureZone::parseList(text, specs, error)) return false;
+  clearZones();
+
+  const int threads = zoneThreadCount(int(specs.size()));
+  std::vector<std::shared_ptr<DspSetupCache>> caches;
+  for (int t = 0; t < threads; ++t) {
+    _zoneDspThreads.push_back(std::make_unique<QThread>());
+    caches.push_back(std::make_shared<DspSetupCache>());
+  }
+
+  DdpSender* ddp = _ddpSender;
+  for (int i = 0; i < int(specs.size()); ++i) {
+    const CaptureZone& spec = specs[i];
+    const std::string name = spec.name.toStdString();
+    const int t = i % threads;
+    QThread* thread = _zoneDspThreads[size_t(t)].get();
+
+    // Round-robin over the zone threads; the first processor on each reports its CPU
+    auto* dsp = new AudioProcessor;
+    dsp->shareSetups(caches[size_t(t)]);
+    dsp->setZone(name, i < threads ? "zone-dsp-" + std::to_string(t) : std::string());
+    if (_bands > 0) dsp->setNumBands(_bands);
+    if (_autoFft) dsp->setAutoTuning(true);
+    else if (_fftN > 0) dsp->setFftSize(_fftN, _fftHop);
+    dsp->setSrBinMapping(_srLayout, _srMix, _srNormalize);
+    dsp->moveToThread(thread);
+    connect(thread, &QThread::started, dsp, &AudioProcessor::start);
+    // The thread ends once every processor on it has torn down (see stop())
+    connect(dsp, &AudioProcessor::stopped, this, [this, t] {
+      if (size_t(t) < _zoneDspStopping.size() && --_zoneDspStopping[size_t(t)] == 0)
+        _zoneDspThreads[size_t(t)]->quit();
+    });
+    const QString label = spec.name;
+    connect(dsp, &AudioProcessor::status, this, [this, label](const QString& msg) { emit status(label + ": " + msg); });
+    const int zone = i + 1;              // LedSegment::zone; 0 is the main processor
+    connect(dsp, &AudioProcessor::frameReady, ddp,
+            [ddp, zone](const SpectrumFramePtr& f) { ddp->submitZoneFrame(zone, f); }, Qt::DirectConnection);
+
+    // Empty (or the main spec itself) = the main capture; zones naming the same source share one
+    AudioCapture* capture = nullptr;
+    if (spec.source.isEmpty() || spec.source == _audio->sourceSpec()) {
+      capture = _audio;
+    } else {
+      for (AudioCapture* c : _zoneCaptures)
+        if (c->sourceSpec() == spec.source) capture = c;
+    }
+    if (!capture) {
+      capture = new AudioCapture;
+      capture->setSourceSpec(spec.source);
+      capture->setName(name);
+      auto captureThread = std::make_unique<QThread>();
+      capture->moveToThread(captureThread.get());
+      connect(captureThread.get(), &QThread::started, capture, &AudioCapture::start);
+      connect(capture, &AudioCapture::stopped, captureThread.get(), &QThread::quit);
+      const QString source = spec.source;
+      connect(capture, &AudioCapture::status, this, [this, source](const QString& msg) { emit status(source + ": " + msg); });
+      _zoneCaptures.push_back(capture);
+      _zoneCaptureThreads.push_back(std::move(captureThread));
+    }
+    // Direct: like the main processor, the setup is built on the capture thread
+    connect(capture, &AudioCapture::deviceSampleRateChanged, dsp, &AudioProcessor::setSampleRate, Qt::DirectConnection);
+    _zones.push_back(Zone{spec, capture, dsp});
+    if (!capture->attachRing(dsp->inputRing(), spec.left, spec.right)) {
+      if (error) *error = QString("zones: no room for zone '%1' on its capture").arg(spec.name);
+      clearZones();
+      return false;
+    }
+  }
+  _zoneSpecs = specs;
+
+  if (_ledOn) pushSegments();
+  return true;
+}
+
+void Pipeline::clearZones() {
+  for (auto& t : _zoneCaptureThreads) { t->quit(); t->wait(); }
+  for (auto& t : _zoneDspThreads)     { t->quit(); t->wait(); }
+  _zoneDspStopping.clear();
+  for (Zone& z : _zones) {
+    z.capture->detachRing(z.dsp->inputRing());
+    delete z.dsp;
+  }
+  _zones.clear();
+  for (AudioCapture* c : _zoneCaptures) delete c;
+  _zoneCaptures.clear();
+  _zoneCaptureThreads.clear();
+  _zoneDspThreads.clear();
+  _zoneSpecs.clear();
+}
+
+bool Pipeline::resolveZones(QVector<LedSegment>& segments, QString* unknown) const {
+  bool ok = true;
+  for (LedSegment& seg : segments) {
+    seg.zone = seg.zoneName.isEmpty() || seg.zoneName == "main" ? 0 : -1;
+    for (int i = 0; i < int(_zoneSpecs.size()) && seg.zone < 0; ++i)
+      if (_zoneSpecs[i].name == seg.zoneName) seg.zone = i + 1;
+    if (seg.zone < 0 && ok) {
+      ok = false;
+      if (unknown) *unknown = seg.zoneName;
+    }
+  }
+  return ok;
+}
+
+void Pipeline::pushSegments() {
+  QVector<LedSegment> segments = _segments;
+  QString unknown;
+  // Segments of a zone that is gone stay dark (DdpSender skips zone -1)
+  if (!resolveZones(segments, &unknown)) emit status(QString("LEDs: no zone '%1' any more").arg(unknown));
+  DdpSender* sender = _ddpSender;
+  QMetaObject::invokeMethod(sender, [sender, segments]() {
+    sender->setSegments(segments);
+    sender->setEnabled(true);
+  }, Qt::QueuedConnection);
+}
+
+void Pipeline::setNumBands(int n) {
+  _bands = n;
+  _dsp->setNumBands(n);
+  for (Zone& z : _zones) z.dsp->setNumBands(n);
+}
+
+void Pipeline::setAutoTuning(bool on) {
+  _autoFft = on;
+  _dsp->setAutoTuning(on);
+  for (Zone& z : _zones) z.dsp->setAutoTuning(on);
+}
+
+void Pipeline::setFftSize(int n, int hop) {
+  _autoFft = false;
+  _fftN = n;
+  _fftHop = hop;
+  _dsp->setFftSize(n, hop);
+  for (Zone& z : _zones) z.dsp->setFftSize(n, hop);
+}
+
+void Pipeline::setSrBinMapping(int layout, int mix, int normalize) {
+  _srLayout = layout;
+  _srMix = mix;
+  _srNormalize = normalize;
+  _dsp->setSrBinMapping(layout, mix, normalize);
+  for (Zone& z : _zones) z.dsp->setSrBinMapping(layout, mix, normalize);
+}
+
+bool Pipeline::setTargets(const QString& text, QString* error, int* count) {
+  QVector<SrTarget> targets;
+  if (!UdpSrSender::parseTargets(text, targets, error)) return false;
+  // Queued so it lands between sends
+  UdpSrSender* sender = _srSender;
+  QMetaObject::invokeMethod(sender, [sender, targets]() { sender->setTargets(targets); },
+                            Qt::QueuedConnection);
+  if (count) *count = int(targets.size());
+  return true;
+}
+
+bool Pipeline::startLedStreaming(const QString& text, QString* error, int* count) {
+  QVector<LedSegment> segments;
+  if (!DdpSender::parseSegments(text, segments, error)) return false;
+  if (segments.isEmpty()) {
+    if (error) *error = "LEDs: no segments";
+    return false;
+  }
+  QString unknown;
+  if (!resolveZones(segments, &unknown)) {
+    if (error) *error = QString("LEDs: unknown zone '%1'").arg(unknown);
+    return false;
+  }
+  _segments = segments;
+  _ledOn = true;
+  pushSegments();
+  if (count) *count = int(segments.size());
+  return true;
+}
+
+void Pipeline::stopLedStreaming() {
+  _ledOn = false;
+  DdpSender* sender = _ddpSender;
+  QMetaObject::invokeMethod(sender, [sender]() { sender->setEnabled(false); }, Qt::QueuedConnection);
+}
+
+void Pipeline::setLedEffect(int effect) {
+  DdpSender* sender = _ddpSender;
+  QMetaObject::invokeMethod(sender, [sender, effect]() { sender->setEffect(effect); }, Qt::QueuedConnection);
+}
+
+void Pipeline::setLedBrightness(double b) {
+  DdpSender* sender = _ddpSender;
+  QMetaObject::invokeMethod(sender, [sender, b]() { sender->setBrightness(b); }, Qt::QueuedConnection);
+}
+
+void Pipeline::setLedFps(double fps) {
+  DdpSender* sender = _ddpSender;
+  QMetaObject::invokeMethod(sender, [sender, fps]() { sender->setFps(fps); }, Qt::QueuedConnection);
+}
+
+void Pipeline::startMetrics(const QHostAddress& address, quint16 port) {
+  if (_metricsServer) return;
+  _metricsServer = new MetricsServer;
+  _metricsServer->setListen(address, port);
+  _metricsServer->moveToThread(&_metricsThread);
+  connect(&_metricsThread, &QThread::started, _metricsServer, &MetricsServer::start);
+  connect(&_metricsThread, &QThread::finished, _metricsServer, &QObject::deleteLater);
+  connect(_metricsServer, &MetricsServer::status, this, &Pipeline::status);
+  _metricsThread.start();
+}
+
+bool Pipeline::apply(const PipelineConfig& cfg, QString* error) {
+  if (!cfg.source.isEmpty() && !setSource(cfg.source, error)) return false;
+  QString zones = cfg.zones;
+  if (zones.isEmpty())
+    if (const char* env = std::getenv("WLEDQT_ZONES")) zones = QString::fromLocal8Bit(env);
+  if (!zones.isEmpty() && !setZones(zones, error)) return false;
+
+  // Thread-safe: setups are built here and the DSP threads swap them in between hops
+  setNumBands(cfg.bands);
+  if (cfg.autoFft) setAutoTuning(true);
+  else if (cfg.fftSize > 0) setFftSize(cfg.fftSize, cfg.hop);
+  setSrBinMapping(cfg.srLayout, cfg.srMix, cfg.srNormalize);
+
+  if (!cfg.targets.isEmpty() && !setTargets(cfg.targets, error)) return false;
+
+  setLedEffect(cfg.ledEffect);
+  setLedBrightness(cfg.ledBrightness / 100.0);
+  if (cfg.ledFps > 0.0) setLedFps(cfg.ledFps);
+  if (!cfg.ledSegments.isEmpty() && !startLedStreaming(cfg.ledSegments, error)) return false;
+
+  QHostAddress address;
+  quint16 port = 0;
+  if (!cfg.metrics.isEmpty()) {
+    if (!MetricsServer::parseListen(cfg.metrics, address, port)) {
+      if (error) *error = "metrics: expected port, :port or host:port, got \"" + cfg.metrics + "\"";
+      return false;
+    }
+    startMetrics(address, port);
+  } else if (MetricsServer::fromEnvironment(address, port)) {
+    startMetrics(address, port);
+  }
+  return true;
+}
+
+// --- start / stop ---
+
+void Pipeline::start() {
+  if (_running) return;
+  _running = true;
+  _audioThread.start();
+  _dspThread.start();
+  _adspThread.start();
+  for (auto& t : _zoneCaptureThreads) t->start();
+  for (auto& t : _zoneDspThreads) t->start();
+}
+
+void Pipeline::stop() {
+  if (!_running) return;
+  _running = false;
+  // Capture threads quit right away. The processors tear down on their own
+  // threads after the hop in progress, and their stopped() quits the thread.
+  _audioThread.quit();
+  for (auto& t : _zoneCaptureThreads) t->quit();
+  _zoneDspStopping.assign(_zoneDspThreads.size(), 0);
+  for (size_t i = 0; i < _zones.size(); ++i) ++_zoneDspStopping[i % _zoneDspThreads.size()];
+  _audio->requestStop();
+  for (AudioCapture* c : _zoneCaptures) c->requestStop();
+  _dsp->requestStop();
+  _adsp->requestStop();
+  for (Zone& z : _zones) z.dsp->requestStop();
+}
+
+void Pipeline::shutdown() {
+  if (!_audio) return;
+  if (_running) {
+    _audio->requestStop();
+    for (AudioCapture* c : _zoneCaptures) c->requestStop();
+    _dsp->requestStop();
+    _adsp->requestStop();
+    for (Zone& z : _zones) z.dsp->requestStop();
+    _running = false;
+  }
+  clearZones();             // joins the zone threads; their frames go to the DdpSender still alive here
+  _audioThread.quit(); _audioThread.wait();
+  _dspThread.quit();   _dspThread.wait();
+  _adspThread.quit();  _adspThread.wait();
+  _netThread.quit();   _netThread.wait();   // senders delete themselves on finished
+  _srSender = nullptr;
+  _ledThread.quit();   _ledThread.wait();
+  _ddpSender = nullptr;
+  _metricsThread.quit(); _metricsThread.wait();
+  _metricsServer = nullptr;
+
+  // Workers are deleted on this thread; the tracer after every thread that records into it has stopped
+  _audio->deleteLater(); _audio = nullptr;
+  _dsp->deleteLater();   _dsp   = nullptr;
+  _adsp->deleteLater();  _adsp  = nullptr;
+  delete _latency;       _latency = nullptr;
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QHostAddress>
+#include <QVector>
+#include <memory>
+#include <vector>
+#include "CaptureSource.h"
+#include "DdpSender.h"
+#include "SrBinMapper.h"
+
+class AudioCapture;
+class AudioProcessor;
+class AdvancedAudioProcessor;
+class UdpSrSender;
+class LatencyTracer;
+class MetricsServer;
+struct PipelineConfig;
+
+// Capture -> DSP -> senders, without any UI: the part the GUI (MainWindow) and
+// the headless daemon (daemon.cpp) share. Owns the worker threads, wires the
+// workers together and knows the start/stop and shutdown order:
+//
+//   capture --ring--> AudioProcessor --frameReady (direct)--> UdpSrSender / DdpSender mailboxes
+//           \-ring--> AdvancedAudioProcessor --analysis (direct)--> DdpSender, onsets -> UdpSrSender
+//
+// Analysis zones (setZones, CaptureZone) add one AudioProcessor per zone, fed
+// from its own channel pair of the main capture or of an extra capture (one
+// per distinct source), their frames going to DdpSender's zone mailboxes for
+// segments with ?zone=name. The zone processors share a small fixed set of
+// DSP threads (WLEDQT_ZONE_THREADS, default half the cores up to 4) and,
+// per thread, one DspSetupCache: CPU grows with the zones, not threads with them.
+//
+// The sender threads run for the pipeline's whole life (idle without targets
+// / segments); capture and the processors run between start() and stop().
+// The workers stay reachable so a client can connect to their signals
+// (frames for the bars, sender stats); the setters below are safe from the
+// pipeline's thread at any time.
+class Pipeline : public QObject {
+  Q_OBJECT
+public:
+  explicit Pipeline(QObject* parent = nullptr);
+  ~Pipeline();    // == shutdown()
+
+  AudioCapture*           capture() const { return _audio; }
+  AudioProcessor*         processor() const { return _dsp; }
+  AdvancedAudioProcessor* advanced() const { return _adsp; }
+  UdpSrSender*            srSender() const { return _srSender; }
+  DdpSender*              ddpSender() const { return _ddpSender; }
+  LatencyTracer*          latency() const { return _latency; }
+  bool isRunning() const { return _running; }
+
+  // CaptureSpec text, used by the next start(); false (and *error) if it doesn't parse
+  bool setSource(const QString& spec, QString* error = nullptr);
+  // Analysis zones, "name=[source]#ch[-ch], ..." ("" = none); only while stopped.
+  // LED segments already streaming are re-resolved against the new names.
+  bool setZones(const QString& text, QString* error = nullptr);
+  const QVector<CaptureZone>& zones() const { return _zoneSpecs; }
+  // Analysis layout of the main and every zone processor (thread-safe, any time)
+  void setNumBands(int n);
+  void setAutoTuning(bool on);
+  void setFftSize(int n, int hop = 0);
+  // SrBinMapper Layout / Mix / Normalize for the 16 SR bins
+  void setSrBinMapping(int layout, int mix, int normalize);
+  // WLED sound-reactive targets, "ip[:port], ..."; *count = targets applied
+  bool setTargets(const QString& text, QString* error = nullptr, int* count = nullptr);
+  // Pixel streaming to "ip[:port]/leds, ..."; false on a parse error, an
+  // unknown ?zone= or no segments
+  bool startLedStreaming(const QString& segments, QString* error = nullptr, int* count = nullptr);
+  void stopLedStreaming();
+  void setLedEffect(int effect);            // LedEffectEngine::Effect
+  void setLedBrightness(double b);          // 0..1
+  void setLedFps(double fps);
+  // MetricsServer on its own thread (once; later calls are ignored)
+  void startMetrics(const QHostAddress& address, quint16 port);
+
+  // Everything in a config file (PipelineConfig); stops at the first bad value
+  bool apply(const PipelineConfig& cfg, QString* error = nullptr);
+
+  // Stops the workers and joins every thread; the pipeline is unusable after
+  void shutdown();
+
+public slots:
+  void start();
+  void stop();
+
+signals:
+  // From capture, DSP and the metrics server, delivered on the pipeline's thread
+  void status(const QString& msg);
+
+private:
+  void wireUp();
+
+  // --- zones ---
+  struct Zone {
+    CaptureZone     spec;
+    AudioCapture*   capture = nullptr;      // _audio or one of _zoneCaptures
+    AudioProcessor* dsp = nullptr;
+  };
+  void clearZones();                        // stopped: joins the zone threads, deletes their workers
+  static int zoneThreadCount(int zones);
+  // LedSegment::zone from zoneName (0 = main); false names the first unknown one
+  bool resolveZones(QVector<LedSegment>& segments, QString* unknown) const;
+  void pushSegments();                      // _segments -> DdpSender, enabled
+
+  QVector<CaptureZone> _zoneSpecs;
+  std::vector<Zone> _zones;
+  std::vector<AudioCapture*> _zoneCaptures;                  // extra sources, one each
+  std::vector<std::unique_ptr<QThread>> _zoneCaptureThreads;  // index-matched
+  std::vector<std::unique_ptr<QThread>> _zoneDspThreads;      // shared by the zone processors
+  std::vector<int> _zoneDspStopping;                          // per zone thread: processors not yet stopped
+
+  // Last layout asked for, so zones created later match the main processor
+  int  _bands{0};
+  bool _autoFft{false};
+  int  _fftN{0}, _fftHop{0};
+  int  _srLayout{0}, _srMix{0}, _srNormalize{int(SrBinMapper::Normalize::Dynamics)};
+
+  QVector<LedSegment> _segments;            // while streaming, zone names unresolved
+  bool _ledOn{false};
+
+  QThread _audioThread;
+  QThread _dspThread;
+  QThread _adspThread;
+  QThread _netThread;       // UdpSrSender: fixed-cadence sends, independent of the owner's event loop
+  QThread _ledThread;       // DdpSender: effect rendering + pixel streaming
+  QThread _metricsThread;   // MetricsServer, only after startMetrics()
+
+  AudioCapture*           _audio{nullptr};
+  AudioProcessor*         _dsp{nullptr};
+  AdvancedAudioProcessor* _adsp{nullptr};
+  UdpSrSender*            _srSender{nullptr};
+  DdpSender*              _ddpSender{nullptr};
+  MetricsServer*          _metricsServer{nullptr};
+  LatencyTracer*          _latency{nullptr};
+  bool _running{false};
+};
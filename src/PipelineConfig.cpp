@@ -0,0 +1,140 @@
+#include "PipelineConfig.h"
+#include "AudioProcessor.h"
+#include "LedEffectEngine.h"
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSettings>
+#include <QStringList>
+
+namespace {
+
+// {"leds": {"effect": 1}} -> "leds/effect" = 1, like QSettings names INI groups
+void flatten(const QVariantMap& in, const QString& prefix, QVariantMap& out) {
+  for (auto it = in.begin(); it != in.end(); ++it) {
+    const QString key = prefix.isEmpty() ? it.key() : prefix + "/" + it.key();
+    if (it.value().typeId() == QMetaType::QVariantMap) flatten(it.value().toMap(), key, out);
+    else out.insert(key, it.value());
+  }
+}
+
+// INI splits "a, b" into a list at the commas, JSON may give an array: join either back
+QString text(const QVariant& v) {
+  if (v.typeId() == QMetaType::QStringList || v.typeId() == QMetaType::QVariantList)
+    return v.toStringList().join(", ");
+  return v.toString().trimmed();
+}
+
+bool toInt(const QVariant& v, int& out) {
+  bool ok = false;
+  const int n = text(v).toInt(&ok);
+  if (ok) out = n;
+  return ok;
+}
+
+bool toEffect(const QVariant& v, int& out) {
+  const QString name = text(v);
+  for (int e = 0; e < int(LedEffectEngine::Effect::Count); ++e) {
+    if (name.compare(LedEffectEngine::effectName(LedEffectEngine::Effect(e)), Qt::CaseInsensitive) == 0) {
+      out = e;
+      return true;
+    }
+  }
+  int n = 0;
+  if (!toInt(v, n) || n < 0 || n >= int(LedEffectEngine::Effect::Count)) return false;
+  out = n;
+  return true;
+}
+
+// An SrBinMapper enum by name (any case) or index
+template <class E>
+bool toEnum(const QVariant& v, int count, const char* (*name)(E), int& out) {
+  const QString s = text(v);
+  for (int i = 0; i < count; ++i) {
+    if (s.compare(name(E(i)), Qt::CaseInsensitive) == 0) {
+      out = i;
+      return true;
+    }
+  }
+  int n = 0;
+  if (!toInt(v, n) || n < 0 || n >= count) return false;
+  out = n;
+  return true;
+}
+
+} // namespace
+
+bool PipelineConfig::load(const QString& path, PipelineConfig& out, QString* error) {
+  QVariantMap values;
+  if (path.endsWith(".json", Qt::CaseInsensitive)) {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+      if (error) *error = "cannot open " + path;
+      return false;
+    }
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(f.readAll(), &parseError);
+    if (!doc.isObject()) {
+      if (error) *error = QString("%1: %2 at offset %3").arg(path, parseError.errorString()).arg(parseError.offset);
+      return false;
+    }
+    flatten(doc.object().toVariantMap(), QString(), values);
+  } else {
+    if (!QFile::exists(path)) {
+      if (error) *error = "cannot open " + path;
+      return false;
+    }
+    QSettings ini(path, QSettings::IniFormat);
+    if (ini.status() != QSettings::NoError) {
+      if (error) *error = path + ": not a valid INI file";
+      return false;
+    }
+    for (const QString& key : ini.allKeys()) values.insert(key, ini.value(key));
+  }
+  if (!fromMap(values, out, error)) {
+    if (error) *error = path + ": " + *error;
+    return false;
+  }
+  return true;
+}
+
+bool PipelineConfig::fromMap(const QVariantMap& values, PipelineConfig& out, QString* error) {
+  PipelineConfig c;
+  for (auto it = values.begin(); it != values.end(); ++it) {
+    const QString& key = it.key();
+    const QVariant& v = it.value();
+    bool ok = true;
+    if (key == "source")               c.source = text(v);
+    else if (key == "zones")           c.zones = text(v);
+    else if (key == "bands")           ok = toInt(v, c.bands) && AudioProcessor::isSupportedBandCount(c.bands);
+    else if (key == "fftSize")         ok = toInt(v, c.fftSize) && c.fftSize >= AudioProcessor::kMinFft
+                                             && c.fftSize <= AudioProcessor::kMaxFft
+                                             && (c.fftSize & (c.fftSize - 1)) == 0;
+    else if (key == "hop")             ok = toInt(v, c.hop) && c.hop >= 0;
+    else if (key == "autoFft")         c.autoFft = v.toBool();
+    else if (key == "srLayout")        ok = toEnum(v, SrBinMapper::kLayouts, &SrBinMapper::layoutName, c.srLayout);
+    else if (key == "srMix")           ok = toEnum(v, SrBinMapper::kMixes, &SrBinMapper::mixName, c.srMix);
+    else if (key == "srNormalize")     ok = toEnum(v, SrBinMapper::kNormalizes, &SrBinMapper::normalizeName,
+                                                   c.srNormalize);
+    else if (key == "targets")         c.targets = text(v);
+    else if (key == "metrics")         c.metrics = text(v);
+    else if (key == "leds/segments")   c.ledSegments = text(v);
+    else if (key == "leds/effect")     ok = toEffect(v, c.ledEffect);
+    else if (key == "leds/brightness") ok = toInt(v, c.ledBrightness) && c.ledBrightness >= 0 && c.ledBrightness <= 100;
+    else if (key == "leds/fps")        c.ledFps = text(v).toDouble(&ok);
+    else {
+      if (error) *error = "unknown key \"" + key + "\"";
+      return false;
+    }
+    if (!ok) {
+      if (error) *error = QString("bad value for %1: \"%2\"").arg(key, text(v));
+      return false;
+    }
+  }
+  if (c.hop > 0 && c.fftSize == 0) {
+    if (error) *error = "hop needs fftSize";
+    return false;
+  }
+  out = c;
+  return true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <QString>
+#include <QVariantMap>
+#include "SrBinMapper.h"
+
+// Pipeline settings for the daemon, from a JSON or INI file (by extension:
+// .json is JSON, anything else INI). Same keys either way; "leds/effect" is
+// {"leds": {"effect": ...}} in JSON and effect= under [leds] in INI:
+//
+//   source          CaptureSpec, e.g. "file:show.wav?loop" (default: WLEDQT_CAPTURE / loopback)
+//   zones           CaptureZone list, "kick=#1, vocals=device:USB#1-2" (default: WLEDQT_ZONES)
+//   bands           16, 32, 64, 128 or 256 (default 32)
+//   fftSize, hop    FFT layout (default: from the sample rate, hop N/2)
+//   autoFft         true = AudioProcessor::setAutoTuning
+//   srLayout        SR bins from bands: contiguous (default) or wledgeq
+//   srMix           L/R per band: mean (default), max, left or right
+//   srNormalize     framemax, runningpeak, fixed or dynamics (default)
+//   targets         WLED SR targets, "ip[:port], ..." (a JSON array works too)
+//   metrics         MetricsServer listen address (default: WLEDQT_METRICS)
+//   leds/segments   pixel streaming, "ip[:port]/leds, ..." (empty = off)
+//   leds/effect     LedEffectEngine effect by name or index
+//   leds/brightness percent
+//   leds/fps        render rate
+//
+// Unknown keys are an error, so a typo doesn't silently fall back to a default.
+struct PipelineConfig {
+  QString source;
+  QString zones;
+  int     bands = 32;
+  int     fftSize = 0, hop = 0;     // 0 = AudioProcessor's default
+  bool    autoFft = false;
+  int     srLayout = 0, srMix = 0;  // SrBinMapper::Layout / Mix
+  int     srNormalize = int(SrBinMapper::Normalize::Dynamics);
+  QString targets;
+  QString metrics;
+  QString ledSegments;
+  int     ledEffect = 0;
+  int     ledBrightness = 80;
+  double  ledFps = 0.0;             // 0 = DdpSender default
+
+  static bool load(const QString& path, PipelineConfig& out, QString* error = nullptr);
+  // Flat "group/key" map (what QSettings gives for INI, and JSON after flattening)
+  static bool fromMap(const QVariantMap& values, PipelineConfig& out, QString* error = nullptr);
+};
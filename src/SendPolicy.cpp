@@ -0,0 +1,100 @@
+#include "SendPolicy.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+SendPolicyConfig SendPolicyConfig::fromEnvironment() {
+  SendPolicyConfig cfg;
+  if (const char* env = std::getenv("WLEDQT_SEND_POLICY")) {
+    if (std::strcmp(env, "off") == 0 || std::strcmp(env, "0") == 0) cfg.enabled = false;
+  }
+  return cfg;
+}
+
+void SendPolicy::configure(const SendPolicyConfig& cfg) {
+  _cfg = cfg;
+  _cfg.tolerance = std::clamp(_cfg.tolerance, 0, 255);
+  _cfg.keyframeMs = std::max(_cfg.keyframeMs, 10);
+  _cfg.maxIntervalMs = std::max(_cfg.maxIntervalMs, 0.0);
+  reset();
+}
+
+void SendPolicy::reset() {
+  _haveLast = false;
+  _lastSendNs = _lastKeyNs = 0;
+  _loss = _rtt = _baseRtt = 0.0f;
+  _intervalMs = 0.0;
+  _sinceBackoff = 0;
+}
+
+SendPolicy::Decision SendPolicy::decide(const uint8_t* content, int len, int64_t nowNs, bool transient) {
+  Decision d = Decision::Send;
+  if (!_cfg.enabled) {
+    d = Decision::Send;
+  } else if (transient) {
+    d = Decision::Transient;
+  } else if (!_haveLast || int(_last.size()) != len ||
+             nowNs - _lastKeyNs >= int64_t(_cfg.keyframeMs) * 1000000) {
+    d = Decision::Keyframe;
+  } else if (nowNs - _lastSendNs < int64_t(_intervalMs * 1e6)) {
+    d = Decision::SkipThrottled;
+  } else {
+    const int tol = _cfg.tolerance;
+    bool changed = false;
+    for (int i = 0; i < len && !changed; ++i) changed = std::abs(int(content[i]) - int(_last[size_t(i)])) > tol;
+    if (!changed) d = Decision::SkipUnchanged;
+  }
+
+  switch (d) {
+    case Decision::SkipUnchanged: ++_counters.skippedUnchanged; return d;
+    case Decision::SkipThrottled: ++_counters.skippedThrottled; return d;
+    case Decision::Keyframe:  ++_counters.keyframes; _lastKeyNs = nowNs; break;
+    case Decision::Transient: ++_counters.transients; break;
+    case Decision::Send: break;
+  }
+  ++_counters.sent;
+  _last.assign(content, content + len);   // same size every tick: no reallocation
+  _haveLast = true;
+  _lastSendNs = nowNs;
+  return d;
+}
+
+// --- link feedback ---
+
+void SendPolicy::reportSend(bool ok) {
+  observeLoss(!ok);
+}
+
+void SendPolicy::reportProbeLost() {
+  observeLoss(true);
+}
+
+void SendPolicy::reportRtt(float ms) {
+  if (ms < 0.0f) return;
+  _rtt = _rtt == 0.0f ? ms : 0.8f * _rtt + 0.2f * ms;
+  // Baseline: the lowest RTT seen, creeping up 1% per report so a route change
+  // doesn't pin it forever
+  _baseRtt = _baseRtt == 0.0f ? ms : std::min(ms, _baseRtt * 1.01f);
+  observeLoss(false);
+}
+
+void SendPolicy::observeLoss(bool lost) {
+  _loss = 0.95f * _loss + (lost ? 0.05f : 0.0f);
+  adapt();
+}
+
+void SendPolicy::adapt() {
+  if (!_cfg.enabled) { _intervalMs = 0.0; return; }
+  const bool congested = _loss > _cfg.lossTarget ||
+                         (_baseRtt > 0.0f && _rtt > _cfg.rttFactor * std::max(_baseRtt, 1.0f));
+  // Loss decays slowly, so back off at most once per 10 reports instead of on
+  // every report while the average is still high
+  if (congested) {
+    if (++_sinceBackoff >= 10 || _intervalMs == 0.0) {
+      _intervalMs = std::min(_cfg.maxIntervalMs, std::max(_intervalMs * 1.5, 10.0));
+      _sinceBackoff = 0;
+    }
+  } else {
+    _intervalMs = std::max(0.0, _intervalMs - 1.0);
+  }
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Per-node decision of whether this tick's datagram(s) actually go out.
+//
+//   - unchanged content (every byte within `tolerance` of what was last sent)
+//     is skipped, down to one keyframe every `keyframeMs` so a node that
+//     missed a packet or rebooted resyncs and WLED's realtime timeout never
+//     fires;
+//   - the minimum interval between sends adapts to the node's link: loss
+//     above `lossTarget`, or RTT above `rttFactor` x its baseline, backs off
+//     multiplicatively (up to `maxIntervalMs`); clean reports recover
+//     additively;
+//   - a transient (onset / beat) always sends, whatever the two rules above say.
+//
+// Callers hand in the part of the payload that matters ("content": the 16 SR
+// bins + level, or a segment's RGB), not the raw datagram, so counters and
+// sequence numbers don't defeat the comparison. Single-threaded (the sender's
+// thread); no allocation once the content size is known.
+struct SendPolicyConfig {
+  bool   enabled = true;
+  int    tolerance = 2;            // per byte
+  int    keyframeMs = 1000;
+  double maxIntervalMs = 200.0;    // slowest rate under sustained loss
+  float  lossTarget = 0.05f;
+  float  rttFactor = 3.0f;
+
+  // WLEDQT_SEND_POLICY=off (or 0) disables it, otherwise the defaults.
+  static SendPolicyConfig fromEnvironment();
+};
+
+class SendPolicy {
+public:
+  enum class Decision { Send, Keyframe, Transient, SkipUnchanged, SkipThrottled };
+  static bool sends(Decision d) { return d == Decision::Send || d == Decision::Keyframe || d == Decision::Transient; }
+
+  struct Counters {
+    uint64_t sent = 0, keyframes = 0, transients = 0;
+    uint64_t skippedUnchanged = 0, skippedThrottled = 0;
+  };
+
+  void configure(const SendPolicyConfig& cfg);
+  const SendPolicyConfig& config() const { return _cfg; }
+  void reset();                    // forget the reference content and link state
+
+  // Decide for this tick's content; on a sending decision the content becomes
+  // the new reference (call before sending; a failed send is reported below).
+  Decision decide(const uint8_t* content, int len, int64_t nowNs, bool transient);
+
+  // Link feedback: local send results (refused by the kernel = lost) and,
+  // where a probe exists, measured round trips / probe timeouts.
+  void reportSend(bool ok);
+  void reportRtt(float ms);
+  void reportProbeLost();
+
+  double intervalMs() const { return _intervalMs; }
+  float lossRate() const { return _loss; }
+  float rttMs() const { return _rtt; }
+  float baselineRttMs() const { return _baseRtt; }
+  const Counters& counters() const { return _counters; }
+  void resetCounters() { _counters = Counters{}; }
+
+private:
+  void observeLoss(bool lost);
+  void adapt();
+
+  SendPolicyConfig _cfg;
+  std::vector<uint8_t> _last;      // content of the last datagram that went out
+  bool    _haveLast = false;
+  int64_t _lastSendNs = 0;
+  int64_t _lastKeyNs = 0;
+
+  float  _loss = 0.0f;             // EWMA of lost / reported
+  float  _rtt = 0.0f;              // EWMA
+  float  _baseRtt = 0.0f;          // slowly rising minimum
+  double _intervalMs = 0.0;        // 0 = every tick
+  int    _sinceBackoff = 0;
+  Counters _counters;
+};
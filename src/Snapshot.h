@@ -2,6 +2,7 @@
 #include <QVector>
 #include <QMetaType>
 #include <QDateTime>
+#include "SpectrumFrame.h"
 
 struct Snapshot {
     QVector<float> leftBars;
@@ -17,4 +18,10 @@ struct Snapshot {
         : leftBars(left), rightBars(right), leftCentroid(leftCent), 
           rightCentroid(rightCent), timestamp(QDateTime::currentDateTime()), 
           frameNumber(frame) {}
+
+    // Copy of a processor frame's bands (the frame itself goes back to its pool)
+    explicit Snapshot(const SpectrumFrame& f)
+        : leftBars(f.bandsL, f.bandsL + f.numBands), rightBars(f.bandsR, f.bandsR + f.numBands),
+          leftCentroid(f.centroidL), rightCentroid(f.centroidR),
+          timestamp(QDateTime::currentDateTime()), frameNumber(int(f.frameIndex)) {}
 };
\ No newline at end of file
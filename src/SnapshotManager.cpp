@@ -1,39 +1,127 @@
 #include "SnapshotManager.h"
+#include "LatencyTracer.h"   // monotonicNs
+#include <QTimer>
+#include <algorithm>
+#include <cmath>
 
 SnapshotManager::SnapshotManager(QObject* parent) : QObject(parent)
 {
-    _snapshots.reserve(_bufferSeconds * ASSUMED_FPS);
+    _anchorNs = monotonicNs();
+    _anchorWall = QDateTime::currentDateTime();
+
+    _notifyTimer = new QTimer(this);
+    _notifyTimer->setSingleShot(true);
+    _notifyTimer->setInterval(kDefaultNotifyMs);
+    connect(_notifyTimer, &QTimer::timeout, this, &SnapshotManager::flushNotify);
+}
+
+int SnapshotManager::capacityFor() const
+{
+    // a little headroom over the nominal rate so jitter doesn't cut the window short
+    const double fps = _logRateHz > 0.0 ? std::min(_fps, _logRateHz) : _fps;
+    return int(std::ceil(_bufferSeconds * fps * 1.05)) + 1;
 }
 
 void SnapshotManager::setBufferDuration(int seconds)
 {
     _bufferSeconds = qBound(10, seconds, 120);  // 10 sec to 2 min
-    trimBuffer();
+    if (_ring.bands() > 0) {
+        _ring.setCapacity(capacityFor());
+        if (!_ring.empty())
+            _ring.evictOlderThan(_ring.timeNs(_ring.size() - 1) - int64_t(_bufferSeconds) * 1000000000LL);
+    }
     emit snapshotsChanged();
 }
 
+void SnapshotManager::setExpectedFrameRate(double fps)
+{
+    if (!(fps > 0.0)) return;
+    _fps = fps;
+    if (_ring.bands() > 0) _ring.setCapacity(capacityFor());
+}
+
+void SnapshotManager::setLogRate(double hz)
+{
+    _logRateHz = hz > 0.0 ? hz : 0.0;
+    _logIntervalNs = _logRateHz > 0.0 ? int64_t(1e9 / _logRateHz) : 0;
+    _nextLogNs = 0;
+    if (_ring.bands() > 0) _ring.setCapacity(capacityFor());
+}
+
+void SnapshotManager::setNotifyInterval(int ms)
+{
+    _notifyTimer->setInterval(qMax(0, ms));
+}
+
+void SnapshotManager::ensureBands(int bands)
+{
+    // band count changed (or first frame): start a fresh ring for the new shape
+    if (bands != _ring.bands())
+        _ring.reset(capacityFor(), bands);
+}
+
+void SnapshotManager::push(const float* left, const float* right, int bands,
+                           float centL, float centR, int64_t timeNs, int frame)
+{
+    if (bands <= 0) return;
+    if (_logIntervalNs > 0) {
+        // decimate to the log rate; deadlines step so the average rate is exact
+        if (timeNs < _nextLogNs) return;
+        _nextLogNs = (timeNs - _nextLogNs < _logIntervalNs) ? _nextLogNs + _logIntervalNs
+                                                           : timeNs + _logIntervalNs;
+    }
+    ensureBands(bands);
+    _ring.push(left, right, centL, centR, timeNs, frame);
+    _ring.evictOlderThan(timeNs - int64_t(_bufferSeconds) * 1000000000LL);
+    markDirty();
+}
+
 void SnapshotManager::addSnapshot(const Snapshot& snapshot)
 {
-    _snapshots.append(snapshot);
-    trimBuffer();
+    const int bands = int(qMin(snapshot.leftBars.size(), snapshot.rightBars.size()));
+    push(snapshot.leftBars.constData(), snapshot.rightBars.constData(), bands,
+         snapshot.leftCentroid, snapshot.rightCentroid, monotonicNs(), snapshot.frameNumber);
+}
+
+void SnapshotManager::addFrame(const SpectrumFramePtr& frame)
+{
+    if (!frame) return;
+    const int64_t t = frame->timestampNs ? frame->timestampNs : monotonicNs();
+    push(frame->bandsL, frame->bandsR, frame->numBands,
+         frame->centroidL, frame->centroidR, t, int(frame->frameIndex));
+}
+
+void SnapshotManager::markDirty()
+{
+    _dirty = true;
+    if (!_notifyTimer->isActive()) _notifyTimer->start();
+}
+
+void SnapshotManager::flushNotify()
+{
+    if (!_dirty) return;
+    _dirty = false;
     emit snapshotsChanged();
 }
 
-void SnapshotManager::trimBuffer()
+QDateTime SnapshotManager::wallTime(int i) const
 {
-    if (_snapshots.isEmpty()) return;
-    
-    // Calculate how many frames to keep based on time
-    const QDateTime cutoffTime = QDateTime::currentDateTime().addSecs(-_bufferSeconds);
-    
-    // Remove old snapshots
-    while (!_snapshots.isEmpty() && _snapshots.first().timestamp < cutoffTime) {
-        _snapshots.removeFirst();
-    }
+    return _anchorWall.addMSecs((_ring.timeNs(i) - _anchorNs) / 1000000);
+}
+
+Snapshot SnapshotManager::snapshotAt(int i) const
+{
+    const int n = _ring.bands();
+    Snapshot s(QVector<float>(_ring.left(i), _ring.left(i) + n),
+               QVector<float>(_ring.right(i), _ring.right(i) + n),
+               _ring.centroidL(i), _ring.centroidR(i), _ring.frameNumber(i));
+    s.timestamp = wallTime(i);
+    return s;
 }
 
 void SnapshotManager::clear()
 {
-    _snapshots.clear();
+    _ring.clear();
+    _dirty = false;
     emit snapshotsChanged();
 }
@@ -0,0 +1,76 @@
+#pragma once
+#include <QObject>
+#include <QDateTime>
+#include "Snapshot.h"
+#include "SnapshotRing.h"
+
+class QTimer;
+
+// Rolling history of processor frames for the snapshot viewer.
+// Storage is a preallocated SnapshotRing sized from the buffer duration, the
+// expected frame rate and the band count, so adding a frame only copies floats.
+// snapshotsChanged is coalesced to at most one emission per notify interval.
+class SnapshotManager : public QObject {
+    Q_OBJECT
+    
+public:
+    explicit SnapshotManager(QObject* parent = nullptr);
+    
+    void setBufferDuration(int seconds);  // how many seconds to keep
+    int getBufferDuration() const { return _bufferSeconds; }
+
+    // Frames per second the ring is sized for (hop rate; 48k / 512 by default).
+    // If frames come in faster the oldest ones are overwritten early.
+    void setExpectedFrameRate(double fps);
+    // Minimum spacing of snapshotsChanged, i.e. the UI refresh rate.
+    void setNotifyInterval(int ms);
+    // Frames logged per second, independent of hop and paint rate. 0 = every frame.
+    void setLogRate(double hz);
+    double logRate() const { return _logRateHz; }
+    // Filterbank points of the current analysis (bands + 2), for labelling.
+    void setBandEdges(const QVector<float>& edgesHz) { _bandEdgesHz = edgesHz; }
+    const QVector<float>& bandEdgesHz() const { return _bandEdgesHz; }
+    
+    const SnapshotRing& ring() const { return _ring; }
+    int count() const { return _ring.size(); }
+    int getCurrentIndex() const { return _ring.size() - 1; }
+    bool isEmpty() const { return _ring.empty(); }
+
+    // Materialized copy of entry i (0 = oldest), for display.
+    Snapshot snapshotAt(int i) const;
+    // Wall-clock time of entry i (stored as steady-clock ns).
+    QDateTime wallTime(int i) const;
+    
+public slots:
+    void addSnapshot(const Snapshot& snapshot);
+    void addFrame(const SpectrumFramePtr& frame);
+    void clear();
+    
+signals:
+    void snapshotsChanged();  // emitted when buffer changes (coalesced)
+    
+private:
+    SnapshotRing _ring;
+    int _bufferSeconds = 30;  // default 30 seconds
+    double _fps = kDefaultFps;
+    static constexpr double kDefaultFps = 48000.0 / 512.0;
+    static constexpr int kDefaultNotifyMs = 33;   // ~30 Hz
+
+    QVector<float> _bandEdgesHz;
+    double _logRateHz = 0.0;
+    int64_t _logIntervalNs = 0;
+    int64_t _nextLogNs = 0;
+    QTimer* _notifyTimer = nullptr;
+    bool _dirty = false;
+
+    // steady <-> wall clock anchor for display timestamps
+    int64_t _anchorNs = 0;
+    QDateTime _anchorWall;
+
+    int capacityFor() const;
+    void ensureBands(int bands);
+    void push(const float* left, const float* right, int bands,
+              float centL, float centR, int64_t timeNs, int frame);
+    void markDirty();
+    void flushNotify();
+};
@@ -0,0 +1,241 @@
+#include "SnapshotRecording.h"
+#include "LatencyTracer.h"   // monotonicNs
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace rec {
+
+int bytesPerValue(Quant q)
+{
+    switch (q) {
+    case Quant::UInt16: return 2;
+    case Quant::UInt8:  return 1;
+    default:            return 4;
+    }
+}
+
+const char* quantName(Quant q)
+{
+    switch (q) {
+    case Quant::UInt16: return "uint16";
+    case Quant::UInt8:  return "uint8";
+    default:            return "float32";
+    }
+}
+
+} // namespace rec
+
+namespace {
+
+// L then R bands in the requested format after the frame header
+void encodeBands(char* dst, const float* l, const float* r, int n, rec::Quant q, float scale)
+{
+    if (q == rec::Quant::Float32) {
+        std::memcpy(dst, l, sizeof(float) * n);
+        std::memcpy(dst + sizeof(float) * n, r, sizeof(float) * n);
+        return;
+    }
+    const float qMax = (q == rec::Quant::UInt16) ? 65535.0f : 255.0f;
+    const float k = scale > 0.0f ? qMax / scale : 0.0f;
+    auto quantize = [&](float v) { return std::clamp(std::lround(v * k), 0L, long(qMax)); };
+
+    if (q == rec::Quant::UInt16) {
+        auto* out = reinterpret_cast<uint16_t*>(dst);
+        for (int i = 0; i < n; ++i) out[i]     = uint16_t(quantize(l[i]));
+        for (int i = 0; i < n; ++i) out[n + i] = uint16_t(quantize(r[i]));
+    } else {
+        auto* out = reinterpret_cast<uint8_t*>(dst);
+        for (int i = 0; i < n; ++i) out[i]     = uint8_t(quantize(l[i]));
+        for (int i = 0; i < n; ++i) out[n + i] = uint8_t(quantize(r[i]));
+    }
+}
+
+void decodeBands(const uchar* src, float* l, float* r, int n, rec::Quant q, float scale)
+{
+    if (q == rec::Quant::Float32) {
+        std::memcpy(l, src, sizeof(float) * n);
+        std::memcpy(r, src + sizeof(float) * n, sizeof(float) * n);
+        return;
+    }
+    if (q == rec::Quant::UInt16) {
+        const float k = scale / 65535.0f;
+        uint16_t v;
+        for (int i = 0; i < n; ++i) { std::memcpy(&v, src + 2 * i, 2);       l[i] = v * k; }
+        for (int i = 0; i < n; ++i) { std::memcpy(&v, src + 2 * (n + i), 2); r[i] = v * k; }
+    } else {
+        const float k = scale / 255.0f;
+        for (int i = 0; i < n; ++i) l[i] = src[i] * k;
+        for (int i = 0; i < n; ++i) r[i] = src[n + i] * k;
+    }
+}
+
+} // namespace
+
+// --- SnapshotRecorder ---
+
+bool SnapshotRecorder::open(const QString& path, const RecordingLayout& layout, rec::Quant quant,
+                            QString* error)
+{
+    close();
+    const int n = layout.numBands();
+    if (n <= 0 || n > SpectrumFrame::kMaxBands || layout.sampleRate <= 0) {
+        if (error) *error = "No analysis layout yet (start audio first)";
+        return false;
+    }
+
+    _file.setFileName(path);
+    if (!_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error) *error = _file.errorString();
+        return false;
+    }
+
+    const int edgesBytes = int(sizeof(float)) * (n + 2);
+    _header = rec::FileHeader{};
+    _header.headerBytes = uint16_t((sizeof(rec::FileHeader) + edgesBytes + 7) & ~size_t(7));
+    _header.quant = uint8_t(quant);
+    _header.sampleRate = uint32_t(layout.sampleRate);
+    _header.fftSize = uint32_t(layout.fftSize);
+    _header.hop = uint32_t(layout.hop);
+    _header.numBands = uint32_t(n);
+    _header.frameBytes = uint32_t(sizeof(rec::FrameHeader) + 2 * n * rec::bytesPerValue(quant));
+    _header.startWallMs = QDateTime::currentMSecsSinceEpoch();
+    _startNs = monotonicNs();
+
+    std::vector<char> head(_header.headerBytes, 0);
+    std::memcpy(head.data(), &_header, sizeof(_header));
+    std::memcpy(head.data() + sizeof(_header), layout.bandEdgesHz.data(), edgesBytes);
+    if (_file.write(head.data(), qint64(head.size())) != qint64(head.size())) {
+        if (error) *error = _file.errorString();
+        _file.close();
+        return false;
+    }
+
+    _scratch.assign(_header.frameBytes, 0);
+    _frames = 0;
+    _bytes = head.size();
+    return true;
+}
+
+void SnapshotRecorder::close()
+{
+    if (_file.isOpen()) {
+        _file.flush();
+        _file.close();
+    }
+}
+
+bool SnapshotRecorder::addFrame(const SpectrumFramePtr& frame)
+{
+    if (!frame || !_file.isOpen()) return false;
+    const SpectrumFrame& f = *frame;
+    const int n = int(_header.numBands);
+    if (f.numBands != n) return false;
+
+    rec::FrameHeader h;
+    h.timeNs = (f.timestampNs ? f.timestampNs : monotonicNs()) - _startNs;
+    h.frameIndex = uint32_t(f.frameIndex);
+    h.rmsL = f.rmsL;
+    h.rmsR = f.rmsR;
+    h.centroidL = f.centroidL;
+    h.centroidR = f.centroidR;
+    float peak = 0.0f;
+    for (int i = 0; i < n; ++i) peak = std::max(peak, std::max(f.bandsL[i], f.bandsR[i]));
+    h.scale = peak;
+    for (int i = 0; i < SpectrumFrame::kSrBins; ++i)
+        h.bins16[i] = uint8_t(std::lround(std::clamp(f.bins16[i], 0.0f, 1.0f) * 255.0f));
+
+    std::memcpy(_scratch.data(), &h, sizeof(h));
+    encodeBands(_scratch.data() + sizeof(h), f.bandsL, f.bandsR, n, rec::Quant(_header.quant), peak);
+
+    if (_file.write(_scratch.data(), qint64(_scratch.size())) != qint64(_scratch.size()))
+        return false;
+    ++_frames;
+    _bytes += _scratch.size();
+    return true;
+}
+
+// --- SnapshotRecordingReader ---
+
+bool SnapshotRecordingReader::open(const QString& path, QString* error)
+{
+    close();
+    auto fail = [&](const QString& why) {
+        if (error) *error = why;
+        close();
+        return false;
+    };
+
+    _file.setFileName(path);
+    if (!_file.open(QIODevice::ReadOnly)) return fail(_file.errorString());
+
+    const qint64 size = _file.size();
+    if (size < qint64(sizeof(rec::FileHeader))) return fail("Not a recording (too short)");
+    _base = _file.map(0, size);
+    if (!_base) return fail("Could not map file: " + _file.errorString());
+
+    std::memcpy(&_header, _base, sizeof(_header));
+    if (std::memcmp(_header.magic, rec::kMagic, 4) != 0) return fail("Not a recording (bad magic)");
+    if (_header.version != rec::kVersion)
+        return fail(QString("Unsupported recording version %1").arg(_header.version));
+
+    const int n = int(_header.numBands);
+    const size_t edgesBytes = sizeof(float) * size_t(n + 2);
+    if (n <= 0 || n > SpectrumFrame::kMaxBands || _header.quant > uint8_t(rec::Quant::UInt8) ||
+        _header.headerBytes < sizeof(rec::FileHeader) + edgesBytes || qint64(_header.headerBytes) > size ||
+        _header.frameBytes != sizeof(rec::FrameHeader) + 2 * n * rec::bytesPerValue(quant()))
+        return fail("Corrupt recording header");
+
+    _edges.resize(n + 2);
+    std::memcpy(_edges.data(), _base + sizeof(rec::FileHeader), edgesBytes);
+    _count = (size - _header.headerBytes) / _header.frameBytes;   // partial tail ignored
+    return true;
+}
+
+void SnapshotRecordingReader::close()
+{
+    if (_base) _file.unmap(_base);
+    _base = nullptr;
+    if (_file.isOpen()) _file.close();
+    _count = 0;
+    _edges.clear();
+    _header = rec::FileHeader{};
+}
+
+void SnapshotRecordingReader::bands(int64_t i, float* outL, float* outR) const
+{
+    decodeBands(frameData(i) + sizeof(rec::FrameHeader), outL, outR, numBands(), quant(), frame(i).scale);
+}
+
+void SnapshotRecordingReader::bins16(int64_t i, float* out16) const
+{
+    const rec::FrameHeader& h = frame(i);
+    for (int k = 0; k < SpectrumFrame::kSrBins; ++k) out16[k] = h.bins16[k] / 255.0f;
+}
+
+QDateTime SnapshotRecordingReader::wallTime(int64_t i) const
+{
+    return QDateTime::fromMSecsSinceEpoch(_header.startWallMs + frame(i).timeNs / 1000000);
+}
+
+Snapshot SnapshotRecordingReader::snapshot(int64_t i) const
+{
+    const int n = numBands();
+    QVector<float> l(n), r(n);
+    bands(i, l.data(), r.data());
+    const rec::FrameHeader& h = frame(i);
+    Snapshot s(l, r, h.centroidL, h.centroidR, int(h.frameIndex));
+    s.timestamp = wallTime(i);
+    return s;
+}
+
+int64_t SnapshotRecordingReader::frameAtTime(int64_t timeNs) const
+{
+    // timestamps are monotonic, so binary search the mapping
+    int64_t lo = 0, hi = _count;
+    while (lo < hi) {
+        const int64_t mid = lo + (hi - lo) / 2;
+        if (frame(mid).timeNs <= timeNs) lo = mid + 1; else hi = mid;
+    }
+    return lo > 0 ? lo - 1 : 0;
+}
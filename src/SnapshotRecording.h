@@ -0,0 +1,144 @@
+#pragma once
+#include <QFile>
+#include <QString>
+#include <QDateTime>
+#include <cstdint>
+#include <vector>
+#include "Snapshot.h"
+#include "SpectrumFrame.h"
+
+// Append-only binary recording of processor frames ("show recordings").
+//
+// Layout (little-endian, as written by the host):
+//   FileHeader                      fixed 64 bytes
+//   float bandEdgesHz[numBands + 2] filterbank points: band b spans
+//                                   edges[b]..edges[b+2], centre edges[b+1]
+//   padding to headerBytes
+//   frames...                       each exactly frameBytes:
+//     FrameHeader, then bandsL[numBands], bandsR[numBands] as `quant`
+//
+// There is no frame count in the header: readers take
+// (fileSize - headerBytes) / frameBytes and ignore a partial tail, so a
+// recording cut short by a crash is still readable.
+//
+// Quantized bands are stored relative to the frame's own peak (FrameHeader::
+// scale): value = q / qMax * scale.
+namespace rec {
+
+enum class Quant : uint8_t { Float32 = 0, UInt16 = 1, UInt8 = 2 };
+
+static constexpr char     kMagic[4] = {'W', 'Q', 'S', 'R'};
+static constexpr uint16_t kVersion  = 1;
+
+#pragma pack(push, 1)
+struct FileHeader {
+    char     magic[4] = {'W', 'Q', 'S', 'R'};
+    uint16_t version = kVersion;
+    uint16_t headerBytes = 0;     // offset of the first frame
+    uint8_t  quant = 0;           // rec::Quant
+    uint8_t  reserved0[3]{};
+    uint32_t sampleRate = 0;
+    uint32_t fftSize = 0;
+    uint32_t hop = 0;
+    uint32_t numBands = 0;
+    uint32_t frameBytes = 0;
+    int64_t  startWallMs = 0;     // wall clock (ms since epoch) at timeNs == 0
+    uint8_t  reserved1[24]{};
+};
+static_assert(sizeof(FileHeader) == 64, "recording header must be 64 bytes");
+
+struct FrameHeader {
+    int64_t  timeNs = 0;          // since the recording started (steady clock)
+    uint32_t frameIndex = 0;
+    float    rmsL = 0.0f, rmsR = 0.0f;
+    float    centroidL = -1.0f, centroidR = -1.0f;
+    float    scale = 0.0f;        // peak of bandsL/R; dequantization scale
+    uint8_t  bins16[SpectrumFrame::kSrBins]{};  // what went to WLED, 0..255
+};
+static_assert(sizeof(FrameHeader) == 48, "recording frame header must be 48 bytes");
+#pragma pack(pop)
+
+int bytesPerValue(Quant q);
+const char* quantName(Quant q);
+
+} // namespace rec
+
+// What the analysis looked like when recording started.
+struct RecordingLayout {
+    int sampleRate = 0;
+    int fftSize = 0;
+    int hop = 0;
+    std::vector<float> bandEdgesHz;   // numBands + 2 points
+    int numBands() const { return bandEdgesHz.size() >= 2 ? int(bandEdgesHz.size()) - 2 : 0; }
+};
+
+// Writes frames to a recording file. Lives on the thread that calls addFrame.
+class SnapshotRecorder {
+public:
+    ~SnapshotRecorder() { close(); }
+
+    bool open(const QString& path, const RecordingLayout& layout, rec::Quant quant,
+              QString* error = nullptr);
+    void close();
+    bool isOpen() const { return _file.isOpen(); }
+
+    // False (and nothing written) if the frame's band count doesn't match the header.
+    bool addFrame(const SpectrumFramePtr& frame);
+
+    uint64_t framesWritten() const { return _frames; }
+    uint64_t bytesWritten() const { return _bytes; }
+    QString fileName() const { return _file.fileName(); }
+
+private:
+    QFile _file;
+    rec::FileHeader _header;
+    std::vector<char> _scratch;       // one encoded frame
+    int64_t  _startNs = 0;
+    uint64_t _frames = 0;
+    uint64_t _bytes = 0;
+};
+
+// Read-only, memory-mapped view of a recording. Nothing is loaded up front;
+// frame(i) is a pointer into the mapping, so scrubbing hours of data only
+// touches the pages that are looked at.
+class SnapshotRecordingReader {
+public:
+    ~SnapshotRecordingReader() { close(); }
+
+    bool open(const QString& path, QString* error = nullptr);
+    void close();
+    bool isOpen() const { return _base != nullptr; }
+
+    const rec::FileHeader& header() const { return _header; }
+    rec::Quant quant() const { return rec::Quant(_header.quant); }
+    int numBands() const { return int(_header.numBands); }
+    int sampleRate() const { return int(_header.sampleRate); }
+    double frameRate() const { return _header.hop ? double(_header.sampleRate) / _header.hop : 0.0; }
+    const std::vector<float>& bandEdgesHz() const { return _edges; }
+    QString fileName() const { return _file.fileName(); }
+
+    int64_t frameCount() const { return _count; }
+    const rec::FrameHeader& frame(int64_t i) const {
+        return *reinterpret_cast<const rec::FrameHeader*>(frameData(i));
+    }
+    // Dequantized bands of frame i (numBands() floats each).
+    void bands(int64_t i, float* outL, float* outR) const;
+    void bins16(int64_t i, float* out16) const;      // 0..1
+    QDateTime wallTime(int64_t i) const;
+    Snapshot snapshot(int64_t i) const;
+
+    // Last frame with timeNs <= t (0 if t is before the first frame).
+    int64_t frameAtTime(int64_t timeNs) const;
+    int64_t durationNs() const { return _count ? frame(_count - 1).timeNs : 0; }
+
+private:
+    const uchar* frameData(int64_t i) const {
+        return _base + _header.headerBytes + i * int64_t(_header.frameBytes);
+    }
+
+    QFile _file;
+    uchar* _base = nullptr;
+    rec::FileHeader _header;
+    std::vector<float> _edges;
+    int64_t _count = 0;
+};
@@ -0,0 +1,63 @@
+#include "SnapshotRing.h"
+#include <algorithm>
+#include <cstring>
+
+void SnapshotRing::reset(int capacity, int bands)
+{
+    _capacity = std::max(1, capacity);
+    _bands = std::max(1, bands);
+    _left.assign(size_t(_capacity) * _bands, 0.0f);
+    _right.assign(size_t(_capacity) * _bands, 0.0f);
+    _timeNs.assign(_capacity, 0);
+    _frameNumber.assign(_capacity, 0);
+    _centroidL.assign(_capacity, -1.0f);
+    _centroidR.assign(_capacity, -1.0f);
+    clear();
+    _pushed = 0;
+}
+
+void SnapshotRing::setCapacity(int capacity)
+{
+    capacity = std::max(1, capacity);
+    if (capacity == _capacity) return;
+
+    SnapshotRing next(capacity, _bands);
+    for (int i = std::max(0, _size - capacity); i < _size; ++i)
+        next.push(left(i), right(i), centroidL(i), centroidR(i), timeNs(i), frameNumber(i));
+    next._pushed = _pushed;
+    *this = std::move(next);
+}
+
+void SnapshotRing::push(const float* l, const float* r, float centroidL, float centroidR,
+                        int64_t timeNs, int frameNumber)
+{
+    if (_capacity == 0) return;
+
+    int s;
+    if (_size < _capacity) {
+        s = slot(_size);
+        ++_size;
+    } else {
+        s = _tail;                                  // overwrite the oldest
+        _tail = (_tail + 1 == _capacity) ? 0 : _tail + 1;
+    }
+
+    std::memcpy(_left.data() + size_t(s) * _bands, l, sizeof(float) * _bands);
+    std::memcpy(_right.data() + size_t(s) * _bands, r, sizeof(float) * _bands);
+    _timeNs[s] = timeNs;
+    _frameNumber[s] = frameNumber;
+    _centroidL[s] = centroidL;
+    _centroidR[s] = centroidR;
+    ++_pushed;
+}
+
+int SnapshotRing::evictOlderThan(int64_t cutoffNs)
+{
+    int n = 0;
+    while (_size > 0 && _timeNs[_tail] < cutoffNs) {
+        _tail = (_tail + 1 == _capacity) ? 0 : _tail + 1;
+        --_size;
+        ++n;
+    }
+    return n;
+}
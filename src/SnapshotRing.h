@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fixed-capacity history of band frames, stored struct-of-arrays: one
+// contiguous capacity x bands float block per channel plus parallel arrays
+// for timestamps, frame numbers and centroids. Push and evict are O(1) and
+// never allocate; memory is only touched again by setCapacity()/reset().
+//
+// Indexing is oldest-first: 0 is the oldest entry, size()-1 the newest.
+// When the ring is full a push overwrites the oldest entry.
+// Every push also gets a sequence number that never repeats (survives
+// eviction and setCapacity), so views can cache by sequence, not index.
+class SnapshotRing {
+public:
+    SnapshotRing() = default;
+    SnapshotRing(int capacity, int bands) { reset(capacity, bands); }
+
+    // (Re)allocate for `capacity` frames of `bands` values; drops all entries.
+    void reset(int capacity, int bands);
+    // Change capacity, keeping the newest entries that still fit.
+    void setCapacity(int capacity);
+    void clear() { _tail = 0; _size = 0; }   // sequence numbers keep counting
+
+    int  capacity() const { return _capacity; }
+    int  bands() const { return _bands; }
+    int  size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    bool full() const { return _size == _capacity; }
+
+    // Sequence number of entry 0; entry i is firstSequence() + i.
+    uint64_t firstSequence() const { return _pushed - uint64_t(_size); }
+    uint64_t endSequence() const { return _pushed; }   // one past the newest
+
+    // Copy one frame in. `left`/`right` hold bands() values each.
+    void push(const float* left, const float* right, float centroidL, float centroidR,
+              int64_t timeNs, int frameNumber);
+    // Drop entries stamped before cutoffNs (oldest first). Returns how many went.
+    int evictOlderThan(int64_t cutoffNs);
+
+    const float* left(int i) const  { return _left.data() + size_t(slot(i)) * _bands; }
+    const float* right(int i) const { return _right.data() + size_t(slot(i)) * _bands; }
+    int64_t timeNs(int i) const     { return _timeNs[slot(i)]; }
+    int     frameNumber(int i) const{ return _frameNumber[slot(i)]; }
+    float   centroidL(int i) const  { return _centroidL[slot(i)]; }
+    float   centroidR(int i) const  { return _centroidR[slot(i)]; }
+
+private:
+    int slot(int i) const { const int s = _tail + i; return s >= _capacity ? s - _capacity : s; }
+
+    std::vector<float>   _left, _right;   // capacity * bands each
+    std::vector<int64_t> _timeNs;         // steady clock (monotonicNs)
+    std::vector<int>     _frameNumber;
+    std::vector<float>   _centroidL, _centroidR;
+    int _capacity = 0;
+    int _bands = 0;
+    int _tail = 0;     // slot of the oldest entry
+    int _size = 0;
+    uint64_t _pushed = 0;   // total pushes since reset()
+};
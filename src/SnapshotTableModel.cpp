@@ -0,0 +1,85 @@
+#include "SnapshotTableModel.h"
+#include <algorithm>
+
+SnapshotTableModel::SnapshotTableModel(QObject* parent) : QAbstractTableModel(parent)
+{
+}
+
+int SnapshotTableModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : int(_left.size());
+}
+
+int SnapshotTableModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant SnapshotTableModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= int(_left.size())) return QVariant();
+    const int b = index.row();
+
+    if (role == Qt::TextAlignmentRole)
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+    if (role != Qt::DisplayRole) return QVariant();
+
+    switch (index.column()) {
+    case BandColumn:
+        return b;
+    case HzColumn:
+        if (_edgesHz.size() != _left.size() + 2) return QVariant();
+        return QString::number(_edgesHz[b + 1], 'f', 0);
+    case LeftColumn:
+        return _valid ? QString::number(_left[b], 'f', 4) : QString("-");
+    case RightColumn:
+        return _valid ? QString::number(_right[b], 'f', 4) : QString("-");
+    default:
+        return QVariant();
+    }
+}
+
+QVariant SnapshotTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal) return QVariant();
+    switch (section) {
+    case BandColumn:  return QString("Bin");
+    case HzColumn:    return QString("Hz");
+    case LeftColumn:  return QString("Left");
+    case RightColumn: return QString("Right");
+    default:          return QVariant();
+    }
+}
+
+void SnapshotTableModel::setBandEdges(const float* edgesHz, int count)
+{
+    _edgesHz.assign(edgesHz, edgesHz + std::max(0, count));
+    if (!_left.empty())
+        emit dataChanged(index(0, HzColumn), index(int(_left.size()) - 1, HzColumn));
+}
+
+void SnapshotTableModel::setFrame(const float* left, const float* right, int bands)
+{
+    bands = std::max(0, bands);
+    if (bands != int(_left.size())) {
+        beginResetModel();
+        _left.assign(left, left + bands);
+        _right.assign(right, right + bands);
+        _valid = true;
+        endResetModel();
+        return;
+    }
+    std::copy(left, left + bands, _left.begin());
+    std::copy(right, right + bands, _right.begin());
+    _valid = true;
+    if (bands > 0)
+        emit dataChanged(index(0, LeftColumn), index(bands - 1, RightColumn), {Qt::DisplayRole});
+}
+
+void SnapshotTableModel::clearFrame()
+{
+    if (!_valid) return;
+    _valid = false;
+    if (!_left.empty())
+        emit dataChanged(index(0, LeftColumn), index(int(_left.size()) - 1, RightColumn), {Qt::DisplayRole});
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <QAbstractTableModel>
+#include <vector>
+
+// Table view over one frame's bands: Band | Hz | Left | Right.
+// Values are kept as plain floats and formatted only when the view asks for a
+// visible cell, so moving between frames is a copy of 2 x bands floats plus
+// one dataChanged for the value columns (no per-cell items).
+class SnapshotTableModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    enum Column { BandColumn, HzColumn, LeftColumn, RightColumn, ColumnCount };
+
+    explicit SnapshotTableModel(QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    // Filterbank points (bands + 2); centre of band b is edges[b + 1].
+    // Ignored (Hz column blank) if the count doesn't match the frame.
+    void setBandEdges(const float* edgesHz, int count);
+
+    // Show one frame. Changing the band count resets the model, otherwise only
+    // the Left/Right columns are reported as changed.
+    void setFrame(const float* left, const float* right, int bands);
+    void clearFrame();
+
+private:
+    std::vector<float> _left, _right;
+    std::vector<float> _edgesHz;
+    bool _valid = false;
+};
@@ -1,6 +1,15 @@
 #include "SnapshotViewer.h"
+#include "SnapshotRecording.h"
+#include "SnapshotTableModel.h"
+#include "SpectrogramWidget.h"
+#include <algorithm>
+#include <cmath>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QTimer>
 #include <QHeaderView>
 #include <QDateTime>
+#include <QSignalBlocker>
 
 SnapshotViewer::SnapshotViewer(SnapshotManager* manager, QWidget* parent)
     : QWidget(parent), _manager(manager)
@@ -17,7 +26,23 @@ SnapshotViewer::SnapshotViewer(SnapshotManager* manager, QWidget* parent)
             _manager, &SnapshotManager::setBufferDuration);
     connect(_clearButton, &QPushButton::clicked, 
             _manager, &SnapshotManager::clear);
+    connect(_logRateSpin, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, [this](int hz) { _manager->setLogRate(hz); });
+    connect(_clearButton, &QPushButton::clicked,
+            _spectrogram, &SpectrogramWidget::invalidate);   // sequence numbers survive a clear
+    connect(_openRecordingButton, &QPushButton::clicked,
+            this, &SnapshotViewer::onOpenRecordingClicked);
+    connect(_closeRecordingButton, &QPushButton::clicked,
+            this, &SnapshotViewer::closeRecording);
+    connect(_replayButton, &QPushButton::clicked,
+            this, &SnapshotViewer::toggleReplay);
+
+    _replayTimer = new QTimer(this);
+    _replayTimer->setTimerType(Qt::PreciseTimer);
+    _replayTimer->setInterval(10);
+    connect(_replayTimer, &QTimer::timeout, this, &SnapshotViewer::onReplayTick);
     
+    attachLiveSource();
     updateControls();
 }
 
@@ -36,9 +61,29 @@ void SnapshotViewer::setupUI()
     _bufferDurationSpin->setSuffix(" seconds");
     controlsLayout->addWidget(_bufferDurationSpin);
     
+    controlsLayout->addWidget(new QLabel("Log rate:"));
+    _logRateSpin = new QSpinBox();
+    _logRateSpin->setRange(0, 200);
+    _logRateSpin->setValue(int(std::lround(_manager->logRate())));
+    _logRateSpin->setSpecialValueText("every frame");
+    _logRateSpin->setSuffix(" Hz");
+    controlsLayout->addWidget(_logRateSpin);
+    
     _clearButton = new QPushButton("Clear Buffer");
     controlsLayout->addWidget(_clearButton);
     controlsLayout->addStretch();
+
+    // Recordings: open a file to scrub it instead of the live buffer
+    _openRecordingButton = new QPushButton("Open Recording...");
+    _closeRecordingButton = new QPushButton("Back to Live");
+    _replayButton = new QPushButton("Replay to WLED");
+    _closeRecordingButton->setEnabled(false);
+    _replayButton->setEnabled(false);
+    _sourceLabel = new QLabel("Source: live");
+    controlsLayout->addWidget(_sourceLabel);
+    controlsLayout->addWidget(_openRecordingButton);
+    controlsLayout->addWidget(_closeRecordingButton);
+    controlsLayout->addWidget(_replayButton);
     
     // Frame navigation
     auto* navGroup = new QGroupBox("Frame Navigation");
@@ -57,49 +102,189 @@ void SnapshotViewer::setupUI()
     infoLayout->addStretch();
     navLayout->addLayout(infoLayout);
     
-    // Tables for bar values
+    // Band values (model view, only visible rows are formatted) + waterfall
     auto* tablesLayout = new QHBoxLayout();
     
-    auto* leftGroup = new QGroupBox("Left Channel");
-    auto* leftLayout = new QVBoxLayout(leftGroup);
-    _leftTable = new QTableWidget(32, 2);
-    _leftTable->setHorizontalHeaderLabels({"Bin", "Value"});
-    _leftTable->horizontalHeader()->setStretchLastSection(true);
-    _leftTable->setMaximumWidth(200);
-    leftLayout->addWidget(_leftTable);
-    
-    auto* rightGroup = new QGroupBox("Right Channel");
-    auto* rightLayout = new QVBoxLayout(rightGroup);
-    _rightTable = new QTableWidget(32, 2);
-    _rightTable->setHorizontalHeaderLabels({"Bin", "Value"});
-    _rightTable->horizontalHeader()->setStretchLastSection(true);
-    _rightTable->setMaximumWidth(200);
-    rightLayout->addWidget(_rightTable);
-    
-    tablesLayout->addWidget(leftGroup);
-    tablesLayout->addWidget(rightGroup);
-    tablesLayout->addStretch();
+    auto* valuesGroup = new QGroupBox("Bands (L / R)");
+    auto* valuesLayout = new QVBoxLayout(valuesGroup);
+    _model = new SnapshotTableModel(this);
+    _table = new QTableView();
+    _table->setModel(_model);
+    _table->verticalHeader()->hide();
+    _table->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    _table->horizontalHeader()->setStretchLastSection(true);
+    _table->setSelectionMode(QAbstractItemView::NoSelection);
+    _table->setMaximumWidth(320);
+    valuesLayout->addWidget(_table);
+    
+    auto* waterfallGroup = new QGroupBox("Spectrogram (top: left, bottom: right)");
+    auto* waterfallLayout = new QVBoxLayout(waterfallGroup);
+    _spectrogram = new SpectrogramWidget();
+    waterfallLayout->addWidget(_spectrogram);
+    
+    tablesLayout->addWidget(valuesGroup);
+    tablesLayout->addWidget(waterfallGroup, 1);
     
     // Add all sections to main layout
     layout->addWidget(controlsGroup);
     layout->addWidget(navGroup);
-    layout->addLayout(tablesLayout);
+    layout->addLayout(tablesLayout, 1);
+}
+
+// Spectrogram columns come straight from the ring, keyed by sequence number
+void SnapshotViewer::attachLiveSource()
+{
+    const SnapshotManager* manager = _manager;
+    const int bands = _manager->ring().bands();
+    _spectrogram->setSource(bands, [manager, bands](int64_t seq, float* l, float* r) {
+        const SnapshotRing& ring = manager->ring();
+        const int64_t i = seq - int64_t(ring.firstSequence());
+        if (ring.bands() != bands || i < 0 || i >= ring.size()) return false;   // reshaped; reattached on next change
+        std::copy(ring.left(int(i)), ring.left(int(i)) + ring.bands(), l);
+        std::copy(ring.right(int(i)), ring.right(int(i)) + ring.bands(), r);
+        return true;
+    });
+    _liveEdges = _manager->bandEdgesHz();
+    _model->setBandEdges(_liveEdges.constData(), int(_liveEdges.size()));
+}
+
+void SnapshotViewer::attachRecordingSource()
+{
+    const SnapshotRecordingReader* reader = _recording;
+    _spectrogram->setSource(reader->numBands(), [reader](int64_t seq, float* l, float* r) {
+        if (seq < 0 || seq >= reader->frameCount()) return false;
+        reader->bands(seq, l, r);
+        return true;
+    });
+    _scratchL.assign(reader->numBands(), 0.0f);
+    _scratchR.assign(reader->numBands(), 0.0f);
+    const std::vector<float>& edges = reader->bandEdgesHz();
+    _model->setBandEdges(edges.data(), int(edges.size()));
+}
+
+SnapshotViewer::~SnapshotViewer()
+{
+    stopReplay();
+    delete _recording;
+}
+
+int SnapshotViewer::frameCount() const
+{
+    return _recording ? int(_recording->frameCount()) : _manager->count();
+}
+
+void SnapshotViewer::onOpenRecordingClicked()
+{
+    const QString path = QFileDialog::getOpenFileName(this, "Open recording", QString(),
+                                                      "Recordings (*.wqsr);;All files (*)");
+    if (path.isEmpty()) return;
+    QString error;
+    if (!openRecording(path, &error))
+        _sourceLabel->setText("Open failed: " + error);
+}
+
+bool SnapshotViewer::openRecording(const QString& path, QString* error)
+{
+    auto* reader = new SnapshotRecordingReader;
+    if (!reader->open(path, error)) {
+        delete reader;
+        return false;
+    }
+    stopReplay();
+    delete _recording;
+    _recording = reader;
+    attachRecordingSource();
+
+    const double seconds = _recording->durationNs() * 1e-9;
+    _sourceLabel->setText(QString("Source: %1 (%2 frames, %3 s, %4 bands, %5)")
+        .arg(QFileInfo(path).fileName()).arg(_recording->frameCount())
+        .arg(seconds, 0, 'f', 1).arg(_recording->numBands())
+        .arg(rec::quantName(_recording->quant())));
+    _closeRecordingButton->setEnabled(true);
+    _replayButton->setEnabled(_recording->frameCount() > 0);
+    _bufferDurationSpin->setEnabled(false);
+    _clearButton->setEnabled(false);
+
+    updateControls();
+    {
+        QSignalBlocker block(_frameSlider);
+        _frameSlider->setValue(0);   // recordings start at the beginning
+    }
+    updateView();
+    return true;
+}
+
+void SnapshotViewer::closeRecording()
+{
+    stopReplay();
+    delete _recording;
+    _recording = nullptr;
+    attachLiveSource();
+    _sourceLabel->setText("Source: live");
+    _closeRecordingButton->setEnabled(false);
+    _replayButton->setEnabled(false);
+    _bufferDurationSpin->setEnabled(true);
+    _clearButton->setEnabled(true);
+    onSnapshotsChanged();
+}
+
+// --- replay ---
+
+void SnapshotViewer::toggleReplay()
+{
+    if (_replayTimer->isActive()) { stopReplay(); return; }
+    if (!_recording || _recording->frameCount() == 0) return;
+
+    int start = _frameSlider->value();
+    if (start >= frameCount() - 1) start = 0;   // at the end: start over
+    _replayStartNs = _recording->frame(start).timeNs;
+    _replayClock.start();
+    _replayBuf.resize(SpectrumFrame::kSrBins);
+    _replayTimer->start();
+    _replayButton->setText("Stop Replay");
+    emit replayActiveChanged(true);
+}
+
+void SnapshotViewer::stopReplay()
+{
+    if (!_replayTimer || !_replayTimer->isActive()) return;
+    _replayTimer->stop();
+    _replayButton->setText("Replay to WLED");
+    emit replayActiveChanged(false);
+}
+
+void SnapshotViewer::onReplayTick()
+{
+    // Follow the recording's own timestamps, so replay runs at the original pace
+    const int64_t t = _replayStartNs + _replayClock.nsecsElapsed();
+    if (t > _recording->durationNs()) { stopReplay(); return; }
+
+    const int64_t i = _recording->frameAtTime(t);
+    _recording->bins16(i, _replayBuf.data());
+    emit replayBins(_replayBuf);
+    _frameSlider->setValue(int(i));
 }
 
 void SnapshotViewer::onSnapshotsChanged()
 {
+    if (_recording) return;   // live updates don't move a recording's view
+    // Band count or analysis changed underneath: new waterfall / Hz column
+    if (_manager->ring().bands() != _spectrogram->bands() || _manager->bandEdgesHz() != _liveEdges)
+        attachLiveSource();
     updateControls();
     updateView();
 }
 
 void SnapshotViewer::updateControls()
 {
-    const auto& snapshots = _manager->getSnapshots();
+    const int count = frameCount();
     
-    _frameSlider->setEnabled(!snapshots.isEmpty());
-    if (!snapshots.isEmpty()) {
-        _frameSlider->setRange(0, snapshots.size() - 1);
-        _frameSlider->setValue(snapshots.size() - 1);  // default to latest
+    _frameSlider->setEnabled(count > 0);
+    if (count > 0) {
+        // one valueChanged -> updateView per refresh, not two
+        QSignalBlocker block(_frameSlider);
+        _frameSlider->setRange(0, count - 1);
+        _frameSlider->setValue(count - 1);  // default to latest
     }
 }
 
@@ -110,38 +295,52 @@ void SnapshotViewer::onSliderChanged(int value)
 
 void SnapshotViewer::updateView()
 {
-    const auto& snapshots = _manager->getSnapshots();
-    if (snapshots.isEmpty() || _frameSlider->value() >= snapshots.size()) {
+    const int count = frameCount();
+    if (count == 0 || _frameSlider->value() >= count) {
         _frameLabel->setText("Frame: -");
         _timestampLabel->setText("Time: -");
         _centroidLabel->setText("Centroids: L=- R=-");
+        _model->clearFrame();
         return;
     }
     
-    const auto& snapshot = snapshots[_frameSlider->value()];
-    displaySnapshot(snapshot);
+    showFrame(_frameSlider->value());
 }
 
-void SnapshotViewer::displaySnapshot(const Snapshot& snapshot)
+// O(bands) for the labels and table, O(frames moved) for the waterfall
+void SnapshotViewer::showFrame(int i)
 {
-    _frameLabel->setText(QString("Frame: %1").arg(snapshot.frameNumber));
-    _timestampLabel->setText(QString("Time: %1").arg(
-        snapshot.timestamp.toString("hh:mm:ss.zzz")));
+    int frameNumber = 0;
+    float centL = -1.0f, centR = -1.0f;
+    QDateTime when;
+    int64_t seq = 0;
+
+    if (_recording) {
+        const rec::FrameHeader& h = _recording->frame(i);
+        frameNumber = int(h.frameIndex);
+        centL = h.centroidL;
+        centR = h.centroidR;
+        when = _recording->wallTime(i);
+        _recording->bands(i, _scratchL.data(), _scratchR.data());
+        _model->setFrame(_scratchL.data(), _scratchR.data(), _recording->numBands());
+        seq = i;
+    } else {
+        const SnapshotRing& ring = _manager->ring();
+        frameNumber = ring.frameNumber(i);
+        centL = ring.centroidL(i);
+        centR = ring.centroidR(i);
+        when = _manager->wallTime(i);
+        _model->setFrame(ring.left(i), ring.right(i), ring.bands());
+        seq = int64_t(ring.firstSequence()) + i;
+    }
+
+    _frameLabel->setText(QString("Frame: %1").arg(frameNumber));
+    _timestampLabel->setText(QString("Time: %1").arg(when.toString("hh:mm:ss.zzz")));
     
     QString centroidText = QString("Centroids: L=%1 R=%2")
-        .arg(snapshot.leftCentroid >= 0 ? QString::number(snapshot.leftCentroid, 'f', 2) : "-")
-        .arg(snapshot.rightCentroid >= 0 ? QString::number(snapshot.rightCentroid, 'f', 2) : "-");
+        .arg(centL >= 0 ? QString::number(centL, 'f', 2) : "-")
+        .arg(centR >= 0 ? QString::number(centR, 'f', 2) : "-");
     _centroidLabel->setText(centroidText);
-    
-    for (int i = 0; i < snapshot.leftBars.size() && i < 32; ++i) {
-        _leftTable->setItem(i, 0, new QTableWidgetItem(QString::number(i)));
-        _leftTable->setItem(i, 1, new QTableWidgetItem(
-            QString::number(snapshot.leftBars[i], 'f', 4)));
-    }
-    
-    for (int i = 0; i < snapshot.rightBars.size() && i < 32; ++i) {
-        _rightTable->setItem(i, 0, new QTableWidgetItem(QString::number(i)));
-        _rightTable->setItem(i, 1, new QTableWidgetItem(
-            QString::number(snapshot.rightBars[i], 'f', 4)));
-    }
-}
\ No newline at end of file
+
+    _spectrogram->showUpTo(seq);
+}
@@ -4,23 +4,42 @@
 #include <QHBoxLayout>
 #include <QSlider>
 #include <QLabel>
-#include <QTableWidget>
+#include <QTableView>
 #include <QPushButton>
 #include <QSpinBox>
 #include <QGroupBox>
+#include <QElapsedTimer>
 #include "Snapshot.h"
 #include "SnapshotManager.h"
 
+class QTimer;
+class SnapshotRecordingReader;
+class SnapshotTableModel;
+class SpectrogramWidget;
+
 class SnapshotViewer : public QWidget {
     Q_OBJECT
     
 public:
     explicit SnapshotViewer(SnapshotManager* manager, QWidget* parent = nullptr);
+    ~SnapshotViewer() override;
+
+    // Recording on disk (memory-mapped) instead of the live buffer
+    bool openRecording(const QString& path, QString* error = nullptr);
+    bool hasRecording() const { return _recording != nullptr; }
     
 public slots:
     void updateView();
     void onSliderChanged(int value);
     void onSnapshotsChanged();
+    void closeRecording();
+    void toggleReplay();
+    
+signals:
+    // Replay of an open recording at its own frame rate: bins16 (0..1) per frame.
+    // Emitted on the GUI thread; connect DirectConnection to UdpSrSender::submitReplayBins.
+    void replayBins(const QVector<float>& bins16);
+    void replayActiveChanged(bool active);
     
 private:
     SnapshotManager* _manager;
@@ -28,12 +47,33 @@ private:
     QLabel* _frameLabel;
     QLabel* _timestampLabel;
     QLabel* _centroidLabel;
-    QTableWidget* _leftTable;
-    QTableWidget* _rightTable;
+    QTableView* _table;
+    SnapshotTableModel* _model;
+    SpectrogramWidget* _spectrogram;
+    QVector<float> _liveEdges;          // band edges last given to the model (live)
+    std::vector<float> _scratchL, _scratchR;   // decoded recording bands
     QSpinBox* _bufferDurationSpin;
     QPushButton* _clearButton;
+    QSpinBox* _logRateSpin;
+    QPushButton* _openRecordingButton;
+    QPushButton* _closeRecordingButton;
+    QPushButton* _replayButton;
+    QLabel* _sourceLabel;
+
+    SnapshotRecordingReader* _recording = nullptr;
+    QTimer* _replayTimer = nullptr;
+    QElapsedTimer _replayClock;
+    int64_t _replayStartNs = 0;
+    QVector<float> _replayBuf;
+    
+    int frameCount() const;
+    void attachLiveSource();
+    void attachRecordingSource();
+    void onOpenRecordingClicked();
+    void onReplayTick();
+    void stopReplay();
     
     void setupUI();
-    void displaySnapshot(const Snapshot& snapshot);
+    void showFrame(int i);
     void updateControls();
 };
\ No newline at end of file
@@ -0,0 +1,165 @@
+// SpectrogramWidget.cpp
+#include "SpectrogramWidget.h"
+#include <QPainter>
+#include <QResizeEvent>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Dark blue -> purple -> orange -> pale yellow, 256 steps
+void buildLut(QRgb* lut)
+{
+  struct Stop { float t; int r, g, b; };
+  static constexpr Stop stops[] = {
+    {0.00f,   0,   0,   8}, {0.25f,  40,  10, 100}, {0.50f, 150,  30, 110},
+    {0.75f, 240, 110,  30}, {1.00f, 255, 250, 180},
+  };
+  for (int i = 0; i < 256; ++i) {
+    const float t = i / 255.0f;
+    int s = 0;
+    while (s < 3 && t > stops[s + 1].t) ++s;
+    const Stop& a = stops[s];
+    const Stop& b = stops[s + 1];
+    const float u = (t - a.t) / (b.t - a.t);
+    lut[i] = qRgb(int(a.r + u * (b.r - a.r)), int(a.g + u * (b.g - a.g)), int(a.b + u * (b.b - a.b)));
+  }
+}
+}
+
+SpectrogramWidget::SpectrogramWidget(QWidget* parent)
+  : QWidget(parent)
+{
+  setMinimumSize(200, 120);
+  setAttribute(Qt::WA_OpaquePaintEvent);
+  buildLut(_lut);
+}
+
+QSize SpectrogramWidget::sizeHint() const {
+  return { 640, 200 };
+}
+
+void SpectrogramWidget::setSource(int bands, ColumnSource source)
+{
+  _bands = std::max(0, bands);
+  _source = std::move(source);
+  _colL.assign(_bands, 0.0f);
+  _colR.assign(_bands, 0.0f);
+  _img = QImage();
+  _valid = false;
+  update();
+}
+
+void SpectrogramWidget::setDbRange(float minDb, float maxDb)
+{
+  if (!(maxDb > minDb)) return;
+  _minDb = minDb;
+  _maxDb = maxDb;
+  invalidate();
+}
+
+void SpectrogramWidget::invalidate()
+{
+  _valid = false;
+  showUpTo(_last);
+}
+
+void SpectrogramWidget::resizeEvent(QResizeEvent* ev)
+{
+  QWidget::resizeEvent(ev);
+  if (ev->size().width() != _img.width()) {
+    _img = QImage();
+    _valid = false;
+    showUpTo(_last);
+  }
+}
+
+void SpectrogramWidget::showEvent(QShowEvent* ev)
+{
+  QWidget::showEvent(ev);
+  if (!_valid) showUpTo(_last);   // updates while hidden were only recorded
+}
+
+int SpectrogramWidget::columnOf(int64_t seq) const
+{
+  const int64_t w = _img.width();
+  return int(((seq % w) + w) % w);
+}
+
+void SpectrogramWidget::ensureImage()
+{
+  const int w = std::max(1, width());
+  const int h = 2 * _bands + 1;
+  if (_img.width() != w || _img.height() != h) {
+    _img = QImage(w, h, QImage::Format_RGB32);
+    _img.fill(_lut[0]);
+    _valid = false;
+  }
+}
+
+void SpectrogramWidget::renderColumn(int64_t seq)
+{
+  QRgb* px = reinterpret_cast<QRgb*>(_img.bits());
+  const int stride = _img.bytesPerLine() / int(sizeof(QRgb));
+  const int x = columnOf(seq);
+
+  if (!_source || seq < 0 || !_source(seq, _colL.data(), _colR.data())) {
+    for (int y = 0; y < _img.height(); ++y) px[y * stride + x] = _lut[0];
+    return;
+  }
+
+  const float k = 255.0f / (_maxDb - _minDb);
+  auto colour = [&](float v) {
+    const float db = 20.0f * std::log10(std::max(v, 1e-9f));
+    return _lut[std::clamp(int((db - _minDb) * k), 0, 255)];
+  };
+  const int n = _bands;
+  for (int b = 0; b < n; ++b) {
+    px[(n - 1 - b) * stride + x] = colour(_colL[b]);     // left: top half
+    px[(2 * n - b) * stride + x] = colour(_colR[b]);     // right: bottom half
+  }
+  px[n * stride + x] = qRgb(60, 60, 60);                 // separator row
+}
+
+void SpectrogramWidget::renderRange(int64_t first, int64_t last)
+{
+  for (int64_t s = first; s <= last; ++s) renderColumn(s);
+}
+
+void SpectrogramWidget::showUpTo(int64_t seq)
+{
+  if (_bands <= 0 || !isVisible()) { _last = seq; _valid = false; return; }
+  ensureImage();
+
+  const int64_t w = _img.width();
+  const int64_t d = seq - _last;
+  if (!_valid || d >= w || d <= -w) {
+    renderRange(seq - w + 1, seq);               // everything visible
+  } else if (d > 0) {
+    renderRange(_last + 1, seq);                 // newer columns scroll in on the right
+  } else if (d < 0) {
+    renderRange(seq - w + 1, _last - w);         // older columns come back on the left
+  }
+  _last = seq;
+  _valid = true;
+  update();
+}
+
+void SpectrogramWidget::paintEvent(QPaintEvent*)
+{
+  QPainter p(this);
+  if (_img.isNull() || !_valid) {
+    p.fillRect(rect(), QColor(_lut[0]));
+    return;
+  }
+
+  // Oldest visible column sits at the ring position after the newest
+  const int w = _img.width();
+  const int h = _img.height();
+  const int c0 = columnOf(_last + 1);
+  const int tail = w - c0;                       // columns c0..w-1 go first
+  const qreal sy = qreal(height()) / h;
+  const qreal sx = qreal(width()) / w;
+  p.drawImage(QRectF(0, 0, tail * sx, h * sy), _img, QRectF(c0, 0, tail, h));
+  if (c0 > 0)
+    p.drawImage(QRectF(tail * sx, 0, c0 * sx, h * sy), _img, QRectF(0, 0, c0, h));
+}
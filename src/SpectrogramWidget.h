@@ -0,0 +1,57 @@
+#pragma once
+#include <QWidget>
+#include <QImage>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Scrolling waterfall of band history: one image column per frame, newest at
+// the right, left channel on top and right below (low bands at the bottom of
+// each half).
+//
+// Columns live in a ring inside the image keyed by frame sequence number
+// (column = seq mod width), so moving the view by d frames renders only d new
+// columns and painting is two blits. A full redraw costs O(visible columns).
+class SpectrogramWidget : public QWidget {
+  Q_OBJECT
+public:
+  // Fill left/right (bands values each) for frame `seq`; false if there is no such frame.
+  using ColumnSource = std::function<bool(int64_t seq, float* left, float* right)>;
+
+  explicit SpectrogramWidget(QWidget* parent = nullptr);
+
+  QSize sizeHint() const override;
+
+  // New data source / band count; drops everything rendered so far.
+  void setSource(int bands, ColumnSource source);
+  int bands() const { return _bands; }
+
+  // Colour range in dB of the raw band magnitude (default 0..50 dB).
+  void setDbRange(float minDb, float maxDb);
+
+public slots:
+  // Make `seq` the rightmost column.
+  void showUpTo(int64_t seq);
+  // The frames behind already-rendered sequence numbers changed.
+  void invalidate();
+
+protected:
+  void paintEvent(QPaintEvent* ev) override;
+  void resizeEvent(QResizeEvent* ev) override;
+  void showEvent(QShowEvent* ev) override;
+
+private:
+  int columnOf(int64_t seq) const;
+  void ensureImage();
+  void renderColumn(int64_t seq);
+  void renderRange(int64_t first, int64_t last);
+
+  QImage _img;                     // width() x (2 * bands + 1), RGB32
+  int _bands = 0;
+  ColumnSource _source;
+  int64_t _last = 0;               // rightmost sequence currently rendered
+  bool _valid = false;             // image matches _last
+  float _minDb = 0.0f, _maxDb = 50.0f;
+  std::vector<float> _colL, _colR;
+  QRgb _lut[256];
+};
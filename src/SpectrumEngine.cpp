@@ -0,0 +1,119 @@
+#include "SpectrumEngine.h"
+#include "DspKernels.h"
+#include <cmath>
+#include <numeric>
+
+SpectrumEngine::~SpectrumEngine() {
+  clear();
+}
+
+void SpectrumEngine::clear() {
+  for (Resolution* r : _res) delete r;
+  _res.clear();
+}
+
+void SpectrumEngine::setSampleRate(int sr) {
+  _sampleRate = sr;
+  for (Resolution* r : _res) r->out.mags.configure(r->N / 2 + 1, float(sr) / float(r->N));
+}
+
+void SpectrumEngine::invalidate() {
+  for (Resolution* r : _res) r->out.position = -1;
+}
+
+int SpectrumEngine::addResolution(int N) {
+  if (N < 2 || (N & 1)) return -1;
+  for (int i = 0; i < int(_res.size()); ++i)
+    if (_res[i]->N == N) return i;
+
+  auto* r = new Resolution;
+  r->N = N;
+  r->real = fft::makeReal(N);
+  r->cplx = fft::makeComplex(N);
+  if (!r->real || !r->cplx) {
+    delete r;
+    return -1;
+  }
+
+  // Hann window
+  r->window.resize(N);
+  for (int n = 0; n < N; ++n)
+    r->window[n] = 0.5f * (1.0f - std::cos(2.0f * float(M_PI) * n / (N - 1)));
+
+  r->packedIn.assign(N, fft::Complex{0, 0});
+  r->packedOut.assign(N, fft::Complex{0, 0});
+
+  Spectrum& s = r->out;
+  s.N = N;
+  s.frameL.assign(N, 0.0f);
+  s.frameR.assign(N, 0.0f);
+  s.specL.assign(N/2 + 1, fft::Complex{0, 0});
+  s.specR.assign(N/2 + 1, fft::Complex{0, 0});
+  s.magL.assign(N/2 + 1, 0.0f);
+  s.magR.assign(N/2 + 1, 0.0f);
+  s.mags.configure(N/2 + 1, float(_sampleRate) / float(N));
+
+  _res.push_back(r);
+  return int(_res.size()) - 1;
+}
+
+const SpectrumEngine::Spectrum& SpectrumEngine::compute(int handle, const float* srcL,
+                                                        const float* srcR, int64_t position) {
+  Resolution& r = *_res[handle];
+  if (r.out.position == position) return r.out;   // already transformed this hop
+
+  loadFrame(srcL, r.window, r.out.frameL);
+  loadFrame(srcR, r.window, r.out.frameR);
+
+  if (_packed) transformPacked(r);
+  else         transformReal(r);
+
+  computeMagnitudes(r.out.specL, r.out.magL);
+  computeMagnitudes(r.out.specR, r.out.magR);
+  r.out.mags.update(r.out.magL.data(), r.out.magR.data());
+  r.out.position = position;
+  return r.out;
+}
+
+void SpectrumEngine::loadFrame(const float* src, const std::vector<float>& window,
+                               std::vector<float>& frame) {
+  // Simple DC removal: subtract the mean, fused with the window multiply
+  const int N = int(frame.size());
+  const float mean = std::accumulate(src, src + N, 0.0f) / float(N);
+  for (int i = 0; i < N; ++i) {
+    frame[i] = (src[i] - mean) * window[i];
+  }
+}
+
+void SpectrumEngine::transformReal(Resolution& r) {
+  r.real->forward(r.out.frameL.data(), r.out.specL.data());
+  r.real->forward(r.out.frameR.data(), r.out.specR.data());
+}
+
+void SpectrumEngine::transformPacked(Resolution& r) {
+  const int N = r.N;
+  const float* l = r.out.frameL.data();
+  const float* rr = r.out.frameR.data();
+  fft::Complex* in = r.packedIn.data();
+  for (int n = 0; n < N; ++n) { in[n].r = l[n]; in[n].i = rr[n]; }
+
+  r.cplx->forward(in, r.packedOut.data());
+
+  // Split: X_L[k] = (Z[k] + conj(Z[N-k])) / 2,  X_R[k] = (Z[k] - conj(Z[N-k])) / 2j
+  const fft::Complex* Z = r.packedOut.data();
+  fft::Complex* XL = r.out.specL.data();
+  fft::Complex* XR = r.out.specR.data();
+  for (int k = 0; k <= N/2; ++k) {
+    const fft::Complex a = Z[k];
+    const fft::Complex b = Z[k == 0 ? 0 : N - k];
+    XL[k].r = 0.5f * (a.r + b.r);
+    XL[k].i = 0.5f * (a.i - b.i);
+    XR[k].r = 0.5f * (a.i + b.i);
+    XR[k].i = 0.5f * (b.r - a.r);
+  }
+}
+
+void SpectrumEngine::computeMagnitudes(const std::vector<fft::Complex>& spec, std::vector<float>& mag) {
+  // Plain sqrt(re^2 + im^2): audio never gets near hypot's overflow range
+  dsp::kernels().magnitude(mag.data(), reinterpret_cast<const float*>(spec.data()), int(spec.size()));
+}
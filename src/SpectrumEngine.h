@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "FftBackend.h"
+#include "MagnitudeCache.h"
+
+// Shared multi-resolution FFT engine.
+//
+// Owns one plan, one window and one set of frame/spectrum buffers per FFT size.
+// Every analysis stage asks the engine for "the spectrum of size N ending at
+// sample position P"; the result is computed once and cached, so several
+// consumers of the same resolution (bands, chroma, onsets, features) share one
+// transform, one magnitude pass and one MagnitudeCache (mono magnitude, power,
+// log and prefix sums).
+//
+// In packed-stereo mode L and R go through a single complex FFT of
+// z[n] = l[n] + j*r[n] and are split afterwards using conjugate symmetry.
+// An N-point complex FFT costs about as much as two N-point real ones, so
+// this is not a 2x saving on the transform: it saves a plan and a pass over
+// the data.
+class SpectrumEngine {
+public:
+  struct Spectrum {
+    int N = 0;
+    std::vector<float> frameL, frameR;        // mean-removed, windowed input (N)
+    std::vector<fft::Complex> specL, specR;   // one-sided spectra (N/2+1)
+    std::vector<float> magL, magR;            // |X[k]| (N/2+1)
+    MagnitudeCache mags;                      // derived from magL/magR on every compute
+    int64_t position = -1;                    // sample index the frame ends at (-1 = never computed)
+  };
+
+  SpectrumEngine() = default;
+  ~SpectrumEngine();
+  SpectrumEngine(const SpectrumEngine&) = delete;
+  SpectrumEngine& operator=(const SpectrumEngine&) = delete;
+
+  // Packed complex FFT on L+jR (default) or two real FFTs.
+  void setPackedStereo(bool on) { _packed = on; }
+  bool packedStereo() const { return _packed; }
+
+  // Only used to label the caches' bins in Hz (default 48000)
+  void setSampleRate(int sr);
+
+  // Register an FFT size; returns a handle (re-registering a size returns the same handle).
+  // Allocates plans and buffers; returns -1 if the plan could not be created.
+  int addResolution(int N);
+  int resolutionCount() const { return int(_res.size()); }
+
+  // Free all plans and buffers.
+  void clear();
+
+  // Forget cached results (e.g. after the input stream restarts).
+  void invalidate();
+
+  // Transform the N samples at srcL/srcR (the frame ending at `position`).
+  // If that resolution was already computed for `position` the cached result is returned.
+  const Spectrum& compute(int handle, const float* srcL, const float* srcR, int64_t position);
+
+  // Last computed result for a resolution.
+  const Spectrum& spectrum(int handle) const { return _res[handle]->out; }
+
+private:
+  struct Resolution {
+    int N = 0;
+    std::unique_ptr<fft::RealFft> real;       // two-real-FFT path
+    std::unique_ptr<fft::ComplexFft> cplx;    // packed stereo path
+    std::vector<float> window;                // Hann (N)
+    std::vector<fft::Complex> packedIn;       // l + j*r (N)
+    std::vector<fft::Complex> packedOut;      // Z[k] (N)
+    Spectrum out;
+  };
+
+  static void loadFrame(const float* src, const std::vector<float>& window, std::vector<float>& frame);
+  static void computeMagnitudes(const std::vector<fft::Complex>& spec, std::vector<float>& mag);
+  void transformPacked(Resolution& r);
+  void transformReal(Resolution& r);
+
+  std::vector<Resolution*> _res;
+  bool _packed = true;
+  int _sampleRate = 48000;
+};
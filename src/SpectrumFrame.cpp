@@ -0,0 +1,38 @@
+#include "SpectrumFrame.h"
+#include <algorithm>
+
+SpectrumFramePool* SpectrumFramePool::create(int capacity) {
+  return new SpectrumFramePool(capacity);
+}
+
+SpectrumFramePool::SpectrumFramePool(int capacity)
+  : _frames(new SpectrumFrame[std::max(1, capacity)]), _capacity(std::max(1, capacity)) {
+  for (int i = 0; i < _capacity; ++i) _frames[i]._pool = this;
+}
+
+SpectrumFramePool::~SpectrumFramePool() {
+  delete[] _frames;
+}
+
+void SpectrumFramePool::close() {
+  unhold();
+}
+
+void SpectrumFramePool::unhold() {
+  if (_holds.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+}
+
+// Single producer: only the owning DSP thread calls acquire().
+SpectrumFramePtr SpectrumFramePool::acquire() {
+  for (int n = 0; n < _capacity; ++n) {
+    SpectrumFrame& f = _frames[_next];
+    _next = (_next + 1) % _capacity;
+    int expected = 0;
+    if (f._refs.compare_exchange_strong(expected, 1, std::memory_order_acquire)) {
+      _holds.fetch_add(1, std::memory_order_relaxed);
+      return SpectrumFramePtr(&f);
+    }
+  }
+  _exhausted.fetch_add(1, std::memory_order_relaxed);
+  return {};
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <QMetaType>
+#include <atomic>
+#include <cstdint>
+
+class SpectrumFramePool;
+
+// One hop's worth of analysis output, shared by every consumer.
+//
+// Frames come from a fixed SpectrumFramePool and are handed around through
+// SpectrumFramePtr, an intrusive ref-counted handle. Copying a handle is one
+// atomic increment; when the last handle goes away the frame simply becomes
+// free again in its pool. Nothing is allocated per hop.
+struct SpectrumFrame {
+  static constexpr int kMaxBands = 256;
+  static constexpr int kSrBins = 16;
+
+  int      numBands = 0;
+  float    bandsL[kMaxBands];        // raw linear band magnitudes
+  float    bandsR[kMaxBands];
+  float    levelL[kMaxBands];        // 0..1 per band after the dynamics stage (AGC, floor, smoothing)
+  float    levelR[kMaxBands];
+  float    bins16[kSrBins];          // 0..1, what goes to WLED
+  float    level = 0.0f;             // overall 0..1 level (dynamics stage)
+  bool     peak = false;             // loudness peak this hop
+  bool     gate = false;             // signal above the tracked noise floor
+  float    noiseFloorDb = -120.0f;
+  float    rmsL = 0.0f, rmsR = 0.0f; // linear RMS of the windowed frame
+  float    dbL = -120.0f, dbR = -120.0f;
+  float    centroidL = -1.0f;        // amplitude-weighted band index, -1 = silent
+  float    centroidR = -1.0f;
+  // Spectral features of the L/R-mean spectrum (MagnitudeCache), bins 1 .. N/2-1
+  float    spectralCentroidHz = 0.0f;
+  float    spectralRolloffHz = 0.0f;   // 90% of the magnitude lies below
+  float    spectralFlatness = 0.0f;    // 0 tonal .. 1 noise-like
+  float    chroma[12] = {};            // pitch-class magnitude (C, C#, ... B)
+  // Harmonic / percussive split (HpssProcessor) of the L/R-mean spectrum
+  float    harmonic[kMaxBands];        // raw linear band magnitudes, harmonic part
+  float    percussive[kMaxBands];      // ... percussive part (harmonic + percussive = mean of L/R)
+  float    harmonic16[kSrBins];        // 0..1, bins16 drawn from the harmonic part only
+  float    percussive16[kSrBins];
+  float    harmonicShare = 0.5f;       // harmonic fraction of the overall level
+  uint64_t frameIndex = 0;           // hop counter since start
+  int64_t  timestampNs = 0;          // steady clock when the frame was emitted
+  int64_t  captureNs = 0;            // steady clock when its newest sample was captured (0 = unknown)
+
+private:
+  friend class SpectrumFramePool;
+  friend class SpectrumFramePtr;
+  std::atomic<int>   _refs{0};
+  SpectrumFramePool* _pool = nullptr;
+};
+
+class SpectrumFramePtr {
+public:
+  SpectrumFramePtr() = default;
+  SpectrumFramePtr(const SpectrumFramePtr& o) : _f(o._f) { retain(); }
+  SpectrumFramePtr(SpectrumFramePtr&& o) noexcept : _f(o._f) { o._f = nullptr; }
+  SpectrumFramePtr& operator=(SpectrumFramePtr o) noexcept { std::swap(_f, o._f); return *this; }
+  ~SpectrumFramePtr() { release(); }
+
+  SpectrumFrame* get() const { return _f; }
+  SpectrumFrame* operator->() const { return _f; }
+  SpectrumFrame& operator*() const { return *_f; }
+  explicit operator bool() const { return _f != nullptr; }
+  void reset() { release(); _f = nullptr; }
+
+private:
+  friend class SpectrumFramePool;
+  explicit SpectrumFramePtr(SpectrumFrame* f) : _f(f) {}   // adopts a reference
+  void retain() { if (_f) _f->_refs.fetch_add(1, std::memory_order_relaxed); }
+  void release();
+
+  SpectrumFrame* _f = nullptr;
+};
+Q_DECLARE_METATYPE(SpectrumFramePtr)
+
+// Fixed set of frames. acquire() hands out a free one (or an empty handle when
+// every frame is still referenced, i.e. the consumers are behind: the caller
+// drops that hop instead of queueing without bound).
+//
+// The pool is shared by its owner and by every frame in use, so it outlives
+// the owner if frames are still in flight (e.g. queued to the GUI). Create it
+// with create() and let the owner call close() instead of deleting it.
+class SpectrumFramePool {
+public:
+  static SpectrumFramePool* create(int capacity);
+  void close();                       // owner is done; frees once the last frame returns
+
+  SpectrumFramePtr acquire();
+  int capacity() const { return _capacity; }
+  uint64_t exhausted() const { return _exhausted.load(std::memory_order_relaxed); }
+  int inUse() const { return _holds.load(std::memory_order_relaxed) - 1; }   // frames still referenced (owner open)
+
+private:
+  friend class SpectrumFramePtr;
+  explicit SpectrumFramePool(int capacity);
+  ~SpectrumFramePool();
+  void frameReturned() { unhold(); }
+  void unhold();
+
+  SpectrumFrame*        _frames = nullptr;
+  int                   _capacity = 0;
+  int                   _next = 0;              // producer-only scan start
+  std::atomic<int>      _holds{1};              // owner + frames in use
+  std::atomic<uint64_t> _exhausted{0};
+};
+
+inline void SpectrumFramePtr::release() {
+  if (_f && _f->_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    _f->_pool->frameReturned();
+}
@@ -0,0 +1,150 @@
+#include "SrBinMapper.h"
+#include "BandFilterbank.h"
+#include "DspKernels.h"
+#include <algorithm>
+#include <cmath>
+
+// WLED sound-reactive GEQ channel edges in Hz (16 channels, 17 edges)
+static constexpr float kWledEdgesHz[SrBinMapper::kBins + 1] = {
+  43, 86, 129, 216, 301, 430, 560, 818, 1120, 1421, 1895, 2412, 3015, 3704, 4479, 7106, 9259
+};
+
+const char* SrBinMapper::layoutName(Layout l) {
+  switch (l) {
+    case Layout::Contiguous: return "contiguous";
+    case Layout::WledGeq:    return "wledgeq";
+  }
+  return "?";
+}
+
+const char* SrBinMapper::mixName(Mix m) {
+  switch (m) {
+    case Mix::Mean:  return "mean";
+    case Mix::Max:   return "max";
+    case Mix::Left:  return "left";
+    case Mix::Right: return "right";
+  }
+  return "?";
+}
+
+const char* SrBinMapper::normalizeName(Normalize n) {
+  switch (n) {
+    case Normalize::FrameMax:    return "framemax";
+    case Normalize::RunningPeak: return "runningpeak";
+    case Normalize::Fixed:       return "fixed";
+    case Normalize::Dynamics:    return "dynamics";
+  }
+  return "?";
+}
+
+// A contiguous row holds at most N/16 + 2 bands, GEQ rows are disjoint apart
+// from one nearest band per empty channel: 2N + 16 entries always suffice.
+void SrBinMapper::reserve(int maxBands) {
+  const size_t n = size_t(std::max(0, maxBands));
+  _mono.reserve(n);
+  _row.reserve(n);
+  _rowStart.reserve(kBins + 1);
+  _index.reserve(2 * n + kBins);
+  _weight.reserve(2 * n + kBins);
+}
+
+void SrBinMapper::build(const BandFilterbank& bank) {
+  _bands = bank.bands();
+  _mono.assign(_bands, 0.0f);
+  _row.assign(_bands, 0.0f);
+  _rowStart.assign(1, 0);
+  _index.clear();
+  _weight.clear();
+  _peak = 0.0f;
+  if (_bands <= 0) return;
+
+  if (_layout == Layout::WledGeq) buildWledGeq(bank);
+  else                            buildContiguous();
+}
+
+void SrBinMapper::pushRow() {
+  float sum = 0.0f;
+  for (float v : _row) sum += v;
+  if (sum > 0.0f) {
+    for (int b = 0; b < _bands; ++b) {
+      if (_row[b] <= 0.0f) continue;
+      _index.push_back(b);
+      _weight.push_back(_row[b] / sum);   // row average
+    }
+  }
+  _rowStart.push_back(int(_weight.size()));
+}
+
+// Bin i covers band-index interval [i*N/16, (i+1)*N/16); partially covered bands
+// contribute by overlap, so N=16/32/64 reduce to plain averages and N<16 repeats.
+void SrBinMapper::buildContiguous() {
+  std::vector<float>& w = _row;
+  for (int i = 0; i < kBins; ++i) {
+    std::fill(w.begin(), w.end(), 0.0f);
+    const float a = float(i)     * _bands / kBins;
+    const float z = float(i + 1) * _bands / kBins;
+    for (int b = int(std::floor(a)); b < std::min(_bands, int(std::ceil(z))); ++b) {
+      w[b] = std::min(z, float(b + 1)) - std::max(a, float(b));
+    }
+    pushRow();
+  }
+}
+
+// Each band goes to the GEQ channel containing its centre. Channels with no
+// band centre (coarse layouts) take the nearest band instead of staying dark.
+void SrBinMapper::buildWledGeq(const BandFilterbank& bank) {
+  std::vector<float>& w = _row;
+  for (int i = 0; i < kBins; ++i) {
+    std::fill(w.begin(), w.end(), 0.0f);
+    const float lo = kWledEdgesHz[i], hi = kWledEdgesHz[i + 1];
+    bool any = false;
+    for (int b = 0; b < _bands; ++b) {
+      const float c = bank.centerHz(b);
+      if (c >= lo && c < hi) { w[b] = 1.0f; any = true; }
+    }
+    if (!any) {
+      const float mid = std::sqrt(lo * hi);
+      int best = 0;
+      for (int b = 1; b < _bands; ++b)
+        if (std::fabs(std::log(bank.centerHz(b) / mid)) < std::fabs(std::log(bank.centerHz(best) / mid)))
+          best = b;
+      w[best] = 1.0f;
+    }
+    pushRow();
+  }
+}
+
+void SrBinMapper::map(const float* bandsL, const float* bandsR, float* out) {
+  if (_bands <= 0) { std::fill(out, out + kBins, 0.0f); return; }
+
+  float* m = _mono.data();
+  switch (_mix) {
+    case Mix::Mean:  for (int b = 0; b < _bands; ++b) m[b] = 0.5f * (bandsL[b] + bandsR[b]); break;
+    case Mix::Max:   for (int b = 0; b < _bands; ++b) m[b] = std::max(bandsL[b], bandsR[b]); break;
+    case Mix::Left:  std::copy(bandsL, bandsL + _bands, m); break;
+    case Mix::Right: std::copy(bandsR, bandsR + _bands, m); break;
+  }
+
+  dsp::kernels().sparseMatVec(out, m, _rowStart.data(), _index.data(), _weight.data(), kBins);
+
+  float mx = 0.0f;
+  for (int i = 0; i < kBins; ++i) mx = std::max(mx, out[i]);
+
+  float scale = 0.0f;
+  switch (_norm) {
+    case Normalize::FrameMax:
+      scale = mx > 0.0f ? 1.0f / mx : 0.0f;
+      break;
+    case Normalize::RunningPeak:
+      _peak = std::max(mx, _peak * _decay);
+      scale = _peak > 1e-9f ? 1.0f / _peak : 0.0f;
+      break;
+    case Normalize::Fixed:
+      scale = _gain;
+      break;
+    case Normalize::Dynamics:
+      scale = 1.0f;
+      break;
+  }
+  for (int i = 0; i < kBins; ++i) out[i] = std::clamp(out[i] * scale, 0.0f, 1.0f);
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+
+class BandFilterbank;
+
+// The one place N analysis bands become the 16 WLED sound-reactive bins.
+//
+// build() precomputes a 16 x N weight table (CSR, each row averaging its bands)
+// whenever the band layout changes; map() then runs once per hop:
+//   mix L/R per band -> sparse 16 x N average -> normalize to 0..1.
+// With Normalize::Dynamics (the default) the caller passes the per-band levels
+// from DynamicsProcessor, which are already 0..1, and map() only averages.
+class SrBinMapper {
+public:
+  static constexpr int kBins = 16;
+
+  // How bands are grouped into the 16 bins
+  enum class Layout {
+    Contiguous,   // equal runs of band index (fractional overlap when N isn't a multiple of 16)
+    WledGeq       // by band centre frequency, using WLED's own 16 GEQ channel ranges
+  };
+  // How the two channels are combined per band
+  enum class Mix { Mean, Max, Left, Right };
+  // How the 16 values are scaled into 0..1
+  enum class Normalize {
+    FrameMax,     // divide by this frame's largest bin (old behaviour)
+    RunningPeak,  // divide by a slowly decaying peak, so quiet passages stay quiet
+    Fixed,        // multiply by a fixed gain, then clamp
+    Dynamics,     // input is already AGC'd levels (DynamicsProcessor); clamp only
+  };
+  static constexpr int kLayouts = 2, kMixes = 4, kNormalizes = 4;
+
+  // Lower-case names for config files and the GUI
+  static const char* layoutName(Layout l);
+  static const char* mixName(Mix m);
+  static const char* normalizeName(Normalize n);
+
+  void setLayout(Layout l) { _layout = l; }
+  void setMix(Mix m) { _mix = m; }
+  void setNormalize(Normalize n) { _norm = n; _peak = 0.0f; }
+  void setFixedGain(float g) { _gain = g; }
+  void setPeakDecay(float perFrame) { _decay = perFrame; }
+
+  Layout layout() const { return _layout; }
+  Mix mix() const { return _mix; }
+  Normalize normalize() const { return _norm; }
+
+  // So later build() calls up to maxBands don't allocate
+  void reserve(int maxBands);
+  // Rebuild the table for the filterbank's band count / centre frequencies.
+  void build(const BandFilterbank& bank);
+  void reset() { _peak = 0.0f; }
+
+  // bandsL/bandsR: bands() values each; out: kBins values in 0..1
+  void map(const float* bandsL, const float* bandsR, float* out);
+
+  int bands() const { return _bands; }
+
+private:
+  void buildContiguous();
+  void buildWledGeq(const BandFilterbank& bank);
+  void pushRow();                               // normalize _row and append it as CSR
+
+  Layout _layout = Layout::Contiguous;
+  Mix _mix = Mix::Mean;
+  Normalize _norm = Normalize::Dynamics;
+  float _gain = 1.0f;
+  float _decay = 0.995f;                        // ~2 s half-life at 93 frames/s
+  float _peak = 0.0f;
+
+  int _bands = 0;
+  std::vector<int>   _rowStart;
+  std::vector<int>   _index;
+  std::vector<float> _weight;
+  std::vector<float> _mono;                     // mixed bands (scratch, sized in build)
+  std::vector<float> _row;                      // dense weights of the row being built
+};
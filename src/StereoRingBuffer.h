@@ -0,0 +1,170 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+// Lock-free single-producer / single-consumer ring of de-interleaved stereo floats.
+//
+// Producer: the miniaudio data callback (real-time thread).
+// Consumer: the DSP thread (AudioProcessor / AdvancedAudioProcessor).
+//
+// All storage is allocated up front in reset(); the write*/consume calls
+// never allocate, lock or signal, so they are safe to call from the audio callback.
+// Head/tail are monotonically increasing frame counters; capacity is a power of two
+// so wrapping is a mask.
+class StereoRingBuffer {
+public:
+  explicit StereoRingBuffer(std::size_t capacityFrames = 1u << 15) { reset(capacityFrames); }
+
+  StereoRingBuffer(const StereoRingBuffer&) = delete;
+  StereoRingBuffer& operator=(const StereoRingBuffer&) = delete;
+
+  // (Re)allocate storage. NOT thread-safe: only call while neither side is running.
+  void reset(std::size_t capacityFrames) {
+    std::size_t cap = 1;
+    while (cap < capacityFrames) cap <<= 1;
+    _l.assign(cap, 0.0f);
+    _r.assign(cap, 0.0f);
+    _mask = cap - 1;
+    _head.store(0, std::memory_order_relaxed);
+    _tail.store(0, std::memory_order_relaxed);
+    _overruns.store(0, std::memory_order_relaxed);
+    _droppedFrames.store(0, std::memory_order_relaxed);
+    for (Stamp& s : _stamps) { s.endFrame.store(0, std::memory_order_relaxed); s.ns.store(0, std::memory_order_relaxed); }
+    _stampHead.store(0, std::memory_order_relaxed);
+  }
+
+  std::size_t capacity() const { return _mask + 1; }
+
+  // Frames ready for the consumer (exact on the consumer side, a lower bound elsewhere).
+  std::size_t availableRead() const {
+    return std::size_t(_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_relaxed));
+  }
+  // Free space for the producer (exact on the producer side, a lower bound elsewhere).
+  std::size_t availableWrite() const {
+    return capacity() - std::size_t(_head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_acquire));
+  }
+
+  // ---- Producer side ----
+
+  // De-interleave `frames` frames of `channels`-channel audio straight into the ring,
+  // taking channel `left` / `right` (0-based) as L/R: a multichannel source feeds
+  // one ring per channel pair, left == right is a mono channel duplicated.
+  // Channels past the source's count clamp to its last one (mono in -> L = R).
+  // Frames that do not fit are dropped and counted as an overrun.
+  std::size_t writeInterleaved(const float* in, std::size_t frames, unsigned channels,
+                               unsigned left = 0, unsigned right = 1) {
+    const std::size_t n = reserveWrite(frames);
+    const uint64_t head = _head.load(std::memory_order_relaxed);
+    const unsigned stride = channels > 0 ? channels : 1;
+    const unsigned lOff = std::min(left, stride - 1);
+    const unsigned rOff = std::min(right, stride - 1);
+    for (std::size_t i = 0; i < n; ++i, in += stride) {
+      const std::size_t idx = std::size_t(head + i) & _mask;
+      _l[idx] = in[lOff];
+      _r[idx] = in[rOff];
+    }
+    _head.store(head + n, std::memory_order_release);
+    return n;
+  }
+
+  // Keep cadence stable on device glitches (pInput == nullptr).
+  std::size_t writeSilence(std::size_t frames) {
+    const std::size_t n = reserveWrite(frames);
+    const uint64_t head = _head.load(std::memory_order_relaxed);
+    const std::size_t idx = std::size_t(head) & _mask;
+    const std::size_t first = std::min(n, capacity() - idx);
+    std::memset(_l.data() + idx, 0, first * sizeof(float));
+    std::memset(_r.data() + idx, 0, first * sizeof(float));
+    std::memset(_l.data(), 0, (n - first) * sizeof(float));
+    std::memset(_r.data(), 0, (n - first) * sizeof(float));
+    _head.store(head + n, std::memory_order_release);
+    return n;
+  }
+
+  // ---- Consumer side ----
+
+  // Zero-copy read: hands up to `maxFrames` frames to fn(const float* L, const float* R, size_t n)
+  // as at most two contiguous spans, then releases them. Returns frames consumed.
+  template <class Fn>
+  std::size_t consume(std::size_t maxFrames, Fn&& fn) {
+    const uint64_t tail = _tail.load(std::memory_order_relaxed);
+    const std::size_t n = std::min(maxFrames, std::size_t(_head.load(std::memory_order_acquire) - tail));
+    if (n == 0) return 0;
+    const std::size_t idx = std::size_t(tail) & _mask;
+    const std::size_t first = std::min(n, capacity() - idx);
+    fn(_l.data() + idx, _r.data() + idx, first);
+    if (n > first) fn(_l.data(), _r.data(), n - first);
+    _tail.store(tail + n, std::memory_order_release);
+    return n;
+  }
+
+  // Throw away everything currently queued (e.g. stale audio on restart).
+  void discard() {
+    _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+  }
+
+  // ---- Capture timestamps ----
+  // The producer stamps each write with the time the period was captured; the
+  // consumer can then ask when any frame position it reads was captured.
+  // Positions are absolute frame indices (framesRead()/framesWritten() scale).
+
+  // Producer: call right after a write; covers every frame up to framesWritten().
+  void stamp(int64_t ns) {
+    const uint64_t i = _stampHead.load(std::memory_order_relaxed);
+    Stamp& s = _stamps[i & (kStamps - 1)];
+    s.endFrame.store(_head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    s.ns.store(ns, std::memory_order_relaxed);
+    _stampHead.store(i + 1, std::memory_order_release);
+  }
+
+  // Consumer: stamp of the write that contained frame `pos` (0 if too old / never stamped).
+  int64_t captureTimeOf(uint64_t pos) const {
+    const uint64_t h = _stampHead.load(std::memory_order_acquire);
+    int64_t ns = 0;
+    for (uint64_t n = 0; n < kStamps && n < h; ++n) {
+      const Stamp& s = _stamps[(h - 1 - n) & (kStamps - 1)];
+      if (s.endFrame.load(std::memory_order_relaxed) <= pos) break;   // ends before pos
+      ns = s.ns.load(std::memory_order_relaxed);
+    }
+    return ns;
+  }
+
+  // ---- Counters (readable from any thread) ----
+  uint64_t overruns()      const { return _overruns.load(std::memory_order_relaxed); }      // writes that had to drop
+  uint64_t droppedFrames() const { return _droppedFrames.load(std::memory_order_relaxed); } // frames lost to overruns
+  uint64_t framesWritten() const { return _head.load(std::memory_order_relaxed); }
+  uint64_t framesRead()    const { return _tail.load(std::memory_order_relaxed); }
+
+private:
+  // Clamp a write to the free space, counting anything that does not fit.
+  std::size_t reserveWrite(std::size_t frames) {
+    const std::size_t space = availableWrite();
+    if (frames <= space) return frames;
+    _overruns.fetch_add(1, std::memory_order_relaxed);
+    _droppedFrames.fetch_add(frames - space, std::memory_order_relaxed);
+    return space;
+  }
+
+  std::vector<float> _l, _r;
+  std::size_t _mask = 0;
+
+  // Producer and consumer indices on separate cache lines to avoid false sharing.
+  alignas(64) std::atomic<uint64_t> _head{0};
+  alignas(64) std::atomic<uint64_t> _tail{0};
+
+  // Capture stamps: one per write, newest kStamps kept (~1.3 s of 10 ms periods)
+  static constexpr uint64_t kStamps = 128;
+  struct Stamp {
+    std::atomic<uint64_t> endFrame{0};   // framesWritten() after the write
+    std::atomic<int64_t>  ns{0};
+  };
+  Stamp _stamps[kStamps];
+  alignas(64) std::atomic<uint64_t> _stampHead{0};
+
+  alignas(64) std::atomic<uint64_t> _overruns{0};
+  std::atomic<uint64_t> _droppedFrames{0};
+};
@@ -0,0 +1,176 @@
+#include "TempoTracker.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr double kTwoPi = 6.283185307179586;
+
+// signed distance a - b on the unit circle, in [-0.5, 0.5)
+double wrapPhase(double d) {
+  d -= std::floor(d + 0.5);
+  return d;
+}
+}
+
+TempoTracker::~TempoTracker() = default;
+
+void TempoTracker::configure(double hopRate, double minBpm, double maxBpm,
+                             double historySeconds, int recomputeHops) {
+  _hopRate = std::max(1.0, hopRate);
+  _minBpm = std::max(20.0, minBpm);
+  _maxBpm = std::max(_minBpm + 1.0, maxBpm);
+  _recompute = std::max(1, recomputeHops);
+
+  // History must hold a few periods of the slowest tempo
+  const int want = std::max(int(std::ceil(historySeconds * _hopRate)),
+                            int(std::ceil(4.0 * 60.0 / _minBpm * _hopRate)));
+  int len = 64;
+  while (len < want) len <<= 1;
+
+  if (len != _len) {
+    _len = len;
+    _ac = fft::makeReal(2 * _len, true);
+    _acIn.assign(2 * _len, 0.0f);
+    _acOut.assign(2 * _len, 0.0f);
+    _acSpec.assign(_len + 1, fft::Complex{0, 0});
+  }
+
+  // Log-Gaussian tempo prior centred on 120 BPM (about an octave wide)
+  _prior.assign(_len, 0.0f);
+  for (int lag = 1; lag < _len; ++lag) {
+    const double bpm = 60.0 * _hopRate / lag;
+    const double o = std::log2(bpm / 120.0);
+    _prior[lag] = float(std::exp(-0.5 * o * o / (0.9 * 0.9)));
+  }
+  reset();
+}
+
+void TempoTracker::reset() {
+  _env.assign(_len, 0.0f);
+  _head = 0;
+  _fed = 0;
+  _mean = 0.0f;
+  _peak = 1e-3f;
+  _period = 60.0 * _hopRate / 120.0;
+  _phase = 0.0;
+  _confidence = 0.0;
+  _beat = false;
+  _sinceUpdate = 0;
+}
+
+bool TempoTracker::process(float onsetStrength) {
+  if (_len == 0) return false;
+
+  // --- novelty: log compression, remove slow trend, half-wave rectify ---
+  const float x = std::log1p(100.0f * std::max(0.0f, onsetStrength));
+  _mean += 0.01f * (x - _mean);
+  const float n = std::max(0.0f, x - _mean);
+  _env[_head] = n;
+  _head = (_head + 1) & (_len - 1);
+  ++_fed;
+  _peak = std::max(n, _peak * 0.999f);
+
+  if (++_sinceUpdate >= _recompute && _fed >= _len / 2) {
+    _sinceUpdate = 0;
+    updateTempo();
+    anchorPhase();
+  }
+
+  // --- phase-locked oscillator ---
+  // Advance by one hop, then nudge toward the novelty peak: a peak just after
+  // the predicted beat (phase slightly > 0) pulls the phase back, and vice versa.
+  const double prev = _phase;
+  _phase += 1.0 / _period;
+  const double w = (n / _peak) * (0.05 + 0.15 * _confidence);
+  _phase -= w * std::sin(kTwoPi * _phase) / kTwoPi;
+  _phase -= std::floor(_phase);
+  _beat = _phase < prev;   // wrapped: beat in this hop
+  return _beat;
+}
+
+void TempoTracker::updateTempo() {
+  if (!_ac) return;
+  // Unroll the ring oldest -> newest, zero-padded to 2L so the ACF is linear
+  float sum = 0.0f;
+  for (int i = 0; i < _len; ++i) {
+    const float v = _env[(_head + i) & (_len - 1)];
+    _acIn[i] = v;
+    sum += v;
+  }
+  const float mean = sum / float(_len);
+  for (int i = 0; i < _len; ++i) _acIn[i] -= mean;
+  std::fill(_acIn.begin() + _len, _acIn.end(), 0.0f);
+
+  _ac->forward(_acIn.data(), _acSpec.data());
+  for (auto& c : _acSpec) {
+    c.r = c.r * c.r + c.i * c.i;
+    c.i = 0.0f;
+  }
+  _ac->inverse(_acSpec.data(), _acOut.data());
+  const float r0 = _acOut[0];
+  if (!(r0 > 0.0f)) { _confidence = 0.0; return; }
+
+  // Biased ACF (it tapers with lag, so of two octave-related peaks of equal
+  // height the faster one wins) weighted by the tempo prior
+  const int lagMin = std::max(2, int(std::floor(60.0 * _hopRate / _maxBpm)));
+  const int lagMax = std::min(_len - 2, int(std::ceil(60.0 * _hopRate / _minBpm)));
+  auto score = [&](int lag) {
+    return _acOut[lag] * _prior[lag];
+  };
+  int best = -1;
+  float bestScore = 0.0f;
+  for (int lag = lagMin; lag <= lagMax; ++lag) {
+    const float s = score(lag);
+    if (s > bestScore) { bestScore = s; best = lag; }
+  }
+  if (best < 0) { _confidence *= 0.5; return; }
+
+  // Octave check: a pulse train correlates as well at 2P as at P, and the
+  // prior can tip it toward half tempo. Prefer the half lag if it is nearly
+  // as strong.
+  const int half = best / 2;
+  if (half >= lagMin) {
+    int h = half;
+    for (int d = -1; d <= 1; ++d)
+      if (half + d >= lagMin && _acOut[half + d] > _acOut[h]) h = half + d;
+    if (_acOut[h] >= 0.85f * _acOut[best]) { best = h; bestScore = score(h); }
+  }
+
+  // Parabolic refinement around the peak
+  double lag = best;
+  if (best > lagMin && best < lagMax) {
+    const float a = score(best - 1), b = bestScore, c = score(best + 1);
+    const float den = a - 2.0f * b + c;
+    if (den < 0.0f) lag += 0.5 * (a - c) / den;
+  }
+
+  // Smooth in the log domain unless the tempo clearly jumped
+  const double ratio = std::log2(lag / _period);
+  _period = (std::abs(ratio) > 0.1) ? lag : _period * std::exp2(0.3 * ratio);
+
+  const double c = std::clamp(double(_acOut[best]) / r0 * double(_len) / double(_len - best), 0.0, 1.0);
+  _confidence += 0.3 * (c - _confidence);
+}
+
+void TempoTracker::anchorPhase() {
+  // Comb filter: which offset (hops since the last beat) lines up best with
+  // the novelty sampled one, two, ... periods back?
+  const int P = std::max(1, int(std::lround(_period)));
+  const int combs = std::max(1, std::min(4, int((_len - 1) / _period)));
+  int bestOff = 0;
+  float bestSum = -1.0f;
+  for (int off = 0; off < P; ++off) {
+    float s = 0.0f;
+    for (int k = 0; k < combs; ++k) {
+      const int ago = off + int(std::lround(k * _period));
+      if (ago < _len) s += envAgo(ago) * (1.0f - 0.15f * k);
+    }
+    if (s > bestSum) { bestSum = s; bestOff = off; }
+  }
+
+  // Phase implied by "the last beat was bestOff hops ago"
+  const double target = double(bestOff) / _period;
+  const double err = wrapPhase(target - _phase);
+  if (_confidence > 0.3 && std::abs(err) > 0.25) _phase = target - std::floor(target);   // lost lock
+  else _phase = _phase + 0.25 * err - std::floor(_phase + 0.25 * err);
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "FftBackend.h"
+
+// Onset-envelope tempo and beat tracker, fed once per analysis hop.
+//
+//  - novelty: each hop's onset strength is log-compressed, a slow running
+//    mean is subtracted and the result half-wave rectified, then stored in a
+//    power-of-two ring covering a few seconds
+//  - tempo: every `recomputeHops` hops the ring's autocorrelation is taken via
+//    FFT (|X|^2 -> IFFT, zero-padded so it isn't circular), weighted with a
+//    log-Gaussian prior around 120 BPM, and the strongest lag in the BPM range
+//    refined with parabolic interpolation
+//  - beat: a phase-locked oscillator runs at the estimated period; each hop
+//    the novelty pulls its phase toward peaks, and on every tempo update a
+//    comb filter over the last few periods re-anchors the phase
+//
+// Work per hop is O(1) except the periodic O(L log L) tempo update.
+// One instance per stream; no shared state.
+class TempoTracker {
+public:
+  TempoTracker() = default;
+  ~TempoTracker();
+  TempoTracker(const TempoTracker&) = delete;
+  TempoTracker& operator=(const TempoTracker&) = delete;
+
+  // hopRate: hops per second. historySeconds is rounded up to a power of two of hops.
+  void configure(double hopRate, double minBpm = 60.0, double maxBpm = 200.0,
+                 double historySeconds = 6.0, int recomputeHops = 16);
+  void reset();
+
+  // Feed one hop's onset strength (>= 0). Returns true if a beat falls in this hop.
+  bool process(float onsetStrength);
+
+  double bpm() const { return 60.0 * _hopRate / _period; }
+  double periodHops() const { return _period; }
+  double phase() const { return _phase; }          // 0..1, 0 = on the beat
+  double confidence() const { return _confidence; } // 0..1
+  bool beat() const { return _beat; }
+
+private:
+  void updateTempo();
+  void anchorPhase();
+  float envAgo(int hopsAgo) const { return _env[(_head - 1 - hopsAgo) & (_len - 1)]; }
+
+  double _hopRate = 187.5;
+  double _minBpm = 60.0, _maxBpm = 200.0;
+  int _recompute = 16;
+
+  // novelty ring
+  int _len = 0;                      // power of two
+  int _head = 0;                     // next write
+  long long _fed = 0;                // hops seen since reset
+  std::vector<float> _env;
+  float _mean = 0.0f;                // slow running mean of the log envelope
+  float _peak = 1e-3f;               // decaying max of novelty (for PLL gain)
+
+  // autocorrelation (FFT size 2 * _len)
+  std::unique_ptr<fft::RealFft> _ac;  // forward + inverse
+  std::vector<float> _acIn, _acOut;
+  std::vector<fft::Complex> _acSpec;
+  std::vector<float> _prior;         // per lag
+
+  // beat state
+  double _period = 93.75;            // hops per beat
+  double _phase = 0.0;
+  double _confidence = 0.0;
+  bool _beat = false;
+  int _sinceUpdate = 0;
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Lock-free latest-wins mailbox between one writer and one reader thread.
+//
+// Three slots: the writer fills the back slot and publishes it by swapping it
+// with the middle one; the reader swaps the middle slot into the front when a
+// newer value is waiting. Neither side ever blocks or copies the other's slot,
+// and a slow reader simply skips intermediate values.
+//
+//   writer:  T& s = tb.writeBuffer(); ...fill s...; tb.publish();
+//   reader:  if (tb.update()) use(tb.readBuffer());
+template <class T>
+class TripleBuffer {
+public:
+  // Writer side
+  T& writeBuffer() { return _slots[_back].value; }
+  void publish() {
+    _back = _middle.exchange(uint8_t(_back | kDirty), std::memory_order_acq_rel) & kIndex;
+  }
+
+  // Reader side: true if a newer value was swapped in since the last call
+  bool update() {
+    if (!(_middle.load(std::memory_order_relaxed) & kDirty)) return false;
+    _front = _middle.exchange(_front, std::memory_order_acq_rel) & kIndex;
+    return true;
+  }
+  const T& readBuffer() const { return _slots[_front].value; }
+  T& readBuffer() { return _slots[_front].value; }
+
+private:
+  static constexpr uint8_t kIndex = 0x3;
+  static constexpr uint8_t kDirty = 0x4;
+
+  struct alignas(64) Slot { T value{}; };
+  Slot _slots[3];
+  alignas(64) std::atomic<uint8_t> _middle{1};
+  alignas(64) uint8_t _back = 0;     // writer-owned
+  alignas(64) uint8_t _front = 2;    // reader-owned
+};
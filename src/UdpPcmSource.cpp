@@ -0,0 +1,99 @@
+#include "UdpPcmSource.h"
+#include "LatencyTracer.h"
+#include <QUdpSocket>
+#include <QHostAddress>
+#include <QtEndian>
+#include <algorithm>
+
+UdpPcmSource::UdpPcmSource(const CaptureSpec& spec) : _spec(spec) {}
+
+UdpPcmSource::~UdpPcmSource() {
+  stop();
+}
+
+bool UdpPcmSource::start(CaptureSink* sink, int& sampleRate, int& channels, QString& info) {
+  stop();
+  _sock = new QUdpSocket;
+  if (!_sock->bind(QHostAddress::AnyIPv4, _spec.port, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint)) {
+    info = QString("capture: cannot bind UDP port %1: %2").arg(_spec.port).arg(_sock->errorString());
+    stop();
+    return false;
+  }
+  if (!_spec.group.isEmpty() && !_sock->joinMulticastGroup(QHostAddress(_spec.group))) {
+    info = QString("capture: cannot join %1: %2").arg(_spec.group, _sock->errorString());
+    stop();
+    return false;
+  }
+  _sock->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 1 << 20);
+
+  _sink = sink;
+  _datagram.resize(kMaxDatagram);
+  _haveSeq = false;
+  _lostPackets = 0;
+  QObject::connect(_sock, &QUdpSocket::readyRead, _sock, [this] { onReadyRead(); });
+
+  sampleRate = _spec.sampleRate;
+  channels = _spec.channels;
+  info = QString("%1 :%2%3: %4 Hz, %5 ch")
+           .arg(_spec.kind == CaptureSpec::Kind::Rtp ? "RTP L16" : "UDP PCM")
+           .arg(_spec.port)
+           .arg(_spec.group.isEmpty() ? QString() : " (" + _spec.group + ")")
+           .arg(_spec.sampleRate).arg(_spec.channels);
+  return true;
+}
+
+void UdpPcmSource::stop() {
+  if (_sock) { _sock->close(); delete _sock; _sock = nullptr; }
+  _sink = nullptr;
+}
+
+void UdpPcmSource::onReadyRead() {
+  while (_sock && _sock->hasPendingDatagrams()) {
+    const qint64 n = _sock->readDatagram(_datagram.data(), _datagram.size());
+    if (n <= 0 || !_sink) continue;
+    const int64_t now = monotonicNs();
+    if (_spec.kind == CaptureSpec::Kind::Rtp) {
+      handleRtp(_datagram.constData(), int(n), now);
+    } else {
+      const int frameBytes = pcmBytesPerSample(_spec.format) * _spec.channels;
+      pushPcm(_sink, _datagram.constData(), int(n) / frameBytes, _spec.channels, _spec.format, now);
+    }
+  }
+}
+
+void UdpPcmSource::handleRtp(const char* data, int size, int64_t now) {
+  // Fixed header: V(2) P X CC(4) | M PT(7) | seq(16) | timestamp(32) | SSRC(32) | CSRC list
+  if (size < 12 || (quint8(data[0]) >> 6) != 2) return;
+  const bool padding = data[0] & 0x20;
+  const bool extension = data[0] & 0x10;
+  const int csrc = data[0] & 0x0F;
+  const quint16 seq = qFromBigEndian<quint16>(data + 2);
+
+  int offset = 12 + 4 * csrc;
+  if (extension) {
+    if (size < offset + 4) return;
+    offset += 4 + 4 * qFromBigEndian<quint16>(data + offset + 2);
+  }
+  int end = size;
+  if (padding) end -= quint8(data[size - 1]);
+  if (end <= offset) return;
+
+  const int frameBytes = pcmBytesPerSample(_spec.format) * _spec.channels;
+  const int frames = (end - offset) / frameBytes;
+
+  // Fill short gaps with silence; drop late/duplicate packets
+  if (_haveSeq) {
+    const qint16 delta = qint16(seq - _nextSeq);
+    if (delta < 0) return;
+    if (delta > 0) {
+      _lostPackets += quint64(delta);
+      const qint64 gap = qint64(delta) * (_lastPacketFrames ? _lastPacketFrames : frames);
+      if (gap <= qint64(_spec.sampleRate) * kMaxGapMs / 1000) _sink->pushSilence(unsigned(gap), now);
+    }
+  }
+  _haveSeq = true;
+  _nextSeq = quint16(seq + 1);
+  _lastPacketFrames = frames;
+
+  pushPcm(_sink, data + offset, frames, _spec.channels, _spec.format, now);
+}
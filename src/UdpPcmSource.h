@@ -0,0 +1,37 @@
+#pragma once
+#include "CaptureSource.h"
+#include <QByteArray>
+
+class QUdpSocket;
+
+// PCM over UDP from another box (e.g. a PipeWire/ffmpeg/gstreamer sender):
+//   udp  each datagram is bare interleaved PCM in the configured format
+//   rtp  RTP with an L16 payload (RFC 3551: big-endian 16-bit); lost packets
+//        (sequence gaps) become silence so the analysis cadence holds
+// Optionally joins a multicast group. The socket lives on the capture thread.
+class UdpPcmSource : public CaptureSource {
+public:
+  explicit UdpPcmSource(const CaptureSpec& spec);
+  ~UdpPcmSource() override;
+
+  bool start(CaptureSink* sink, int& sampleRate, int& channels, QString& info) override;
+  void stop() override;
+
+private:
+  void onReadyRead();
+  void handleRtp(const char* data, int size, int64_t now);
+
+  CaptureSpec _spec;
+  CaptureSink* _sink = nullptr;
+  QUdpSocket* _sock = nullptr;
+  QByteArray _datagram;                 // receive buffer, reused
+
+  // RTP state
+  bool _haveSeq = false;
+  quint16 _nextSeq = 0;
+  int _lastPacketFrames = 0;
+  quint64 _lostPackets = 0;
+
+  static constexpr int kMaxDatagram = 65536;
+  static constexpr int kMaxGapMs = 100;  // longer gaps are not filled (stream restarted)
+};
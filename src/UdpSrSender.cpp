@@ -0,0 +1,424 @@
+#include "UdpSrSender.h"
+#include "NodeProbe.h"
+#include <QUdpSocket>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QMutexLocker>
+#include <QDebug>
+#include <algorithm>  // std::clamp
+#include <cmath>      // std::lround
+
+#if defined(__linux__)
+  #define WLEDQT_HAVE_SENDMMSG 1
+  #include <sys/socket.h>
+  #include <netinet/in.h>
+  #include <cerrno>
+  #include <cstring>
+#endif
+
+struct UdpSrSender::Target {
+  SrTarget      dst;
+  SrTargetStats stats;
+  SendPolicy    policy;
+  // Same events as stats, for the metrics endpoint (never reset)
+  metrics::Counter sent, dropped, suppressed;
+};
+
+struct UdpSrSender::Batch {
+#ifdef WLEDQT_HAVE_SENDMMSG
+  std::vector<sockaddr_in> addrs;
+  std::vector<mmsghdr>     msgs;
+  std::vector<mmsghdr>     due;         // this tick's subset of msgs
+  iovec                    iov{};       // every message points at the same packet
+#endif
+};
+
+UdpSrSender::UdpSrSender(QObject* parent)
+  : QObject(parent), _batch(new Batch) {
+}
+
+UdpSrSender::~UdpSrSender() {
+  for (Target* t : _targets) delete t;
+  delete _batch;
+}
+
+// --- target list ---
+
+void UdpSrSender::setTarget(const QHostAddress& ip, quint16 port) {
+  setTargets({ SrTarget{ip, port} });
+}
+
+void UdpSrSender::setTargets(const QVector<SrTarget>& targets) {
+  QMutexLocker lock(&_statsMutex);
+  for (Target* t : _targets) delete t;
+  _targets.clear();
+  _targets.reserve(targets.size());
+  for (const SrTarget& d : targets) {
+    if (d.address.isNull() || d.address.protocol() != QAbstractSocket::IPv4Protocol) continue;
+    auto* t = new Target;
+    t->dst = d;
+    t->stats.address = d.address;
+    t->stats.port = d.port;
+    t->stats.multicast = d.address.isMulticast();
+    t->policy.configure(_policy);
+    const std::string target = metrics::labels({{"target", QString("%1:%2").arg(d.address.toString()).arg(d.port).toStdString()}});
+    t->sent.bind("wledqt_sr_sent_total", target, "SR datagrams sent");
+    t->dropped.bind("wledqt_sr_dropped_total", target, "SR datagrams the socket refused");
+    t->suppressed.bind("wledqt_sr_suppressed_total", target, "SR frames held back by the send policy");
+    _targets.push_back(t);
+  }
+  _due.reserve(_targets.size());
+  rebuildBatch();
+  updateProbeNodes();
+}
+
+void UdpSrSender::addTarget(const QHostAddress& ip, quint16 port) {
+  QVector<SrTarget> list;
+  {
+    QMutexLocker lock(&_statsMutex);
+    for (const Target* t : _targets) list.push_back(t->dst);
+  }
+  list.push_back(SrTarget{ip, port});
+  setTargets(list);
+}
+
+void UdpSrSender::clearTargets() {
+  setTargets({});
+}
+
+void UdpSrSender::setMulticastTtl(int ttl) {
+  _multicastTtl = std::clamp(ttl, 1, 255);
+  if (_sock) _sock->setSocketOption(QAbstractSocket::MulticastTtlOption, _multicastTtl);
+}
+
+// --- send policy ---
+
+void UdpSrSender::setSendPolicy(const SendPolicyConfig& cfg) {
+  QMutexLocker lock(&_statsMutex);
+  _policy = cfg;
+  for (Target* t : _targets) t->policy.configure(cfg);
+  updateProbeNodes();
+}
+
+// Caller holds _statsMutex (or runs before the list is shared).
+void UdpSrSender::updateProbeNodes() {
+  if (!_probe) return;
+  QVector<QHostAddress> nodes;
+  if (_policy.enabled)
+    for (const Target* t : _targets) nodes.push_back(t->dst.address);
+  _probe->setNodes(nodes);
+}
+
+void UdpSrSender::onProbe(const QHostAddress& node, float rttMs, bool ok) {
+  QMutexLocker lock(&_statsMutex);
+  for (Target* t : _targets) {
+    if (!(t->dst.address == node)) continue;
+    if (ok) t->policy.reportRtt(rttMs); else t->policy.reportProbeLost();
+    t->stats.rttMs = t->policy.rttMs();
+    t->stats.intervalMs = float(t->policy.intervalMs());
+  }
+}
+
+bool UdpSrSender::parseTargets(const QString& text, QVector<SrTarget>& out, QString* error) {
+  out.clear();
+  static const QRegularExpression sep("[,;\\s]+");
+  const QStringList items = text.split(sep, Qt::SkipEmptyParts);
+  for (const QString& item : items) {
+    QString host = item;
+    quint16 port = 11988;
+    const int colon = item.lastIndexOf(':');
+    if (colon >= 0) {
+      bool ok = false;
+      const int p = item.mid(colon + 1).toInt(&ok);
+      if (!ok || p <= 0 || p > 65535) {
+        if (error) *error = QString("Bad port in '%1'").arg(item);
+        return false;
+      }
+      host = item.left(colon);
+      port = quint16(p);
+    }
+    QHostAddress addr;
+    if (!addr.setAddress(host) || addr.protocol() != QAbstractSocket::IPv4Protocol) {
+      if (error) *error = QString("Bad IPv4 address '%1'").arg(host);
+      return false;
+    }
+    out.push_back(SrTarget{addr, port});
+  }
+  return true;
+}
+
+// --- stats ---
+
+QVector<SrTargetStats> UdpSrSender::targetStats() const {
+  QMutexLocker lock(&_statsMutex);
+  QVector<SrTargetStats> out;
+  out.reserve(int(_targets.size()));
+  for (const Target* t : _targets) out.push_back(t->stats);
+  return out;
+}
+
+int UdpSrSender::targetCount() const {
+  QMutexLocker lock(&_statsMutex);
+  return int(_targets.size());
+}
+
+void UdpSrSender::resetStats() {
+  QMutexLocker lock(&_statsMutex);
+  for (Target* t : _targets) {
+    SrTargetStats& s = t->stats;
+    s.sent = s.dropped = s.suppressed = 0;
+    s.lastSendUs = s.avgSendUs = s.maxSendUs = 0.0f;
+  }
+}
+
+void UdpSrSender::record(Target& t, bool ok, float us) {
+  SrTargetStats& s = t.stats;
+  if (ok) { ++s.sent; t.sent.add(); } else { ++s.dropped; t.dropped.add(); }
+  s.lastSendUs = us;
+  s.avgSendUs  = (s.sent + s.dropped == 1) ? us : 0.9f * s.avgSendUs + 0.1f * us;
+  s.maxSendUs  = std::max(s.maxSendUs, us);
+  t.policy.reportSend(ok);
+  s.intervalMs = float(t.policy.intervalMs());
+}
+
+// --- clock ---
+
+int64_t UdpSrSender::nowNs() {
+  return monotonicNs();   // same clock as the capture stamps
+}
+
+void UdpSrSender::start() {
+  _cpu.bind("net");
+  _cpu.mark();
+  if (!_sock) {
+    _sock = new QUdpSocket(this);
+    // Bind up front so the descriptor exists for socket options and sendmmsg
+    if (!_sock->bind(QHostAddress::AnyIPv4, 0))
+      qWarning() << "UdpSrSender: bind failed:" << _sock->errorString();
+    _sock->setSocketOption(QAbstractSocket::MulticastTtlOption, _multicastTtl);
+  }
+  if (!_probe) {
+    _probe = new NodeProbe(this);
+    connect(_probe, &NodeProbe::result, this, &UdpSrSender::onProbe);
+    QMutexLocker lock(&_statsMutex);
+    updateProbeNodes();
+  }
+  _probe->start();
+  if (!_timer) {
+    _timer = new QTimer(this);
+    _timer->setTimerType(Qt::PreciseTimer);
+    _timer->setSingleShot(true);
+    connect(_timer, &QTimer::timeout, this, &UdpSrSender::tick);
+  }
+  _nextDeadlineNs = nowNs();
+  _lastStatsNs = _nextDeadlineNs;
+  scheduleNext();
+}
+
+void UdpSrSender::stop() {
+  if (_timer) _timer->stop();
+  if (_probe) _probe->stop();
+  _cpu.release();
+  emit stopped();
+}
+
+void UdpSrSender::setSendRate(double hz) {
+  _rateHz = std::clamp(hz, 1.0, 200.0);
+  _periodNs = int64_t(1e9 / _rateHz);
+}
+
+// Deadlines advance by exactly one period, so the average rate is exact even
+// though each QTimer shot is only millisecond-accurate. If we fall more than a
+// period behind (suspended, debugger) we resync instead of bursting.
+void UdpSrSender::scheduleNext() {
+  const int64_t now = nowNs();
+  _nextDeadlineNs += _periodNs;
+  if (_nextDeadlineNs <= now) _nextDeadlineNs = now + _periodNs;
+  _timer->start(int((_nextDeadlineNs - now + 500000) / 1000000));
+}
+
+// --- sending ---
+
+void UdpSrSender::submitBins(const QVector<float>& bins) {
+  submit(_mailbox, bins.constData(), int(bins.size()), 0);
+}
+
+void UdpSrSender::submitReplayBins(const QVector<float>& bins) {
+  submit(_replayMailbox, bins.constData(), int(bins.size()), 0);
+}
+
+void UdpSrSender::submitFrame(const SpectrumFramePtr& frame) {
+  if (!frame) return;
+  if (frame->peak) _peaks.fetch_add(1, std::memory_order_relaxed);
+  submit(_mailbox, frame->bins16, SpectrumFrame::kSrBins, frame->captureNs, frame->level);
+}
+
+void UdpSrSender::submit(TripleBuffer<BinsSlot>& box, const float* bins, int count, int64_t captureNs,
+                         float level) {
+  BinsSlot& s = box.writeBuffer();
+  s.count = std::min(count, kMaxBins);
+  std::copy(bins, bins + s.count, s.bins);
+  s.stampNs = nowNs();
+  s.captureNs = captureNs;
+  s.level = level;
+  box.publish();
+}
+
+void UdpSrSender::tick() {
+  scheduleNext();
+
+  TripleBuffer<BinsSlot>& box = source() == Source::Replay ? _replayMailbox : _mailbox;
+  const bool fresh = box.update();         // newest bins, if any arrived
+  const BinsSlot& s = box.readBuffer();
+  const int64_t now = nowNs();
+  if (s.stampNs == 0 || now - s.stampNs > int64_t(kStaleMs) * 1000000) return;  // audio stopped
+  if (_targets.empty()) return;
+
+  const uint32_t transients = _transients.load(std::memory_order_relaxed);
+  const bool transient = transients != _seenTransients;
+  _seenTransients = transients;
+  const uint32_t peaks = _peaks.load(std::memory_order_relaxed);
+  const bool peak = peaks != _seenPeaks && source() == Source::Live;
+  _seenPeaks = peaks;
+
+  buildPacket(s, peak);
+  if (fanOut(transient) > 0 && _tracer) {
+    const int64_t sent = nowNs();
+    _tracer->record(LatencyTracer::Send, sent - now);
+    // Only the first send of each frame counts for end-to-end (repeats would skew it)
+    if (fresh && s.captureNs) _tracer->record(LatencyTracer::EndToEnd, sent - s.captureNs);
+  }
+
+  if (now - _lastStatsNs >= 1000000000) {
+    _lastStatsNs = now;
+    emit statsReady(targetStats());
+  }
+}
+
+void UdpSrSender::buildPacket(const BinsSlot& s, bool peak) {
+  SrV2Packet& p = _packet;
+  p = SrV2Packet{};  // header already "00002", rest zero
+  const float* bins = s.bins;
+  const int count = s.count;
+
+  // --- overall energy from bins (mean 0..1) ---
+  float mean = 0.0f;
+  for (int i = 0; i < count; ++i) mean += bins[i];
+  mean = count == 0 ? 0.f : mean / float(count);
+
+  // Level and peak come from the DSP dynamics stage (AGC'd already); bins
+  // submitted without a frame (replay, submitBins) just use their mean
+  const float level = s.level >= 0.0f ? s.level : mean;
+
+  // Fill packet levels (0..255 float)
+  p.sampleRaw  = std::clamp(mean, 0.0f, 1.0f) * 255.0f;  // raw mean (optional)
+  p.sampleSmth = std::clamp(level, 0.0f, 1.0f) * 255.0f;
+  p.samplePeak = peak ? 1 : 0;
+
+  p.frameCounter  = _frame++;
+
+  // Map N arbitrary bins -> 16 bins (average per segment), 0..255
+  const int N = count;
+  for (int i = 0; i < 16; ++i) {
+    if (N == 0) { p.fftResult[i] = 0; continue; }
+    int k0 = (i * N) / 16;
+    int k1 = ((i + 1) * N) / 16 - 1;
+    if (k1 < k0) k1 = k0;
+    double acc = 0.0; int cnt = 0;
+    for (int k = k0; k <= k1; ++k) {
+      acc += std::clamp(bins[k], 0.0f, 1.0f);
+      ++cnt;
+    }
+    float avg = cnt ? float(acc / cnt) : 0.f;
+    p.fftResult[i] = static_cast<uint8_t>(std::lround(avg * 255.0f));
+  }
+
+  // Policy view: everything WLED draws from, minus the frame counter / raw mean
+  std::copy(p.fftResult, p.fftResult + 16, _content);
+  _content[16] = uint8_t(std::lround(p.sampleSmth));
+  _content[17] = p.samplePeak;
+}
+
+int UdpSrSender::fanOut(bool transient) {
+  QMutexLocker lock(&_statsMutex);
+  const int64_t now = nowNs();
+  _due.clear();
+  for (size_t i = 0; i < _targets.size(); ++i) {
+    Target* t = _targets[i];
+    if (SendPolicy::sends(t->policy.decide(_content, int(sizeof(_content)), now, transient)))
+      _due.push_back(int(i));
+    else {
+      ++t->stats.suppressed;
+      t->suppressed.add();
+    }
+  }
+  if (!_due.empty() && !sendBatched()) sendEach();
+  return int(_due.size());
+}
+
+void UdpSrSender::sendEach() {
+  const char* data = reinterpret_cast<const char*>(&_packet);
+  QElapsedTimer t;
+  for (int i : _due) {
+    Target* target = _targets[size_t(i)];
+    t.start();
+    const qint64 n = _sock->writeDatagram(data, sizeof(_packet), target->dst.address, target->dst.port);
+    record(*target, n == qint64(sizeof(_packet)), float(t.nsecsElapsed()) * 1e-3f);
+  }
+}
+
+void UdpSrSender::rebuildBatch() {
+#ifdef WLEDQT_HAVE_SENDMMSG
+  const size_t n = _targets.size();
+  _batch->addrs.assign(n, sockaddr_in{});
+  _batch->msgs.assign(n, mmsghdr{});
+  _batch->due.reserve(n);
+  _batch->iov.iov_base = &_packet;
+  _batch->iov.iov_len  = sizeof(_packet);
+  for (size_t i = 0; i < n; ++i) {
+    sockaddr_in& sa = _batch->addrs[i];
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(_targets[i]->dst.port);
+    sa.sin_addr.s_addr = htonl(_targets[i]->dst.address.toIPv4Address());
+    msghdr& h = _batch->msgs[i].msg_hdr;
+    h.msg_name = &sa;
+    h.msg_namelen = sizeof(sa);
+    h.msg_iov = &_batch->iov;
+    h.msg_iovlen = 1;
+  }
+#endif
+}
+
+bool UdpSrSender::sendBatched() {
+#ifdef WLEDQT_HAVE_SENDMMSG
+  const int fd = int(_sock->socketDescriptor());
+  if (fd < 0) return false;
+
+  // Only the targets the policy let through this tick
+  std::vector<mmsghdr>& due = _batch->due;
+  due.clear();
+  for (int k : _due) due.push_back(_batch->msgs[size_t(k)]);
+
+  const int n = int(due.size());
+  QElapsedTimer t;
+  int i = 0;
+  while (i < n) {
+    t.start();
+    const int r = ::sendmmsg(fd, due.data() + i, unsigned(n - i), MSG_DONTWAIT);
+    const float us = float(t.nsecsElapsed()) * 1e-3f;
+    if (r > 0) {
+      for (int j = 0; j < r; ++j) record(*_targets[size_t(_due[size_t(i + j)])], true, us);
+      i += r;
+    } else {
+      // The first message of this batch was refused (EAGAIN, unreachable, ...):
+      // count it as dropped and carry on with the rest.
+      record(*_targets[size_t(_due[size_t(i)])], false, us);
+      ++i;
+    }
+  }
+  return true;
+#else
+  return false;
+#endif
+}
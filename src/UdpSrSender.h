@@ -0,0 +1,191 @@
+#pragma once
+#include <QObject>
+#include <QVector>
+#include <QHostAddress>
+#include <QMutex>
+#include <QMetaType>
+#include <cstdint>    // uint8_t, uint16_t
+#include <vector>
+#include <atomic>
+#include "TripleBuffer.h"
+#include "SpectrumFrame.h"
+#include "LatencyTracer.h"
+#include "SendPolicy.h"
+#include "Metrics.h"
+
+class QUdpSocket;
+class QTimer;
+class NodeProbe;
+
+#pragma pack(push, 1)
+struct SrV2Packet {
+  char    header[6] = "00002";   // 6 bytes, last is '\0'
+  uint8_t pressure[2]{};         // unused -> 0
+  float   sampleRaw{};           // 0..255 (float)
+  float   sampleSmth{};          // 0..255 (float)
+  uint8_t samplePeak{};          // 0/1
+  uint8_t frameCounter{};        // rolls over
+  uint8_t fftResult[16]{};       // 16 bins, 0..255
+  uint16_t zeroCrossingCount{};  // optional
+  float   FFT_Magnitude{};       // optional
+  float   FFT_MajorPeak{};       // optional Hz
+};
+#pragma pack(pop)
+static_assert(sizeof(SrV2Packet) == 44, "SR v2 packet must be 44 bytes");
+
+// One destination: a WLED node (unicast) or a multicast group.
+struct SrTarget {
+  QHostAddress address;
+  quint16      port = 11988;
+};
+Q_DECLARE_METATYPE(SrTarget)
+
+// Per-target counters. sendUs is the time spent in the send call that carried
+// this target's datagram (for a batched send, the whole batch).
+struct SrTargetStats {
+  QHostAddress address;
+  quint16  port = 0;
+  bool     multicast = false;
+  uint64_t sent = 0;
+  uint64_t dropped = 0;          // send failed / not accepted by the kernel
+  uint64_t suppressed = 0;       // held back by the send policy (unchanged / throttled)
+  float    intervalMs = 0.0f;    // current adaptive minimum send interval
+  float    rttMs = 0.0f;         // probe round trip (0 = not measured)
+  float    lastSendUs = 0.0f;
+  float    avgSendUs = 0.0f;     // EWMA
+  float    maxSendUs = 0.0f;
+};
+Q_DECLARE_METATYPE(SrTargetStats)
+
+// Builds one SR v2 packet per frame and fans it out to every target.
+// The packet is serialized once into a member buffer; on Linux all targets go
+// out in one sendmmsg() call, elsewhere one writeDatagram per target from the
+// same buffer. The target list is preallocated so a send never allocates.
+//
+// Meant to live on its own thread: the DSP thread drops the latest bins into a
+// lock-free mailbox (submitBins, DirectConnection) and a deadline-driven timer
+// on the network thread sends whatever is newest at a fixed rate (50 Hz by
+// default). Neither the GUI event loop nor the hop rate affects the cadence.
+//
+// Each target has a SendPolicy: packets whose bins/level haven't changed are
+// skipped down to a keyframe a second, and a lossy or slow node (NodeProbe
+// RTT, refused sends) is sent to less often. Onsets (markTransient) always
+// go out on the next tick.
+class UdpSrSender : public QObject {
+  Q_OBJECT
+public:
+  explicit UdpSrSender(QObject* parent=nullptr);
+  ~UdpSrSender() override;
+
+  // Replace the list with a single target (old behaviour).
+  void setTarget(const QHostAddress& ip, quint16 port=11988);
+  // For multicast instead:
+  //   setTarget(QHostAddress("239.0.0.1"), 11988);
+
+  // Parse "ip[:port], ip[:port] ..." (commas, spaces or semicolons). Returns false and
+  // fills `error` on the first bad entry. IPv4 only, like WLED.
+  static bool parseTargets(const QString& text, QVector<SrTarget>& out, QString* error = nullptr);
+
+  // Optional latency recording of fan-out time and capture -> datagram (not owned).
+  void setLatencyTracer(LatencyTracer* tracer) { _tracer = tracer; }
+
+  // Thread-safe snapshot of the per-target counters.
+  QVector<SrTargetStats> targetStats() const;
+  int targetCount() const;
+
+  // Hand over normalized bins (0..1). Callable from one producer thread at a
+  // time (connect with Qt::DirectConnection from the DSP thread); never blocks.
+  void submitBins(const QVector<float>& bins);
+  // Same, taking bins16 from a processor frame.
+  void submitFrame(const SpectrumFramePtr& frame);
+
+  // Where tick() takes its bins from. In Replay the live mailbox keeps filling
+  // but only bins from submitReplayBins go out, so a recording can drive the
+  // targets while audio runs. Replay has its own mailbox and producer.
+  enum class Source { Live, Replay };
+  void setSource(Source s) { _source.store(s, std::memory_order_relaxed); }   // any thread
+  Source source() const { return _source.load(std::memory_order_relaxed); }
+  void submitReplayBins(const QVector<float>& bins);   // one replay producer thread
+
+  // An onset happened: the next tick sends to every target regardless of the
+  // send policy. Any thread, never blocks.
+  void markTransient() { _transients.fetch_add(1, std::memory_order_relaxed); }
+
+  static constexpr int kMaxBins = 256;
+  static constexpr double kDefaultRateHz = 50.0;
+  static constexpr int kStaleMs = 250;     // stop sending when no bins arrived for this long
+
+public slots:
+  // Runs on the sender's thread: creates the socket and starts the send clock.
+  void start();
+  void stop();
+  void setSendRate(double hz);
+
+  void setTargets(const QVector<SrTarget>& targets);
+  void addTarget(const QHostAddress& ip, quint16 port=11988);
+  void clearTargets();
+  void setMulticastTtl(int ttl);
+  void setSendPolicy(const SendPolicyConfig& cfg);
+  void resetStats();
+
+signals:
+  // Emitted about once a second while sending.
+  void statsReady(const QVector<SrTargetStats>& stats);
+  void stopped();
+
+private:
+  struct Target;
+
+  struct BinsSlot {
+    int     count = 0;
+    float   bins[kMaxBins];
+    int64_t stampNs = 0;           // steady clock at submit
+    int64_t captureNs = 0;         // capture stamp of the audio behind it (0 = unknown)
+    float   level = -1.0f;         // dynamics-stage level 0..1; < 0 = not known (use the bins' mean)
+  };
+
+  static void submit(TripleBuffer<BinsSlot>& box, const float* bins, int count, int64_t captureNs,
+                     float level = -1.0f);
+  void tick();                     // timer fired: send latest, schedule next deadline
+  void scheduleNext();
+  static int64_t nowNs();
+  void buildPacket(const BinsSlot& s, bool peak);
+  int  fanOut(bool transient);     // returns the number of targets sent to
+  void sendEach();                 // portable path: writeDatagram per due target
+  bool sendBatched();              // sendmmsg where available; false if not usable
+  void record(Target& t, bool ok, float us);
+  void rebuildBatch();             // refresh cached sockaddrs after a target change
+  void onProbe(const QHostAddress& node, float rttMs, bool ok);
+  void updateProbeNodes();
+
+  QUdpSocket*   _sock{nullptr};   // created in start() on the sender thread
+  QTimer*       _timer{nullptr};
+  double        _rateHz{kDefaultRateHz};
+  int64_t       _periodNs{int64_t(1e9 / kDefaultRateHz)};
+  int64_t       _nextDeadlineNs{0};
+  int64_t       _lastStatsNs{0};
+  TripleBuffer<BinsSlot> _mailbox; // DSP thread -> sender thread, latest wins
+  TripleBuffer<BinsSlot> _replayMailbox;   // replay producer -> sender thread
+  std::atomic<Source> _source{Source::Live};
+  LatencyTracer* _tracer{nullptr};
+
+  std::vector<Target*> _targets;
+  mutable QMutex _statsMutex;      // guards Target::stats for targetStats()
+  metrics::ThreadCpu _cpu;
+  int           _multicastTtl{1};
+  std::vector<int> _due;           // targets the policy lets through this tick
+  SendPolicyConfig _policy{SendPolicyConfig::fromEnvironment()};
+  NodeProbe*    _probe{nullptr};
+  std::atomic<uint32_t> _transients{0};
+  uint32_t      _seenTransients{0};
+  std::atomic<uint32_t> _peaks{0};  // SpectrumFrame::peak hops; latched so a skipped frame can't lose one
+  uint32_t      _seenPeaks{0};
+
+  SrV2Packet    _packet{};         // serialized once per frame, shared by all targets
+  uint8_t       _content[18]{};    // what the policy compares: 16 bins, smoothed level, peak
+  quint8        _frame{0};
+
+  // Batched send state (Linux): one mmsghdr/iovec/sockaddr per target
+  struct Batch;
+  Batch* _batch{nullptr};
+};
@@ -0,0 +1,85 @@
+#include <QCoreApplication>
+#include <QDir>
+#include <QStandardPaths>
+#include <QTimer>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include "Pipeline.h"
+#include "PipelineConfig.h"
+#include "FftBackend.h"
+
+// wledqt-daemon [config.json | config.ini]
+// The same capture -> DSP -> senders pipeline as the GUI, without Qt Widgets:
+// configured from the file (see PipelineConfig.h) and the WLEDQT_* variables,
+// status lines on stderr, metrics over HTTP with WLEDQT_METRICS / "metrics".
+// Runs until SIGINT / SIGTERM.
+
+namespace {
+
+std::atomic<bool> quitRequested{false};
+
+// Only sets a flag: the event loop polls it (nothing else is safe in a handler)
+void onSignal(int) { quitRequested.store(true); }
+
+void usage() {
+    std::fprintf(stderr,
+        "usage: wledqt-daemon [config.json | config.ini]\n"
+        "keys: source, zones, bands, fftSize, hop, autoFft, srLayout, srMix, srNormalize,\n"
+        "      targets, metrics,\n"
+        "      leds/segments, leds/effect, leds/brightness, leds/fps\n");
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("wledqt");   // shares the GUI's cache dir (FFTW wisdom)
+
+    const QStringList args = app.arguments();
+    if (args.size() > 2 || (args.size() == 2 && (args[1] == "-h" || args[1] == "--help"))) {
+        usage();
+        return args.size() == 2 ? 0 : 2;
+    }
+
+    PipelineConfig cfg;
+    QString error;
+    if (args.size() == 2 && !PipelineConfig::load(args[1], cfg, &error)) {
+        std::fprintf(stderr, "wledqt-daemon: %s\n", qPrintable(error));
+        return 2;
+    }
+    if (cfg.targets.isEmpty() && cfg.ledSegments.isEmpty())
+        std::fprintf(stderr, "wledqt-daemon: no targets or leds/segments configured, nothing will be sent\n");
+
+    // FFTW wisdom: plans measured on an earlier run are reused (no-op with kissfft)
+    const QString cache = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    const std::string wisdom = QDir(cache).filePath("fftw-wisdom").toStdString();
+    fft::loadWisdom(wisdom);
+
+    int rc = 0;
+    {
+        Pipeline pipeline;
+        QObject::connect(&pipeline, &Pipeline::status, [](const QString& msg) {
+            std::fprintf(stderr, "%s\n", qPrintable(msg));
+        });
+        if (!pipeline.apply(cfg, &error)) {
+            std::fprintf(stderr, "wledqt-daemon: %s\n", qPrintable(error));
+            return 2;
+        }
+
+        std::signal(SIGINT, onSignal);
+        std::signal(SIGTERM, onSignal);
+        QTimer poll;
+        QObject::connect(&poll, &QTimer::timeout, &app, [] {
+            if (quitRequested.load()) QCoreApplication::quit();
+        });
+        poll.start(200);
+
+        pipeline.start();
+        rc = app.exec();
+        std::fprintf(stderr, "wledqt-daemon: stopping\n");
+    }
+
+    if (fft::backendAvailable(fft::Backend::Fftw) && QDir().mkpath(cache)) fft::saveWisdom(wisdom);
+    return rc;
+}
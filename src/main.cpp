@@ -1,9 +1,24 @@
 #include <QApplication>
+#include <QDir>
+#include <QStandardPaths>
 #include "MainWindow.h"
+#include "FftBackend.h"
 
 int main(int argc, char *argv[]) {
     QApplication app(argc, argv);
-    MainWindow w;
-    w.show();
-    return app.exec();
+
+    // FFTW wisdom: plans measured on an earlier run are reused (no-op with kissfft)
+    const QString cache = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    const std::string wisdom = QDir(cache).filePath("fftw-wisdom").toStdString();
+    fft::loadWisdom(wisdom);
+
+    int rc = 0;
+    {
+        MainWindow w;
+        w.show();
+        rc = app.exec();
+    }
+
+    if (fft::backendAvailable(fft::Backend::Fftw) && QDir().mkpath(cache)) fft::saveWisdom(wisdom);
+    return rc;
 }